@@ -0,0 +1,94 @@
+#include "qx/Circuit.hpp"
+#include "qx/DenseStateVector.hpp"
+#include "qx/V3xLibqasmInterface.hpp"
+#include "v3x/cqasm.hpp"
+
+#include <benchmark/benchmark.h>
+#include <fmt/format.h>
+#include <string>
+
+
+namespace qx {
+
+namespace {
+
+std::size_t const NUMBER_OF_QUBITS = 16;
+
+// Statements cycling over single-qubit gates, rotations with distinct angles, CNOT and CR on single qubits,
+// and a Hadamard gate broadcast over the whole register.
+std::string getProgram(std::size_t numberOfStatements) {
+    std::string program = fmt::format("version 3.0\nqubit[{}] q\n", NUMBER_OF_QUBITS);
+    for (std::size_t i = 0; i < numberOfStatements; ++i) {
+        auto q = i % NUMBER_OF_QUBITS;
+        auto next = (q + 1) % NUMBER_OF_QUBITS;
+        auto angle = 0.001 * static_cast<double>(i);
+        switch (i % 5) {
+            case 0: program += fmt::format("X q[{}]\n", q); break;
+            case 1: program += fmt::format("Rx q[{}], {}\n", q, angle); break;
+            case 2: program += fmt::format("CNOT q[{}], q[{}]\n", q, next); break;
+            case 3: program += fmt::format("CR q[{}], q[{}], {}\n", q, next, angle); break;
+            default: program += "H q\n"; break;
+        }
+    }
+    return program;
+}
+
+cqasm::v3x::analyzer::AnalysisResult analyze(std::string const &program) {
+    return cqasm::v3x::default_analyzer("3.0").analyze_string(program, std::nullopt);
+}
+
+// The three steps of executeString are timed separately, on the same program: parsing and analysis by libqasm,
+// loading of the analyzed program into a circuit, and a single shot of the circuit on the dense state vector.
+// Argument: number of statements. 250000 statements give a million gates, since one in five is broadcast over
+// 16 qubits.
+void BM_ParseCqasm(benchmark::State &state) {
+    auto program = getProgram(static_cast<std::size_t>(state.range(0)));
+    for (auto _ : state) {
+        auto analysisResult = analyze(program);
+        benchmark::DoNotOptimize(analysisResult.root);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_LoadCqasmCode(benchmark::State &state) {
+    auto analysisResult = analyze(getProgram(static_cast<std::size_t>(state.range(0))));
+    if (!analysisResult.errors.empty()) {
+        state.SkipWithError("Invalid cQASM program");
+        return;
+    }
+
+    std::size_t numberOfGates = 0;
+    for (auto _ : state) {
+        auto circuit = loadCqasmCode(*analysisResult.root);
+        numberOfGates = circuit.getNumberOfInstructions();
+        benchmark::DoNotOptimize(numberOfGates);
+    }
+    state.counters["gates"] = static_cast<double>(numberOfGates);
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_ExecuteLoadedCircuit(benchmark::State &state) {
+    auto analysisResult = analyze(getProgram(static_cast<std::size_t>(state.range(0))));
+    if (!analysisResult.errors.empty()) {
+        state.SkipWithError("Invalid cQASM program");
+        return;
+    }
+
+    auto circuit = loadCqasmCode(*analysisResult.root);
+    core::DenseStateVector victim(NUMBER_OF_QUBITS);
+    for (auto _ : state) {
+        victim.reset();
+        circuit.execute(victim, std::monostate{});
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+}  // namespace
+
+BENCHMARK(BM_ParseCqasm)->Arg(250000)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+BENCHMARK(BM_LoadCqasmCode)->Arg(250000)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+BENCHMARK(BM_ExecuteLoadedCircuit)->Arg(10000)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+}  // namespace qx
@@ -0,0 +1,166 @@
+#include "qx/DenseStateVector.hpp"
+#include "qx/Gates.hpp"
+
+#include <benchmark/benchmark.h>
+#include <complex>
+#include <cstdlib>  // getenv
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>  // sysconf
+#endif
+
+
+namespace qx::core {
+
+namespace {
+
+std::size_t getPhysicalMemory() {
+#if defined(__unix__) || defined(__APPLE__)
+    return static_cast<std::size_t>(sysconf(_SC_PHYS_PAGES)) * static_cast<std::size_t>(sysconf(_SC_PAGE_SIZE));
+#else
+    return 0;
+#endif
+}
+
+// The memory-mapped file is created in $QX_BENCHMARK_DIR, which should be on the fast local disk, or in the
+// temporary directory otherwise.
+std::string getStateFilePath() {
+    char const *directory = std::getenv("QX_BENCHMARK_DIR");
+    auto path = directory != nullptr ? std::filesystem::path(directory) : std::filesystem::temp_directory_path();
+    return (path / "qx_dense_state_vector_benchmark.bin").string();
+}
+
+// One layer of Hadamards, followed by a CNOT ladder, which touches every qubit including the high-order ones.
+void applyLayer(DenseStateVector &state) {
+    auto n = state.getNumberOfQubits();
+    for (std::size_t q = 0; q < n; ++q) {
+        state.apply<1>(gates::H, std::array<QubitIndex, 1>{QubitIndex{q}});
+    }
+    for (std::size_t q = 0; q + 1 < n; ++q) {
+        state.apply<2>(gates::CNOT, std::array<QubitIndex, 2>{QubitIndex{q}, QubitIndex{q + 1}});
+    }
+}
+
+// Same gates as applyLayer, as one sequence for applySequence.
+class Layer {
+public:
+    explicit Layer(std::size_t n) : singleQubitOperands(n), twoQubitOperands(n - 1) {
+        for (std::size_t q = 0; q < n; ++q) {
+            singleQubitOperands[q] = {QubitIndex{q}};
+            gates.emplace_back(DenseStateVector::GateReference<1>{gates::H, singleQubitOperands[q]});
+        }
+        for (std::size_t q = 0; q + 1 < n; ++q) {
+            twoQubitOperands[q] = {QubitIndex{q}, QubitIndex{q + 1}};
+            gates.emplace_back(DenseStateVector::GateReference<2>{gates::CNOT, twoQubitOperands[q]});
+        }
+    }
+
+    std::vector<DenseStateVector::SequenceGate> const &getGates() const { return gates; }
+
+private:
+    std::vector<std::array<QubitIndex, 1>> singleQubitOperands;
+    std::vector<std::array<QubitIndex, 2>> twoQubitOperands;
+    std::vector<DenseStateVector::SequenceGate> gates;
+};
+
+// Arguments: number of qubits, and whether the amplitudes are memory-mapped (1) or in RAM (0).
+void BM_DenseStateVector(benchmark::State &state) {
+    auto numberOfQubits = static_cast<std::size_t>(state.range(0));
+    bool mapped = state.range(1) != 0;
+    auto bytes = (std::size_t{1} << numberOfQubits) * sizeof(std::complex<double>);
+
+    if (!mapped && bytes > getPhysicalMemory()) {
+        state.SkipWithError("state vector does not fit in RAM");
+        return;
+    }
+
+    DenseStateVector victim(numberOfQubits, mapped ? getStateFilePath() : "");
+    for (auto _ : state) {
+        applyLayer(victim);
+    }
+
+    state.counters["block_swaps"] = static_cast<double>(victim.getNumberOfBlockSwaps());
+    state.counters["state_bytes"] = static_cast<double>(bytes);
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * bytes * (2 * numberOfQubits - 1)));
+}
+
+// Arguments: number of qubits, and whether the gates are applied one by one (0) or as one sequence (1),
+// whose gates on the low config::DENSE_TILE_QUBITS qubits then go through the state vector together.
+// Each gate sweep reads and writes all the amplitudes once.
+void BM_DenseStateVectorGateSequence(benchmark::State &state) {
+    auto numberOfQubits = static_cast<std::size_t>(state.range(0));
+    bool sequence = state.range(1) != 0;
+    auto bytes = (std::size_t{1} << numberOfQubits) * sizeof(std::complex<double>);
+
+    if (bytes > getPhysicalMemory()) {
+        state.SkipWithError("state vector does not fit in RAM");
+        return;
+    }
+
+    DenseStateVector victim(numberOfQubits);
+    Layer layer(numberOfQubits);
+    for (auto _ : state) {
+        if (sequence) {
+            victim.applySequence(layer.getGates());
+        } else {
+            applyLayer(victim);
+        }
+    }
+
+    auto gates = static_cast<double>(state.iterations() * layer.getGates().size());
+    auto sweeps = static_cast<double>(victim.getNumberOfGateSweeps());
+    state.counters["gate_sweeps"] = sweeps / static_cast<double>(state.iterations());
+    state.counters["bytes_per_gate"] = 2 * static_cast<double>(bytes) * sweeps / gates;
+    state.SetBytesProcessed(static_cast<std::int64_t>(2 * static_cast<double>(bytes) * sweeps));
+}
+
+// Arguments: number of qubits, whether the controlled X gates are applied as 8x8 TOFFOLI matrices (0)
+// or as X on the target where the controls are set (1), and number of controls (only 2 for TOFFOLI).
+void BM_DenseStateVectorControlled(benchmark::State &state) {
+    auto numberOfQubits = static_cast<std::size_t>(state.range(0));
+    bool controlled = state.range(1) != 0;
+    auto numberOfControls = static_cast<std::size_t>(state.range(2));
+
+    DenseStateVector victim(numberOfQubits);
+    std::vector<QubitIndex> controls;
+    for (std::size_t q = 0; q < numberOfControls; ++q) {
+        controls.push_back(QubitIndex{numberOfQubits - q - 1});
+    }
+    for (auto _ : state) {
+        for (std::size_t target = 0; target < 8; ++target) {
+            if (controlled) {
+                victim.applyControlled(gates::X, controls, QubitIndex{target});
+            } else {
+                victim.apply<3>(gates::TOFFOLI, std::array<QubitIndex, 3>{controls[0], controls[1], QubitIndex{target}});
+            }
+        }
+    }
+}
+
+}  // namespace
+
+BENCHMARK(BM_DenseStateVectorControlled)
+    ->ArgNames({"qubits", "controlled", "controls"})
+    ->Args({24, 0, 2})
+    ->Args({24, 1, 2})
+    ->Args({24, 1, 6})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+BENCHMARK(BM_DenseStateVectorGateSequence)
+    ->ArgNames({"qubits", "sequence"})
+    ->ArgsProduct({{16, 20, 24}, {0, 1}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+BENCHMARK(BM_DenseStateVector)
+    ->ArgNames({"qubits", "mapped"})
+    ->ArgsProduct({benchmark::CreateDenseRange(28, 32, 1), {0, 1}})
+    ->Iterations(1)
+    ->Unit(benchmark::kSecond)
+    ->UseRealTime();
+
+}  // namespace qx::core
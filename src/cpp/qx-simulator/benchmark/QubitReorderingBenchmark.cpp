@@ -0,0 +1,53 @@
+#include "qx/DenseStateVector.hpp"
+#include "qx/Gates.hpp"
+#include "qx/QubitReordering.hpp"
+
+#include <benchmark/benchmark.h>
+
+
+namespace qx {
+
+namespace {
+
+// Rotations cycling over all the qubits, followed by a CNOT ladder, with fewer in-block positions than qubits:
+// without hint, the least recently used in-block qubit is always the next one needed.
+Circuit getCircuit(std::size_t numberOfQubits, std::size_t layers) {
+    Circuit circuit;
+    for (std::size_t layer = 0; layer < layers; ++layer) {
+        for (std::size_t q = 0; q < numberOfQubits; ++q) {
+            circuit.addInstruction(Circuit::Unitary<1>{gates::RX(0.1 * static_cast<double>(layer + q)),
+                                                       {core::QubitIndex{q}}});
+        }
+        for (std::size_t q = 0; q + 1 < numberOfQubits; ++q) {
+            circuit.addInstruction(Circuit::Unitary<2>{gates::CNOT, {core::QubitIndex{q}, core::QubitIndex{q + 1}}});
+        }
+    }
+    return circuit;
+}
+
+// Arguments: number of qubits, number of in-block positions, and whether reorderQubits is applied (1) or not (0).
+void BM_QubitReordering(benchmark::State &state) {
+    auto numberOfQubits = static_cast<std::size_t>(state.range(0));
+    auto blockQubits = static_cast<std::size_t>(state.range(1));
+    bool reorder = state.range(2) != 0;
+
+    auto circuit = reorder ? reorderQubits(getCircuit(numberOfQubits, 4), blockQubits) : getCircuit(numberOfQubits, 4);
+
+    core::DenseStateVector victim(numberOfQubits, "", blockQubits);
+    for (auto _ : state) {
+        circuit.execute(victim, std::monostate{});
+    }
+
+    state.counters["block_swaps"] = static_cast<double>(victim.getNumberOfBlockSwaps()) /
+        static_cast<double>(state.iterations());
+}
+
+}  // namespace
+
+BENCHMARK(BM_QubitReordering)
+    ->ArgNames({"qubits", "block", "reorder"})
+    ->ArgsProduct({{20, 22}, {16}, {0, 1}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+}  // namespace qx
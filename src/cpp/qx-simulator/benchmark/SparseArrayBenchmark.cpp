@@ -0,0 +1,108 @@
+#include "qx/Circuit.hpp"
+#include "qx/Core.hpp"
+#include "qx/Gates.hpp"
+#include "qx/QuantumStatePool.hpp"
+
+#include <benchmark/benchmark.h>
+#include <vector>
+
+
+namespace qx {
+
+namespace {
+
+void addControlledX(Circuit &circuit, std::vector<core::QubitIndex> controls, std::size_t target) {
+    circuit.addInstruction(Circuit::ControlledUnitary{ std::move(controls), gates::X, core::QubitIndex{ target } });
+}
+
+// Ripple-carry adder b += a of two registers of bits qubits (Cuccaro et al.), after Hadamard gates on the superposed
+// low-order qubits of a and of b. All the gates of the adder are permutations of the basis vectors, so the state keeps
+// 4^superposed non-zero amplitudes, in a single group of qubits.
+// Qubit 0 is the carry in, qubits 1 + 2i and 2 + 2i are bit i of a and of b, and the last qubit is the carry out.
+Circuit getAdder(std::size_t bits, std::size_t superposed) {
+    auto a = [](std::size_t i) { return core::QubitIndex{ 1 + 2 * i }; };
+    auto b = [](std::size_t i) { return core::QubitIndex{ 2 + 2 * i }; };
+    auto carry = [&a](std::size_t i) { return i == 0 ? core::QubitIndex{ 0 } : a(i - 1); };
+
+    Circuit circuit;
+    for (std::size_t i = 0; i < superposed; ++i) {
+        circuit.addInstruction(Circuit::Unitary<1>{ gates::H, { a(i) } });
+        circuit.addInstruction(Circuit::Unitary<1>{ gates::H, { b(i) } });
+    }
+    for (std::size_t i = 0; i < bits; ++i) {
+        addControlledX(circuit, { a(i) }, b(i).value);
+        addControlledX(circuit, { a(i) }, carry(i).value);
+        addControlledX(circuit, { carry(i), b(i) }, a(i).value);
+    }
+    addControlledX(circuit, { a(bits - 1) }, 2 * bits + 1);
+    for (std::size_t i = bits; i-- > 0;) {
+        addControlledX(circuit, { carry(i), b(i) }, a(i).value);
+        addControlledX(circuit, { a(i) }, carry(i).value);
+        addControlledX(circuit, { carry(i) }, b(i).value);
+    }
+    return circuit;
+}
+
+// Arguments: number of bits of the adder, number of superposed qubits of each register,
+// and the sparse storage: hash map (0) or sorted array (1).
+void BM_SparseArrayAdder(benchmark::State &state) {
+    auto bits = static_cast<std::size_t>(state.range(0));
+    auto superposed = static_cast<std::size_t>(state.range(1));
+    auto storage = state.range(2) != 0 ? SparseStorage::SortedArray : SparseStorage::HashMap;
+
+    auto circuit = getAdder(bits, superposed);
+    core::QuantumState victim(2 * bits + 2, storage);
+    std::size_t numberOfAmplitudes = 0;
+    for (auto _ : state) {
+        victim.reset();
+        circuit.execute(victim, std::monostate{});
+        numberOfAmplitudes = 0;
+        victim.forEach([&numberOfAmplitudes](auto const &) { ++numberOfAmplitudes; });
+    }
+
+    state.counters["amplitudes"] = static_cast<double>(numberOfAmplitudes);
+}
+
+// Short jobs of a few shots each, as a service runs them: a new state per job, or a state borrowed from the pool.
+// Arguments: number of shots per job, number of superposed qubits of each register of the adder, and whether the state
+// is borrowed (1) or new (0). With 6 superposed qubits, the 4096 amplitudes take hash maps of more than 127 slots.
+void BM_ShortJobs(benchmark::State &state) {
+    auto shots = static_cast<std::size_t>(state.range(0));
+    auto superposed = static_cast<std::size_t>(state.range(1));
+    auto pooled = state.range(2) != 0;
+
+    auto circuit = getAdder(8, superposed);
+    circuit.addInstruction(Circuit::MeasureAll{});
+    for (auto _ : state) {
+        auto run = [&circuit, shots](core::QuantumState &victim) {
+            for (std::size_t shot = 0; shot < shots; ++shot) {
+                victim.reset();
+                circuit.execute(victim, std::monostate{});
+            }
+            benchmark::DoNotOptimize(victim.getMeasurementRegister());
+        };
+        if (pooled) {
+            run(*core::QuantumStatePool<double>::borrow(18));
+        } else {
+            core::QuantumState victim(18);
+            run(victim);
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+}  // namespace
+
+BENCHMARK(BM_ShortJobs)
+    ->ArgNames({"shots", "superposed", "pooled"})
+    ->ArgsProduct({{1, 10}, {3, 6}, {0, 1}})
+    ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK(BM_SparseArrayAdder)
+    ->ArgNames({"bits", "superposed", "sorted"})
+    ->ArgsProduct({{16}, {4, 8}, {0, 1}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+}  // namespace qx
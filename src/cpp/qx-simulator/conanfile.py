@@ -23,6 +23,7 @@ class QxConan(ConanFile):
         "shared": [True, False],
         "fPIC": [True, False],
         "asan_enabled": [True, False],
+        "build_benchmarks": [True, False],
         "build_python": [True, False],
         "build_tests": [True, False],
         "cpu_compatibility_mode": [True, False],
@@ -33,6 +34,7 @@ class QxConan(ConanFile):
         "shared": False,
         "fPIC": True,
         "asan_enabled": False,
+        "build_benchmarks": False,
         "build_python": False,
         "build_tests": False,
         "cpu_compatibility_mode": False,
@@ -40,7 +42,7 @@ class QxConan(ConanFile):
         "python_ext": None
     }
 
-    exports_sources = "CMakeLists.txt", "include/*", "python/*", "src/*", "tests/*"
+    exports_sources = "CMakeLists.txt", "benchmark/*", "include/*", "python/*", "src/*", "tests/*"
 
     def build_requirements(self):
         self.requires("abseil/20230125.3")
@@ -50,6 +52,8 @@ class QxConan(ConanFile):
             self.tool_requires("zulu-openjdk/11.0.19")
         if self.options.build_tests:
             self.requires("gtest/1.14.0")
+        if self.options.build_benchmarks:
+            self.requires("benchmark/1.8.3")
 
     def requirements(self):
         self.requires("antlr4-cppruntime/4.13.1")
@@ -82,6 +86,7 @@ class QxConan(ConanFile):
         deps.generate()
         tc = CMakeToolchain(self)
         tc.variables["ASAN_ENABLED"] = self.options.asan_enabled
+        tc.variables["QX_BUILD_BENCHMARKS"] = self.options.build_benchmarks
         tc.variables["QX_BUILD_PYTHON"] = self.options.build_python
         tc.variables["QX_BUILD_TESTS"] = self.options.build_tests
         tc.variables["QX_CPU_COMPATIBILITY_MODE"] = self.options.cpu_compatibility_mode
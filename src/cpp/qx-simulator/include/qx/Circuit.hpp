@@ -2,8 +2,12 @@
 
 #include "qx/Core.hpp"
 #include "qx/ErrorModels.hpp"
+#include "qx/UnitaryMatrix.hpp"
 
+#include <cstdint>  // uint64_t
+#include <functional>
 #include <optional>
+#include <span>
 #include <string>
 #include <vector>
 
@@ -26,43 +30,131 @@ public:
         std::function<void(BasisVector &)> operation;
     };
 
+    // Inserted by reorderQubits: the qubits, hottest first, that the next gates use the most.
+    // Only a dense state vector acts on it, by changing its qubit order. The quantum state is not changed.
+    struct QubitLayout {
+        std::vector<core::QubitIndex> hotQubits;
+    };
+
+    // Angle of a parametric gate, such as Rx, Ry, Rz and CR, with respect to which getGradients differentiates.
+    // The derivative of the gate is -i/2 generator times the gate, where the generator acts on the single operand,
+    // or on the target where all the controls are 1.
+    struct GateParameter {
+        core::GateMatrix<double, 2> generator{};
+    };
+
     template <std::size_t NumberOfOperands> struct Unitary {
         // Matrix is stored inline but could also be a pointer.
         core::DenseUnitaryMatrix<1 << NumberOfOperands> matrix{};
         std::array<core::QubitIndex, NumberOfOperands> operands{};
+        // Only for single-qubit gates.
+        std::optional<GateParameter> parameter{};
+    };
+
+    // Single-qubit gate on the target, applied where all the controls are 1, such as CNOT, CZ, CR and TOFFOLI.
+    // There can be any number of controls, and only the amplitudes whose control bits are all set are visited.
+    struct ControlledUnitary {
+        std::vector<core::QubitIndex> controls;
+        core::DenseUnitaryMatrix<2> matrix{ core::DenseUnitaryMatrix<2>::identity() };
+        core::QubitIndex target{};
+        std::optional<GateParameter> parameter{};
     };
 
+    // Every instruction is as large as the largest alternative, so three-qubit gates are controlled unitaries:
+    // an inline 8x8 matrix would triple the memory, and the loading time, of million-gate circuits.
     using Instruction =
-        std::variant<Measure, MeasureAll, PrepZ, MeasurementRegisterOperation,
-                     Unitary<1>, Unitary<2>, Unitary<3>>;
+        std::variant<Measure, MeasureAll, PrepZ, MeasurementRegisterOperation, QubitLayout,
+                     Unitary<1>, Unitary<2>, ControlledUnitary>;
 
-    struct ControlledInstruction {
-        ControlledInstruction(
-            Instruction instr,
-            std::shared_ptr<std::vector<core::QubitIndex>> ctrlB)
-            : instruction(std::move(instr)), controlBits(std::move(ctrlB)){};
+    // The instruction is executed when the bits of the measurement register selected by mask are equal to value.
+    struct ControlCondition {
+        BasisVector mask{};
+        BasisVector value{};
+    };
 
+    struct ControlledInstruction {
         Instruction instruction;
-        std::shared_ptr<std::vector<core::QubitIndex>> controlBits;
+        // Empty for unconditional instructions.
+        std::optional<ControlCondition> condition;
     };
 
+    // Expectation value of an observable, and its derivatives with respect to the angles of the parametric gates,
+    // in the order of the parametric instructions in the circuit.
+    struct Gradients {
+        double expectation = 0.;
+        std::vector<double> gradients;
+    };
+
+    // Called by executeBranching once per outcome branch, with its measurement register and its number of shots.
+    using BranchCallback = std::function<void(BasisVector measurementRegister, std::uint64_t shots)>;
+
     // We could in the future add loops and if/else...
 
     explicit Circuit(std::string name = "", std::size_t iterations = 1)
         : name(std::move(name)), iterations(iterations) {}
 
-    void
-    addInstruction(Instruction instruction,
-                   std::shared_ptr<std::vector<core::QubitIndex>> controlBits) {
-        controlledInstructions.emplace_back(std::move(instruction), std::move(controlBits));
+    // Not inline: GCC reports a false -Wmaybe-uninitialized when it inlines the move of a ControlledUnitary into the
+    // vector, for any instruction.
+    void addInstruction(Instruction instruction);
+
+    void addInstruction(ControlledInstruction controlledInstruction);
+
+    // The instruction is only executed when all the control bits are set in the measurement register.
+    void addInstruction(Instruction instruction, std::vector<core::QubitIndex> const &controlBits);
+
+    // Explicitly instantiated for core::BasicQuantumState, core::BasicDenseStateVector and
+    // core::BasicDistributedStateVector, in float and double.
+    template <typename State>
+    void execute(State &quantumState, error_models::ErrorModel const &errorModel) const;
+
+    // Runs all the shots together: at each measurement, the state is split into its outcome branches, and the shots
+    // are shared between them with a binomial draw. Each branch then runs once, however many shots it has.
+    // quantumState ends in the state of the last branch, which has the most shots at each split.
+    // Only for the sparse core::BasicQuantumState, which is cheap to copy, and without error model.
+    // Explicitly instantiated for float and double.
+    template <typename T>
+    void executeBranching(core::BasicQuantumState<T> &quantumState, std::uint64_t shots,
+                          BranchCallback const &callback) const;
+
+    // Overall unitary of the circuit, which can only end with measurements, since they are ignored.
+    // Blocks of columns go through all the gates at once, on all hardware threads.
+    // Throws std::runtime_error for resets, classical control and measurements followed by other instructions,
+    // and beyond config::MAX_UNITARY_QUBITS qubits.
+    [[nodiscard]] core::UnitaryMatrix getUnitary(std::size_t numberOfQubits) const;
+
+    // Expectation value of the observable, a sum of Pauli terms, in the final state of the circuit from |0...0>,
+    // together with its gradients, by the adjoint method: one pass forward over the gates, and one pass backward that
+    // undoes each gate on the state and on the observable applied to it, whatever the number of parameters.
+    // A parametric instruction repeated over several iterations gets the sum of the derivatives of its repetitions.
+    // Runs on dense state vectors in RAM. Measurements at the end are ignored.
+    // Throws std::runtime_error for the same circuits as getUnitary, for invalid Pauli terms,
+    // and beyond config::MAX_GRADIENT_QUBITS qubits.
+    [[nodiscard]] Gradients getGradients(std::size_t numberOfQubits,
+                                         std::span<core::PauliTerm const> observable) const;
+
+    [[nodiscard]] std::string getName() const { return name; }
+
+    [[nodiscard]] std::size_t getIterations() const { return iterations; }
+
+    [[nodiscard]] std::size_t getNumberOfInstructions() const { return controlledInstructions.size(); }
+
+    [[nodiscard]] std::vector<ControlledInstruction> const &getControlledInstructions() const {
+        return controlledInstructions;
     }
 
-    void execute(core::QuantumState &quantumState,
-                 error_models::ErrorModel const &errorModel) const;
+    // Upper bound of log2 of the number of non-zero amplitudes of a sparse quantum state during a shot, starting from
+    // at most 2^initialQubits of them. Each gate multiplies that number by at most the largest number of non-zero
+    // entries in a column of its matrix, while measurements and resets are taken as not reducing it.
+    [[nodiscard]] std::size_t getMaxAmplitudeQubits(std::size_t numberOfQubits, std::size_t initialQubits = 0) const;
 
-    [[nodiscard]] std::string getName() const { return name; }
+    // Qubits that are measured by at least one instruction, whether that instruction is executed or not.
+    [[nodiscard]] std::vector<std::size_t> getMeasuredQubits(std::size_t numberOfQubits) const;
 
 private:
+    // Gates of a circuit that can only end with measurements, for one iteration.
+    // Throws std::runtime_error otherwise, with what naming the result that cannot be computed.
+    [[nodiscard]] std::vector<Instruction const *> getGatesBeforeMeasurements(std::string const &what) const;
+
     std::vector<ControlledInstruction> controlledInstructions;
     std::string const name;
     std::size_t const iterations = 1;
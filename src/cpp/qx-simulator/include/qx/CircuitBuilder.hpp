@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>  // size_t
+#include <memory>  // shared_ptr
+#include <optional>
+#include <string>
+#include <vector>
+
+
+namespace qx {
+
+class Circuit;
+
+// Builds a circuit instruction by instruction, for callers that already hold the gates in memory, and runs it with
+// executeCircuit, without printing cQASM text for the parser to read back.
+// Gates are those of cQASM 3.0, with the same names and operands: for instance, addGate("CNOT", {0, 1}) or
+// addGate("Rx", {2}, 0.5). Qubit operands are single qubits, not registers.
+// An invalid instruction is not added, and the builder then keeps its first error: executeCircuit returns it as
+// a SimulationError, so that a whole batch of circuits can be built before checking them.
+class CircuitBuilder {
+public:
+    explicit CircuitBuilder(std::size_t numberOfQubits);
+
+    [[nodiscard]] std::size_t getNumberOfQubits() const { return numberOfQubits; }
+
+    // The parameter is the angle of Rx, Ry, Rz and CR, or the integer k of CRk.
+    // With control bits, the gate only runs when all those bits of the measurement register are 1, that is, when
+    // the last measurements of those qubits gave 1.
+    CircuitBuilder &addGate(std::string const &name, std::vector<std::size_t> const &qubits,
+                            std::optional<double> parameter = std::nullopt,
+                            std::vector<std::size_t> const &controlBits = {});
+
+    CircuitBuilder &addMeasure(std::size_t qubit);
+
+    CircuitBuilder &addMeasureAll();
+
+    // Resets the qubit to |0>.
+    CircuitBuilder &addReset(std::size_t qubit);
+
+    [[nodiscard]] std::optional<std::string> const &getError() const { return error; }
+
+    // The circuit built so far. It is not changed by later additions, which go to a copy, so that it can keep
+    // running in the background.
+    [[nodiscard]] std::shared_ptr<Circuit const> getCircuit() const { return circuit; }
+
+private:
+    // Returns false, and keeps the error, if a qubit is out of range or repeated.
+    bool checkQubits(std::vector<std::size_t> const &qubits, bool distinct);
+
+    Circuit &getCircuitToChange();
+
+    std::size_t numberOfQubits = 0;
+    std::shared_ptr<Circuit> circuit;
+    std::optional<std::string> error;
+};
+
+}  // namespace qx
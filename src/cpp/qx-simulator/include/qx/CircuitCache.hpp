@@ -0,0 +1,81 @@
+#pragma once
+
+#include "qx/Circuit.hpp"
+
+#include "absl/container/flat_hash_map.h"
+#include <cstddef>  // size_t
+#include <cstdint>  // uint64_t
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+
+
+namespace qx {
+
+struct CircuitCacheStatistics {
+    std::uint64_t hits = 0;
+    std::uint64_t misses = 0;
+    std::uint64_t evictions = 0;
+    std::size_t entries = 0;
+    std::size_t bytes = 0;
+    std::size_t maxBytes = 0;
+};
+
+// In-process LRU cache of compiled circuits, keyed by a hash of the cQASM source text and version.
+// The footprint of the cache is bounded by maxBytes, estimated from the source text and the number of instructions.
+// All member functions are thread-safe.
+class CircuitCache {
+public:
+    struct Entry {
+        std::shared_ptr<Circuit const> circuit;
+        std::size_t qubitCount = 0;
+    };
+
+    explicit CircuitCache(std::size_t maxBytes = config::CIRCUIT_CACHE_MAX_BYTES) : maxBytes(maxBytes) {}
+
+    CircuitCache(CircuitCache const &) = delete;
+
+    void operator=(CircuitCache const &) = delete;
+
+    // The process-wide cache used by executeString.
+    static CircuitCache &getInstance();
+
+    [[nodiscard]] std::optional<Entry> find(std::string const &source, std::string const &version);
+
+    void insert(std::string const &source, std::string const &version, Entry entry);
+
+    void clear();
+
+    // A maximum of 0 disables caching altogether.
+    void setMaxBytes(std::size_t m);
+
+    [[nodiscard]] CircuitCacheStatistics getStatistics() const;
+
+private:
+    struct Node {
+        std::size_t hash = 0;
+        std::string source;
+        std::string version;
+        Entry entry;
+        std::size_t bytes = 0;
+    };
+
+    using Lru = std::list<Node>;
+
+    static std::size_t getHash(std::string const &source, std::string const &version);
+
+    void evict(std::size_t targetBytes);
+
+    mutable std::mutex mutex;
+    Lru lru;  // Most recently used first.
+    absl::flat_hash_map<std::size_t, Lru::iterator> index;
+    std::size_t maxBytes = 0;
+    std::size_t bytes = 0;
+    std::uint64_t hits = 0;
+    std::uint64_t misses = 0;
+    std::uint64_t evictions = 0;
+};
+
+}  // namespace qx
@@ -6,8 +6,12 @@
 
 namespace qx::config {
 
+// Epsilon for the comparison of amplitudes, per floating-point precision
+template <typename T> inline constexpr T EPSILON = 0.000000000001;
+template <> inline constexpr float EPSILON<float> = 0.000001f;
+
 // Epsilon for double comparison
-static constexpr double EPS = 0.000000000001;
+static constexpr double EPS = EPSILON<double>;
 
 // Number of decimals in output
 static constexpr std::uint64_t const OUTPUT_DECIMALS = 8;
@@ -21,4 +25,49 @@ static constexpr std::uint64_t ZERO_CYCLE_SIZE = 100;
 // used based on the runtime number of qubits.
 static constexpr std::size_t MAX_QUBIT_NUMBER = 64;
 
+// Number of low-order qubits whose amplitudes are processed together, as one block,
+// by a dense state vector stored in a memory-mapped file
+static constexpr std::size_t MAPPED_DENSE_BLOCK_QUBITS = 24;
+
+// Number of low-order qubits whose amplitudes form one tile of a dense state vector (256 KiB in double precision).
+// Consecutive gates on qubits stored in these bits are applied one tile at a time, which then stays in the L2 cache.
+static constexpr std::size_t DENSE_TILE_QUBITS = 14;
+
+// Maximum number of qubits of a marginal distribution, which has 2^n entries
+static constexpr std::size_t MAX_MARGINAL_QUBITS = 24;
+
+// Minimum number of amplitudes per thread when a dense state vector is queried in parallel
+static constexpr std::size_t MIN_AMPLITUDES_PER_QUERY_THREAD = 1 << 20;
+
+// Maximum number of processes among which a distributed dense state vector is partitioned
+static constexpr std::size_t MAX_DISTRIBUTED_RANKS = 64;
+
+// Number of gates over which the qubit usage is counted by the qubit-reordering pass for the dense backend
+static constexpr std::size_t QUBIT_REORDERING_WINDOW = 64;
+
+// Maximum number of qubits of a circuit whose unitary is computed, which has 4^n entries (256 MiB for 12 qubits)
+static constexpr std::size_t MAX_UNITARY_QUBITS = 12;
+
+// Number of entries of the blocks of columns of a unitary that go through the whole circuit at once,
+// so that they stay in cache from one gate to the next
+static constexpr std::size_t UNITARY_BLOCK_ENTRIES = 1 << 14;
+
+// Maximum number of qubits of a circuit whose gradients are computed, on two dense state vectors in RAM
+// (8 GiB for 28 qubits)
+static constexpr std::size_t MAX_GRADIENT_QUBITS = 28;
+
+// Maximum number of free sparse quantum states kept by each thread for its next simulations, per precision
+static constexpr std::size_t QUANTUM_STATE_POOL_SIZE = 4;
+
+// Maximum bytes of amplitude containers that a state keeps when it is returned to the pool, so that an idle pool does
+// not hold on to the memory of an occasional large simulation. What is kept is charged to the memory budget of the next
+// simulation, or freed if it does not fit (8 MiB, about 300000 double amplitudes in hash maps)
+static constexpr std::uint64_t POOLED_AMPLITUDES_MAX_BYTES = 8 << 20;
+
+// Number of bytes of shot records that are buffered before they are written to SimulationOptions::shot_record_file
+static constexpr std::size_t SHOT_RECORD_CHUNK_BYTES = 1 << 20;
+
+// Default memory budget of the compiled-circuit cache used by executeString
+static constexpr std::size_t CIRCUIT_CACHE_MAX_BYTES = 64 * 1024 * 1024;
+
 }  // namespace qx::config
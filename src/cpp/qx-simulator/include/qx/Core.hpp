@@ -1,22 +1,29 @@
 #pragma once
 
 #include "absl/container/flat_hash_map.h"
+#include <algorithm>  // max
 #include <cassert>
 #include <complex>
 #include <limits>
+#include <span>
+#include <string>
+#include <utility>  // exchange
+#include <vector>
 
 #include "qx/Common.hpp"
 #include "qx/CompileTimeConfiguration.hpp"
+#include "qx/SimulationOptions.hpp"
 
 
 namespace qx::core {
 
-inline constexpr bool isNotNull(std::complex<double> c) {
+template <typename T>
+inline constexpr bool isNotNull(std::complex<T> c) {
 #if defined(_MSC_VER)
-    return c.real() > config::EPS || -c.real() > config::EPS ||
-           c.imag() > config::EPS || -c.imag() > config::EPS;
+    return c.real() > config::EPSILON<T> || -c.real() > config::EPSILON<T> ||
+           c.imag() > config::EPSILON<T> || -c.imag() > config::EPSILON<T>;
 #else
-    return std::abs(c.real()) > config::EPS || std::abs(c.imag()) > config::EPS;
+    return std::abs(c.real()) > config::EPSILON<T> || std::abs(c.imag()) > config::EPSILON<T>;
 #endif
 }
 
@@ -42,6 +49,12 @@ public:
     explicit constexpr DenseUnitaryMatrix(Matrix const &m)
         : DenseUnitaryMatrix(m, true) {}
 
+    // Skips the unitarity check, a full matrix product, for matrices that are unitary by construction,
+    // such as the rotations of any angle in gates.
+    static constexpr DenseUnitaryMatrix<N> fromUnitary(Matrix const &m) {
+        return DenseUnitaryMatrix(m, false);
+    }
+
     [[nodiscard]] inline constexpr const std::complex<double>& at(std::size_t i, std::size_t j) const {
         return matrix[i][j];
     }
@@ -100,52 +113,183 @@ private:
     std::array<std::array<std::complex<double>, N>, N> const matrix;
 };
 
-class QuantumState;
+// Entries of a gate matrix, in the precision of the amplitudes the gate is applied to.
+template <typename T, std::size_t N>
+using GateMatrix = std::array<std::array<std::complex<T>, N>, N>;
+
+template <typename T, std::size_t N>
+GateMatrix<T, N> toGateMatrix(DenseUnitaryMatrix<N> const &m) {
+    GateMatrix<T, N> result;
+    for (std::size_t i = 0; i < N; ++i) {
+        for (std::size_t j = 0; j < N; ++j) {
+            result[i][j] = static_cast<std::complex<T>>(m.at(i, j));
+        }
+    }
+    return result;
+}
+
+// Largest number of non-zero entries in a column of the matrix, that is of amplitudes that the gate produces from a
+// single one: 1 for permutations and diagonal gates, 2 for a Hadamard gate.
+template <std::size_t N>
+std::size_t getMaxNonZerosPerColumn(DenseUnitaryMatrix<N> const &matrix) {
+    std::size_t result = 1;
+    for (std::size_t j = 0; j < N; ++j) {
+        std::size_t nonZeros = 0;
+        for (std::size_t i = 0; i < N; ++i) {
+            nonZeros += isNotNull(matrix.at(i, j)) ? 1 : 0;
+        }
+        result = std::max(result, nonZeros);
+    }
+    return result;
+}
+
+template <typename T> class BasicQuantumState;
+struct Snapshot;
+
+// Throws std::runtime_error unless the qubits can be queried for their marginal probabilities.
+void checkMarginalQubits(std::span<QubitIndex const> qubits, std::size_t numberOfQubits);
+
+// Term of an observable: a real coefficient times a tensor product of Pauli operators, one of I, X, Y and Z per qubit,
+// with qubit 0 on the right. For instance, "ZIX" is X on qubit 0 and Z on qubit 2.
+struct PauliTerm {
+    double coefficient = 1.;
+    std::string paulis;
+};
+
+// Throws std::runtime_error unless the term has one Pauli operator per qubit.
+void checkPauliTerm(PauliTerm const &term, std::size_t numberOfQubits);
+
+// Bytes taken by the amplitudes of the quantum states that report to it, such as the branches of
+// Circuit::executeBranching, and the peak of their total. See SimulationOptions::max_memory_bytes.
+// Not thread-safe: the states of a simulation all run on the same thread.
+class MemoryTracker {
+public:
+    // A budget of 0 means no budget.
+    explicit MemoryTracker(std::uint64_t b = 0) : budget(b) {}
+
+    [[nodiscard]] std::uint64_t getBudget() const { return budget; }
+
+    [[nodiscard]] std::uint64_t getBytes() const { return bytes; }
 
-class SparseArray {
+    [[nodiscard]] std::uint64_t getPeakBytes() const { return peakBytes; }
+
+    // A state that took oldBytes now takes newBytes.
+    // Throws std::runtime_error, and leaves the total unchanged, if the total would then exceed the budget.
+    void update(std::uint64_t oldBytes, std::uint64_t newBytes);
+
+    // Throws std::runtime_error if the total would exceed the budget once it grows by the bytes, without counting them.
+    void check(std::uint64_t addedBytes) const;
+
+private:
+    std::uint64_t const budget = 0;
+    std::uint64_t bytes = 0;
+    std::uint64_t peakBytes = 0;
+};
+
+// Amplitudes are std::complex<T>, with T either float or double.
+// The non-zero amplitudes are kept either in a hash map or in a sorted array, see SparseStorage.
+template <typename T> class BasicSparseArray {
 public:
-    using Map = absl::flat_hash_map<BasisVector, std::complex<double>>;
-    using Iterator = Map::const_iterator;
+    using Map = absl::flat_hash_map<BasisVector, std::complex<T>>;
+    using SortedArray = std::vector<std::pair<BasisVector, std::complex<T>>>;
+
+    BasicSparseArray() = delete;
 
-    SparseArray() = delete;
+    explicit BasicSparseArray(std::size_t s, SparseStorage st = SparseStorage::HashMap) : size(s), storage(st){};
 
-    explicit SparseArray(std::size_t s) : size(s){};
+    // The scratch amplitudes are left out: only their allocation matters, and copies are made to be run on,
+    // by Circuit::executeBranching.
+    BasicSparseArray(BasicSparseArray const &other)
+        : size(other.size), storage(other.storage), zeroCounter(other.zeroCounter), data(other.data),
+          sortedData(other.sortedData) {}
+
+    BasicSparseArray(BasicSparseArray &&) = default;
+
+    BasicSparseArray &operator=(BasicSparseArray const &) = default;
+
+    BasicSparseArray &operator=(BasicSparseArray &&) = default;
+
+    // Bytes allocated for the amplitudes, from the capacity of the containers.
+    [[nodiscard]] std::uint64_t getMemoryBytes() const;
+
+    // Upper bound of the bytes allocated while a gate produces that many amplitudes, which includes the amplitudes
+    // before the gate and, for a sorted array, the runs that are merged. Saturates at the largest std::uint64_t.
+    [[nodiscard]] static std::uint64_t getMaxMemoryBytes(std::uint64_t numberOfAmplitudes, SparseStorage storage);
 
     [[nodiscard]] std::size_t getSize() const { return size; }
 
-    [[nodiscard]] std::vector<std::complex<double>> testToVector() const {
-        std::vector<std::complex<double>> result(getSize(), 0);
+    // Number of amplitudes stored, including the zeros that are not cleaned up yet.
+    [[nodiscard]] std::size_t getNumberOfStoredAmplitudes() const {
+        return storage == SparseStorage::SortedArray ? sortedData.size() : data.size();
+    }
 
-        for (auto const &kv : *this) {
-            result[kv.first.toSizeT()] = kv.second;
-        }
+    [[nodiscard]] SparseStorage getStorage() const { return storage; }
+
+    [[nodiscard]] std::vector<std::complex<T>> testToVector() const {
+        std::vector<std::complex<T>> result(getSize(), 0);
+
+        visit([&result](auto const &amplitudes) {
+            for (auto const &kv : amplitudes) {
+                result[kv.first.toSizeT()] = kv.second;
+            }
+        });
 
         return result;
     }
 
-    [[nodiscard]] Iterator begin() const { return data.cbegin(); }
+    // Calls f with the container of the amplitudes, a Map or a SortedArray, which holds (basis vector, amplitude)
+    // pairs either way. Only the sorted array iterates in the order of the basis vectors.
+    template <typename F> void visit(F &&f) const {
+        if (storage == SparseStorage::SortedArray) {
+            f(sortedData);
+        } else {
+            f(data);
+        }
+    }
+
+    template <typename F> void visit(F &&f) {
+        if (storage == SparseStorage::SortedArray) {
+            f(sortedData);
+        } else {
+            f(data);
+        }
+    }
 
-    [[nodiscard]] Iterator end() const { return data.cend(); }
+    // Returns 0 for a basis vector that is not stored.
+    [[nodiscard]] std::complex<T> get(BasisVector index) const;
 
-    void set(BasisVector index, std::complex<double> value);
+    void set(BasisVector index, std::complex<T> value);
 
-    void clear() { data.clear(); }
+    void clear() {
+        clearKeepingAllocation(data);
+        clearKeepingAllocation(scratch);
+        sortedData.clear();
+        zeroCounter = 0;
+    }
+
+    // Frees the containers, in turn, that would take the bytes kept beyond maxBytes, see getMemoryBytes.
+    // Only meant for cleared amplitudes.
+    void shrink(std::uint64_t maxBytes);
 
-    SparseArray &operator*=(double d) {
-        std::for_each(data.begin(), data.end(),
-                      [d](auto &kv) { kv.second *= d; });
+    BasicSparseArray &operator*=(double d) {
+        visit([d](auto &amplitudes) {
+            std::for_each(amplitudes.begin(), amplitudes.end(), [d](auto &kv) { kv.second *= static_cast<T>(d); });
+        });
         return *this;
     }
 
     template <typename F> void forEach(F &&f) {
         cleanupZeros();
-        std::for_each(data.begin(), data.end(), f);
+        visit([&f](auto &amplitudes) { std::for_each(amplitudes.begin(), amplitudes.end(), f); });
     }
 
     template <typename F> void forEachSorted(F &&f) {
         cleanupZeros();
-        std::vector<std::pair<BasisVector, std::complex<double>>> sorted(
-            data.begin(), data.end());
+        if (storage == SparseStorage::SortedArray) {
+            std::for_each(sortedData.begin(), sortedData.end(), f);
+            return;
+        }
+        SortedArray sorted(data.begin(), data.end());
         std::sort(sorted.begin(), sorted.end(),
                   [](auto const &left, auto const &right) {
                       return left.first < right.first;
@@ -153,62 +297,163 @@ public:
         std::for_each(sorted.begin(), sorted.end(), f);
     }
 
-    template <typename F> void eraseIf(F &&pred) { absl::erase_if(data, pred); }
+    template <typename F> void eraseIf(F &&pred) {
+        if (storage == SparseStorage::SortedArray) {
+            std::erase_if(sortedData, pred);
+        } else {
+            absl::erase_if(data, pred);
+        }
+    }
 
 private:
-    friend QuantumState;
+    friend BasicQuantumState<T>;
 
-    // Let f build a new SparseArray to replace *this, assuming f is linear.
+    // Replaces the amplitudes by these ones, which can be in any order.
+    void assign(SortedArray amplitudes);
+
+    // Hash map only: lets f build a new Map to replace the amplitudes, assuming f is linear.
     template <typename F> void applyLinear(F &&f) {
+        assert(storage == SparseStorage::HashMap);
+
         // Every ZERO_CYCLE_SIZE gates, cleanup the 0s
         if (zeroCounter >= config::ZERO_CYCLE_SIZE) {
             cleanupZeros();
         }
         ++zeroCounter;
 
-        Map result;
-
+        scratch.clear();
+        scratch.reserve(data.size());
         for (auto const &kv : data) {
-            f(kv.first, kv.second, result);
+            f(kv.first, kv.second, scratch);
         }
 
-        data.swap(result);
+        data.swap(scratch);
     }
 
+    // Sorted array only: applies the gate to the operands of the basis vectors in which all the bits of controlMask
+    // are set, and keeps the other ones as is. This is a linear merge, see Core.cpp.
+    template <std::size_t NumberOfOperands>
+    void applySorted(GateMatrix<T, 1 << NumberOfOperands> const &matrix,
+                     std::array<QubitIndex, NumberOfOperands> const &operands, BasisVector controlMask);
+
     void cleanupZeros();
 
-    std::size_t const size = 0;
+    // absl's clear() frees the tables of more than 127 slots, whereas erasing all the amplitudes keeps the table for
+    // the next ones to reuse.
+    static void clearKeepingAllocation(Map &map) { map.erase(map.begin(), map.end()); }
+
+    std::size_t size = 0;
+    SparseStorage storage = SparseStorage::HashMap;
     std::uint64_t zeroCounter = 0;
     Map data;
+    // Hash map only: the amplitudes before the last gate, whose allocation the next gate reuses.
+    Map scratch;
+    SortedArray sortedData;
 };
 
-class QuantumState {
+using SparseArray = BasicSparseArray<double>;
+
+// The quantum state is factorized into disjoint groups of qubits, each with its own sparse amplitudes.
+// Qubits that were never operated on are in state |0> and do not belong to any group.
+// Groups are merged (tensor product) only when a multi-qubit gate spans them, and a measured qubit
+// is split off from its group, since it is then in a product state with the rest.
+// Amplitudes are std::complex<T>, with T either float or double.
+template <typename T> class BasicQuantumState {
 public:
-    explicit QuantumState(std::size_t n)
-        : numberOfQubits(n), data(1 << numberOfQubits) {
+    explicit BasicQuantumState(std::size_t n, SparseStorage s = SparseStorage::HashMap)
+        : numberOfQubits(n), storage(s), groupIndices(n, NO_GROUP) {
         assert(numberOfQubits > 0 && "QuantumState needs at least one qubit");
         assert(numberOfQubits <= config::MAX_QUBIT_NUMBER &&
                "QuantumState currently cannot support that many qubits with this version of QX-simulator");
-        data.set(BasisVector{}, 1);  // Start initialized in state 00...000
     };
 
+    // A copy reports its own bytes to the same MemoryTracker, and throws like a gate if they exceed the budget.
+    // The spare amplitudes are not copied.
+    BasicQuantumState(BasicQuantumState const &other)
+        : numberOfQubits(other.numberOfQubits), storage(other.storage), groups(other.groups),
+          groupIndices(other.groupIndices), measurementRegister(other.measurementRegister),
+          memoryTracker(other.memoryTracker) {
+        updateMemoryBytes();
+    }
+
+    // The moved-from state is left in state 00...000, without tracker. The bytes stay with the same tracker.
+    BasicQuantumState(BasicQuantumState &&other)
+        : numberOfQubits(other.numberOfQubits), storage(other.storage), groups(std::move(other.groups)),
+          spareAmplitudes(std::move(other.spareAmplitudes)),
+          groupIndices(std::exchange(other.groupIndices, std::vector<std::size_t>(other.numberOfQubits, NO_GROUP))),
+          measurementRegister(std::exchange(other.measurementRegister, BasisVector{})),
+          memoryTracker(std::exchange(other.memoryTracker, nullptr)), trackedBytes(std::exchange(other.trackedBytes, 0)),
+          groupsChanged(other.groupsChanged) {
+        other.groups.clear();
+        other.spareAmplitudes.clear();
+    }
+
+    // The number of qubits and the storage are fixed, and a tracker is shared by copies, which assignment would break.
+    BasicQuantumState &operator=(BasicQuantumState const &) = delete;
+
+    BasicQuantumState &operator=(BasicQuantumState &&) = delete;
+
+    ~BasicQuantumState() { setMemoryTracker(nullptr); }
+
+    // The state reports the bytes of its amplitudes to the tracker after each gate, and throws std::runtime_error
+    // when they exceed its budget. nullptr detaches the state from its tracker.
+    // Spare amplitudes that do not fit in what is left of the budget are freed rather than charged.
+    void setMemoryTracker(MemoryTracker *tracker);
+
+    // Bytes allocated for the amplitudes, spare ones included, see BasicSparseArray::getMemoryBytes.
+    [[nodiscard]] std::uint64_t getMemoryBytes() const;
+
     [[nodiscard]] std::size_t getNumberOfQubits() const { return numberOfQubits; }
 
+    [[nodiscard]] std::size_t getNumberOfQubitGroups() const { return groups.size(); }
+
+    [[nodiscard]] SparseStorage getSparseStorage() const { return storage; }
+
+    // Back to state 00...000. The amplitudes of the groups are kept aside, cleared, for the next groups to reuse
+    // their allocations, see QuantumStatePool.
     void reset() {
-        data.clear();
-        data.set(BasisVector{}, 1);  // Start initialized in state 00...000
+        for (auto &group : groups) {
+            recycleAmplitudes(group.amplitudes);
+        }
+        groups.clear();
+        std::fill(groupIndices.begin(), groupIndices.end(), NO_GROUP);
         measurementRegister.reset();
     }
 
+    // Frees the containers of the spare amplitudes that would take the bytes kept beyond maxBytes,
+    // see QuantumStatePool.
+    void shrinkSpareAmplitudes(std::uint64_t maxBytes = config::POOLED_AMPLITUDES_MAX_BYTES);
+
     void testInitialize(
         std::initializer_list<std::pair<std::string, std::complex<double>>> values);
 
+    [[nodiscard]] Snapshot getSnapshot();
+
+    // Replaces the state, which ends up as a single group, by the snapshot.
+    // Throws std::runtime_error if the snapshot does not fit this state.
+    void restore(Snapshot const &snapshot);
+
     template <std::size_t NumberOfOperands>
-    QuantumState &
+    BasicQuantumState &
     apply(DenseUnitaryMatrix<1 << NumberOfOperands> const &m,
           std::array<QubitIndex, NumberOfOperands> const &operands);
 
-    template <typename F> void forEach(F &&f) { data.forEachSorted(f); }
+    // Applies the single-qubit gate to the target where all the controls are 1. The other amplitudes are kept as is.
+    BasicQuantumState &applyControlled(DenseUnitaryMatrix<2> const &m, std::span<QubitIndex const> controls,
+                                       QubitIndex target);
+
+    // Iterates over the non-zero amplitudes of the joint state, sorted by basis vector.
+    template <typename F> void forEach(F &&f) {
+        auto sorted = getSortedJointState();
+        std::for_each(sorted.begin(), sorted.end(), f);
+    }
+
+    // Amplitude of a basis vector of the joint state, looked up in each group.
+    [[nodiscard]] std::complex<T> getAmplitude(BasisVector basisVector) const;
+
+    // Probabilities of the 2^k outcomes of measuring the k qubits, without collapsing the state.
+    // Bit i of an outcome is the value of qubits[i]. Throws std::runtime_error, see checkMarginalQubits.
+    [[nodiscard]] std::vector<double> getMarginalProbabilities(std::span<QubitIndex const> qubits) const;
 
     [[nodiscard]] BasisVector getMeasurementRegister() const { return measurementRegister; }
 
@@ -217,89 +462,101 @@ public:
     template <typename F>
     void measure(QubitIndex qubitIndex, F &&randomGenerator) {
         auto rand = randomGenerator();
-        double probabilityOfMeasuringOne = 0.;
-
-        data.forEach([qubitIndex, &probabilityOfMeasuringOne](auto const &kv) {
-            if (kv.first.test(qubitIndex.value)) {
-                probabilityOfMeasuringOne += std::norm(kv.second);
-            }
-        });
+        double probabilityOfMeasuringOne = getProbabilityOfMeasuringOne(qubitIndex);
 
         if (rand < probabilityOfMeasuringOne) {
-            data.eraseIf([qubitIndex](auto const &kv) {
-                return !kv.first.test(qubitIndex.value);
-            });
-            data *= std::sqrt(1 / probabilityOfMeasuringOne);
+            collapse(qubitIndex, true, probabilityOfMeasuringOne, false);
             measurementRegister.set(qubitIndex.value, true);
         } else {
-            data.eraseIf([qubitIndex](auto const &kv) {
-                return kv.first.test(qubitIndex.value);
-            });
-            data *= std::sqrt(1 / (1 - probabilityOfMeasuringOne));
+            collapse(qubitIndex, false, 1 - probabilityOfMeasuringOne, false);
             measurementRegister.set(qubitIndex.value, false);
         }
     }
 
     template <typename F> void measureAll(F &&randomGenerator) {
-        auto rand = randomGenerator();
-        double probability = 0.;
-
-        auto measuredState = std::invoke([this, &probability, rand] {
-            for (auto const &kv :
-                 data) { // Does this work with non-ordered iteration?
-                probability += std::norm(kv.second);
-                if (probability > rand) {
-                    return kv;
-                }
-            }
-            throw std::runtime_error(
-                "Vector was not normalized at measurement location (a bug)");
-        });
-
-        data.clear();
-        data.set(measuredState.first,
-                 measuredState.second / std::abs(measuredState.second));
-        measurementRegister = measuredState.first;
+        measurementRegister = collapseAll(randomGenerator());
     }
 
     template <typename F>
     void prep(QubitIndex qubitIndex, F &&randomGenerator) {
         // Measure + conditional X, and reset the measurement register.
         auto rand = randomGenerator();
-        double probabilityOfMeasuringOne = 0.;
-
-        data.forEach([qubitIndex, &probabilityOfMeasuringOne](auto const &kv) {
-            if (kv.first.test(qubitIndex.value)) {
-                probabilityOfMeasuringOne += std::norm(kv.second);
-            }
-        });
+        double probabilityOfMeasuringOne = getProbabilityOfMeasuringOne(qubitIndex);
 
         if (rand < probabilityOfMeasuringOne) {
-            data.eraseIf([qubitIndex](auto const &kv) {
-                return !kv.first.test(qubitIndex.value);
-            });
-            SparseArray::Map newData;
-            for (auto kv : data.data) {
-                auto newKey = kv.first;
-                newKey.set(qubitIndex.value, false);
-                newData.insert(std::make_pair(
-                    newKey,
-                    kv.second * std::sqrt(1 / probabilityOfMeasuringOne)));
-            }
-            data.data = newData; // Could fix the interface
+            collapse(qubitIndex, true, probabilityOfMeasuringOne, true);
         } else {
-            data.eraseIf([qubitIndex](auto const &kv) {
-                return kv.first.test(qubitIndex.value);
-            });
-            data *= std::sqrt(1 / (1 - probabilityOfMeasuringOne));
+            collapse(qubitIndex, false, 1 - probabilityOfMeasuringOne, true);
         }
         measurementRegister.set(qubitIndex.value, false);
     };
 
+    [[nodiscard]] double getProbabilityOfMeasuringOne(QubitIndex qubitIndex) const;
+
+    // Quantum jump of amplitude damping: the qubit decays from |1> to |0>. The measurement register is unchanged.
+    void decay(QubitIndex qubitIndex, double probabilityOfMeasuringOne) {
+        collapse(qubitIndex, true, probabilityOfMeasuringOne, true);
+    }
+
+    // No-jump evolution of amplitude damping: the |1> part of the qubit is damped by sqrt(1 - gamma),
+    // and the state is renormalized.
+    void dampWithoutDecay(QubitIndex qubitIndex, double gamma, double probabilityOfMeasuringOne);
+
 private:
+    static constexpr std::size_t NO_GROUP = std::numeric_limits<std::size_t>::max();
+
+    struct QubitGroup {
+        BasisVector qubits;
+        BasicSparseArray<T> amplitudes;
+        // The basis vectors are stored with these bits flipped. This is how a measured qubit is reset to |0>,
+        // or split off with outcome 1, without rewriting (and rehashing) all the basis vectors of the group.
+        // Always 0 for a sorted array, whose order it would break: the bit is cleared in place instead.
+        BasisVector flippedBits{};
+    };
+
+    // Returns the index of the group holding all the operands, merging groups as needed.
+    std::size_t mergeGroups(std::span<QubitIndex const> operands);
+
+    std::size_t tensorProduct(std::size_t left, std::size_t right);
+
+    // Moves the last group in place of the erased one.
+    void eraseGroup(std::size_t groupIndex);
+
+    // Empty amplitudes for a new group, from the spare ones if any.
+    BasicSparseArray<T> takeAmplitudes();
+
+    void recycleAmplitudes(BasicSparseArray<T> &amplitudes);
+
+    void updateMemoryBytes();
+
+    // The bytes only change when groups were created, merged or erased, see groupsChanged, or when the containers of
+    // the group of the gate grew.
+    void updateMemoryBytesAfterGate(BasicSparseArray<T> const &amplitudes, std::uint64_t bytesBefore);
+
+    // Throws std::runtime_error before a gate that produces at most nonZerosPerColumn amplitudes from each one of the
+    // group, if the amplitudes it could produce would exceed the budget of the memory tracker. This stops a gate that
+    // would grow the amplitudes far beyond the budget before it allocates them.
+    void checkMemoryBytesBeforeGate(QubitGroup const &group, std::size_t nonZerosPerColumn) const;
+
+    void collapse(QubitIndex qubitIndex, bool outcome, double probabilityOfOutcome, bool resetToZero);
+
+    BasisVector collapseAll(double rand);
+
+    [[nodiscard]] std::vector<std::pair<BasisVector, std::complex<T>>> getSortedJointState();
+
     std::size_t const numberOfQubits = 1;
-    SparseArray data;
+    SparseStorage const storage = SparseStorage::HashMap;
+    std::vector<QubitGroup> groups;
+    std::vector<BasicSparseArray<T>> spareAmplitudes;
+    std::vector<std::size_t> groupIndices;
     BasisVector measurementRegister{};
+    MemoryTracker *memoryTracker = nullptr;
+    // Bytes last reported to memoryTracker.
+    std::uint64_t trackedBytes = 0;
+    // Whether amplitudes were taken or recycled since the bytes were last reported.
+    bool groupsChanged = false;
 };
 
+using QuantumState = BasicQuantumState<double>;
+
 }  // namespace qx::core
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "qx/Circuit.hpp"
+
+#include <cstdint>  // uint8_t
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+
+namespace qx {
+
+// Gates of cQASM 3.0 that the simulator supports, shared by the cQASM importer and CircuitBuilder.
+enum class CqasmGateId : std::uint8_t {
+    I, X, Y, Z, H, S, Sdag, T, Tdag, X90, mX90, Y90, mY90, Rx, Ry, Rz, CNOT, CZ, CR, CRk, SWAP, TOFFOLI
+};
+
+// By cQASM name, such as "CNOT". A single hash lookup.
+[[nodiscard]] std::optional<CqasmGateId> findCqasmGate(std::string_view name);
+
+// Gate with its parameter, whose matrix is computed once, and can then be added on any qubits:
+// the cQASM importer binds each statement once, however many qubits its registers broadcast it to.
+class BoundCqasmGate {
+public:
+    // The parameter is the angle of Rx, Ry, Rz and CR, or the integer k of CRk.
+    // Throws std::runtime_error for a missing, unexpected or non-integer parameter.
+    BoundCqasmGate(CqasmGateId id, std::optional<double> parameter);
+
+    [[nodiscard]] std::size_t getNumberOfQubits() const { return numberOfQubits; }
+
+    // The qubit operands are in cQASM order: for controlled gates, the controls come first.
+    // The gate is only executed when all the control bits are set in the measurement register.
+    // Throws std::runtime_error for the wrong number of qubits.
+    void addTo(Circuit &circuit, std::span<core::QubitIndex const> qubits,
+               std::vector<core::QubitIndex> const &controlBits = {}) const;
+
+private:
+    CqasmGateId id;
+    std::size_t numberOfQubits;
+    // Operands are set by addTo.
+    std::variant<Circuit::Unitary<1>, Circuit::Unitary<2>, Circuit::ControlledUnitary> prototype;
+};
+
+// Adds one gate, by cQASM name, on single qubits: registers are broadcast by the caller.
+// Throws std::runtime_error for unknown gates, and as BoundCqasmGate.
+void addCqasmGate(Circuit &circuit, std::string const &name, std::span<core::QubitIndex const> qubits,
+                  std::optional<double> parameter = std::nullopt,
+                  std::vector<core::QubitIndex> const &controlBits = {});
+
+}  // namespace qx
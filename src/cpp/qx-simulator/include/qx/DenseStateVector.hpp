@@ -0,0 +1,276 @@
+#pragma once
+
+#include "qx/Core.hpp"
+
+#include <complex>
+#include <cstddef>  // size_t
+#include <cstdint>  // uint64_t
+#include <optional>
+#include <span>
+#include <string>
+#include <utility>  // pair
+#include <variant>
+#include <vector>
+
+
+namespace qx::core {
+
+// Storage for the amplitudes of a dense state vector, either in RAM or in a memory-mapped file.
+// Memory-mapped files are only supported on POSIX systems.
+template <typename T> class AmplitudeBuffer {
+public:
+    explicit AmplitudeBuffer(std::size_t size, std::string const &filePath = "");
+
+    AmplitudeBuffer(AmplitudeBuffer const &) = delete;
+
+    AmplitudeBuffer &operator=(AmplitudeBuffer const &) = delete;
+
+    ~AmplitudeBuffer();
+
+    [[nodiscard]] std::size_t getSize() const { return size; }
+
+    [[nodiscard]] bool isMapped() const { return mapped != nullptr; }
+
+    [[nodiscard]] std::complex<T> *data() { return isMapped() ? mapped : inMemory.data(); }
+
+    [[nodiscard]] std::complex<T> const *data() const { return isMapped() ? mapped : inMemory.data(); }
+
+    // Sets all amplitudes to 0.
+    void zero();
+
+private:
+    std::size_t size = 0;
+    std::vector<std::complex<T>> inMemory;
+    std::complex<T> *mapped = nullptr;
+    int fileDescriptor = -1;
+};
+
+// Dense state vector over all 2^n basis vectors, processed in blocks of 2^blockQubits consecutive amplitudes.
+// Gates are only ever applied to qubits that are stored in the low-order (in-block) bits of the amplitude index:
+// when a gate operates on a qubit stored in a high-order bit, a block-swap pass first exchanges that bit with
+// the least recently used in-block bit. This turns all gate passes into sequential block sweeps,
+// which is what makes the memory-mapped storage practical beyond the size of RAM.
+// Amplitudes are std::complex<T>, with T either float or double.
+template <typename T> class BasicDenseStateVector {
+public:
+    // Gate of a sequence given to applySequence. The matrix and operands are not copied.
+    template <std::size_t NumberOfOperands> struct GateReference {
+        DenseUnitaryMatrix<1 << NumberOfOperands> const &matrix;
+        std::array<QubitIndex, NumberOfOperands> const &operands;
+    };
+
+    // Controlled gate of a sequence, see applyControlled.
+    struct ControlledGateReference {
+        DenseUnitaryMatrix<2> const &matrix;
+        std::span<QubitIndex const> controls;
+        QubitIndex target;
+    };
+
+    using SequenceGate =
+        std::variant<GateReference<1>, GateReference<2>, GateReference<3>, ControlledGateReference>;
+
+    // Amplitudes are kept in RAM if filePath is empty, and in a memory-mapped file at filePath otherwise.
+    // The file must not exist yet, otherwise std::runtime_error is thrown. It is created and unlinked right away,
+    // so that its space is freed when the DenseStateVector is destroyed.
+    // By default, blocks span the whole state in RAM, and config::MAPPED_DENSE_BLOCK_QUBITS for a memory-mapped file.
+    explicit BasicDenseStateVector(std::size_t n, std::string const &filePath = "",
+                                   std::optional<std::size_t> blockQubits = std::nullopt);
+
+    [[nodiscard]] std::size_t getNumberOfQubits() const { return numberOfQubits; }
+
+    [[nodiscard]] std::size_t getBlockQubits() const { return blockQubits; }
+
+    [[nodiscard]] bool isMapped() const { return amplitudes.isMapped(); }
+
+    // Position of each qubit in the amplitude index.
+    [[nodiscard]] std::vector<std::size_t> const &getQubitOrder() const { return qubitPositions; }
+
+    [[nodiscard]] std::uint64_t getNumberOfBlockSwaps() const { return numberOfBlockSwaps; }
+
+    // Number of passes of gates over the whole state vector, each reading and writing all the amplitudes once.
+    [[nodiscard]] std::uint64_t getNumberOfGateSweeps() const { return numberOfGateSweeps; }
+
+    // Hint that the qubits, hottest first, are the most used by the next gates, see reorderQubits.
+    // As many of them as fit are moved in block, and the other qubits are evicted first when a block swap is needed.
+    // This only changes the qubit order, not the state. Without memory-mapped file, all qubits are in block.
+    void setHotQubits(std::span<QubitIndex const> qubits);
+
+    void reset();
+
+    void testInitialize(
+        std::initializer_list<std::pair<std::string, std::complex<double>>> values);
+
+    [[nodiscard]] Snapshot getSnapshot() const;
+
+    // Replaces the state by the snapshot. The qubit order is kept.
+    // Throws std::runtime_error if the snapshot does not fit this state.
+    void restore(Snapshot const &snapshot);
+
+    template <std::size_t NumberOfOperands>
+    BasicDenseStateVector &
+    apply(DenseUnitaryMatrix<1 << NumberOfOperands> const &m,
+          std::array<QubitIndex, NumberOfOperands> const &operands);
+
+    // Applies the single-qubit gate to the target where all the controls are 1, and only visits those amplitudes.
+    // Only the target needs to be in block: controls stored in high-order bits select whole blocks.
+    BasicDenseStateVector &applyControlled(DenseUnitaryMatrix<2> const &m, std::span<QubitIndex const> controls,
+                                           QubitIndex target);
+
+    // Same as applying the gates one by one. Runs of consecutive gates whose operands are all stored in the low
+    // config::DENSE_TILE_QUBITS bits of the amplitude index are applied together, one tile of amplitudes at a time,
+    // so that the whole run costs a single pass over the state vector instead of one pass per gate.
+    // For controlled gates, this only applies to the target.
+    void applySequence(std::span<SequenceGate const> gates);
+
+    // Iterates over the non-zero amplitudes, sorted by basis vector.
+    template <typename F> void forEach(F &&f) {
+        auto sorted = getSortedNonZeroAmplitudes();
+        std::for_each(sorted.begin(), sorted.end(), f);
+    }
+
+    [[nodiscard]] std::complex<T> getAmplitude(BasisVector basisVector) const;
+
+    // Probabilities of the 2^k outcomes of measuring the k qubits, without collapsing the state.
+    // Bit i of an outcome is the value of qubits[i]. Large state vectors are summed up by several threads.
+    // Throws std::runtime_error, see checkMarginalQubits.
+    [[nodiscard]] std::vector<double> getMarginalProbabilities(std::span<QubitIndex const> qubits) const;
+
+    // The next three methods combine this state with another one over the same qubits in the same qubit order,
+    // such as two state vectors in RAM that went through the same gates.
+
+    // <this|other>.
+    [[nodiscard]] std::complex<double> innerProduct(BasicDenseStateVector const &other) const;
+
+    // <this|G|other>, where G is the 2x2 matrix m on the target where all the controls are 1, and 0 elsewhere.
+    [[nodiscard]] std::complex<double> getMatrixElement(BasicDenseStateVector const &other,
+                                                        GateMatrix<double, 2> const &m,
+                                                        std::span<QubitIndex const> controls, QubitIndex target) const;
+
+    // Replaces this state by the sum of the Pauli terms applied to the other state, which is not normalized anymore.
+    // The terms must have one operator per qubit, see checkPauliTerm.
+    void setToPauliSum(BasicDenseStateVector const &other, std::span<PauliTerm const> observable);
+
+    [[nodiscard]] BasisVector getMeasurementRegister() const { return measurementRegister; }
+
+    BasisVector &getMeasurementRegister() { return measurementRegister; }
+
+    template <typename F>
+    void measure(QubitIndex qubitIndex, F &&randomGenerator) {
+        auto rand = randomGenerator();
+        double probabilityOfMeasuringOne = getProbabilityOfMeasuringOne(qubitIndex);
+
+        if (rand < probabilityOfMeasuringOne) {
+            collapse(qubitIndex, true, probabilityOfMeasuringOne, false);
+            measurementRegister.set(qubitIndex.value, true);
+        } else {
+            collapse(qubitIndex, false, 1 - probabilityOfMeasuringOne, false);
+            measurementRegister.set(qubitIndex.value, false);
+        }
+    }
+
+    template <typename F> void measureAll(F &&randomGenerator) {
+        measurementRegister = collapseAll(randomGenerator());
+    }
+
+    template <typename F>
+    void prep(QubitIndex qubitIndex, F &&randomGenerator) {
+        // Measure + conditional X, and reset the measurement register.
+        auto rand = randomGenerator();
+        double probabilityOfMeasuringOne = getProbabilityOfMeasuringOne(qubitIndex);
+
+        if (rand < probabilityOfMeasuringOne) {
+            collapse(qubitIndex, true, probabilityOfMeasuringOne, true);
+        } else {
+            collapse(qubitIndex, false, 1 - probabilityOfMeasuringOne, true);
+        }
+        measurementRegister.set(qubitIndex.value, false);
+    }
+
+    [[nodiscard]] double getProbabilityOfMeasuringOne(QubitIndex qubitIndex) const;
+
+    // Quantum jump of amplitude damping: the qubit decays from |1> to |0>. The measurement register is unchanged.
+    void decay(QubitIndex qubitIndex, double probabilityOfMeasuringOne) {
+        collapse(qubitIndex, true, probabilityOfMeasuringOne, true);
+    }
+
+    // No-jump evolution of amplitude damping: the |1> part of the qubit is damped by sqrt(1 - gamma),
+    // and the state is renormalized.
+    void dampWithoutDecay(QubitIndex qubitIndex, double gamma, double probabilityOfMeasuringOne);
+
+private:
+    // Blocks always leave room for all the operands of a gate.
+    static constexpr std::size_t MAX_NUMBER_OF_OPERANDS = 3;
+
+    // Gate whose operands are in block, ready to be applied to any tile that holds all their positions.
+    template <std::size_t NumberOfOperands> struct PreparedGate {
+        GateMatrix<T, 1 << NumberOfOperands> matrix{};
+        // Offsets of the amplitudes mixed by the gate, in the order of the matrix columns.
+        std::array<std::size_t, 1 << NumberOfOperands> offsets{};
+        std::array<std::size_t, NumberOfOperands> sortedPositions{};
+    };
+
+    struct PreparedControlledGate {
+        GateMatrix<T, 2> matrix{};
+        std::size_t targetBit = 0;
+        std::size_t controlMask = 0;
+        // Positions of the controls and of the target.
+        std::vector<std::size_t> sortedPositions;
+    };
+
+    using AnyPreparedGate = std::variant<PreparedGate<1>, PreparedGate<2>, PreparedGate<3>, PreparedControlledGate>;
+
+    [[nodiscard]] std::size_t getNumberOfBlocks() const { return amplitudes.getSize() >> blockQubits; }
+
+    // Makes sure the qubit is stored in an in-block bit, without evicting any of the other operand positions.
+    void moveInBlock(QubitIndex qubitIndex, std::uint64_t &operandPositions);
+
+    void swapPositions(std::size_t highPosition, std::size_t lowPosition);
+
+    // Moves the operands in block, and counts the gate.
+    template <std::size_t NumberOfOperands>
+    PreparedGate<NumberOfOperands> prepare(DenseUnitaryMatrix<1 << NumberOfOperands> const &m,
+                                           std::array<QubitIndex, NumberOfOperands> const &operands);
+
+    PreparedControlledGate prepare(ControlledGateReference const &gate);
+
+    // Applies the gate to the size amplitudes from tile, where size is above all the operand positions.
+    template <std::size_t NumberOfOperands>
+    static void applyToTile(PreparedGate<NumberOfOperands> const &gate, std::complex<T> *tile, std::size_t size);
+
+    // Same for the size amplitudes from index start, where size is only above the target position.
+    static void applyToTile(PreparedControlledGate const &gate, std::complex<T> *tile, std::size_t size,
+                            std::size_t start);
+
+    template <std::size_t NumberOfOperands>
+    void addToSequence(GateReference<NumberOfOperands> const &gate, std::vector<AnyPreparedGate> &tiledGates);
+
+    void addToSequence(ControlledGateReference const &gate, std::vector<AnyPreparedGate> &tiledGates);
+
+    // Applies the gates, one tile at a time, and clears them.
+    void applyTiled(std::vector<AnyPreparedGate> &tiledGates);
+
+    [[nodiscard]] BasisVector toBasisVector(std::size_t index) const;
+
+    [[nodiscard]] std::size_t toIndex(BasisVector basisVector) const;
+
+    void collapse(QubitIndex qubitIndex, bool outcome, double probabilityOfOutcome, bool resetToZero);
+
+    BasisVector collapseAll(double rand);
+
+    [[nodiscard]] std::vector<std::pair<BasisVector, std::complex<T>>> getSortedNonZeroAmplitudes() const;
+
+    std::size_t const numberOfQubits = 1;
+    std::size_t const blockQubits = 1;
+    AmplitudeBuffer<T> amplitudes;
+    std::vector<std::size_t> qubitPositions;
+    std::vector<std::uint64_t> lastUses;  // Per in-block position.
+    std::uint64_t numberOfGates = 0;
+    std::uint64_t numberOfBlockSwaps = 0;
+    std::uint64_t numberOfGateSweeps = 0;
+    BasisVector hotQubits{};
+    BasisVector measurementRegister{};
+};
+
+using DenseStateVector = BasicDenseStateVector<double>;
+
+}  // namespace qx::core
@@ -0,0 +1,185 @@
+#pragma once
+
+#include "qx/Core.hpp"
+#include "qx/Snapshot.hpp"
+
+#include <algorithm>  // for_each
+#include <array>
+#include <complex>
+#include <cstddef>  // size_t
+#include <cstdint>  // uint64_t
+#include <span>
+#include <sys/types.h>  // pid_t
+#include <utility>  // pair
+#include <vector>
+
+
+namespace qx::core {
+
+// Dense state vector over all 2^n basis vectors, partitioned among numberOfRanks local processes, a power of two.
+// The amplitudes are in one segment of POSIX shared memory, mapped into all the processes, and rank r owns the slice of
+// the 2^localQubits amplitudes whose high-order (global) index bits are r.
+// Rank 0 is the calling process, and the other ranks are worker processes forked by the constructor, which apply each
+// command to their own slice between two process-shared barriers.
+// Gates are only ever applied to qubits stored in local bits, so that each rank can work on its slice independently:
+// as with the blocks of core::BasicDenseStateVector, a qubit stored in a global bit is first exchanged with the least
+// recently used local bit. In this exchange, each pair of ranks that differ in that global bit swaps half of their
+// amplitudes, directly in shared memory. Controls stored in global bits select whole ranks, without exchange.
+// Only supported on Linux. Amplitudes are std::complex<T>, with T either float or double.
+template <typename T> class BasicDistributedStateVector {
+public:
+    // Throws std::runtime_error if numberOfRanks is not a power of two of at most config::MAX_DISTRIBUTED_RANKS, if it
+    // leaves less than 2 local qubits, or if the shared memory or the worker processes cannot be created.
+    BasicDistributedStateVector(std::size_t n, std::size_t numberOfRanks);
+
+    BasicDistributedStateVector(BasicDistributedStateVector const &) = delete;
+
+    BasicDistributedStateVector &operator=(BasicDistributedStateVector const &) = delete;
+
+    // Stops the worker processes, and releases the shared memory.
+    ~BasicDistributedStateVector();
+
+    [[nodiscard]] std::size_t getNumberOfQubits() const { return numberOfQubits; }
+
+    [[nodiscard]] std::size_t getNumberOfRanks() const { return numberOfRanks; }
+
+    [[nodiscard]] std::size_t getLocalQubits() const { return localQubits; }
+
+    // Position of each qubit in the amplitude index.
+    [[nodiscard]] std::vector<std::size_t> const &getQubitOrder() const { return qubitPositions; }
+
+    // Number of exchanges of a global bit with a local bit, each moving half of the amplitudes between ranks.
+    [[nodiscard]] std::uint64_t getNumberOfSliceExchanges() const { return numberOfSliceExchanges; }
+
+    // Hint that the qubits, hottest first, are the most used by the next gates, see reorderQubits.
+    // As many of them as fit are moved to local bits, and the other qubits are evicted first when an exchange is needed.
+    void setHotQubits(std::span<QubitIndex const> qubits);
+
+    void reset();
+
+    [[nodiscard]] Snapshot getSnapshot() const;
+
+    // Replaces the state by the snapshot. The qubit order is kept.
+    // Throws std::runtime_error if the snapshot does not fit this state.
+    void restore(Snapshot const &snapshot);
+
+    template <std::size_t NumberOfOperands>
+    BasicDistributedStateVector &apply(DenseUnitaryMatrix<1 << NumberOfOperands> const &m,
+                                       std::array<QubitIndex, NumberOfOperands> const &operands);
+
+    // Applies the single-qubit gate to the target where all the controls are 1, and only visits those amplitudes.
+    BasicDistributedStateVector &applyControlled(DenseUnitaryMatrix<2> const &m, std::span<QubitIndex const> controls,
+                                                 QubitIndex target);
+
+    // Iterates over the non-zero amplitudes, sorted by basis vector.
+    template <typename F> void forEach(F &&f) {
+        auto sorted = getSortedNonZeroAmplitudes();
+        std::for_each(sorted.begin(), sorted.end(), f);
+    }
+
+    [[nodiscard]] std::complex<T> getAmplitude(BasisVector basisVector) const;
+
+    // Probabilities of the 2^k outcomes of measuring the k qubits, without collapsing the state.
+    // Bit i of an outcome is the value of qubits[i]. Throws std::runtime_error, see checkMarginalQubits.
+    [[nodiscard]] std::vector<double> getMarginalProbabilities(std::span<QubitIndex const> qubits) const;
+
+    [[nodiscard]] BasisVector getMeasurementRegister() const { return measurementRegister; }
+
+    BasisVector &getMeasurementRegister() { return measurementRegister; }
+
+    template <typename F>
+    void measure(QubitIndex qubitIndex, F &&randomGenerator) {
+        auto rand = randomGenerator();
+        double probabilityOfMeasuringOne = getProbabilityOfMeasuringOne(qubitIndex);
+
+        if (rand < probabilityOfMeasuringOne) {
+            collapse(qubitIndex, true, probabilityOfMeasuringOne, false);
+            measurementRegister.set(qubitIndex.value, true);
+        } else {
+            collapse(qubitIndex, false, 1 - probabilityOfMeasuringOne, false);
+            measurementRegister.set(qubitIndex.value, false);
+        }
+    }
+
+    template <typename F> void measureAll(F &&randomGenerator) {
+        measurementRegister = collapseAll(randomGenerator());
+    }
+
+    template <typename F>
+    void prep(QubitIndex qubitIndex, F &&randomGenerator) {
+        // Measure + conditional X, and reset the measurement register.
+        auto rand = randomGenerator();
+        double probabilityOfMeasuringOne = getProbabilityOfMeasuringOne(qubitIndex);
+
+        if (rand < probabilityOfMeasuringOne) {
+            collapse(qubitIndex, true, probabilityOfMeasuringOne, true);
+        } else {
+            collapse(qubitIndex, false, 1 - probabilityOfMeasuringOne, true);
+        }
+        measurementRegister.set(qubitIndex.value, false);
+    }
+
+    [[nodiscard]] double getProbabilityOfMeasuringOne(QubitIndex qubitIndex) const;
+
+    // Quantum jump of amplitude damping: the qubit decays from |1> to |0>. The measurement register is unchanged.
+    void decay(QubitIndex qubitIndex, double probabilityOfMeasuringOne) {
+        collapse(qubitIndex, true, probabilityOfMeasuringOne, true);
+    }
+
+    // No-jump evolution of amplitude damping: the |1> part of the qubit is damped by sqrt(1 - gamma),
+    // and the state is renormalized.
+    void dampWithoutDecay(QubitIndex qubitIndex, double gamma, double probabilityOfMeasuringOne);
+
+private:
+    // In shared memory: the barriers, the current command and the partial sums of the ranks. See the source file.
+    struct SharedControl;
+
+    struct Command;
+
+    [[nodiscard]] std::size_t getSliceSize() const { return static_cast<std::size_t>(1) << localQubits; }
+
+    // Runs the command on all the ranks, this process being rank 0, and waits until they are all done.
+    void run(Command const &command) const;
+
+    // Loop of the worker processes, which exit on the Exit command.
+    [[noreturn]] void serve(std::size_t rank) const;
+
+    static void execute(Command const &command, std::complex<T> *amplitudes, std::size_t localQubits, std::size_t rank,
+                        double &partial);
+
+    // Makes sure the qubit is stored in a local bit, without evicting any of the other operand positions.
+    void moveLocal(QubitIndex qubitIndex, std::uint64_t &operandPositions);
+
+    // Exchanges the global bit with the local bit, in all the ranks at once.
+    void swapPositions(std::size_t globalPosition, std::size_t localPosition);
+
+    // Stops the worker processes, and unmaps the shared memory.
+    void release();
+
+    [[nodiscard]] BasisVector toBasisVector(std::size_t index) const;
+
+    [[nodiscard]] std::size_t toIndex(BasisVector basisVector) const;
+
+    void collapse(QubitIndex qubitIndex, bool outcome, double probabilityOfOutcome, bool resetToZero);
+
+    BasisVector collapseAll(double rand);
+
+    [[nodiscard]] std::vector<std::pair<BasisVector, std::complex<T>>> getSortedNonZeroAmplitudes() const;
+
+    std::size_t const numberOfQubits = 1;
+    std::size_t const numberOfRanks = 1;
+    std::size_t const localQubits = 1;
+    SharedControl *control = nullptr;
+    std::complex<T> *amplitudes = nullptr;
+    std::vector<pid_t> workers;
+    std::vector<std::size_t> qubitPositions;
+    std::vector<std::uint64_t> lastUses;  // Per local position.
+    std::uint64_t numberOfGates = 0;
+    std::uint64_t numberOfSliceExchanges = 0;
+    BasisVector hotQubits{};
+    BasisVector measurementRegister{};
+};
+
+using DistributedStateVector = BasicDistributedStateVector<double>;
+
+}  // namespace qx::core
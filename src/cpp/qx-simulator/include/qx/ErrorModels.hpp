@@ -1,8 +1,14 @@
 #pragma once
 
 #include "qx/Core.hpp"
+#include "qx/Random.hpp"
 
+#include <algorithm>  // max
+#include <cstdint>  // uint64_t
+#include <optional>
+#include <span>
 #include <variant>
+#include <vector>
 
 
 namespace qx {
@@ -17,13 +23,85 @@ public:
         assert(0. <= p && p <= 1.);
     }
 
-    void addError(qx::core::QuantumState &quantumState) const;
+    // Explicitly instantiated for core::BasicQuantumState, core::BasicDenseStateVector and
+    // core::BasicDistributedStateVector, in float and double.
+    template <typename State>
+    void addError(State &quantumState) const;
 
 private:
     double probability = 0.;
 };
 
-using ErrorModel = std::variant<DepolarizingChannel, std::monostate>;
+// Amplitude damping (T1 decay) of the operands of every gate, simulated with quantum trajectories.
+// Each operand decays to |0> with probability gamma times its probability of being |1>; otherwise, the no-jump
+// evolution damps its |1> part. Candidate decays happen with probability gamma per operand, and the number of operands
+// until the next one is sampled directly, so random numbers are only drawn for candidate decays.
+class AmplitudeDampingChannel {
+public:
+    explicit AmplitudeDampingChannel(double g) : gamma(g) {
+        assert(0. <= g && g <= 1.);
+    }
+
+    // Explicitly instantiated for core::BasicQuantumState, core::BasicDenseStateVector and
+    // core::BasicDistributedStateVector, in float and double.
+    template <typename State>
+    void addError(State &quantumState, std::span<core::QubitIndex const> operands) const;
+
+private:
+    double gamma = 0.;
+    // Per trajectory, this is why the error model is created for each simulation.
+    mutable std::optional<std::uint64_t> operandsUntilCandidateDecay;
+};
+
+using ErrorModel = std::variant<DepolarizingChannel, AmplitudeDampingChannel, std::monostate>;
+
+// Measured bits are read wrongly, independently from each other, as a post-processing of the measurement histogram.
+class ReadoutError {
+public:
+    ReadoutError(double zeroToOne, double oneToZero)
+        : probabilityOfZeroToOne(zeroToOne), probabilityOfOneToZero(oneToZero) {
+        assert(0. <= zeroToOne && zeroToOne <= 1.);
+        assert(0. <= oneToZero && oneToZero <= 1.);
+    }
+
+    // Calls add(readState, count) with the states read in shots that all measured the same state.
+    // Only the bits of the measured qubits can be read wrongly. Candidate errors happen with the largest of the two
+    // probabilities per bit, and the number of bits until the next one is sampled directly,
+    // so that the cost is proportional to the number of errors rather than to the number of shots.
+    template <typename F>
+    void addReadStates(BasisVector measuredState, std::uint64_t count,
+                       std::vector<std::size_t> const &measuredQubits, F &&add) const {
+        auto probabilityOfCandidate = std::max(probabilityOfZeroToOne, probabilityOfOneToZero);
+        auto numberOfBits = count * measuredQubits.size();
+        auto shotsWithoutError = count;
+
+        auto bitIndex = probabilityOfCandidate > 0. ? random::randomGeometric(probabilityOfCandidate) : numberOfBits;
+        while (bitIndex < numberOfBits) {
+            auto shot = bitIndex / measuredQubits.size();
+            auto readState = measuredState;
+            for (; bitIndex < numberOfBits && bitIndex / measuredQubits.size() == shot;
+                 bitIndex += 1 + random::randomGeometric(probabilityOfCandidate)) {
+                auto qubit = measuredQubits[bitIndex % measuredQubits.size()];
+                auto probability = measuredState.test(qubit) ? probabilityOfOneToZero : probabilityOfZeroToOne;
+                if (random::randomZeroOneDouble() * probabilityOfCandidate <= probability) {
+                    readState.set(qubit, !measuredState.test(qubit));
+                }
+            }
+            if (!(readState == measuredState)) {
+                --shotsWithoutError;
+                add(readState, 1);
+            }
+        }
+
+        if (shotsWithoutError > 0) {
+            add(measuredState, shotsWithoutError);
+        }
+    }
+
+private:
+    double probabilityOfZeroToOne = 0.;
+    double probabilityOfOneToZero = 0.;
+};
 
 template <typename ErrorModelDef>
 ErrorModel getErrorModel(ErrorModelDef errorModelDef) {
@@ -31,6 +109,11 @@ ErrorModel getErrorModel(ErrorModelDef errorModelDef) {
         return std::monostate();
     }
 
+    if (errorModelDef->name == "amplitude_damping") {
+        return AmplitudeDampingChannel(
+            errorModelDef->parameters[0]->as_const_real()->value);
+    }
+
     if (errorModelDef->name != "depolarizing_channel") {
         throw std::runtime_error("Unknown error model!");
     }
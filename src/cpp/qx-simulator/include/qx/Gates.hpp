@@ -10,6 +10,8 @@ template <std::size_t N> using UnitaryMatrix = core::DenseUnitaryMatrix<N>;
 using namespace std::complex_literals;
 
 // All those matrices can currently be constexpr with GCC, but not Clang.
+// The rotations are unitary for any angle, and skip the unitarity check, which would otherwise run for every
+// parametric gate of a circuit.
 
 #if !defined(_MSC_VER) && !defined(__clang__)
 #define __CONSTEXPR__ constexpr
@@ -38,7 +40,7 @@ static __CONSTEXPR__ UnitaryMatrix<2>
 static __CONSTEXPR__ UnitaryMatrix<2> TDAG = T.dagger();
 
 static __CONSTEXPR__ UnitaryMatrix<2> RX(double theta) {
-    return UnitaryMatrix<2>(
+    return UnitaryMatrix<2>::fromUnitary(
         {{{std::cos(theta / 2), -1i * std::sin(theta / 2)},
           {-1i * std::sin(theta / 2), std::cos(theta / 2)}}});
 }
@@ -47,7 +49,7 @@ static __CONSTEXPR__ auto X90 = RX(PI / 2);
 static __CONSTEXPR__ auto MX90 = RX(-PI / 2);
 
 static __CONSTEXPR__ UnitaryMatrix<2> RY(double theta) {
-    return UnitaryMatrix<2>({{{std::cos(theta / 2), -std::sin(theta / 2)},
+    return UnitaryMatrix<2>::fromUnitary({{{std::cos(theta / 2), -std::sin(theta / 2)},
                               {std::sin(theta / 2), std::cos(theta / 2)}}});
 }
 
@@ -55,7 +57,7 @@ static __CONSTEXPR__ auto Y90 = RY(PI / 2);
 static __CONSTEXPR__ auto MY90 = RY(-PI / 2);
 
 static __CONSTEXPR__ UnitaryMatrix<2> RZ(double theta) {
-    return UnitaryMatrix<2>(
+    return UnitaryMatrix<2>::fromUnitary(
         {{{std::cos(theta / 2) - 1i * std::sin(theta / 2), 0},
           {0, std::cos(theta / 2) + 1i * std::sin(theta / 2)}}});
 }
@@ -66,6 +68,25 @@ static __CONSTEXPR__ auto MZ90 = RZ(-PI / 2);
 static __CONSTEXPR__ UnitaryMatrix<2>
     H({{{1 / SQRT_2, 1 / SQRT_2}, {1 / SQRT_2, -1 / SQRT_2}}});
 
+// Phase shift of |1>, the target gate of CR.
+static __CONSTEXPR__ UnitaryMatrix<2> PHASE(double theta) {
+    return UnitaryMatrix<2>::fromUnitary({{{1, 0}, {0, std::cos(theta) + 1i * std::sin(theta)}}});
+}
+
+// Generator G of each rotation R(theta) above, such that dR/dtheta = -i/2 G R(theta), see Circuit::GateParameter.
+// Not unitary in general, hence plain gate matrices.
+static __CONSTEXPR__ core::GateMatrix<double, 2> RX_GENERATOR{ { { { { 0, 0 }, { 1, 0 } } },
+                                                                 { { { 1, 0 }, { 0, 0 } } } } };
+
+static __CONSTEXPR__ core::GateMatrix<double, 2> RY_GENERATOR{ { { { { 0, 0 }, { 0, -1 } } },
+                                                                 { { { 0, 1 }, { 0, 0 } } } } };
+
+static __CONSTEXPR__ core::GateMatrix<double, 2> RZ_GENERATOR{ { { { { 1, 0 }, { 0, 0 } } },
+                                                                 { { { 0, 0 }, { -1, 0 } } } } };
+
+static __CONSTEXPR__ core::GateMatrix<double, 2> PHASE_GENERATOR{ { { { { 0, 0 }, { 0, 0 } } },
+                                                                    { { { 0, 0 }, { -2, 0 } } } } };
+
 static __CONSTEXPR__ UnitaryMatrix<4>
     CNOT({{{1, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, 0, 1}, {0, 0, 1, 0}}});
 
@@ -76,7 +97,7 @@ static __CONSTEXPR__ UnitaryMatrix<4>
     CZ({{{1, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, 1, 0}, {0, 0, 0, -1}}});
 
 static __CONSTEXPR__ UnitaryMatrix<4> CR(double theta) {
-    return UnitaryMatrix<4>(
+    return UnitaryMatrix<4>::fromUnitary(
         {{{1, 0, 0, 0},
           {0, 1, 0, 0},
           {0, 0, 1, 0},
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "qx/SimulationProgress.hpp"
+#include "qx/SimulationResult.hpp"
+#include "qx/Simulator.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>  // size_t
+#include <deque>
+#include <functional>
+#include <memory>  // shared_ptr
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <variant>
+#include <vector>
+
+
+namespace qx {
+
+// A simulation submitted to a JobPool, shared between the submitter and the worker thread that runs it.
+class Job {
+public:
+    using Result = std::variant<SimulationResult, SimulationError>;
+
+    using Task = std::function<Result(SimulationProgress &)>;
+
+    Job(Task task, std::size_t shotsRequested, SimulationProgress::Callback callback);
+
+    [[nodiscard]] std::size_t getShotsDone() const { return progress.getShotsDone(); }
+
+    [[nodiscard]] std::size_t getShotsRequested() const { return shotsRequested; }
+
+    [[nodiscard]] bool isDone() const;
+
+    // Blocks until the job is done.
+    [[nodiscard]] Result wait() const;
+
+    // Returns whether the job is done, after at most the timeout.
+    bool waitFor(std::chrono::milliseconds timeout) const;
+
+    // A job that did not start yet is done right away, with a SimulationError.
+    // A running job stops before its next shot, and its result only covers the shots done so far.
+    void cancel();
+
+private:
+    friend class JobPool;
+
+    void run();
+
+    Task task;
+    std::size_t const shotsRequested = 0;
+    SimulationProgress progress;
+    mutable std::mutex mutex;
+    mutable std::condition_variable done;
+    bool started = false;
+    std::optional<Result> result;
+};
+
+// Fixed set of worker threads running the submitted jobs in order.
+class JobPool {
+public:
+    // Uses one thread per hardware thread by default.
+    static JobPool &getInstance();
+
+    explicit JobPool(std::size_t numberOfThreads);
+
+    JobPool(JobPool const &) = delete;
+
+    JobPool &operator=(JobPool const &) = delete;
+
+    // See shutdown.
+    ~JobPool();
+
+    std::shared_ptr<Job> submit(Job::Task task, std::size_t shotsRequested,
+                                SimulationProgress::Callback callback = nullptr);
+
+    [[nodiscard]] std::size_t getNumberOfThreads() const;
+
+    // Extra threads finish their current job before stopping, and are joined by the next call to submit or
+    // setNumberOfThreads.
+    void setNumberOfThreads(std::size_t n);
+
+    // Cancels all the jobs, and waits for the running ones to stop.
+    // Jobs submitted afterwards are cancelled right away, so that no task or callback runs anymore.
+    void shutdown();
+
+private:
+    void work();
+
+    // With the mutex held, which finished workers do not take again.
+    void joinFinishedWorkers();
+
+    mutable std::mutex mutex;
+    std::condition_variable jobAvailable;
+    std::deque<std::shared_ptr<Job>> queue;
+    std::vector<std::shared_ptr<Job>> runningJobs;
+    std::vector<std::thread> workers;
+    std::vector<std::thread::id> finishedWorkers;
+    std::size_t numberOfThreads = 0;
+    std::size_t numberOfRunningWorkers = 0;
+    bool stopping = false;
+};
+
+}  // namespace qx
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "qx/Circuit.hpp"
+
+#include <array>
+#include <cstddef>  // size_t
+#include <cstdint>  // uint8_t, uint64_t
+#include <functional>
+#include <span>
+#include <variant>
+#include <vector>
+
+
+namespace qx {
+
+// Samples the shots of a Clifford circuit with stochastic Pauli noise, without a quantum state per shot.
+// A noiseless reference shot gives one valid measurement register. Any other shot only differs from it by its Pauli
+// frame, the Pauli errors it went through, which Clifford gates map to other Pauli errors. A measurement then flips the
+// reference outcome where the frame has an X or a Y on the measured qubit.
+// The frames of BATCH_SIZE shots are stored as bits, in one X word and one Z word per qubit, so that a gate is a few
+// XORs for the whole batch. Measurements and resets randomize the Z part of the frame, which leaves a Z eigenstate
+// unchanged, but samples the random outcome of a later measurement in another basis.
+class PauliFrameSampler {
+public:
+    static constexpr std::size_t BATCH_SIZE = 256;
+
+    using ShotsCallback = std::function<void(BasisVector measurementRegister, std::uint64_t shots)>;
+
+    // Throws std::runtime_error for instructions other than Clifford gates, measurements and resets, such as T,
+    // Rx with an angle that is not a multiple of pi/2, TOFFOLI, and conditional instructions.
+    PauliFrameSampler(Circuit const &circuit, std::size_t numberOfQubits);
+
+    // Runs up to BATCH_SIZE shots, whose reference measurement register comes from a noiseless shot of the circuit,
+    // and calls callback with their measurement registers and how many shots got each one.
+    // Depolarizing errors happen before every instruction, as with error_models::DepolarizingChannel.
+    void sample(BasisVector reference, std::size_t shots, double depolarizingProbability,
+                ShotsCallback const &callback) const;
+
+private:
+    // Bit i of word i / 64 is shot i of the batch.
+    using Lanes = std::array<std::uint64_t, BATCH_SIZE / 64>;
+
+    // Gate on up to two qubits, given by the Pauli operators to which it conjugates X and Z on each of its qubits.
+    // Bit b of a mask is qubits[b], as bit b of the index of the gate matrix.
+    struct CliffordGate {
+        struct Image {
+            std::uint8_t xMask = 0;
+            std::uint8_t zMask = 0;
+        };
+
+        std::size_t numberOfQubits = 0;
+        std::array<std::size_t, 2> qubits{};
+        // Images of X and Z on qubits[b] at 2 * b and 2 * b + 1.
+        std::array<Image, 4> images{};
+    };
+
+    using Operation = std::variant<CliffordGate, Circuit::Measure, Circuit::MeasureAll, Circuit::PrepZ>;
+
+    template <std::size_t N>
+    static CliffordGate getCliffordGate(core::DenseUnitaryMatrix<N> const &matrix,
+                                        std::span<core::QubitIndex const> operands);
+
+    std::size_t numberOfQubits = 0;
+    std::vector<Operation> operations;
+    std::vector<std::size_t> measuredQubits;
+};
+
+}  // namespace qx
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "qx/Core.hpp"
+
+#include <cstddef>  // size_t
+#include <memory>
+
+
+namespace qx::core {
+
+// Per-thread pool of sparse quantum states, so that consecutive simulations of the same number of qubits on a thread
+// reuse the allocations of the previous ones instead of growing new hash maps from empty.
+// Each thread keeps at most config::QUANTUM_STATE_POOL_SIZE free states per precision, and drops the least recently
+// returned one beyond that. Explicitly instantiated for float and double.
+template <typename T> class QuantumStatePool {
+public:
+    // Detaches the state from its memory tracker, resets it, frees its large amplitude containers, and gives it back
+    // to the pool of the calling thread. What it keeps is charged to the tracker of the next simulation.
+    struct Return {
+        void operator()(BasicQuantumState<T> *quantumState) const;
+    };
+
+    using Handle = std::unique_ptr<BasicQuantumState<T>, Return>;
+
+    // A state in state 00...000, from the pool of the calling thread if it holds one with that number of qubits
+    // and storage, and new otherwise.
+    [[nodiscard]] static Handle borrow(std::size_t numberOfQubits, SparseStorage storage = SparseStorage::HashMap);
+
+    // Number of free states in the pool of the calling thread.
+    [[nodiscard]] static std::size_t getSize();
+
+    // Frees the states in the pool of the calling thread.
+    static void clear();
+};
+
+}  // namespace qx::core
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "qx/Circuit.hpp"
+
+#include <cstddef>  // size_t
+
+
+namespace qx {
+
+// Pass for the dense backend, whose block swaps move a qubit from a high-order position of the amplitude index into
+// one of its lowPositions in-block positions, see core::BasicDenseStateVector.
+// The gates are split into windows of windowSize gates. Before each window whose hottest qubits differ from the
+// previous one, a Circuit::QubitLayout lists the qubits of the window by decreasing number of gates: they are then
+// moved in block together, and are the last to be evicted during the window.
+// The qubits keep their labels, since the dense state vector translates them to positions, so the measurement
+// register and the final state are the same as without the pass.
+[[nodiscard]] Circuit reorderQubits(Circuit const &circuit, std::size_t lowPositions,
+                                    std::size_t windowSize = config::QUBIT_REORDERING_WINDOW);
+
+}  // namespace qx
@@ -1,6 +1,17 @@
 #pragma once
 
+#include "qx/CircuitCache.hpp"
+#include "qx/JobPool.hpp"
 #include "qx/Simulator.hpp"
+#include "qx/Snapshot.hpp"
+
+#include <algorithm>  // sort
+#include <complex>
+#include <memory>  // shared_ptr
+#include <stdexcept>  // runtime_error
+#include <string>
+#include <utility>  // pair
+#include <vector>
 
 namespace qxelarator {
 
@@ -9,9 +20,10 @@ execute_string(
     std::string const &s,
     std::size_t iterations = 1,
     std::optional<std::uint_fast64_t> seed = std::nullopt,
-    std::string version = "3.0") {
+    std::string version = "3.0",
+    qx::SimulationOptions const &options = qx::SimulationOptions()) {
 
-    return qx::executeString(s, iterations, seed, version);
+    return qx::executeString(s, iterations, seed, version, options);
 }
 
 std::variant<qx::SimulationResult, qx::SimulationError>
@@ -19,9 +31,281 @@ execute_file(
     std::string const &filePath,
     std::size_t iterations = 1,
     std::optional<std::uint_fast64_t> seed = std::nullopt,
+    std::string version = "3.0",
+    qx::SimulationOptions const &options = qx::SimulationOptions()) {
+
+    return qx::executeFile(filePath, iterations, seed, version, options);
+}
+
+// Upper bound of the memory taken by the amplitudes, as a dictionary, see qx::estimateMemoryString.
+std::variant<qx::MemoryEstimate, qx::SimulationError>
+estimate_memory_string(
+    std::string const &s,
+    std::size_t iterations = 1,
+    std::string version = "3.0",
+    qx::SimulationOptions const &options = qx::SimulationOptions()) {
+
+    return qx::estimateMemoryString(s, iterations, version, options);
+}
+
+std::variant<qx::MemoryEstimate, qx::SimulationError>
+estimate_memory_file(
+    std::string const &filePath,
+    std::size_t iterations = 1,
+    std::string version = "3.0",
+    qx::SimulationOptions const &options = qx::SimulationOptions()) {
+
+    return qx::estimateMemoryFile(filePath, iterations, version, options);
+}
+
+// NumPy array with the overall unitary of the circuit, see qx::getUnitaryString.
+std::variant<qx::UnitaryResult, qx::SimulationError>
+get_unitary_string(
+    std::string const &s,
+    std::string version = "3.0") {
+
+    return qx::getUnitaryString(s, version);
+}
+
+std::variant<qx::UnitaryResult, qx::SimulationError>
+get_unitary_file(
+    std::string const &filePath,
     std::string version = "3.0") {
 
-    return qx::executeFile(filePath, iterations, seed, version);
+    return qx::getUnitaryFile(filePath, version);
+}
+
+// Amplitudes keyed by basis state strings, as in SimulationResult.state.
+using Amplitudes = std::vector<std::pair<std::string, std::complex<double>>>;
+
+// Saves amplitudes keyed by basis state, such as the state of a SimulationResult, to a snapshot file that
+// SimulationOptions.initial_state_file can start from, see qx::core::saveSnapshot. Returns None or a SimulationError.
+std::optional<qx::SimulationError>
+save_snapshot(
+    std::string const &filePath,
+    Amplitudes const &state,
+    std::string const &measurement_register = "",
+    bool compress = false) {
+
+    try {
+        if (state.empty()) {
+            throw std::runtime_error("Snapshot has no amplitudes");
+        }
+        auto const numberOfQubits = state.front().first.size();
+        auto toBasisVector = [numberOfQubits](std::string const &basisState) {
+            if (basisState.size() != numberOfQubits || numberOfQubits == 0 ||
+                numberOfQubits > qx::config::MAX_QUBIT_NUMBER ||
+                basisState.find_first_not_of("01") != std::string::npos) {
+                throw std::runtime_error("Invalid basis state '" + basisState + "' in snapshot of " +
+                    std::to_string(numberOfQubits) + " qubits");
+            }
+            return qx::BasisVector(basisState);
+        };
+
+        std::vector<std::pair<qx::BasisVector, std::complex<double>>> sortedAmplitudes;
+        sortedAmplitudes.reserve(state.size());
+        for (auto const &[basisState, amplitude] : state) {
+            sortedAmplitudes.emplace_back(toBasisVector(basisState), amplitude);
+        }
+        std::sort(sortedAmplitudes.begin(), sortedAmplitudes.end(),
+            [](auto const &left, auto const &right) { return left.first < right.first; });
+
+        auto measurementRegister = measurement_register.empty() ? qx::BasisVector{}
+                                                                : toBasisVector(measurement_register);
+        qx::core::saveSnapshot(qx::core::Snapshot::fromSortedAmplitudes(numberOfQubits, sortedAmplitudes,
+            measurementRegister), filePath, compress);
+    } catch (std::exception const &e) {
+        return qx::SimulationError{ e.what() };
+    }
+    return std::nullopt;
+}
+
+// qxelarator.Snapshot with the non-zero amplitudes of a snapshot file, keyed as in SimulationResult.state,
+// see qx::core::loadSnapshot.
+std::variant<qx::core::Snapshot, qx::SimulationError>
+load_snapshot(
+    std::string const &filePath) {
+
+    try {
+        return qx::core::loadSnapshot(filePath);
+    } catch (std::exception const &e) {
+        return qx::SimulationError{ e.what() };
+    }
+}
+
+// Circuit built gate by gate, see qx::CircuitBuilder. Each method returns the circuit, so that calls can be chained.
+class Circuit {
+public:
+    explicit Circuit(std::size_t number_of_qubits) : builder(number_of_qubits) {}
+
+    [[nodiscard]] std::size_t number_of_qubits() const { return builder.getNumberOfQubits(); }
+
+    Circuit &add_gate(
+        std::string const &name,
+        std::vector<std::size_t> const &qubits,
+        std::optional<double> parameter = std::nullopt,
+        std::vector<std::size_t> const &condition = std::vector<std::size_t>()) {
+
+        builder.addGate(name, qubits, parameter, condition);
+        return *this;
+    }
+
+    Circuit &add_measure(std::size_t qubit) {
+        builder.addMeasure(qubit);
+        return *this;
+    }
+
+    Circuit &add_measure_all() {
+        builder.addMeasureAll();
+        return *this;
+    }
+
+    Circuit &add_reset(std::size_t qubit) {
+        builder.addReset(qubit);
+        return *this;
+    }
+
+    // The first invalid instruction, or None.
+    [[nodiscard]] std::optional<std::string> error() const { return builder.getError(); }
+
+    [[nodiscard]] qx::CircuitBuilder const &get_builder() const { return builder; }
+
+private:
+    qx::CircuitBuilder builder;
+};
+
+std::variant<qx::SimulationResult, qx::SimulationError>
+execute_circuit(
+    Circuit const &circuit,
+    std::size_t iterations = 1,
+    std::optional<std::uint_fast64_t> seed = std::nullopt,
+    qx::SimulationOptions const &options = qx::SimulationOptions()) {
+
+    return qx::executeCircuit(circuit.get_builder(), iterations, seed, options);
+}
+
+// Expectation value of the observable, a dictionary of Pauli strings to coefficients, and its gradients with
+// respect to the angles of the Rx, Ry, Rz and CR gates, see qx::getGradientsString.
+std::variant<qx::GradientResult, qx::SimulationError>
+get_gradients_string(
+    std::string const &s,
+    qx::Observable const &observable,
+    std::string version = "3.0") {
+
+    return qx::getGradientsString(s, observable, version);
+}
+
+std::variant<qx::GradientResult, qx::SimulationError>
+get_gradients_file(
+    std::string const &filePath,
+    qx::Observable const &observable,
+    std::string version = "3.0") {
+
+    return qx::getGradientsFile(filePath, observable, version);
+}
+
+// Handle on a simulation submitted with submit_string, submit_file or submit_circuit.
+class Job {
+public:
+    explicit Job(std::shared_ptr<qx::Job> j) : job(std::move(j)) {}
+
+    [[nodiscard]] std::size_t shots_done() const { return job->getShotsDone(); }
+
+    [[nodiscard]] std::size_t shots_requested() const { return job->getShotsRequested(); }
+
+    [[nodiscard]] bool done() const { return job->isDone(); }
+
+    std::variant<qx::SimulationResult, qx::SimulationError> wait() const { return job->wait(); }
+
+    // A running simulation stops before its next shot, and its result only covers the shots done so far.
+    void cancel() { job->cancel(); }
+
+private:
+    std::shared_ptr<qx::Job> job;
+};
+
+// Same as execute_string, but runs in the background on the job pool.
+// The progress callback, if any, is called from a worker thread with the number of shots done and requested.
+Job
+submit_string(
+    std::string const &s,
+    std::size_t iterations = 1,
+    std::optional<std::uint_fast64_t> seed = std::nullopt,
+    std::string version = "3.0",
+    qx::SimulationOptions const &options = qx::SimulationOptions(),
+    qx::SimulationProgress::Callback progress = nullptr) {
+
+    return Job(qx::JobPool::getInstance().submit(
+        [s, iterations, seed, version, options](qx::SimulationProgress &p) {
+            return qx::executeString(s, iterations, seed, version, options, &p);
+        },
+        iterations, std::move(progress)));
+}
+
+// Same as execute_file, but runs in the background on the job pool.
+Job
+submit_file(
+    std::string const &filePath,
+    std::size_t iterations = 1,
+    std::optional<std::uint_fast64_t> seed = std::nullopt,
+    std::string version = "3.0",
+    qx::SimulationOptions const &options = qx::SimulationOptions(),
+    qx::SimulationProgress::Callback progress = nullptr) {
+
+    return Job(qx::JobPool::getInstance().submit(
+        [filePath, iterations, seed, version, options](qx::SimulationProgress &p) {
+            return qx::executeFile(filePath, iterations, seed, version, options, &p);
+        },
+        iterations, std::move(progress)));
+}
+
+// Same as execute_circuit, but runs in the background on the job pool.
+// The circuit can be changed in the meantime: the job runs the circuit as it was when submitted.
+Job
+submit_circuit(
+    Circuit const &circuit,
+    std::size_t iterations = 1,
+    std::optional<std::uint_fast64_t> seed = std::nullopt,
+    qx::SimulationOptions const &options = qx::SimulationOptions(),
+    qx::SimulationProgress::Callback progress = nullptr) {
+
+    return Job(qx::JobPool::getInstance().submit(
+        [builder = circuit.get_builder(), iterations, seed, options](qx::SimulationProgress &p) {
+            return qx::executeCircuit(builder, iterations, seed, options, &p);
+        },
+        iterations, std::move(progress)));
+}
+
+std::size_t
+get_job_pool_threads() {
+    return qx::JobPool::getInstance().getNumberOfThreads();
+}
+
+void
+set_job_pool_threads(std::size_t threads) {
+    qx::JobPool::getInstance().setNumberOfThreads(threads);
+}
+
+// Cancels the submitted jobs and waits for the running ones to stop, so that no progress callback is called while
+// the interpreter finalizes. Registered with atexit by the qxelarator module.
+void
+shutdown_job_pool() {
+    qx::JobPool::getInstance().shutdown();
+}
+
+qx::CircuitCacheStatistics
+get_circuit_cache_statistics() {
+    return qx::CircuitCache::getInstance().getStatistics();
+}
+
+void
+set_circuit_cache_max_bytes(std::size_t max_bytes) {
+    qx::CircuitCache::getInstance().setMaxBytes(max_bytes);
+}
+
+void
+clear_circuit_cache() {
+    qx::CircuitCache::getInstance().clear();
 }
 
 }  // namespace qxelarator
@@ -8,6 +8,7 @@
 
 namespace qx::random {
 
+// Only seeds the random number generator of the calling thread.
 void seed(std::uint_fast64_t seedValue);
 
 double randomZeroOneDouble();
@@ -15,6 +16,17 @@ double randomZeroOneDouble();
 std::uint_fast64_t randomInteger(std::uint_fast64_t min,
                                  std::uint_fast64_t max);
 
+// 64 independent random bits, such as the random Pauli frames of 64 shots.
+std::uint64_t randomBits();
+
+// Number of failed Bernoulli trials with success probability p before the first success, capped to 2^62.
+// Used to skip directly to the next of a series of rare events.
+std::uint64_t randomGeometric(double p);
+
+// Number of successes in n Bernoulli trials with success probability p, in constant expected time.
+// Only built on randomZeroOneDouble, so that it gives the same results on all platforms.
+std::uint64_t randomBinomial(std::uint64_t n, double p);
+
 double uniformMinMaxIntegerDistribution(std::uint_fast64_t min,
                                         std::uint_fast64_t max, double x);
 
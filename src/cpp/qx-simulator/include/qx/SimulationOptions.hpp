@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstddef>  // size_t
+#include <string>
+#include <vector>
+
+
+namespace qx {
+
+enum class StateBackend {
+    // Factorized sparse amplitudes, see core::QuantumState.
+    Sparse,
+    // All 2^n amplitudes, in RAM or in a memory-mapped file, see core::DenseStateVector.
+    Dense,
+};
+
+enum class Precision {
+    // std::complex<double> amplitudes.
+    Double,
+    // std::complex<float> amplitudes, which take half the memory. Enough for sampling-oriented workloads.
+    Float,
+};
+
+enum class SparseStorage {
+    // Hash map from basis vector to amplitude. Inserts are O(1), but the amplitudes are scanned in no particular order.
+    HashMap,
+    // Array of (basis vector, amplitude) pairs, sorted by basis vector. Gates are linear merges of the array, which
+    // is scanned in order and needs no hashing, and the amplitudes of the final state come out sorted.
+    SortedArray,
+};
+
+struct SimulationOptions {
+    StateBackend backend = StateBackend::Sparse;
+
+    Precision precision = Precision::Double;
+
+    // Sparse backend only: container of the amplitudes of each group of qubits.
+    SparseStorage sparse_storage = SparseStorage::HashMap;
+
+    // Dense backend only: file in which to memory-map the amplitudes, instead of keeping them in RAM.
+    // The file must not exist yet, and is removed as soon as it is mapped.
+    std::string dense_state_file = "";
+
+    // Dense backend only, with a memory-mapped file: number of low-order qubits of a block of amplitudes.
+    // 0 means the default, config::MAPPED_DENSE_BLOCK_QUBITS.
+    std::size_t dense_block_qubits = 0;
+
+    // Dense backend only: number of local processes, a power of two, among which the amplitudes are partitioned in
+    // POSIX shared memory, see core::DistributedStateVector. Linux only, and not compatible with dense_state_file.
+    // 0 and 1 mean a single process.
+    std::size_t dense_processes = 1;
+
+    // Dense backend only: moves the qubits that the next gates use the most in block ahead of time, see reorderQubits.
+    // This saves block swaps with a memory-mapped file, or slice exchanges with dense_processes, and does not change
+    // the results. Ignored for a state vector in RAM of a single process, whose qubits are all in block.
+    bool reorder_qubits = false;
+
+    // Snapshot file from which every shot starts, instead of state 00...000. See core::Snapshot.
+    std::string initial_state_file = "";
+
+    // Snapshot file to which the final state of the last shot is saved.
+    std::string final_state_file = "";
+
+    // Whether to compress the basis vectors in final_state_file.
+    bool compress_final_state = false;
+
+    // Sparse backend only: runs all the shots together, and splits the state into its outcome branches at each
+    // measurement, so that each branch runs once instead of once per shot. See Circuit::executeBranching.
+    // Much faster for circuits with a few mid-circuit measurements, such as syndrome extraction rounds.
+    // Not compatible with depolarizing_probability and amplitude_damping, which differ from shot to shot.
+    bool shot_branching = false;
+
+    // Samples the shots of a Clifford circuit, with depolarizing noise, as the Pauli frames of a noiseless reference
+    // shot, many shots at a time. See PauliFrameSampler. Much faster for large error-correction circuits.
+    // Needs a circuit of Clifford gates, measurements and resets, without conditional instructions, and is not
+    // compatible with amplitude_damping, shot_branching and initial_state_file.
+    // The reference shot runs on the sparse backend, and the final state and queries in the result are its own.
+    bool pauli_frames = false;
+
+    // Budget, in bytes, of the memory taken by the amplitudes, or 0 for no budget. The dense backend, whose memory is
+    // known in advance, is rejected before it starts above the budget, see estimateMemoryString. The sparse backend
+    // stops with a SimulationError at the first gate after which its amplitudes, the branches of shot_branching
+    // included, take more.
+    std::size_t max_memory_bytes = 0;
+
+    // Error models, all disabled by default. See docs/manual/error_models.rst.
+    // At most one of depolarizing_probability and amplitude_damping can be set.
+    double depolarizing_probability = 0.;
+
+    double amplitude_damping = 0.;
+
+    // Probabilities that a measured 0 is read as 1, and that a measured 1 is read as 0.
+    double readout_error_zero_to_one = 0.;
+
+    double readout_error_one_to_zero = 0.;
+
+    // Whether the result holds all the non-zero amplitudes of the final state, which are sorted and formatted.
+    // Leave it out when only a few amplitudes or a marginal distribution are needed, see below.
+    bool include_state = true;
+
+    // Basis states, e.g. "0110" with qubit 0 on the right, whose final amplitudes are returned in the result.
+    std::vector<std::string> amplitude_queries = {};
+
+    // Qubits whose marginal probabilities in the final state are returned in the result.
+    std::vector<std::size_t> marginal_qubits = {};
+
+    // Whether the result also holds the measurement register of every shot, bit-packed, see ShotRecords.
+    // With shot_branching and pauli_frames, the shots that ran together are recorded in a random order.
+    bool record_shots = false;
+
+    // With record_shots: file to which the shot records are written as they come, in chunks, instead of being
+    // kept in the result.
+    std::string shot_record_file = "";
+};
+
+}  // namespace qx
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <algorithm>  // max
+#include <atomic>
+#include <cstddef>  // size_t
+#include <functional>
+#include <utility>  // move
+
+
+namespace qx {
+
+// Lets another thread follow the shots of a running simulation, and stop it early.
+class SimulationProgress {
+public:
+    using Callback = std::function<void(std::size_t shotsDone, std::size_t shotsRequested)>;
+
+    // The callback is called from the simulating thread, about every percent of the requested shots and after the
+    // last one.
+    explicit SimulationProgress(Callback callback = nullptr) : callback(std::move(callback)) {}
+
+    SimulationProgress(SimulationProgress const &) = delete;
+
+    SimulationProgress &operator=(SimulationProgress const &) = delete;
+
+    [[nodiscard]] std::size_t getShotsDone() const { return shotsDone; }
+
+    [[nodiscard]] bool isCancelled() const { return cancelled; }
+
+    // The simulation stops before its next shot.
+    void cancel() { cancelled = true; }
+
+    void onShotDone(std::size_t shotsRequested) { onShotsDone(1, shotsRequested); }
+
+    // Shots that are simulated together, see SimulationOptions::shot_branching.
+    void onShotsDone(std::size_t count, std::size_t shotsRequested) {
+        auto done = shotsDone += count;
+        auto interval = std::max<std::size_t>(1, shotsRequested / 100);
+        if (callback && (done / interval != (done - count) / interval || done == shotsRequested)) {
+            callback(done, shotsRequested);
+        }
+    }
+
+private:
+    Callback const callback;
+    std::atomic<std::size_t> shotsDone = 0;
+    std::atomic<bool> cancelled = false;
+};
+
+}  // namespace qx
@@ -1,26 +1,39 @@
 #pragma once
 
 #include "qx/Common.hpp"
+#include "qx/ErrorModels.hpp"
 
 #include <absl/container/btree_map.h>
 #include <complex>
 #include <fmt/ostream.h>
+#include <fstream>
+#include <optional>
 #include <string>
+#include <utility>  // pair
 #include <vector>
 
 
 namespace qx {
 
-namespace core {
-class QuantumState;
-}
-
 struct Complex {
     double real = 0;
     double imag = 0;
     double norm = 0;
 };
 
+// Measurement registers of the shots, see SimulationOptions::record_shots. Shots that run one after the other are in
+// the order in which they ran. Shots that run together, with shot_branching or pauli_frames, are in a uniformly
+// random order, which has the same distribution since the shots are independent.
+struct ShotRecords {
+    std::size_t number_of_bits = 0;
+    std::size_t bytes_per_shot = 0;
+    std::uint64_t number_of_shots = 0;
+
+    // number_of_shots rows of bytes_per_shot bytes: bit q of a shot is bit q % 8 of byte q / 8 of its row.
+    // Empty when the records were written to SimulationOptions::shot_record_file instead.
+    std::vector<std::uint8_t> bytes;
+};
+
 struct SimulationResult {
     using Results = std::vector<std::pair<std::string, std::uint64_t>>;
 
@@ -31,26 +44,107 @@ struct SimulationResult {
 
     Results results;
     State state;
+
+    // Final amplitudes of SimulationOptions::amplitude_queries, in the same order.
+    State amplitudes;
+
+    // Final probabilities of all the outcomes of SimulationOptions::marginal_qubits.
+    // Character i from the right of an outcome is the value of marginal_qubits[i].
+    std::vector<std::pair<std::string, double>> marginal_probabilities;
+
+    // Bytes taken by the amplitudes of the final state, and their peak over all the shots.
+    // See SimulationOptions::max_memory_bytes.
+    std::uint64_t amplitude_bytes = 0;
+    std::uint64_t peak_amplitude_bytes = 0;
+
+    // Only with SimulationOptions::record_shots.
+    std::optional<ShotRecords> shot_records;
 };
 
 std::ostream &operator<<(std::ostream &os, SimulationResult const &r);
 
-class SimulationResultAccumulator {
+// Packs the measurement registers of the shots into ShotRecords, or writes them to a file in chunks of
+// config::SHOT_RECORD_CHUNK_BYTES, with the same layout and without header.
+class ShotRecorder {
 public:
-    explicit SimulationResultAccumulator(qx::core::QuantumState &s) : quantumState(s){};
+    // Throws std::runtime_error if the file cannot be created.
+    ShotRecorder(std::size_t numberOfBits, std::string const &filePath = "");
+
+    void append(BasisVector measurementRegister, std::uint64_t count = 1);
+
+    // Shots that ran together: they are appended in a uniformly random order, drawn with qx::random, before the next
+    // shots appended one by one, or at the end.
+    void appendUnordered(BasisVector measurementRegister, std::uint64_t count);
 
-    void append(BasisVector measuredState);
+    // Throws std::runtime_error if the file cannot be written.
+    ShotRecords finish();
 
-    SimulationResult get();
+private:
+    void appendPending();
+
+    void flush();
+
+    ShotRecords records;
+    std::ofstream file;
+    // Ordered, so that the same seed gives the same records.
+    absl::btree_map<BasisVector, std::uint64_t> pending;
+};
+
+class SimulationResultAccumulator {
+public:
+    explicit SimulationResultAccumulator(std::size_t n) : numberOfQubits(n){};
+
+    // Shots that ran one after the other, such as those of a shot loop.
+    void append(BasisVector measuredState, std::uint64_t count = 1);
+
+    // Shots that ran together, such as the branches of Circuit::executeBranching or a batch of Pauli frames, whatever
+    // their count: they are recorded in a random order, see ShotRecorder::appendUnordered.
+    void appendUnordered(BasisVector measuredState, std::uint64_t count);
+
+    // Replaces the measured states by the states that are read, bit errors included.
+    void applyReadoutError(error_models::ReadoutError const &readoutError, std::vector<std::size_t> const &measuredQubits);
+
+    // Records the measurement register of each shot appended from now on, see ShotRecorder.
+    // The bit errors of applyReadoutError are then drawn for each shot as it is appended, rather than once all the
+    // shots are done, so that the records and the results agree.
+    void recordShots(std::string const &filePath, std::optional<error_models::ReadoutError> readoutError,
+                     std::vector<std::size_t> measuredQubits);
+
+    // The final quantum state is taken from the state the shots were run on,
+    // a core::BasicQuantumState, a core::BasicDenseStateVector or a core::BasicDistributedStateVector,
+    // in float or double.
+    template <typename State> SimulationResult get(State &quantumState, bool includeState = true) {
+        auto simulationResult = getMeasurementResults();
+        if (!includeState) {
+            return simulationResult;
+        }
+
+        quantumState.forEach([this, &simulationResult](auto const &kv) {
+            auto const &c = kv.second;
+            simulationResult.state.push_back(std::make_pair(
+                getStateString(kv.first), Complex{ .real = c.real(), .imag = c.imag(), .norm = std::norm(c) }));
+        });
+
+        return simulationResult;
+    }
 
 private:
-    template <typename F> void forAllNonZeroStates(F &&f);
+    SimulationResult getMeasurementResults();
 
     std::string getStateString(BasisVector s);
 
-    core::QuantumState &quantumState;
+    // Draws the bit errors of the recorded shots, if any, before adding them.
+    void read(BasisVector measuredState, std::uint64_t count, bool ranTogether);
+
+    void add(BasisVector readState, std::uint64_t count, bool ranTogether);
+
+    std::size_t const numberOfQubits = 0;
     absl::btree_map<BasisVector, std::uint64_t> measuredStates;
     std::uint64_t nMeasurements = 0;
+
+    std::optional<ShotRecorder> shotRecorder;
+    std::optional<error_models::ReadoutError> shotReadoutError;
+    std::vector<std::size_t> shotMeasuredQubits;
 };
 
 }  // namespace qx
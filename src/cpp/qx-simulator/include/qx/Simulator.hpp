@@ -1,10 +1,16 @@
 #pragma once
 
+#include "qx/CircuitBuilder.hpp"
+#include "qx/SimulationOptions.hpp"
+#include "qx/SimulationProgress.hpp"
 #include "qx/SimulationResult.hpp"
 
+#include <complex>
 #include <optional>
 #include <string>
+#include <utility>  // pair
 #include <variant>
+#include <vector>
 
 
 namespace qx {
@@ -13,18 +19,110 @@ struct SimulationError {
     std::string message = "Simulation error";
 };
 
+// If progress is given, it is updated after every shot, and the simulation stops early when it is cancelled.
+// The result then only covers the shots done so far.
+
 std::variant<SimulationResult, SimulationError>
 executeString(
     std::string const &s,
     std::size_t iterations = 1,
     std::optional<std::uint_fast64_t> seed = std::nullopt,
-    std::string cqasm_version = "3.0");
+    std::string cqasm_version = "3.0",
+    SimulationOptions const &options = SimulationOptions(),
+    SimulationProgress *progress = nullptr);
 
 std::variant<SimulationResult, SimulationError>
 executeFile(
     std::string const &filePath,
     std::size_t iterations = 1,
     std::optional<std::uint_fast64_t> seed = std::nullopt,
+    std::string cqasm_version = "3.0",
+    SimulationOptions const &options = SimulationOptions(),
+    SimulationProgress *progress = nullptr);
+
+// Same as executeString, for a circuit built without cQASM. Returns the first error of the builder, if any.
+std::variant<SimulationResult, SimulationError>
+executeCircuit(
+    CircuitBuilder const &circuit,
+    std::size_t iterations = 1,
+    std::optional<std::uint_fast64_t> seed = std::nullopt,
+    SimulationOptions const &options = SimulationOptions(),
+    SimulationProgress *progress = nullptr);
+
+// Upper bound of the memory taken by the amplitudes of a simulation, without running it.
+struct MemoryEstimate {
+    // Exact for the dense backend. For the sparse backend, from the factor by which each gate can at most multiply the
+    // number of non-zero amplitudes, see Circuit::getMaxAmplitudeQubits: usually far above the actual peak.
+    // Both saturate at the largest std::uint64_t.
+    std::uint64_t max_amplitudes = 0;
+    std::uint64_t max_amplitude_bytes = 0;
+};
+
+// The number of iterations only matters with shot_branching, whose branches are copies of the state.
+
+std::variant<MemoryEstimate, SimulationError>
+estimateMemoryString(
+    std::string const &s,
+    std::size_t iterations = 1,
+    std::string cqasm_version = "3.0",
+    SimulationOptions const &options = SimulationOptions());
+
+std::variant<MemoryEstimate, SimulationError>
+estimateMemoryFile(
+    std::string const &filePath,
+    std::size_t iterations = 1,
+    std::string cqasm_version = "3.0",
+    SimulationOptions const &options = SimulationOptions());
+
+// Overall unitary of a circuit, see Circuit::getUnitary.
+struct UnitaryResult {
+    std::size_t number_of_qubits = 0;
+
+    // 2^n x 2^n entries, column by column: entry (row, column) is at row + column * 2^n,
+    // where bit q of the row and column indices is the value of qubit q.
+    std::vector<std::complex<double>> matrix;
+};
+
+// For circuits of at most config::MAX_UNITARY_QUBITS qubits, without resets, classical control
+// and measurements other than at the end, which are ignored.
+
+std::variant<UnitaryResult, SimulationError>
+getUnitaryString(
+    std::string const &s,
+    std::string cqasm_version = "3.0");
+
+std::variant<UnitaryResult, SimulationError>
+getUnitaryFile(
+    std::string const &filePath,
+    std::string cqasm_version = "3.0");
+
+// Sum of Pauli terms: pairs of a Pauli string, with one of I, X, Y and Z per qubit and qubit 0 on the right,
+// and a real coefficient. For instance, {{"ZZ", 1.}, {"IX", 0.5}} is Z0 Z1 + 0.5 X0.
+using Observable = std::vector<std::pair<std::string, double>>;
+
+// Expectation value of an observable in the final state of a circuit, and its gradients,
+// see Circuit::getGradients.
+struct GradientResult {
+    double expectation = 0.;
+
+    // Derivatives with respect to the angles of the Rx, Ry, Rz and CR gates, in the order of the circuit,
+    // with one entry per qubit operand of those gates.
+    std::vector<double> gradients;
+};
+
+// For circuits of at most config::MAX_GRADIENT_QUBITS qubits, without resets, classical control
+// and measurements other than at the end, which are ignored.
+
+std::variant<GradientResult, SimulationError>
+getGradientsString(
+    std::string const &s,
+    Observable const &observable,
+    std::string cqasm_version = "3.0");
+
+std::variant<GradientResult, SimulationError>
+getGradientsFile(
+    std::string const &filePath,
+    Observable const &observable,
     std::string cqasm_version = "3.0");
 
 }  // namespace qx
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "qx/Core.hpp"
+
+#include <complex>
+#include <cstddef>  // size_t
+#include <cstdint>  // uint32_t
+#include <string>
+#include <utility>  // pair
+#include <vector>
+
+
+namespace qx::core {
+
+// Amplitudes and measurement register of a quantum state, as saved to and loaded from a binary snapshot file.
+// A sparse snapshot holds the non-zero amplitudes along with their basis vectors, sorted by basis vector.
+// A dense snapshot holds all 2^n amplitudes, and no basis vectors.
+struct Snapshot {
+    enum class Representation : std::uint32_t {
+        Sparse = 0,
+        Dense = 1,
+    };
+
+    // Picks whichever representation is smaller. Amplitudes are always saved in double precision.
+    // Explicitly instantiated for float and double.
+    template <typename T>
+    static Snapshot fromSortedAmplitudes(std::size_t numberOfQubits,
+        std::vector<std::pair<BasisVector, std::complex<T>>> const &sortedAmplitudes,
+        BasisVector measurementRegister);
+
+    [[nodiscard]] std::size_t getNumberOfAmplitudes() const { return amplitudes.size(); }
+
+    // Iterates over the non-zero amplitudes, sorted by basis vector.
+    template <typename F> void forEach(F &&f) const {
+        for (std::size_t i = 0; i < amplitudes.size(); ++i) {
+            if (representation == Representation::Sparse) {
+                f(basisVectors[i], amplitudes[i]);
+            } else if (isNotNull(amplitudes[i])) {
+                f(BasisVector::fromSizeT(i), amplitudes[i]);
+            }
+        }
+    }
+
+    std::size_t numberOfQubits = 0;
+    Representation representation = Representation::Sparse;
+    BasisVector measurementRegister{};
+    std::vector<BasisVector> basisVectors;
+    std::vector<std::complex<double>> amplitudes;
+};
+
+// With compress, the basis vectors of a sparse snapshot are stored as variable-length deltas,
+// which typically takes one or two bytes each instead of eight.
+// Throws std::runtime_error if the file cannot be written.
+void saveSnapshot(Snapshot const &snapshot, std::string const &filePath, bool compress = false);
+
+// Throws std::runtime_error if the file cannot be read or is not a valid snapshot.
+Snapshot loadSnapshot(std::string const &filePath);
+
+}  // namespace qx::core
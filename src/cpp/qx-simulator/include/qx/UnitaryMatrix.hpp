@@ -0,0 +1,62 @@
+#pragma once
+
+#include "qx/Core.hpp"
+
+#include <complex>
+#include <cstddef>  // size_t
+#include <span>
+#include <utility>  // move
+#include <vector>
+
+
+namespace qx::core {
+
+// Overall unitary of a circuit on n qubits, a 2^n x 2^n matrix stored column by column: entry (row, column) is at
+// row + column * 2^n. Bit q of a row or column index is the value of qubit q.
+// Column j is the state that basis vector j evolves to, so a gate is applied to all the columns as to state vectors.
+class UnitaryMatrix {
+public:
+    // Starts as the identity. Throws std::runtime_error beyond config::MAX_UNITARY_QUBITS qubits.
+    explicit UnitaryMatrix(std::size_t n);
+
+    [[nodiscard]] std::size_t getNumberOfQubits() const { return numberOfQubits; }
+
+    [[nodiscard]] std::size_t getDimension() const { return dimension; }
+
+    [[nodiscard]] std::complex<double> at(std::size_t row, std::size_t column) const {
+        return entries[row + column * dimension];
+    }
+
+    [[nodiscard]] std::vector<std::complex<double>> const &getEntries() const { return entries; }
+
+    // Moves the column-major entries out, leaving the matrix empty.
+    [[nodiscard]] std::vector<std::complex<double>> takeEntries() { return std::move(entries); }
+
+    // Left-multiplies the columns in [firstColumn, endColumn) by the gate.
+    // Distinct column ranges can be processed concurrently.
+    template <std::size_t NumberOfOperands>
+    void apply(DenseUnitaryMatrix<1 << NumberOfOperands> const &m,
+               std::array<QubitIndex, NumberOfOperands> const &operands, std::size_t firstColumn,
+               std::size_t endColumn);
+
+    template <std::size_t NumberOfOperands>
+    void apply(DenseUnitaryMatrix<1 << NumberOfOperands> const &m,
+               std::array<QubitIndex, NumberOfOperands> const &operands) {
+        apply(m, operands, 0, dimension);
+    }
+
+    // Same for the single-qubit gate on the target, where all the controls are 1.
+    void applyControlled(DenseUnitaryMatrix<2> const &m, std::span<QubitIndex const> controls, QubitIndex target,
+                         std::size_t firstColumn, std::size_t endColumn);
+
+    void applyControlled(DenseUnitaryMatrix<2> const &m, std::span<QubitIndex const> controls, QubitIndex target) {
+        applyControlled(m, controls, target, 0, dimension);
+    }
+
+private:
+    std::size_t const numberOfQubits = 0;
+    std::size_t const dimension = 1;
+    std::vector<std::complex<double>> entries;
+};
+
+}  // namespace qx::core
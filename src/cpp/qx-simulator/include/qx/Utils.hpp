@@ -1,6 +1,7 @@
 #pragma once
 
 #include <array>
+#include <bit>  // popcount
 #include <cassert>
 #include <climits>
 #include <string>
@@ -66,6 +67,26 @@ public:
         }
     }
 
+    inline void operator|=(Bitset<NumberOfBits> const &other) {
+        for (std::size_t i = 0; i < data.size(); ++i) {
+            data[i] |= other.data[i];
+        }
+    }
+
+    inline void operator&=(Bitset<NumberOfBits> const &other) {
+        for (std::size_t i = 0; i < data.size(); ++i) {
+            data[i] &= other.data[i];
+        }
+    }
+
+    [[nodiscard]] inline std::size_t count() const {
+        std::size_t result = 0;
+        for (auto d : data) {
+            result += std::popcount(d);
+        }
+        return result;
+    }
+
     template <typename H> friend H AbslHashValue(H h, Bitset const &bitset) {
         return H::combine(std::move(h), bitset.data);
     }
@@ -77,6 +98,15 @@ public:
         return data[0];
     }
 
+    [[nodiscard]] static Bitset fromSizeT(std::size_t value) {
+#if !defined(_MSC_VER)
+        static_assert(STORAGE_SIZE == 1);
+#endif
+        Bitset result;
+        result.data[0] = value;
+        return result;
+    }
+
     [[nodiscard]] std::string toString() const {
         std::string result;
         for (std::size_t i = 0; i < NumberOfBits; ++i) {
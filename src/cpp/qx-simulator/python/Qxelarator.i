@@ -5,6 +5,11 @@
 %module(docstring=DOCSTRING) qxelarator
 
 %include "std_string.i"
+%include "std_vector.i"
+
+// For the amplitude and marginal queries of SimulationOptions.
+%template(StringVector) std::vector<std::string>;
+%template(SizeVector) std::vector<std::size_t>;
 
 %typemap(in) std::optional<std::uint_fast64_t> {
     if($input == Py_None) {
@@ -14,6 +19,31 @@
     }
 }
 
+// Gate parameters of Circuit.add_gate.
+%typemap(in) std::optional<double> {
+    if ($input == Py_None) {
+        $1 = std::nullopt;
+    } else {
+        $1 = PyFloat_AsDouble($input);
+        if (PyErr_Occurred()) {
+            SWIG_fail;
+        }
+    }
+}
+
+%typecheck(SWIG_TYPECHECK_DOUBLE) std::optional<double> {
+    $1 = $input == Py_None || PyFloat_Check($input) || PyLong_Check($input);
+}
+
+%typemap(out) std::optional<std::string> {
+    if ($1) {
+        $result = PyUnicode_FromString($1->c_str());
+    } else {
+        Py_INCREF(Py_None);
+        $result = Py_None;
+    }
+}
+
 // Map the output of execute_string/execute_file to a simple Python class for user-friendliness.
 %typemap(out) std::variant<qx::SimulationResult, qx::SimulationError> {
     if (std::holds_alternative<qx::SimulationResult>($1)) {
@@ -26,42 +56,354 @@
 
         auto const* cppSimulationResult = std::get_if<qx::SimulationResult>(&$1);
 
-        PyObject_SetAttrString(simulationResult, "shots_done", PyLong_FromUnsignedLongLong(cppSimulationResult->shots_done));
-        PyObject_SetAttrString(simulationResult, "shots_requested", PyLong_FromUnsignedLongLong(cppSimulationResult->shots_requested));
+        // PyObject_SetAttrString and PyDict_SetItemString take their own reference to the value.
+        auto setAttribute = [simulationResult](char const* name, PyObject* value) {
+            PyObject_SetAttrString(simulationResult, name, value);
+            Py_DECREF(value);
+        };
+        auto setItem = [](PyObject* dictionary, char const* key, PyObject* value) {
+            PyDict_SetItemString(dictionary, key, value);
+            Py_DECREF(value);
+        };
+
+        setAttribute("shots_done", PyLong_FromUnsignedLongLong(cppSimulationResult->shots_done));
+        setAttribute("shots_requested", PyLong_FromUnsignedLongLong(cppSimulationResult->shots_requested));
 
         auto results = PyDict_New();
         for(auto const& x: cppSimulationResult->results) {
-            PyDict_SetItemString(results, x.first.c_str(), PyLong_FromUnsignedLongLong(x.second));
+            setItem(results, x.first.c_str(), PyLong_FromUnsignedLongLong(x.second));
         }
-        PyObject_SetAttrString(simulationResult, "results", results);
+        setAttribute("results", results);
 
         auto state = PyDict_New();
         for(auto const& x: cppSimulationResult->state) {
-            PyDict_SetItemString(state, x.first.c_str(), PyComplex_FromCComplex({ .real = x.second.real, .imag = x.second.imag }));
+            setItem(state, x.first.c_str(), PyComplex_FromCComplex({ .real = x.second.real, .imag = x.second.imag }));
+        }
+        setAttribute("state", state);
+
+        auto amplitudes = PyDict_New();
+        for(auto const& x: cppSimulationResult->amplitudes) {
+            setItem(amplitudes, x.first.c_str(), PyComplex_FromCComplex({ .real = x.second.real, .imag = x.second.imag }));
+        }
+        setAttribute("amplitudes", amplitudes);
+
+        auto marginalProbabilities = PyDict_New();
+        for(auto const& x: cppSimulationResult->marginal_probabilities) {
+            setItem(marginalProbabilities, x.first.c_str(), PyFloat_FromDouble(x.second));
+        }
+        setAttribute("marginal_probabilities", marginalProbabilities);
+
+        setAttribute("amplitude_bytes", PyLong_FromUnsignedLongLong(cppSimulationResult->amplitude_bytes));
+        setAttribute("peak_amplitude_bytes", PyLong_FromUnsignedLongLong(cppSimulationResult->peak_amplitude_bytes));
+
+        // Records written to a file are left out, as well as the records of a result without them.
+        auto& shotRecords = std::get_if<qx::SimulationResult>(&$1)->shot_records;
+        if (shotRecords && !shotRecords->bytes.empty()) {
+            auto array = makeShotRecordArray(std::move(*shotRecords));
+            if (!array) {
+                Py_DECREF(simulationResult);
+                SWIG_fail;
+            }
+            setAttribute("shot_records", array);
         }
-        PyObject_SetAttrString(simulationResult, "state", state);
 
         $result = simulationResult;
     } else {
+        $result = makeSimulationError(*std::get_if<qx::SimulationError>(&$1));
+    }
+}
+
+// Map the output of get_unitary_string/get_unitary_file to a 2^n x 2^n NumPy array, indexed by row and column.
+// NumPy is only needed at runtime: the column-major entries are copied into a bytearray, which NumPy then wraps.
+%typemap(out) std::variant<qx::UnitaryResult, qx::SimulationError> {
+    if (auto const* unitary = std::get_if<qx::UnitaryResult>(&$1)) {
+        auto numpy = PyImport_ImportModule("numpy");
+        if (!numpy) {
+            SWIG_fail;
+        }
+
+        auto buffer = PyByteArray_FromStringAndSize(reinterpret_cast<char const*>(unitary->matrix.data()),
+            static_cast<Py_ssize_t>(unitary->matrix.size() * sizeof(std::complex<double>)));
+        auto dimension = 1ULL << unitary->number_of_qubits;
+        auto flat = PyObject_CallMethod(numpy, "frombuffer", "Os", buffer, "complex128");
+        Py_DECREF(buffer);
+        Py_DECREF(numpy);
+        if (!flat) {
+            SWIG_fail;
+        }
+
+        // The transpose of the row-major (column, row) array is the column-major (row, column) array, without a copy.
+        auto transposed = PyObject_CallMethod(flat, "reshape", "(KK)", dimension, dimension);
+        Py_DECREF(flat);
+        if (!transposed) {
+            SWIG_fail;
+        }
+        $result = PyObject_GetAttrString(transposed, "T");
+        Py_DECREF(transposed);
+    } else {
+        $result = makeSimulationError(*std::get_if<qx::SimulationError>(&$1));
+    }
+}
+
+// Map the output of estimate_memory_string/estimate_memory_file to a plain dictionary.
+%typemap(out) std::variant<qx::MemoryEstimate, qx::SimulationError> {
+    if (auto const* estimate = std::get_if<qx::MemoryEstimate>(&$1)) {
+        auto result = PyDict_New();
+        auto setItem = [result](char const* key, unsigned long long value) {
+            auto pyValue = PyLong_FromUnsignedLongLong(value);
+            PyDict_SetItemString(result, key, pyValue);
+            Py_DECREF(pyValue);
+        };
+        setItem("max_amplitudes", estimate->max_amplitudes);
+        setItem("max_amplitude_bytes", estimate->max_amplitude_bytes);
+
+        $result = result;
+    } else {
+        $result = makeSimulationError(*std::get_if<qx::SimulationError>(&$1));
+    }
+}
+
+// Observables of get_gradients_string/get_gradients_file are dictionaries of Pauli strings to real coefficients.
+%typemap(in) qx::Observable const & (qx::Observable observable) {
+    if (!PyDict_Check($input)) {
+        SWIG_exception_fail(SWIG_TypeError, "observable must be a dictionary of Pauli strings to coefficients");
+    }
+    PyObject *key;
+    PyObject *value;
+    Py_ssize_t position = 0;
+    while (PyDict_Next($input, &position, &key, &value)) {
+        auto const *paulis = PyUnicode_Check(key) ? PyUnicode_AsUTF8(key) : nullptr;
+        auto coefficient = PyFloat_AsDouble(value);
+        if (!paulis || PyErr_Occurred()) {
+            SWIG_exception_fail(SWIG_TypeError, "observable must be a dictionary of Pauli strings to coefficients");
+        }
+        observable.emplace_back(paulis, coefficient);
+    }
+    $1 = &observable;
+}
+
+%typecheck(SWIG_TYPECHECK_POINTER) qx::Observable const & {
+    $1 = PyDict_Check($input);
+}
+
+// Map the output of get_gradients_string/get_gradients_file to a simple Python class, with a list of gradients.
+%typemap(out) std::variant<qx::GradientResult, qx::SimulationError> {
+    if (auto const* gradientResult = std::get_if<qx::GradientResult>(&$1)) {
         auto pmod = PyImport_ImportModule("qxelarator");
-        auto pclass = PyObject_GetAttrString(pmod, "SimulationError");
+        auto pclass = PyObject_GetAttrString(pmod, "GradientResult");
         Py_DECREF(pmod);
 
-        auto errorString = PyUnicode_FromString(std::get_if<qx::SimulationError>(&$1)->message.c_str());
-        auto args = PyTuple_Pack(1, errorString);
+        auto result = PyObject_CallObject(pclass, NULL);
+        Py_DECREF(pclass);
+
+        auto expectation = PyFloat_FromDouble(gradientResult->expectation);
+        PyObject_SetAttrString(result, "expectation", expectation);
+        Py_DECREF(expectation);
+
+        auto gradients = PyList_New(static_cast<Py_ssize_t>(gradientResult->gradients.size()));
+        for (std::size_t i = 0; i < gradientResult->gradients.size(); ++i) {
+            PyList_SET_ITEM(gradients, static_cast<Py_ssize_t>(i), PyFloat_FromDouble(gradientResult->gradients[i]));
+        }
+        PyObject_SetAttrString(result, "gradients", gradients);
+        Py_DECREF(gradients);
 
-        auto simulationError = PyObject_CallObject(pclass, args);
-        Py_DECREF(args);
+        $result = result;
+    } else {
+        $result = makeSimulationError(*std::get_if<qx::SimulationError>(&$1));
+    }
+}
+
+// Amplitudes of save_snapshot are dictionaries of basis state strings to complex numbers.
+%typemap(in) qxelarator::Amplitudes const & (qxelarator::Amplitudes amplitudes) {
+    if (!PyDict_Check($input)) {
+        SWIG_exception_fail(SWIG_TypeError, "state must be a dictionary of basis states to amplitudes");
+    }
+    PyObject *key;
+    PyObject *value;
+    Py_ssize_t position = 0;
+    while (PyDict_Next($input, &position, &key, &value)) {
+        auto const *basisState = PyUnicode_Check(key) ? PyUnicode_AsUTF8(key) : nullptr;
+        auto amplitude = PyComplex_AsCComplex(value);
+        if (!basisState || PyErr_Occurred()) {
+            SWIG_exception_fail(SWIG_TypeError, "state must be a dictionary of basis states to amplitudes");
+        }
+        amplitudes.emplace_back(basisState, std::complex<double>(amplitude.real, amplitude.imag));
+    }
+    $1 = &amplitudes;
+}
+
+%typecheck(SWIG_TYPECHECK_POINTER) qxelarator::Amplitudes const & {
+    $1 = PyDict_Check($input);
+}
+
+%typemap(out) std::optional<qx::SimulationError> {
+    if ($1) {
+        $result = makeSimulationError(*$1);
+    } else {
+        Py_INCREF(Py_None);
+        $result = Py_None;
+    }
+}
+
+// Map the output of load_snapshot to a simple Python class, with the same basis state strings as SimulationResult.
+%typemap(out) std::variant<qx::core::Snapshot, qx::SimulationError> {
+    if (auto const* snapshot = std::get_if<qx::core::Snapshot>(&$1)) {
+        auto getBasisState = [numberOfQubits = snapshot->numberOfQubits](qx::BasisVector basisVector) {
+            auto basisState = basisVector.toString();
+            return basisState.substr(basisState.size() - numberOfQubits);
+        };
+
+        auto state = PyDict_New();
+        snapshot->forEach([&state, &getBasisState](qx::BasisVector basisVector, std::complex<double> amplitude) {
+            auto pyAmplitude = PyComplex_FromDoubles(amplitude.real(), amplitude.imag());
+            PyDict_SetItemString(state, getBasisState(basisVector).c_str(), pyAmplitude);
+            Py_DECREF(pyAmplitude);
+        });
+
+        auto pmod = PyImport_ImportModule("qxelarator");
+        auto pclass = PyObject_GetAttrString(pmod, "Snapshot");
+        Py_DECREF(pmod);
+        $result = PyObject_CallFunction(pclass, "Os", state, getBasisState(snapshot->measurementRegister).c_str());
         Py_DECREF(pclass);
-        Py_DECREF(errorString);
+        Py_DECREF(state);
+    } else {
+        $result = makeSimulationError(*std::get_if<qx::SimulationError>(&$1));
+    }
+}
 
-        $result = simulationError;
+// Progress callbacks are Python callables taking the number of shots done and requested.
+// They are called from a worker thread, which holds the GIL for the duration of the call.
+%typemap(in) qx::SimulationProgress::Callback {
+    if ($input == Py_None) {
+        $1 = nullptr;
+    } else if (!PyCallable_Check($input)) {
+        SWIG_exception_fail(SWIG_TypeError, "progress must be callable or None");
+    } else {
+        Py_INCREF($input);
+        std::shared_ptr<PyObject> callable($input, [](PyObject *o) {
+            auto gil = PyGILState_Ensure();
+            Py_DECREF(o);
+            PyGILState_Release(gil);
+        });
+        $1 = [callable](std::size_t shotsDone, std::size_t shotsRequested) {
+            auto gil = PyGILState_Ensure();
+            auto result = PyObject_CallFunction(callable.get(), "KK",
+                static_cast<unsigned long long>(shotsDone), static_cast<unsigned long long>(shotsRequested));
+            if (result) {
+                Py_DECREF(result);
+            } else {
+                PyErr_Print();
+            }
+            PyGILState_Release(gil);
+        };
     }
 }
 
+%typecheck(SWIG_TYPECHECK_POINTER) qx::SimulationProgress::Callback {
+    $1 = $input == Py_None || PyCallable_Check($input);
+}
+
+// Simulations do not touch any Python object, so other Python threads can run in the meantime.
+%define RELEASE_GIL(function)
+%exception function {
+    Py_BEGIN_ALLOW_THREADS
+    $action
+    Py_END_ALLOW_THREADS
+}
+%enddef
+
+RELEASE_GIL(qxelarator::execute_string)
+RELEASE_GIL(qxelarator::execute_file)
+RELEASE_GIL(qxelarator::execute_circuit)
+RELEASE_GIL(qxelarator::estimate_memory_string)
+RELEASE_GIL(qxelarator::estimate_memory_file)
+RELEASE_GIL(qxelarator::get_unitary_string)
+RELEASE_GIL(qxelarator::get_unitary_file)
+RELEASE_GIL(qxelarator::get_gradients_string)
+RELEASE_GIL(qxelarator::get_gradients_file)
+RELEASE_GIL(qxelarator::save_snapshot)
+RELEASE_GIL(qxelarator::load_snapshot)
+RELEASE_GIL(qxelarator::Job::wait)
+// Running jobs may need the GIL for their progress callbacks before they stop.
+RELEASE_GIL(qxelarator::shutdown_job_pool)
+
+// Jobs are only created by submit_string, submit_file and submit_circuit.
+%ignore qxelarator::Job::Job;
+
+// The builder behind a Circuit is only for the C++ side.
+%ignore qxelarator::Circuit::get_builder;
+
+// Circuit cache statistics are returned as a plain dictionary, for monitoring.
+%typemap(out) qx::CircuitCacheStatistics {
+    auto statistics = PyDict_New();
+    auto setItem = [statistics](char const* key, unsigned long long value) {
+        auto pyValue = PyLong_FromUnsignedLongLong(value);
+        PyDict_SetItemString(statistics, key, pyValue);
+        Py_DECREF(pyValue);
+    };
+    setItem("hits", $1.hits);
+    setItem("misses", $1.misses);
+    setItem("evictions", $1.evictions);
+    setItem("entries", $1.entries);
+    setItem("bytes", $1.bytes);
+    setItem("max_bytes", $1.maxBytes);
+
+    $result = statistics;
+}
+
 %{
 #include "qx/Qxelarator.hpp"
+
+PyObject *makeSimulationError(qx::SimulationError const &error) {
+    auto pmod = PyImport_ImportModule("qxelarator");
+    auto pclass = PyObject_GetAttrString(pmod, "SimulationError");
+    Py_DECREF(pmod);
+
+    auto errorString = PyUnicode_FromString(error.message.c_str());
+    auto args = PyTuple_Pack(1, errorString);
+
+    auto simulationError = PyObject_CallObject(pclass, args);
+    Py_DECREF(args);
+    Py_DECREF(pclass);
+    Py_DECREF(errorString);
+
+    return simulationError;
+}
+
+// NumPy uint8 array of shape (shots, bytes per shot) over the bytes of the shot records, without a copy: the array
+// keeps a qxelarator.ShotRecordBuffer alive, which owns the bytes through a capsule and describes them to NumPy.
+PyObject *makeShotRecordArray(qx::ShotRecords &&shotRecords) {
+    auto numpy = PyImport_ImportModule("numpy");
+    if (!numpy) {
+        return nullptr;
+    }
+
+    auto *bytes = new std::vector<std::uint8_t>(std::move(shotRecords.bytes));
+    auto capsule = PyCapsule_New(bytes, nullptr, [](PyObject *o) {
+        delete static_cast<std::vector<std::uint8_t>*>(PyCapsule_GetPointer(o, nullptr));
+    });
+
+    auto pmod = PyImport_ImportModule("qxelarator");
+    auto pclass = PyObject_GetAttrString(pmod, "ShotRecordBuffer");
+    Py_DECREF(pmod);
+    auto buffer = PyObject_CallFunction(pclass, "OKKK", capsule, static_cast<unsigned long long>(
+        reinterpret_cast<std::uintptr_t>(bytes->data())), static_cast<unsigned long long>(shotRecords.number_of_shots),
+        static_cast<unsigned long long>(shotRecords.bytes_per_shot));
+    Py_DECREF(pclass);
+    Py_DECREF(capsule);
+    if (!buffer) {
+        Py_DECREF(numpy);
+        return nullptr;
+    }
+
+    auto array = PyObject_CallMethod(numpy, "asarray", "O", buffer);
+    Py_DECREF(buffer);
+    Py_DECREF(numpy);
+    return array;
+}
 %}
 
+%include "qx/SimulationOptions.hpp"
+
 // Include the header file with above prototypes
 %include "qx/Qxelarator.hpp"
@@ -15,12 +15,49 @@ class SimulationResult:
         self.shots_done = 0
         self.results = {}
         self.state = {}
+        self.amplitudes = {}
+        self.marginal_probabilities = {}
+        self.amplitude_bytes = 0
+        self.peak_amplitude_bytes = 0
+        self.shot_records = None
 
     def __repr__(self):
         return f"""Shots requested: {self.shots_requested}
 Shots done: {self.shots_done}
 Results: {self.results}
-State: {self.state}"""
+State: {self.state}
+Amplitudes: {self.amplitudes}
+Marginal probabilities: {self.marginal_probabilities}"""
+
+class ShotRecordBuffer:
+    """Shot records of a SimulationResult, which NumPy wraps without a copy through the array interface."""
+    def __init__(self, owner, address, shots, bytes_per_shot):
+        self._owner = owner
+        self.__array_interface__ = {
+            "shape": (shots, bytes_per_shot),
+            "typestr": "|u1",
+            "data": (address, False),
+            "version": 3,
+        }
+
+class GradientResult:
+    def __init__(self):
+        self.expectation = 0.
+        self.gradients = []
+
+    def __repr__(self):
+        return f"""Expectation: {self.expectation}
+Gradients: {self.gradients}"""
+
+class Snapshot:
+    """Amplitudes and measurement register of a snapshot file, see load_snapshot and save_snapshot."""
+    def __init__(self, state, measurement_register):
+        self.state = state
+        self.measurement_register = measurement_register
+
+    def __repr__(self):
+        return f"""State: {self.state}
+Measurement register: {self.measurement_register}"""
 
 class SimulationError:
     def __init__(self, message):
@@ -29,4 +66,8 @@ class SimulationError:
     def __repr__(self):
         return f"Quantum simulation error: {self.message}"
 
-from .qxelarator import *
\ No newline at end of file
+from .qxelarator import *
+
+# Background jobs must not run, nor call progress callbacks, once the interpreter finalizes.
+import atexit
+atexit.register(shutdown_job_pool)
\ No newline at end of file
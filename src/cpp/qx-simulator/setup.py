@@ -236,6 +236,7 @@ setup(
         'delocate; platform_system == "Darwin"',
     ],
     install_requires=['msvc-runtime; platform_system == "Windows"'],
-    tests_require=["pytest"],
+    extras_require={"unitary": ["numpy"]},
+    tests_require=["pytest", "numpy"],
     zip_safe=False,
 )
@@ -1,8 +1,22 @@
+#include "qx/JobPool.hpp"
 #include "qx/Simulator.hpp"
 #include "qx/Version.hpp"
 
+#include <algorithm>  // sort
+#include <charconv>  // from_chars
+#include <chrono>
+#include <cstdio>  // fflush
+#include <cstdint>  // uint_fast64_t
+#include <cstring>  // strlen
+#include <filesystem>
 #include <fmt/core.h>
 #include <fmt/ostream.h>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
 
 
 static constexpr char const* banner = R"(
@@ -16,51 +30,257 @@ static constexpr char const* banner = R"(
                      <   QuTech - TU Delft   |   Version {} ({})   >
 ===============================================================================================)";
 
+// Files picked up when a directory is given in batch mode.
+static constexpr char const* circuitFileExtensions[] = { ".qc", ".cq", ".qasm" };
 
-void print_banner() {
-    fmt::print(banner, QX_VERSION, QX_RELEASE_YEAR);
-    fmt::print("\n\n");
+
+void print_banner(std::ostream &os) {
+    fmt::print(os, banner, QX_VERSION, QX_RELEASE_YEAR);
+    fmt::print(os, "\n\n");
+}
+
+void print_usage(char const *program) {
+    fmt::print(std::cerr,
+        "Usage: {0} [-c iterations] [--seed seed] [--quiet] file.qc\n"
+        "       {0} --batch [-c iterations] [--seed seed] [--quiet] [--threads threads] [--list file]"
+        " (file.qc | directory)...\n"
+        "\n"
+        "Batch mode runs all the given files, all the circuit files in the given directories,\n"
+        "and all the files listed one per line in the --list files, in parallel.\n"
+        "It writes one JSON record per file to the standard output, in the order of the files.\n",
+        program);
+}
+
+// Only plain decimal numbers are accepted: no sign, no leading whitespace, and nothing after the digits.
+std::optional<std::uint_fast64_t> parse_unsigned(char const *s) {
+    std::uint_fast64_t result = 0;
+    auto const *end = s + std::strlen(s);
+    auto [ptr, ec] = std::from_chars(s, end, result);
+    if (ec != std::errc() || ptr != end) {
+        return std::nullopt;
+    }
+    return result;
+}
+
+// Numbers of iterations and of threads must be positive.
+std::optional<std::size_t> parse_count(char const *s) {
+    auto result = parse_unsigned(s);
+    if (!result || *result == 0) {
+        return std::nullopt;
+    }
+    return static_cast<std::size_t>(*result);
+}
+
+std::string to_json(std::string const &s) {
+    std::string result = "\"";
+    for (char c : s) {
+        switch (c) {
+            case '"': result += "\\\""; break;
+            case '\\': result += "\\\\"; break;
+            case '\n': result += "\\n"; break;
+            case '\r': result += "\\r"; break;
+            case '\t': result += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    result += fmt::format("\\u{:04x}", static_cast<unsigned char>(c));
+                } else {
+                    result += c;
+                }
+        }
+    }
+    return result + "\"";
+}
+
+std::string to_json_record(std::string const &filePath,
+                           std::variant<qx::SimulationResult, qx::SimulationError> const &simulationResult,
+                           double seconds) {
+    auto record = fmt::format("{{\"file\": {}, \"time_s\": {}", to_json(filePath), seconds);
+
+    if (auto* error = std::get_if<qx::SimulationError>(&simulationResult)) {
+        return record + fmt::format(", \"error\": {}}}", to_json(error->message));
+    }
+
+    auto const &result = std::get<qx::SimulationResult>(simulationResult);
+    record += fmt::format(", \"shots_requested\": {}, \"shots_done\": {}, \"results\": {{",
+        result.shots_requested, result.shots_done);
+    for (std::size_t i = 0; i < result.results.size(); ++i) {
+        record += fmt::format("{}{}: {}", i ? ", " : "", to_json(result.results[i].first), result.results[i].second);
+    }
+    record += "}, \"state\": {";
+    for (std::size_t i = 0; i < result.state.size(); ++i) {
+        auto const &amplitude = result.state[i].second;
+        record += fmt::format("{}{}: {{\"real\": {}, \"imag\": {}, \"norm\": {}}}", i ? ", " : "",
+            to_json(result.state[i].first), amplitude.real, amplitude.imag, amplitude.norm);
+    }
+    return record + "}}";
+}
+
+bool is_circuit_file(std::filesystem::path const &path) {
+    return std::any_of(std::begin(circuitFileExtensions), std::end(circuitFileExtensions),
+        [&path](auto const &extension) { return path.extension() == extension; });
+}
+
+// Directories are searched recursively. Returns std::nullopt if an input cannot be read.
+std::optional<std::vector<std::string>> collect_files(std::vector<std::string> const &inputs,
+                                                      std::vector<std::string> const &listFiles) {
+    std::vector<std::string> result;
+
+    for (auto const &listFile : listFiles) {
+        std::ifstream list(listFile);
+        if (!list) {
+            fmt::print(std::cerr, "Cannot read file list '{}'\n", listFile);
+            return std::nullopt;
+        }
+        for (std::string line; std::getline(list, line);) {
+            if (!line.empty()) {
+                result.push_back(line);
+            }
+        }
+    }
+
+    for (auto const &input : inputs) {
+        std::error_code ec;
+        if (!std::filesystem::is_directory(input, ec)) {
+            result.push_back(input);
+            continue;
+        }
+
+        std::vector<std::string> directoryFiles;
+        for (auto const &entry : std::filesystem::recursive_directory_iterator(input, ec)) {
+            if (entry.is_regular_file() && is_circuit_file(entry.path())) {
+                directoryFiles.push_back(entry.path().string());
+            }
+        }
+        if (ec) {
+            fmt::print(std::cerr, "Cannot read directory '{}': {}\n", input, ec.message());
+            return std::nullopt;
+        }
+        std::sort(directoryFiles.begin(), directoryFiles.end());
+        result.insert(result.end(), directoryFiles.begin(), directoryFiles.end());
+    }
+
+    return result;
+}
+
+// Returns the number of files that could not be simulated.
+std::size_t run_batch(std::vector<std::string> const &filePaths, std::size_t iterations,
+                      std::optional<std::uint_fast64_t> seed, std::size_t threads) {
+    qx::JobPool jobPool(threads);
+
+    std::vector<std::shared_ptr<qx::Job>> jobs;
+    std::vector<double> durations(filePaths.size(), 0.);
+    for (std::size_t i = 0; i < filePaths.size(); ++i) {
+        jobs.push_back(jobPool.submit([&filePath = filePaths[i], &duration = durations[i], iterations, seed](
+                                          qx::SimulationProgress &progress) {
+            auto start = std::chrono::steady_clock::now();
+            auto simulationResult = qx::executeFile(filePath, iterations, seed, "3.0", qx::SimulationOptions(),
+                &progress);
+            duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            return simulationResult;
+        }, iterations));
+    }
+
+    std::size_t failures = 0;
+    for (std::size_t i = 0; i < filePaths.size(); ++i) {
+        auto simulationResult = jobs[i]->wait();
+        failures += std::holds_alternative<qx::SimulationError>(simulationResult);
+        fmt::print("{}\n", to_json_record(filePaths[i], simulationResult, durations[i]));
+        std::fflush(stdout);
+    }
+    return failures;
 }
 
 
 int main(int argc, char **argv) {
-    std::string filePath;
+    std::vector<std::string> inputs;
+    std::vector<std::string> listFiles;
     size_t iterations = 1;
-    print_banner();
+    std::optional<std::uint_fast64_t> seed;
+    std::size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    bool batch = false;
+    bool quiet = false;
 
     int argIndex = 1;
     bool argParsingFailed = false;
     while (argIndex < argc) {
-        auto currentArg = argv[argIndex];
+        auto currentArg = std::string(argv[argIndex]);
+        auto hasValue = argIndex + 1 < argc;
 
-        if (std::string(currentArg) == "-c") {
-            if (argIndex + 1 >= argc) {
+        if (currentArg == "-c" && hasValue) {
+            auto count = parse_count(argv[++argIndex]);
+            if (!count) {
                 argParsingFailed = true;
-            } else {
-                iterations = atoi(argv[++argIndex]);
+                break;
             }
-        } else {
-            if (argIndex + 1 < argc) {
+            iterations = *count;
+        } else if (currentArg == "--seed" && hasValue) {
+            seed = parse_unsigned(argv[++argIndex]);
+            if (!seed) {
                 argParsingFailed = true;
-            } else {
-                filePath = std::string(currentArg);
+                break;
             }
-        }
-
-        if (argParsingFailed) {
+        } else if (currentArg == "--threads" && hasValue) {
+            auto count = parse_count(argv[++argIndex]);
+            if (!count) {
+                argParsingFailed = true;
+                break;
+            }
+            threads = *count;
+        } else if (currentArg == "--list" && hasValue) {
+            listFiles.emplace_back(argv[++argIndex]);
+        } else if (currentArg == "--batch") {
+            batch = true;
+        } else if (currentArg == "--quiet") {
+            quiet = true;
+        } else if (currentArg.starts_with("-")) {
+            argParsingFailed = true;
             break;
+        } else {
+            inputs.push_back(currentArg);
         }
 
         ++argIndex;
     }
 
-    if (filePath.empty() || argParsingFailed) {
-        fmt::print(std::cerr, "Usage: {} [-c iterations] file.qc\n", argv[0]);
+    if (batch) {
+        if (argParsingFailed || (inputs.empty() && listFiles.empty())) {
+            print_usage(argv[0]);
+            return -1;
+        }
+
+        // The standard output only holds the JSON records.
+        if (!quiet) {
+            print_banner(std::cerr);
+        }
+
+        auto filePaths = collect_files(inputs, listFiles);
+        if (!filePaths) {
+            return -1;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        auto failures = run_batch(*filePaths, iterations, seed, threads);
+        std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start;
+
+        if (!quiet) {
+            fmt::print(std::cerr, "Ran {} file{} on {} thread{} in {:.3f} s, {} failed\n", filePaths->size(),
+                (filePaths->size() != 1 ? "s" : ""), threads, (threads > 1 ? "s" : ""), seconds.count(), failures);
+        }
+        return failures > 0 ? 1 : 0;
+    }
+
+    if (inputs.size() != 1 || !listFiles.empty() || argParsingFailed) {
+        print_usage(argv[0]);
         return -1;
     }
-    fmt::print("Will execute {} time{} file '{}'...\n", iterations, (iterations > 1 ? "s" : ""), filePath);
+    auto const &filePath = inputs.front();
+
+    if (!quiet) {
+        print_banner(std::cout);
+        fmt::print("Will execute {} time{} file '{}'...\n", iterations, (iterations > 1 ? "s" : ""), filePath);
+    }
 
-    auto simulationResult = qx::executeFile(filePath, iterations);
+    auto simulationResult = qx::executeFile(filePath, iterations, seed);
     if (auto* error = std::get_if<qx::SimulationError>(&simulationResult)) {
         fmt::print(std::cerr, "{}\n", error->message);
         return 1;
@@ -1,60 +1,319 @@
 #include "qx/Circuit.hpp"
 
+#include "qx/DenseStateVector.hpp"
+#include "qx/DistributedStateVector.hpp"
 #include "qx/Random.hpp"
 #include <algorithm>
+#include <atomic>
+#include <bit>  // bit_width
+#include <fmt/format.h>
+#include <span>
+#include <stdexcept>  // runtime_error
+#include <thread>
 
 
 namespace qx {
 namespace {
 
+// The sparse state has no qubit order.
+template <typename T>
+void setHotQubits(core::BasicQuantumState<T> &, std::span<core::QubitIndex const>) {}
+
+template <typename T>
+void setHotQubits(core::BasicDenseStateVector<T> &quantumState, std::span<core::QubitIndex const> qubits) {
+    quantumState.setHotQubits(qubits);
+}
+
+template <typename T>
+void setHotQubits(core::BasicDistributedStateVector<T> &quantumState, std::span<core::QubitIndex const> qubits) {
+    quantumState.setHotQubits(qubits);
+}
+
+// log2 of the largest number of non-zero entries in a column of the matrix, rounded up: 0 for permutations and
+// diagonal gates, 1 for a Hadamard gate.
+template <std::size_t N>
+std::size_t getBranchingQubits(core::DenseUnitaryMatrix<N> const &matrix) {
+    return static_cast<std::size_t>(std::bit_width(core::getMaxNonZerosPerColumn(matrix) - 1));
+}
+
+template <typename State> inline constexpr bool isDenseStateVector = false;
+
+template <typename T> inline constexpr bool isDenseStateVector<core::BasicDenseStateVector<T>> = true;
+
+template <typename State> struct BufferedGate {
+    using type = std::monostate;
+};
+
+template <typename T> struct BufferedGate<core::BasicDenseStateVector<T>> {
+    using type = typename core::BasicDenseStateVector<T>::SequenceGate;
+};
+
+// With bufferGates, consecutive gates on a dense state vector are applied together by flush, which is called before
+// any other instruction, see core::BasicDenseStateVector::applySequence. The measurement register does not change
+// in between, so the control conditions of buffered gates are still up to date.
+template <typename State>
 struct InstructionExecutor {
 public:
-    explicit InstructionExecutor(core::QuantumState &s) : quantumState(s){};
+    explicit InstructionExecutor(State &s, bool bufferGates = false) : quantumState(s), bufferGates(bufferGates){};
 
     void operator()(Circuit::Measure const &m) {
+        flush();
         quantumState.measure(m.qubitIndex, &random::randomZeroOneDouble);
     }
 
     void operator()(Circuit::MeasureAll const &) {
+        flush();
         quantumState.measureAll(&random::randomZeroOneDouble);
     }
 
     void operator()(Circuit::PrepZ const &r) {
+        flush();
         quantumState.prep(r.qubitIndex, &random::randomZeroOneDouble);
     }
 
     void operator()(Circuit::MeasurementRegisterOperation const &op) {
+        flush();
         op.operation(quantumState.getMeasurementRegister());
     }
 
+    void operator()(Circuit::QubitLayout const &l) {
+        flush();
+        setHotQubits(quantumState, l.hotQubits);
+    }
+
     template <std::size_t N> void operator()(Circuit::Unitary<N> const &u) {
+        if constexpr (isDenseStateVector<State>) {
+            if (bufferGates) {
+                gates.emplace_back(typename State::template GateReference<N>{ u.matrix, u.operands });
+                return;
+            }
+        }
         quantumState.apply(u.matrix, u.operands);
     }
 
+    void operator()(Circuit::ControlledUnitary const &u) {
+        if constexpr (isDenseStateVector<State>) {
+            if (bufferGates) {
+                gates.emplace_back(typename State::ControlledGateReference{ u.matrix, u.controls, u.target });
+                return;
+            }
+        }
+        quantumState.applyControlled(u.matrix, u.controls, u.target);
+    }
+
+    void flush() {
+        if constexpr (isDenseStateVector<State>) {
+            if (!gates.empty()) {
+                quantumState.applySequence(gates);
+                gates.clear();
+            }
+        }
+    }
+
 private:
-    core::QuantumState &quantumState;
+    State &quantumState;
+    bool const bufferGates = false;
+    std::vector<typename BufferedGate<State>::type> gates;
+};
+
+// For the gates of Circuit::getGradients.
+template <typename Executor>
+void executeGate(Circuit::Instruction const &gate, Executor &executor) {
+    if (auto *instruction1 = std::get_if<Circuit::Unitary<1>>(&gate)) {
+        executor(*instruction1);
+    } else if (auto *instruction2 = std::get_if<Circuit::Unitary<2>>(&gate)) {
+        executor(*instruction2);
+    } else if (auto *controlledUnitary = std::get_if<Circuit::ControlledUnitary>(&gate)) {
+        executor(*controlledUnitary);
+    } else {
+        assert(false && "Unimplemented circuit instruction");
+    }
+}
+
+Circuit::Instruction getAdjoint(Circuit::Instruction const &gate) {
+    if (auto *instruction1 = std::get_if<Circuit::Unitary<1>>(&gate)) {
+        return Circuit::Unitary<1>{ instruction1->matrix.dagger(), instruction1->operands };
+    } else if (auto *instruction2 = std::get_if<Circuit::Unitary<2>>(&gate)) {
+        return Circuit::Unitary<2>{ instruction2->matrix.dagger(), instruction2->operands };
+    } else if (auto *controlledUnitary = std::get_if<Circuit::ControlledUnitary>(&gate)) {
+        return Circuit::ControlledUnitary{ controlledUnitary->controls, controlledUnitary->matrix.dagger(),
+                                           controlledUnitary->target };
+    }
+    assert(false && "Unimplemented circuit instruction");
+    return gate;
+}
+
+struct ParameterOperands {
+    core::GateMatrix<double, 2> const &generator;
+    std::span<core::QubitIndex const> controls;
+    core::QubitIndex target;
 };
+
+std::optional<ParameterOperands> getParameter(Circuit::Instruction const &gate) {
+    if (auto *instruction1 = std::get_if<Circuit::Unitary<1>>(&gate); instruction1 && instruction1->parameter) {
+        return ParameterOperands{ instruction1->parameter->generator, {}, instruction1->operands[0] };
+    } else if (auto *controlledUnitary = std::get_if<Circuit::ControlledUnitary>(&gate);
+               controlledUnitary && controlledUnitary->parameter) {
+        return ParameterOperands{ controlledUnitary->parameter->generator, controlledUnitary->controls,
+                                  controlledUnitary->target };
+    }
+    return std::nullopt;
+}
+
+// Runs the branches of Circuit::executeBranching.
+// Position i in the circuit is instruction i % size of iteration i / size.
+template <typename T>
+class BranchExecutor {
+public:
+    using State = core::BasicQuantumState<T>;
+
+    BranchExecutor(std::vector<Circuit::ControlledInstruction> const &instructions, std::size_t iterations,
+                   Circuit::BranchCallback const &callback)
+        : instructions(instructions), numberOfPositions(iterations * instructions.size()), callback(callback) {}
+
+    // Within a MeasureAll, the measurements resume at firstQubit.
+    void run(State &quantumState, std::uint64_t shots, std::size_t position, std::size_t firstQubit) {
+        InstructionExecutor<State> instructionExecutor(quantumState);
+        for (; position < numberOfPositions; ++position, firstQubit = 0) {
+            auto const &controlledInstruction = instructions[position % instructions.size()];
+            if (auto const &condition = controlledInstruction.condition; condition && firstQubit == 0) {
+                auto controlBits = quantumState.getMeasurementRegister();
+                controlBits &= condition->mask;
+                if (!(controlBits == condition->value)) {
+                    continue;
+                }
+            }
+
+            auto const &instruction = controlledInstruction.instruction;
+            if (auto *measure = std::get_if<Circuit::Measure>(&instruction)) {
+                shots = split(quantumState, shots, measure->qubitIndex, false, position + 1, 0);
+            } else if (std::get_if<Circuit::MeasureAll>(&instruction)) {
+                // Measuring the qubits one by one gives the same distribution and measurement register.
+                for (auto qubit = firstQubit; qubit < quantumState.getNumberOfQubits(); ++qubit) {
+                    shots = split(quantumState, shots, core::QubitIndex{ qubit }, false, position, qubit + 1);
+                }
+            } else if (auto *prepZ = std::get_if<Circuit::PrepZ>(&instruction)) {
+                shots = split(quantumState, shots, prepZ->qubitIndex, true, position + 1, 0);
+            } else if (auto *classicalOp = std::get_if<Circuit::MeasurementRegisterOperation>(&instruction)) {
+                instructionExecutor(*classicalOp);
+            } else if (auto *qubitLayout = std::get_if<Circuit::QubitLayout>(&instruction)) {
+                instructionExecutor(*qubitLayout);
+            } else if (auto *instruction1 = std::get_if<Circuit::Unitary<1>>(&instruction)) {
+                instructionExecutor(*instruction1);
+            } else if (auto *instruction2 = std::get_if<Circuit::Unitary<2>>(&instruction)) {
+                instructionExecutor(*instruction2);
+            } else if (auto *controlledUnitary = std::get_if<Circuit::ControlledUnitary>(&instruction)) {
+                instructionExecutor(*controlledUnitary);
+            } else {
+                assert(false && "Unimplemented circuit instruction");
+            }
+        }
+
+        callback(quantumState.getMeasurementRegister(), shots);
+    }
+
+private:
+    // Shares the shots between the two outcomes of measuring the qubit. The outcome with the fewest shots runs first,
+    // on a copy of the state, from the resume position. Since that copy has at most half of the shots,
+    // the recursion depth is at most log2(shots). Returns the shots of the other outcome, to which quantumState collapses.
+    std::uint64_t split(State &quantumState, std::uint64_t shots, core::QubitIndex qubitIndex, bool isPrep,
+                        std::size_t resumePosition, std::size_t resumeQubit) {
+        auto probabilityOfMeasuringOne = std::clamp(quantumState.getProbabilityOfMeasuringOne(qubitIndex), 0., 1.);
+        auto shotsMeasuringOne = random::randomBinomial(shots, probabilityOfMeasuringOne);
+        bool outcome = 2 * shotsMeasuringOne >= shots;
+        auto otherShots = outcome ? shots - shotsMeasuringOne : shotsMeasuringOne;
+
+        if (otherShots > 0) {
+            State other(quantumState);
+            collapse(other, qubitIndex, !outcome, isPrep);
+            run(other, otherShots, resumePosition, resumeQubit);
+        }
+
+        collapse(quantumState, qubitIndex, outcome, isPrep);
+        return shots - otherShots;
+    }
+
+    // The random number picks the outcome, which has a non-zero probability.
+    static void collapse(State &quantumState, core::QubitIndex qubitIndex, bool outcome, bool isPrep) {
+        auto pickOutcome = [outcome]() { return outcome ? 0. : 1.; };
+        if (isPrep) {
+            quantumState.prep(qubitIndex, pickOutcome);
+        } else {
+            quantumState.measure(qubitIndex, pickOutcome);
+        }
+    }
+
+    std::vector<Circuit::ControlledInstruction> const &instructions;
+    std::size_t const numberOfPositions = 0;
+    Circuit::BranchCallback const &callback;
+};
+
+// Errors that follow a gate, on its operands.
+template <typename State>
+void addGateError(error_models::ErrorModel const &errorModel, State &quantumState,
+                  std::span<core::QubitIndex const> operands) {
+    if (auto *amplitudeDampingChannel = std::get_if<error_models::AmplitudeDampingChannel>(&errorModel)) {
+        amplitudeDampingChannel->addError(quantumState, operands);
+    }
+}
+
+template <typename State>
+void addGateError(error_models::ErrorModel const &errorModel, State &quantumState,
+                  Circuit::ControlledUnitary const &controlledUnitary) {
+    if (std::holds_alternative<error_models::AmplitudeDampingChannel>(errorModel)) {
+        auto operands = controlledUnitary.controls;
+        operands.push_back(controlledUnitary.target);
+        addGateError(errorModel, quantumState, operands);
+    }
+}
 } // namespace
 
-void Circuit::execute(core::QuantumState &quantumState,
-                      error_models::ErrorModel const &errorModel) const {
+void Circuit::addInstruction(Instruction instruction) {
+    controlledInstructions.push_back(ControlledInstruction{ std::move(instruction), std::nullopt });
+}
+
+void Circuit::addInstruction(ControlledInstruction controlledInstruction) {
+    controlledInstructions.push_back(std::move(controlledInstruction));
+}
+
+void Circuit::addInstruction(Instruction instruction, std::vector<core::QubitIndex> const &controlBits) {
+    if (controlBits.empty()) {
+        addInstruction(std::move(instruction));
+        return;
+    }
+
+    ControlCondition condition;
+    for (auto const &controlBit : controlBits) {
+        condition.mask.set(controlBit.value);
+    }
+    condition.value = condition.mask;
+    controlledInstructions.push_back(ControlledInstruction{ std::move(instruction), condition });
+}
+
+template <typename State>
+void Circuit::execute(State &quantumState, error_models::ErrorModel const &errorModel) const {
     std::size_t it = iterations;
-    InstructionExecutor instructionExecutor(quantumState);
+    // Error models act on the state after every gate, so gates can only be buffered without them.
+    InstructionExecutor<State> instructionExecutor(quantumState, std::holds_alternative<std::monostate>(errorModel));
     while (it-- > 0) {
         for (auto const &controlledInstruction : controlledInstructions) {
+            // A layout hint was not in the source circuit, so it does not give errors a chance to happen.
+            if (auto *qubitLayout = std::get_if<Circuit::QubitLayout>(&controlledInstruction.instruction)) {
+                instructionExecutor(*qubitLayout);
+                continue;
+            }
+
             if (auto *depolarizing_channel = std::get_if<error_models::DepolarizingChannel>( &errorModel)) {
                 depolarizing_channel->addError(quantumState);
             } else {
-                assert(std::get_if<std::monostate>(&errorModel) && "Unimplemented error model");
+                assert((std::get_if<error_models::AmplitudeDampingChannel>(&errorModel) ||
+                        std::get_if<std::monostate>(&errorModel)) && "Unimplemented error model");
             }
 
-            auto const &controlBits = controlledInstruction.controlBits;
-            if (controlBits) {
-                auto measurementRegister = quantumState.getMeasurementRegister();
-                auto isBitNotSet = [&measurementRegister](auto const &cb) {
-                    return !measurementRegister.test(cb.value);
-                };
-                if (std::any_of(controlBits->begin(), controlBits->end(), isBitNotSet)) {
+            if (auto const &condition = controlledInstruction.condition) {
+                auto controlBits = quantumState.getMeasurementRegister();
+                controlBits &= condition->mask;
+                if (!(controlBits == condition->value)) {
                     continue;
                 }
             }
@@ -73,15 +332,220 @@ void Circuit::execute(core::QuantumState &quantumState,
                 instructionExecutor(*classicalOp);
             } else if (auto *instruction1 = std::get_if<Circuit::Unitary<1>>(&instruction)) {
                 instructionExecutor(*instruction1);
+                addGateError(errorModel, quantumState, instruction1->operands);
             } else if (auto *instruction2 = std::get_if<Circuit::Unitary<2>>(&instruction)) {
                 instructionExecutor(*instruction2);
-            } else if (auto *instruction3 = std::get_if<Circuit::Unitary<3>>(&instruction)) {
-                instructionExecutor(*instruction3);
+                addGateError(errorModel, quantumState, instruction2->operands);
+            } else if (auto *controlledUnitary = std::get_if<Circuit::ControlledUnitary>(&instruction)) {
+                instructionExecutor(*controlledUnitary);
+                addGateError(errorModel, quantumState, *controlledUnitary);
             } else {
                 assert(false && "Unimplemented circuit instruction");
             }
         }
     }
+    instructionExecutor.flush();
+}
+
+template <typename T>
+void Circuit::executeBranching(core::BasicQuantumState<T> &quantumState, std::uint64_t shots,
+                               BranchCallback const &callback) const {
+    if (shots == 0) {
+        return;
+    }
+    BranchExecutor<T>(controlledInstructions, iterations, callback).run(quantumState, shots, 0, 0);
+}
+
+std::vector<Circuit::Instruction const *> Circuit::getGatesBeforeMeasurements(std::string const &what) const {
+    std::vector<Instruction const *> gates;
+    bool measured = false;
+    for (auto const &controlledInstruction : controlledInstructions) {
+        auto const &instruction = controlledInstruction.instruction;
+        if (std::holds_alternative<Measure>(instruction) || std::holds_alternative<MeasureAll>(instruction)) {
+            measured = true;
+            continue;
+        }
+        if (std::holds_alternative<QubitLayout>(instruction)) {
+            continue;
+        }
+        if (measured) {
+            throw std::runtime_error("Cannot compute the " + what + " of a circuit with mid-circuit measurements");
+        }
+        if (controlledInstruction.condition || std::holds_alternative<PrepZ>(instruction) ||
+            std::holds_alternative<MeasurementRegisterOperation>(instruction)) {
+            throw std::runtime_error("Cannot compute the " + what + " of a circuit with resets or classical control");
+        }
+        gates.push_back(&instruction);
+    }
+    // The next iteration would apply gates after the measurements.
+    if (measured && iterations > 1 && !gates.empty()) {
+        throw std::runtime_error("Cannot compute the " + what + " of a circuit with mid-circuit measurements");
+    }
+    return gates;
+}
+
+core::UnitaryMatrix Circuit::getUnitary(std::size_t numberOfQubits) const {
+    auto gates = getGatesBeforeMeasurements("unitary");
+    core::UnitaryMatrix unitary(numberOfQubits);
+
+    auto dimension = unitary.getDimension();
+    auto blockColumns = std::max<std::size_t>(1, config::UNITARY_BLOCK_ENTRIES / dimension);
+    auto numberOfBlocks = (dimension + blockColumns - 1) / blockColumns;
+    std::atomic<std::size_t> nextBlock = 0;
+
+    // Each thread takes the next block of columns, and runs the whole circuit on it.
+    auto work = [this, &gates, &unitary, &nextBlock, dimension, blockColumns, numberOfBlocks]() {
+        for (auto block = nextBlock++; block < numberOfBlocks; block = nextBlock++) {
+            auto firstColumn = block * blockColumns;
+            auto endColumn = std::min(firstColumn + blockColumns, dimension);
+            for (std::size_t it = 0; it < iterations; ++it) {
+                for (auto const *instruction : gates) {
+                    if (auto *instruction1 = std::get_if<Unitary<1>>(instruction)) {
+                        unitary.apply(instruction1->matrix, instruction1->operands, firstColumn, endColumn);
+                    } else if (auto *instruction2 = std::get_if<Unitary<2>>(instruction)) {
+                        unitary.apply(instruction2->matrix, instruction2->operands, firstColumn, endColumn);
+                    } else if (auto *controlledUnitary = std::get_if<ControlledUnitary>(instruction)) {
+                        unitary.applyControlled(controlledUnitary->matrix, controlledUnitary->controls,
+                                                controlledUnitary->target, firstColumn, endColumn);
+                    } else {
+                        assert(false && "Unimplemented circuit instruction");
+                    }
+                }
+            }
+        }
+    };
+
+    auto numberOfThreads = std::clamp<std::size_t>(numberOfBlocks, 1, std::max(1u, std::thread::hardware_concurrency()));
+    {
+        std::vector<std::jthread> threads;
+        for (std::size_t t = 1; t < numberOfThreads; ++t) {
+            threads.emplace_back(work);
+        }
+        work();
+    }
+
+    return unitary;
+}
+
+Circuit::Gradients Circuit::getGradients(std::size_t numberOfQubits,
+                                         std::span<core::PauliTerm const> observable) const {
+    if (numberOfQubits > config::MAX_GRADIENT_QUBITS) {
+        throw std::runtime_error(fmt::format("Cannot compute the gradients of more than {} qubits",
+            config::MAX_GRADIENT_QUBITS));
+    }
+    for (auto const &term : observable) {
+        core::checkPauliTerm(term, numberOfQubits);
+    }
+    auto gates = getGatesBeforeMeasurements("gradients");
+
+    // The backward pass applies the adjoint of each gate. Parametric gates are numbered in circuit order.
+    std::vector<Instruction> adjoints;
+    std::vector<std::optional<std::size_t>> parameterIndices;
+    std::size_t numberOfParameters = 0;
+    for (auto const *gate : gates) {
+        adjoints.push_back(getAdjoint(*gate));
+        parameterIndices.push_back(getParameter(*gate) ? std::optional(numberOfParameters++) : std::nullopt);
+    }
+
+    Gradients result;
+    result.gradients.resize(numberOfParameters, 0.);
+
+    core::BasicDenseStateVector<double> state(numberOfQubits);
+    InstructionExecutor<core::BasicDenseStateVector<double>> stateExecutor(state, true);
+    for (std::size_t it = 0; it < iterations; ++it) {
+        for (auto const *gate : gates) {
+            executeGate(*gate, stateExecutor);
+        }
+    }
+    stateExecutor.flush();
+
+    // Observable applied to the state, then taken back through the adjoint gates along with the state, so that
+    // before undoing gate U, the derivative of the expectation with respect to its angle is
+    // 2 Re <observableState| -i/2 G |state> = Im <observableState|G|state>.
+    core::BasicDenseStateVector<double> observableState(numberOfQubits);
+    observableState.setToPauliSum(state, observable);
+    result.expectation = state.innerProduct(observableState).real();
+
+    InstructionExecutor<core::BasicDenseStateVector<double>> observableExecutor(observableState, true);
+    auto firstParameter = std::find_if(parameterIndices.begin(), parameterIndices.end(),
+        [](auto const &index) { return index.has_value(); }) - parameterIndices.begin();
+    // Nothing left to differentiate once the first parametric gate is undone.
+    for (auto position = iterations * gates.size(); position-- > static_cast<std::size_t>(firstParameter);) {
+        auto i = position % gates.size();
+        if (auto const &index = parameterIndices[i]) {
+            stateExecutor.flush();
+            observableExecutor.flush();
+            auto parameter = *getParameter(*gates[i]);
+            result.gradients[*index] += observableState.getMatrixElement(state, parameter.generator,
+                parameter.controls, parameter.target).imag();
+        }
+        executeGate(adjoints[i], stateExecutor);
+        executeGate(adjoints[i], observableExecutor);
+    }
+
+    return result;
+}
+
+std::vector<std::size_t> Circuit::getMeasuredQubits(std::size_t numberOfQubits) const {
+    std::vector<bool> measured(numberOfQubits, false);
+    for (auto const &controlledInstruction : controlledInstructions) {
+        auto const &instruction = controlledInstruction.instruction;
+        if (auto *measure = std::get_if<Circuit::Measure>(&instruction)) {
+            measured[measure->qubitIndex.value] = true;
+        } else if (std::get_if<Circuit::MeasureAll>(&instruction)) {
+            std::fill(measured.begin(), measured.end(), true);
+        }
+    }
+
+    std::vector<std::size_t> result;
+    for (std::size_t q = 0; q < numberOfQubits; ++q) {
+        if (measured[q]) {
+            result.push_back(q);
+        }
+    }
+    return result;
+}
+
+std::size_t Circuit::getMaxAmplitudeQubits(std::size_t numberOfQubits, std::size_t initialQubits) const {
+    std::size_t qubitsPerIteration = 0;
+    for (auto const &controlledInstruction : controlledInstructions) {
+        auto const &instruction = controlledInstruction.instruction;
+        if (auto *instruction1 = std::get_if<Unitary<1>>(&instruction)) {
+            qubitsPerIteration += getBranchingQubits(instruction1->matrix);
+        } else if (auto *instruction2 = std::get_if<Unitary<2>>(&instruction)) {
+            qubitsPerIteration += getBranchingQubits(instruction2->matrix);
+        } else if (auto *controlledUnitary = std::get_if<ControlledUnitary>(&instruction)) {
+            qubitsPerIteration += getBranchingQubits(controlledUnitary->matrix);
+        }
+    }
+
+    // Every iteration adds at least one qubit, if any, so that the bound reaches numberOfQubits within as many.
+    auto iterationsToCount = std::min(iterations, numberOfQubits);
+    return std::min(numberOfQubits, initialQubits + qubitsPerIteration * iterationsToCount);
 }
 
+template void Circuit::execute(core::BasicQuantumState<float> &quantumState,
+                               error_models::ErrorModel const &errorModel) const;
+
+template void Circuit::execute(core::BasicQuantumState<double> &quantumState,
+                               error_models::ErrorModel const &errorModel) const;
+
+template void Circuit::execute(core::BasicDenseStateVector<float> &quantumState,
+                               error_models::ErrorModel const &errorModel) const;
+
+template void Circuit::execute(core::BasicDenseStateVector<double> &quantumState,
+                               error_models::ErrorModel const &errorModel) const;
+
+template void Circuit::execute(core::BasicDistributedStateVector<float> &quantumState,
+                               error_models::ErrorModel const &errorModel) const;
+
+template void Circuit::execute(core::BasicDistributedStateVector<double> &quantumState,
+                               error_models::ErrorModel const &errorModel) const;
+
+template void Circuit::executeBranching(core::BasicQuantumState<float> &quantumState, std::uint64_t shots,
+                                        BranchCallback const &callback) const;
+
+template void Circuit::executeBranching(core::BasicQuantumState<double> &quantumState, std::uint64_t shots,
+                                        BranchCallback const &callback) const;
+
 } // namespace qx
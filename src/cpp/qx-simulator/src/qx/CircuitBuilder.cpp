@@ -0,0 +1,94 @@
+#include "qx/CircuitBuilder.hpp"
+
+#include "qx/Circuit.hpp"
+#include "qx/CqasmGates.hpp"
+
+#include <algorithm>  // sort, adjacent_find
+#include <fmt/format.h>
+#include <stdexcept>  // runtime_error
+
+
+namespace qx {
+
+namespace {
+
+std::vector<core::QubitIndex> toQubitIndices(std::vector<std::size_t> const &qubits) {
+    std::vector<core::QubitIndex> result;
+    result.reserve(qubits.size());
+    for (auto qubit : qubits) {
+        result.push_back(core::QubitIndex{ qubit });
+    }
+    return result;
+}
+
+} // namespace
+
+CircuitBuilder::CircuitBuilder(std::size_t n)
+    : numberOfQubits(n), circuit(std::make_shared<Circuit>("circuit builder", 1)) {
+    if (numberOfQubits == 0 || numberOfQubits > config::MAX_QUBIT_NUMBER) {
+        error = fmt::format("Cannot build a circuit of {} qubits", numberOfQubits);
+    }
+}
+
+CircuitBuilder &CircuitBuilder::addGate(std::string const &name, std::vector<std::size_t> const &qubits,
+                                        std::optional<double> parameter,
+                                        std::vector<std::size_t> const &controlBits) {
+    if (!checkQubits(qubits, true) || !checkQubits(controlBits, false)) {
+        return *this;
+    }
+
+    try {
+        addCqasmGate(getCircuitToChange(), name, toQubitIndices(qubits), parameter, toQubitIndices(controlBits));
+    } catch (std::runtime_error const &e) {
+        if (!error) {
+            error = e.what();
+        }
+    }
+    return *this;
+}
+
+CircuitBuilder &CircuitBuilder::addMeasure(std::size_t qubit) {
+    if (checkQubits({ qubit }, true)) {
+        getCircuitToChange().addInstruction(Circuit::Measure{ core::QubitIndex{ qubit } });
+    }
+    return *this;
+}
+
+CircuitBuilder &CircuitBuilder::addMeasureAll() {
+    getCircuitToChange().addInstruction(Circuit::MeasureAll{});
+    return *this;
+}
+
+CircuitBuilder &CircuitBuilder::addReset(std::size_t qubit) {
+    if (checkQubits({ qubit }, true)) {
+        getCircuitToChange().addInstruction(Circuit::PrepZ{ core::QubitIndex{ qubit } });
+    }
+    return *this;
+}
+
+bool CircuitBuilder::checkQubits(std::vector<std::size_t> const &qubits, bool distinct) {
+    auto sorted = qubits;
+    std::sort(sorted.begin(), sorted.end());
+    std::optional<std::string> qubitError;
+    if (!sorted.empty() && sorted.back() >= numberOfQubits) {
+        qubitError = fmt::format("Qubit {} is out of range, the circuit has {} qubits", sorted.back(), numberOfQubits);
+    } else if (distinct && std::adjacent_find(sorted.begin(), sorted.end()) != sorted.end()) {
+        qubitError = fmt::format("Qubit {} is used twice by the same instruction",
+            *std::adjacent_find(sorted.begin(), sorted.end()));
+    }
+
+    if (qubitError && !error) {
+        error = std::move(qubitError);
+    }
+    return !qubitError;
+}
+
+Circuit &CircuitBuilder::getCircuitToChange() {
+    // Copy on write: the circuit may have been handed out by getCircuit.
+    if (circuit.use_count() > 1) {
+        circuit = std::make_shared<Circuit>(*circuit);
+    }
+    return *circuit;
+}
+
+} // namespace qx
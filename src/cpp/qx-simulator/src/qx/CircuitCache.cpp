@@ -0,0 +1,107 @@
+#include "qx/CircuitCache.hpp"
+
+#include "absl/hash/hash.h"
+
+
+namespace qx {
+
+namespace {
+
+std::size_t estimateBytes(std::string const &source, std::string const &version, Circuit const &circuit) {
+    static constexpr std::size_t BYTES_PER_INSTRUCTION = sizeof(Circuit::ControlledInstruction);
+
+    return source.size() + version.size() + sizeof(Circuit) +
+        circuit.getNumberOfInstructions() * BYTES_PER_INSTRUCTION;
+}
+
+} // namespace
+
+CircuitCache &CircuitCache::getInstance() {
+    static CircuitCache instance;
+    return instance;
+}
+
+std::size_t CircuitCache::getHash(std::string const &source, std::string const &version) {
+    return absl::HashOf(source, version);
+}
+
+std::optional<CircuitCache::Entry> CircuitCache::find(std::string const &source, std::string const &version) {
+    auto hash = getHash(source, version);
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto it = index.find(hash);
+    // The source text is compared as well, so that hash collisions are simply misses.
+    if (it == index.end() || it->second->source != source || it->second->version != version) {
+        ++misses;
+        return std::nullopt;
+    }
+
+    lru.splice(lru.begin(), lru, it->second);
+    ++hits;
+    return it->second->entry;
+}
+
+void CircuitCache::insert(std::string const &source, std::string const &version, Entry entry) {
+    assert(entry.circuit);
+
+    auto hash = getHash(source, version);
+    auto entryBytes = sizeof(Node) + estimateBytes(source, version, *entry.circuit);
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (auto it = index.find(hash); it != index.end()) {
+        bytes -= it->second->bytes;
+        lru.erase(it->second);
+        index.erase(it);
+    }
+
+    if (entryBytes > maxBytes) {
+        return;
+    }
+
+    evict(maxBytes - entryBytes);
+
+    lru.push_front(Node{ .hash = hash, .source = source, .version = version, .entry = std::move(entry),
+        .bytes = entryBytes });
+    index[hash] = lru.begin();
+    bytes += entryBytes;
+}
+
+void CircuitCache::evict(std::size_t targetBytes) {
+    while (bytes > targetBytes) {
+        assert(!lru.empty());
+        auto const &last = lru.back();
+        bytes -= last.bytes;
+        index.erase(last.hash);
+        lru.pop_back();
+        ++evictions;
+    }
+}
+
+void CircuitCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    lru.clear();
+    index.clear();
+    bytes = 0;
+    hits = 0;
+    misses = 0;
+    evictions = 0;
+}
+
+void CircuitCache::setMaxBytes(std::size_t m) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    maxBytes = m;
+    evict(maxBytes);
+}
+
+CircuitCacheStatistics CircuitCache::getStatistics() const {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    return CircuitCacheStatistics{ .hits = hits, .misses = misses, .evictions = evictions, .entries = lru.size(),
+        .bytes = bytes, .maxBytes = maxBytes };
+}
+
+} // namespace qx
@@ -1,21 +1,28 @@
 #include "qx/Core.hpp"
 
+#include "qx/Snapshot.hpp"
+
+#include <algorithm>  // clamp, sort
+#include <optional>
+#include <type_traits>  // remove_reference_t
+#include <stdexcept>  // runtime_error
+
 namespace qx::core {
 
 namespace {
 
-template <std::size_t NumberOfOperands>
-void applyImpl(DenseUnitaryMatrix<1 << NumberOfOperands> const &matrix,
+template <typename T, std::size_t NumberOfOperands>
+void applyImpl(GateMatrix<T, 1 << NumberOfOperands> const &matrix,
                std::array<QubitIndex, NumberOfOperands> const &operands,
-               BasisVector index, std::complex<double> value,
-               SparseArray::Map &storage) {
+               BasisVector index, std::complex<T> value,
+               typename BasicSparseArray<T>::Map &storage) {
     utils::Bitset<NumberOfOperands> reducedIndex;
     for (std::size_t i = 0; i < NumberOfOperands; ++i) {
         reducedIndex.set(i, index.test(operands[NumberOfOperands - i - 1].value));
     }
 
     for (std::size_t i = 0; i < (1 << NumberOfOperands); ++i) {
-        std::complex<double> addedValue = value * matrix.at(i, reducedIndex.toSizeT());
+        std::complex<T> addedValue = value * matrix[i][reducedIndex.toSizeT()];
 
         if (isNotNull(addedValue)) {
             auto newIndex = index;
@@ -33,40 +40,770 @@ void applyImpl(DenseUnitaryMatrix<1 << NumberOfOperands> const &matrix,
 
 } // namespace
 
-void SparseArray::set(BasisVector index, std::complex<double> value) {
+void checkMarginalQubits(std::span<QubitIndex const> qubits, std::size_t numberOfQubits) {
+    if (qubits.size() > config::MAX_MARGINAL_QUBITS) {
+        throw std::runtime_error("Cannot compute the marginal probabilities of more than " +
+            std::to_string(config::MAX_MARGINAL_QUBITS) + " qubits");
+    }
+
+    BasisVector seen;
+    for (auto const &qubit : qubits) {
+        if (qubit.value >= numberOfQubits) {
+            throw std::runtime_error("Qubit index " + std::to_string(qubit.value) + " is out of range");
+        }
+        if (seen.test(qubit.value)) {
+            throw std::runtime_error("Qubit index " + std::to_string(qubit.value) + " is repeated");
+        }
+        seen.set(qubit.value);
+    }
+}
+
+void checkPauliTerm(PauliTerm const &term, std::size_t numberOfQubits) {
+    if (term.paulis.size() != numberOfQubits) {
+        throw std::runtime_error("Pauli string " + term.paulis + " does not have " + std::to_string(numberOfQubits) +
+            " operators");
+    }
+    if (term.paulis.find_first_not_of("IXYZ") != std::string::npos) {
+        throw std::runtime_error("Pauli string " + term.paulis + " has an operator other than I, X, Y and Z");
+    }
+}
+
+void MemoryTracker::update(std::uint64_t oldBytes, std::uint64_t newBytes) {
+    assert(oldBytes <= bytes);
+    auto total = bytes - oldBytes + newBytes;
+    if (budget > 0 && total > budget) {
+        throw std::runtime_error("the amplitudes take " + std::to_string(total) +
+            " bytes, more than the memory budget of " + std::to_string(budget) + " bytes");
+    }
+    bytes = total;
+    peakBytes = std::max(peakBytes, bytes);
+}
+
+void MemoryTracker::check(std::uint64_t addedBytes) const {
+    if (budget > 0 && addedBytes > budget - std::min(bytes, budget)) {
+        throw std::runtime_error("the amplitudes could take " + std::to_string(addedBytes) +
+            " more bytes with the next gate, more than what is left of the memory budget of " +
+            std::to_string(budget) + " bytes");
+    }
+}
+
+template <typename T>
+std::complex<T> BasicSparseArray<T>::get(BasisVector index) const {
+    if (storage == SparseStorage::SortedArray) {
+        auto it = std::lower_bound(sortedData.begin(), sortedData.end(), index,
+            [](auto const &kv, auto const &i) { return kv.first < i; });
+        return it != sortedData.end() && it->first == index ? it->second : 0;
+    }
+    auto it = data.find(index);
+    return it != data.end() ? it->second : 0;
+}
+
+template <typename T>
+void BasicSparseArray<T>::set(BasisVector index, std::complex<T> value) {
 #ifndef NDEBUG
     if (index.toSizeT() >= size) {
         throw std::runtime_error("SparseArray::set index out of bounds");
     }
 #endif
 
-    if (std::abs(value) < config::EPS) {
+    if (std::abs(value) < config::EPSILON<T>) {
+        return;
+    }
+
+    if (storage == SparseStorage::SortedArray) {
+        auto it = std::lower_bound(sortedData.begin(), sortedData.end(), index,
+            [](auto const &kv, auto const &i) { return kv.first < i; });
+        if (it == sortedData.end() || !(it->first == index)) {
+            sortedData.emplace(it, index, value);
+        }
         return;
     }
 
     data.try_emplace(index, value);
 }
 
-void SparseArray::cleanupZeros() {
-    absl::erase_if(data, [](auto const &kv) { return !isNotNull(kv.second); });
+template <typename T>
+void BasicSparseArray<T>::assign(SortedArray amplitudes) {
+    if (storage == SparseStorage::SortedArray) {
+        auto byBasisVector = [](auto const &left, auto const &right) { return left.first < right.first; };
+        if (!std::is_sorted(amplitudes.begin(), amplitudes.end(), byBasisVector)) {
+            std::sort(amplitudes.begin(), amplitudes.end(), byBasisVector);
+        }
+        sortedData.swap(amplitudes);
+        return;
+    }
+
+    data.clear();
+    data.reserve(amplitudes.size());
+    for (auto const &[index, value] : amplitudes) {
+        data.try_emplace(index, value);
+    }
+}
+
+// The merge relies on the fact that clearing the operand bits keeps the order of the basis vectors that have the same
+// operand bits. The basis vectors are split into one sorted run per value of their operand bits, or into the run of
+// the inactive ones when a control bit is not set. The runs of the active ones are merged on the other bits, which
+// pairs up the amplitudes that the gate mixes, and each output value of the operand bits again makes a sorted run.
+// Finally, the output runs and the inactive run are merged on the whole basis vector.
+template <typename T>
+template <std::size_t NumberOfOperands>
+void BasicSparseArray<T>::applySorted(GateMatrix<T, 1 << NumberOfOperands> const &matrix,
+                                      std::array<QubitIndex, NumberOfOperands> const &operands,
+                                      BasisVector controlMask) {
+    assert(storage == SparseStorage::SortedArray);
+    static constexpr std::size_t NUMBER_OF_RUNS = 1 << NumberOfOperands;
+
+    // Bit i of the value of the operand bits is operands[NumberOfOperands - i - 1], as in the gate matrix.
+    std::array<std::size_t, NumberOfOperands> operandBits;
+    std::size_t operandMask = 0;
+    for (std::size_t i = 0; i < NumberOfOperands; ++i) {
+        operandBits[i] = static_cast<std::size_t>(1) << operands[NumberOfOperands - i - 1].value;
+        operandMask |= operandBits[i];
+    }
+    auto controls = controlMask.toSizeT();
+
+    std::array<SortedArray, NUMBER_OF_RUNS> inputRuns;
+    SortedArray inactive;
+    for (auto const &kv : sortedData) {
+        auto index = kv.first.toSizeT();
+        if ((index & controls) != controls) {
+            inactive.push_back(kv);
+            continue;
+        }
+        std::size_t run = 0;
+        for (std::size_t i = 0; i < NumberOfOperands; ++i) {
+            run |= static_cast<std::size_t>((index & operandBits[i]) != 0) << i;
+        }
+        inputRuns[run].emplace_back(BasisVector::fromSizeT(index & ~operandMask), kv.second);
+    }
+
+    std::array<SortedArray, NUMBER_OF_RUNS> outputRuns;
+    std::array<std::size_t, NUMBER_OF_RUNS> positions{};
+    while (true) {
+        auto rest = std::numeric_limits<std::size_t>::max();
+        for (std::size_t run = 0; run < NUMBER_OF_RUNS; ++run) {
+            if (positions[run] < inputRuns[run].size()) {
+                rest = std::min(rest, inputRuns[run][positions[run]].first.toSizeT());
+            }
+        }
+        if (rest == std::numeric_limits<std::size_t>::max()) {
+            break;
+        }
+
+        std::array<std::complex<T>, NUMBER_OF_RUNS> input{};
+        for (std::size_t run = 0; run < NUMBER_OF_RUNS; ++run) {
+            if (positions[run] < inputRuns[run].size() &&
+                inputRuns[run][positions[run]].first.toSizeT() == rest) {
+                input[run] = inputRuns[run][positions[run]++].second;
+            }
+        }
+
+        for (std::size_t i = 0; i < NUMBER_OF_RUNS; ++i) {
+            std::complex<T> output = 0;
+            for (std::size_t j = 0; j < NUMBER_OF_RUNS; ++j) {
+                output += matrix[i][j] * input[j];
+            }
+            if (isNotNull(output)) {
+                auto index = rest;
+                for (std::size_t k = 0; k < NumberOfOperands; ++k) {
+                    if (utils::getBit(i, k)) {
+                        index |= operandBits[k];
+                    }
+                }
+                outputRuns[i].emplace_back(BasisVector::fromSizeT(index), output);
+            }
+        }
+    }
+
+    auto resultSize = inactive.size();
+    for (auto const &run : outputRuns) {
+        resultSize += run.size();
+    }
+    SortedArray result;
+    result.reserve(resultSize);
+    std::array<std::size_t, NUMBER_OF_RUNS + 1> outputPositions{};
+    auto getRun = [&outputRuns, &inactive](std::size_t run) -> SortedArray const & {
+        return run < NUMBER_OF_RUNS ? outputRuns[run] : inactive;
+    };
+    while (true) {
+        std::size_t next = NUMBER_OF_RUNS + 1;
+        for (std::size_t run = 0; run <= NUMBER_OF_RUNS; ++run) {
+            auto const &r = getRun(run);
+            if (outputPositions[run] < r.size() &&
+                (next > NUMBER_OF_RUNS || r[outputPositions[run]].first < getRun(next)[outputPositions[next]].first)) {
+                next = run;
+            }
+        }
+        if (next > NUMBER_OF_RUNS) {
+            break;
+        }
+        result.push_back(getRun(next)[outputPositions[next]++]);
+    }
+
+    sortedData.swap(result);
+}
+
+template <typename T>
+std::uint64_t BasicSparseArray<T>::getMemoryBytes() const {
+    // A hash map slot has one byte of metadata.
+    return (data.capacity() + scratch.capacity()) * (sizeof(typename Map::value_type) + 1) +
+        sortedData.capacity() * sizeof(typename SortedArray::value_type);
+}
+
+template <typename T>
+void BasicSparseArray<T>::shrink(std::uint64_t maxBytes) {
+    assert(data.empty() && sortedData.empty());
+    std::uint64_t bytes = 0;
+    auto keep = [&bytes, maxBytes](auto &container, std::uint64_t bytesPerElement) {
+        auto containerBytes = container.capacity() * bytesPerElement;
+        if (containerBytes > maxBytes - bytes) {
+            std::remove_reference_t<decltype(container)>().swap(container);
+        } else {
+            bytes += containerBytes;
+        }
+    };
+    keep(data, sizeof(typename Map::value_type) + 1);
+    keep(scratch, sizeof(typename Map::value_type) + 1);
+    keep(sortedData, sizeof(typename SortedArray::value_type));
+}
+
+template <typename T>
+std::uint64_t BasicSparseArray<T>::getMaxMemoryBytes(std::uint64_t numberOfAmplitudes, SparseStorage storage) {
+    // A hash map grows to twice its capacity when it is 7/8 full, so it has at most 16/7 slots per amplitude, and there
+    // are two of them during a gate. The merge of a sorted array holds the amplitudes before the gate, the runs,
+    // whose capacity grows by doubling, and the result.
+    auto bytesPerAmplitude = storage == SparseStorage::SortedArray
+        ? 5 * sizeof(typename SortedArray::value_type)
+        : 2 * 16 * (sizeof(typename Map::value_type) + 1) / 7 + 1;
+    auto constexpr MAX_BYTES = std::numeric_limits<std::uint64_t>::max();
+    if (numberOfAmplitudes > MAX_BYTES / bytesPerAmplitude) {
+        return MAX_BYTES;
+    }
+    return numberOfAmplitudes * bytesPerAmplitude;
+}
+
+template <typename T>
+void BasicSparseArray<T>::cleanupZeros() {
+    eraseIf([](auto const &kv) { return !isNotNull(kv.second); });
     zeroCounter = 0;
 }
 
-void QuantumState::testInitialize(
+template <typename T>
+void BasicQuantumState<T>::testInitialize(
     std::initializer_list<std::pair<std::string, std::complex<double>>> values) {
-    data.clear();
+    reset();
+
+    BasisVector allQubits;
+    for (std::size_t q = 0; q < numberOfQubits; ++q) {
+        allQubits.set(q);
+        groupIndices[q] = 0;
+    }
+    groups.push_back(QubitGroup{ allQubits, takeAmplitudes() });
+
+    auto &data = groups.back().amplitudes;
     double norm = 0;
     for (auto const &kv : values) {
         BasisVector index(kv.first);
-        data.set(index, kv.second);
+        data.set(index, static_cast<std::complex<T>>(kv.second));
         norm += std::norm(kv.second);
     }
-    assert(!isNotNull(norm - 1));
+    assert(!isNotNull<double>(norm - 1));
+}
+
+template <typename T>
+Snapshot BasicQuantumState<T>::getSnapshot() {
+    return Snapshot::fromSortedAmplitudes(numberOfQubits, getSortedJointState(), measurementRegister);
+}
+
+template <typename T>
+void BasicQuantumState<T>::restore(Snapshot const &snapshot) {
+    if (snapshot.numberOfQubits != numberOfQubits) {
+        throw std::runtime_error("Snapshot has " + std::to_string(snapshot.numberOfQubits) +
+            " qubits instead of " + std::to_string(numberOfQubits));
+    }
+
+    reset();
+
+    typename BasicSparseArray<T>::SortedArray values;
+    values.reserve(snapshot.getNumberOfAmplitudes());
+    BasisVector qubits;
+    snapshot.forEach([&values, &qubits](BasisVector basisVector, std::complex<double> amplitude) {
+        values.emplace_back(basisVector, static_cast<std::complex<T>>(amplitude));
+        qubits |= basisVector;
+    });
+
+    if (values.empty()) {
+        throw std::runtime_error("Snapshot has no non-zero amplitude");
+    }
+    for (std::size_t q = numberOfQubits; q < config::MAX_QUBIT_NUMBER; ++q) {
+        if (qubits.test(q)) {
+            throw std::runtime_error("Snapshot has a basis vector beyond its number of qubits");
+        }
+    }
+
+    // All the qubits that are 1 in some basis vector end up in the group, all the others are |0>.
+    // A group is still needed for a (global phase times) 00...000 state.
+    if (qubits.count() == 0) {
+        qubits.set(0);
+    }
+    for (std::size_t q = 0; q < numberOfQubits; ++q) {
+        if (qubits.test(q)) {
+            groupIndices[q] = 0;
+        }
+    }
+    auto amplitudes = takeAmplitudes();
+    amplitudes.assign(std::move(values));
+    groups.push_back(QubitGroup{ qubits, std::move(amplitudes) });
+    measurementRegister = snapshot.measurementRegister;
+    updateMemoryBytes();
+}
+
+template <typename T>
+std::size_t BasicQuantumState<T>::mergeGroups(std::span<QubitIndex const> operands) {
+    std::size_t result = NO_GROUP;
+
+    for (auto const &operand : operands) {
+        auto groupIndex = groupIndices[operand.value];
+
+        if (groupIndex == NO_GROUP) {
+            if (result == NO_GROUP) {
+                BasisVector qubits;
+                qubits.set(operand.value);
+                groups.push_back(QubitGroup{ qubits, takeAmplitudes() });
+                groups.back().amplitudes.set(BasisVector{}, 1);
+                result = groups.size() - 1;
+            } else {
+                // Tensor product with |0> leaves all the basis vectors unchanged.
+                groups[result].qubits.set(operand.value);
+            }
+            groupIndices[operand.value] = result;
+        } else if (result == NO_GROUP) {
+            result = groupIndex;
+        } else if (groupIndex != result) {
+            result = tensorProduct(result, groupIndex);
+        }
+    }
+
+    assert(result != NO_GROUP);
+    return result;
+}
+
+template <typename T>
+std::size_t BasicQuantumState<T>::tensorProduct(std::size_t left, std::size_t right) {
+    assert(left != right);
+
+    auto &leftGroup = groups[left];
+    auto &rightGroup = groups[right];
+
+    typename BasicSparseArray<T>::SortedArray product;
+    leftGroup.amplitudes.visit([&](auto const &leftAmplitudes) {
+        rightGroup.amplitudes.visit([&](auto const &rightAmplitudes) {
+            product.reserve(leftAmplitudes.size() * rightAmplitudes.size());
+            for (auto const &[leftIndex, leftValue] : leftAmplitudes) {
+                for (auto const &[rightIndex, rightValue] : rightAmplitudes) {
+                    auto index = leftIndex;
+                    index ^= leftGroup.flippedBits;
+                    auto otherIndex = rightIndex;
+                    otherIndex ^= rightGroup.flippedBits;
+                    index |= otherIndex;
+                    product.emplace_back(index, leftValue * rightValue);
+                }
+            }
+        });
+    });
+    leftGroup.amplitudes.assign(std::move(product));
+    leftGroup.qubits |= rightGroup.qubits;
+    leftGroup.flippedBits.reset();
+
+    for (std::size_t q = 0; q < numberOfQubits; ++q) {
+        if (rightGroup.qubits.test(q)) {
+            groupIndices[q] = left;
+        }
+    }
+
+    eraseGroup(right);
+
+    return left == groups.size() ? right : left;
+}
+
+template <typename T>
+void BasicQuantumState<T>::eraseGroup(std::size_t groupIndex) {
+    recycleAmplitudes(groups[groupIndex].amplitudes);
+    auto last = groups.size() - 1;
+    if (groupIndex != last) {
+        groups[groupIndex] = std::move(groups[last]);
+        for (std::size_t q = 0; q < numberOfQubits; ++q) {
+            if (groups[groupIndex].qubits.test(q)) {
+                groupIndices[q] = groupIndex;
+            }
+        }
+    }
+    groups.pop_back();
+}
+
+template <typename T>
+BasicSparseArray<T> BasicQuantumState<T>::takeAmplitudes() {
+    if (spareAmplitudes.empty()) {
+        return BasicSparseArray<T>(1 << numberOfQubits, storage);
+    }
+    auto amplitudes = std::move(spareAmplitudes.back());
+    spareAmplitudes.pop_back();
+    groupsChanged = true;
+    return amplitudes;
+}
+
+template <typename T>
+void BasicQuantumState<T>::recycleAmplitudes(BasicSparseArray<T> &amplitudes) {
+    amplitudes.clear();
+    spareAmplitudes.push_back(std::move(amplitudes));
+    groupsChanged = true;
+}
+
+template <typename T>
+void BasicQuantumState<T>::shrinkSpareAmplitudes(std::uint64_t maxBytes) {
+    std::uint64_t bytes = 0;
+    for (auto &amplitudes : spareAmplitudes) {
+        amplitudes.shrink(maxBytes - bytes);
+        bytes += amplitudes.getMemoryBytes();
+    }
+    groupsChanged = true;
+    updateMemoryBytes();
+}
+
+template <typename T>
+void BasicQuantumState<T>::setMemoryTracker(MemoryTracker *tracker) {
+    if (memoryTracker) {
+        memoryTracker->update(trackedBytes, 0);
+    }
+    memoryTracker = tracker;
+    trackedBytes = 0;
+    if (tracker && tracker->getBudget() > 0) {
+        auto usedBytes = tracker->getBytes();
+        for (auto const &group : groups) {
+            usedBytes += group.amplitudes.getMemoryBytes();
+        }
+        shrinkSpareAmplitudes(tracker->getBudget() > usedBytes ? tracker->getBudget() - usedBytes : 0);
+    }
+    updateMemoryBytes();
+}
+
+template <typename T>
+std::uint64_t BasicQuantumState<T>::getMemoryBytes() const {
+    std::uint64_t result = 0;
+    for (auto const &group : groups) {
+        result += group.amplitudes.getMemoryBytes();
+    }
+    for (auto const &amplitudes : spareAmplitudes) {
+        result += amplitudes.getMemoryBytes();
+    }
+    return result;
+}
+
+template <typename T>
+void BasicQuantumState<T>::updateMemoryBytes() {
+    if (!memoryTracker) {
+        return;
+    }
+    auto bytes = getMemoryBytes();
+    memoryTracker->update(trackedBytes, bytes);
+    trackedBytes = bytes;
+    groupsChanged = false;
+}
+
+// Going through all the groups after each gate would take as long as the gate itself for small groups.
+// Measurements and decays are not followed by an update, since they do not grow the amplitudes.
+template <typename T>
+void BasicQuantumState<T>::updateMemoryBytesAfterGate(BasicSparseArray<T> const &amplitudes,
+                                                      std::uint64_t bytesBefore) {
+    if (groupsChanged || amplitudes.getMemoryBytes() != bytesBefore) {
+        updateMemoryBytes();
+    }
+}
+
+template <typename T>
+void BasicQuantumState<T>::checkMemoryBytesBeforeGate(QubitGroup const &group, std::size_t nonZerosPerColumn) const {
+    if (!memoryTracker || memoryTracker->getBudget() == 0 || nonZerosPerColumn <= 1) {
+        return;
+    }
+
+    // The gate multiplies the number of amplitudes by at most nonZerosPerColumn, up to all the basis vectors.
+    std::uint64_t numberOfAmplitudes = group.amplitudes.getNumberOfStoredAmplitudes();
+    auto numberOfGroupQubits = group.qubits.count();
+    auto maxAmplitudes = numberOfGroupQubits < 64 ? static_cast<std::uint64_t>(1) << numberOfGroupQubits
+                                                  : std::numeric_limits<std::uint64_t>::max();
+    auto projectedAmplitudes = numberOfAmplitudes > maxAmplitudes / nonZerosPerColumn
+        ? maxAmplitudes
+        : numberOfAmplitudes * nonZerosPerColumn;
+    if (projectedAmplitudes <= numberOfAmplitudes) {
+        return;
+    }
+    auto bytesBefore = group.amplitudes.getMemoryBytes();
+    auto projectedBytes = BasicSparseArray<T>::getMaxMemoryBytes(projectedAmplitudes, storage);
+    if (projectedBytes > bytesBefore) {
+        memoryTracker->check(projectedBytes - bytesBefore);
+    }
+}
+
+template <typename T>
+double BasicQuantumState<T>::getProbabilityOfMeasuringOne(QubitIndex qubitIndex) const {
+    auto groupIndex = groupIndices[qubitIndex.value];
+    if (groupIndex == NO_GROUP) {
+        return 0.;
+    }
+
+    // Zeros add nothing, so there is no need to clean them up first.
+    auto const &group = groups[groupIndex];
+    auto storedOne = !group.flippedBits.test(qubitIndex.value);
+    double probabilityOfMeasuringOne = 0.;
+    group.amplitudes.visit([&](auto const &amplitudes) {
+        for (auto const &kv : amplitudes) {
+            if (kv.first.test(qubitIndex.value) == storedOne) {
+                probabilityOfMeasuringOne += std::norm(kv.second);
+            }
+        }
+    });
+    return probabilityOfMeasuringOne;
+}
+
+template <typename T>
+void BasicQuantumState<T>::collapse(QubitIndex qubitIndex, bool outcome, double probabilityOfOutcome, bool resetToZero) {
+    auto groupIndex = groupIndices[qubitIndex.value];
+    if (groupIndex == NO_GROUP) {
+        assert(!outcome);
+        return;
+    }
+
+    // Erases the other outcome and renormalizes in a single pass.
+    // There is nothing to do when 0 is measured with certainty, as for most syndrome qubits.
+    auto &group = groups[groupIndex];
+    auto storedOutcome = outcome != group.flippedBits.test(qubitIndex.value);
+    auto factor = static_cast<T>(std::sqrt(1 / probabilityOfOutcome));
+    auto certain = !outcome && probabilityOfOutcome == 1.;
+    if (!certain && storage == SparseStorage::SortedArray) {
+        group.amplitudes.eraseIf([&](auto const &kv) { return kv.first.test(qubitIndex.value) != storedOutcome; });
+        group.amplitudes *= factor;
+    } else if (!certain) {
+        auto &data = group.amplitudes.data;
+        for (auto it = data.begin(); it != data.end();) {
+            if (it->first.test(qubitIndex.value) != storedOutcome) {
+                data.erase(it++);
+            } else {
+                it->second *= factor;
+                ++it;
+            }
+        }
+    }
+
+    // A group of a single qubit keeps its global phase.
+    auto splitOff = group.qubits.count() > 1;
+    if (!splitOff && !(outcome && resetToZero)) {
+        return;
+    }
+
+    // The qubit is now 1 in all the basis vectors of the group, and needs to be 0.
+    // Clearing it in all of them keeps the sorted array sorted.
+    if (outcome && storage == SparseStorage::SortedArray) {
+        for (auto &kv : group.amplitudes.sortedData) {
+            kv.first.set(qubitIndex.value, false);
+        }
+    } else if (outcome) {
+        group.flippedBits.set(qubitIndex.value, !group.flippedBits.test(qubitIndex.value));
+    }
+
+    if (!splitOff) {
+        return;
+    }
+
+    group.qubits.set(qubitIndex.value, false);
+    groupIndices[qubitIndex.value] = NO_GROUP;
+
+    if (outcome && !resetToZero) {
+        BasisVector qubits;
+        qubits.set(qubitIndex.value);
+        groups.push_back(QubitGroup{ qubits, takeAmplitudes() });
+        groups.back().amplitudes.set(qubits, 1);
+        groupIndices[qubitIndex.value] = groups.size() - 1;
+    }
 }
 
+template <typename T>
+void BasicQuantumState<T>::dampWithoutDecay(QubitIndex qubitIndex, double gamma, double probabilityOfMeasuringOne) {
+    auto groupIndex = groupIndices[qubitIndex.value];
+    if (groupIndex == NO_GROUP) {
+        return;
+    }
+
+    auto &group = groups[groupIndex];
+    auto storedOne = !group.flippedBits.test(qubitIndex.value);
+    auto norm = 1 / std::sqrt(1 - gamma * probabilityOfMeasuringOne);
+    auto zeroFactor = static_cast<T>(norm);
+    auto oneFactor = static_cast<T>(std::sqrt(1 - gamma) * norm);
+    group.amplitudes.visit([&](auto &amplitudes) {
+        for (auto &kv : amplitudes) {
+            kv.second *= kv.first.test(qubitIndex.value) == storedOne ? oneFactor : zeroFactor;
+        }
+    });
+}
+
+template <typename T>
+BasisVector BasicQuantumState<T>::collapseAll(double rand) {
+    // A single random number is used for the joint distribution, which is the product of the group distributions:
+    // rand is rescaled to [0, 1) within the interval of the basis vector picked in each group.
+    BasisVector measuredState;
+
+    for (auto &group : groups) {
+        double probability = 0.;
+        std::optional<std::pair<BasisVector, std::complex<T>>> measuredGroupState;
+        std::optional<std::pair<BasisVector, std::complex<T>>> lastNonZero;
+
+        group.amplitudes.visit([&](auto const &amplitudes) {
+            for (auto const &kv : amplitudes) {
+                auto p = std::norm(kv.second);
+                if (p > 0.) {
+                    lastNonZero = kv;
+                }
+                probability += p;
+                if (probability > rand) {
+                    measuredGroupState = kv;
+                    rand = std::clamp((rand - (probability - p)) / p, 0., 1.);
+                    break;
+                }
+            }
+        });
+
+        // Rounding errors, or rand = 1: the outcome is the last basis vector with a non-zero amplitude, which leaves
+        // rand = 1 for the next groups.
+        if (!measuredGroupState) {
+            if (!lastNonZero) {
+                throw std::runtime_error("Vector was not normalized at measurement location (a bug)");
+            }
+            measuredGroupState = lastNonZero;
+            rand = 1.;
+        }
+        measuredGroupState->first ^= group.flippedBits;
+
+        group.amplitudes.clear();
+        group.flippedBits.reset();
+        group.amplitudes.set(measuredGroupState->first,
+            measuredGroupState->second / std::abs(measuredGroupState->second));
+        measuredState |= measuredGroupState->first;
+    }
+
+    return measuredState;
+}
+
+template <typename T>
+std::complex<T> BasicQuantumState<T>::getAmplitude(BasisVector basisVector) const {
+    // Qubits outside of all the groups are |0>.
+    for (std::size_t q = 0; q < config::MAX_QUBIT_NUMBER; ++q) {
+        if (basisVector.test(q) && (q >= numberOfQubits || groupIndices[q] == NO_GROUP)) {
+            return 0;
+        }
+    }
+
+    std::complex<T> result = 1;
+    for (auto const &group : groups) {
+        auto storedBasisVector = basisVector;
+        storedBasisVector &= group.qubits;
+        storedBasisVector ^= group.flippedBits;
+        result *= group.amplitudes.get(storedBasisVector);
+        if (result == std::complex<T>{}) {
+            return 0;
+        }
+    }
+    return result;
+}
+
+template <typename T>
+std::vector<double> BasicQuantumState<T>::getMarginalProbabilities(std::span<QubitIndex const> qubits) const {
+    checkMarginalQubits(qubits, numberOfQubits);
+
+    // The groups are independent, so the marginal distribution is the product of the marginal distributions
+    // over the queried qubits of each group. Queried qubits outside of all the groups are 0.
+    std::vector<double> result(static_cast<std::size_t>(1) << qubits.size(), 0.);
+    result[0] = 1.;
+
+    for (auto const &group : groups) {
+        std::size_t groupOutcomes = 0;
+        for (std::size_t i = 0; i < qubits.size(); ++i) {
+            if (group.qubits.test(qubits[i].value)) {
+                groupOutcomes |= static_cast<std::size_t>(1) << i;
+            }
+        }
+        if (groupOutcomes == 0) {
+            continue;
+        }
+
+        // Zeros add nothing, so there is no need to clean them up first.
+        std::vector<double> groupProbabilities(result.size(), 0.);
+        group.amplitudes.visit([&](auto const &amplitudes) {
+            for (auto const &[storedBasisVector, amplitude] : amplitudes) {
+                auto basisVector = storedBasisVector;
+                basisVector ^= group.flippedBits;
+                std::size_t outcome = 0;
+                for (std::size_t i = 0; i < qubits.size(); ++i) {
+                    if (basisVector.test(qubits[i].value)) {
+                        outcome |= static_cast<std::size_t>(1) << i;
+                    }
+                }
+                groupProbabilities[outcome] += std::norm(amplitude);
+            }
+        });
+
+        // The outcomes so far only have bits of the previous groups.
+        std::vector<double> product(result.size(), 0.);
+        for (std::size_t outcome = 0; outcome < result.size(); ++outcome) {
+            if ((outcome & groupOutcomes) != 0 || result[outcome] == 0.) {
+                continue;
+            }
+            for (auto groupOutcome = groupOutcomes;; groupOutcome = (groupOutcome - 1) & groupOutcomes) {
+                product[outcome | groupOutcome] = result[outcome] * groupProbabilities[groupOutcome];
+                if (groupOutcome == 0) {
+                    break;
+                }
+            }
+        }
+        result.swap(product);
+    }
+
+    return result;
+}
+
+template <typename T>
+std::vector<std::pair<BasisVector, std::complex<T>>> BasicQuantumState<T>::getSortedJointState() {
+    std::vector<std::pair<BasisVector, std::complex<T>>> result{ { BasisVector{}, 1 } };
+
+    for (auto &group : groups) {
+        group.amplitudes.cleanupZeros();
+
+        std::vector<std::pair<BasisVector, std::complex<T>>> product;
+        group.amplitudes.visit([&](auto const &amplitudes) {
+            product.reserve(result.size() * amplitudes.size());
+            for (auto const &[leftIndex, leftValue] : result) {
+                for (auto const &[rightIndex, rightValue] : amplitudes) {
+                    auto index = rightIndex;
+                    index ^= group.flippedBits;
+                    index |= leftIndex;
+                    product.emplace_back(index, leftValue * rightValue);
+                }
+            }
+        });
+        result.swap(product);
+    }
+
+    // With a single group in a sorted array, the joint state is already sorted.
+    std::erase_if(result, [](auto const &kv) { return !isNotNull(kv.second); });
+    auto byBasisVector = [](auto const &left, auto const &right) { return left.first < right.first; };
+    if (!std::is_sorted(result.begin(), result.end(), byBasisVector)) {
+        std::sort(result.begin(), result.end(), byBasisVector);
+    }
+    return result;
+}
+
+template <typename T>
 template <std::size_t NumberOfOperands>
-QuantumState &
-QuantumState::apply(DenseUnitaryMatrix<1 << NumberOfOperands> const &m,
+BasicQuantumState<T> &
+BasicQuantumState<T>::apply(DenseUnitaryMatrix<1 << NumberOfOperands> const &m,
                     std::array<QubitIndex, NumberOfOperands> const &operands) {
     assert(NumberOfOperands <= numberOfQubits &&
            "Quantum gate has more operands than the number of qubits in this "
@@ -77,24 +814,104 @@ QuantumState::apply(DenseUnitaryMatrix<1 << NumberOfOperands> const &m,
                         }) == operands.end() &&
            "Operand refers to a non-existing qubit");
 
-    data.applyLinear([&m, &operands](auto index, auto value, auto &storage) {
-        applyImpl<NumberOfOperands>(m, operands, index, value, storage); });
+    // The new basis vectors are stored without flipped bits.
+    auto matrix = toGateMatrix<T>(m);
+    auto &group = groups[mergeGroups(operands)];
+    if (memoryTracker) {
+        checkMemoryBytesBeforeGate(group, getMaxNonZerosPerColumn(m));
+    }
+    auto groupBytes = group.amplitudes.getMemoryBytes();
+    if (storage == SparseStorage::SortedArray) {
+        group.amplitudes.applySorted(matrix, operands, BasisVector{});
+        updateMemoryBytesAfterGate(group.amplitudes, groupBytes);
+        return *this;
+    }
+
+    auto flippedBits = group.flippedBits;
+    group.amplitudes.applyLinear([&matrix, &operands, flippedBits](auto index, auto value, auto &storage) {
+        index ^= flippedBits;
+        applyImpl<T, NumberOfOperands>(matrix, operands, index, value, storage); });
+    group.flippedBits.reset();
+    updateMemoryBytesAfterGate(group.amplitudes, groupBytes);
 
     return *this;
 }
 
+template <typename T>
+BasicQuantumState<T> &
+BasicQuantumState<T>::applyControlled(DenseUnitaryMatrix<2> const &m, std::span<QubitIndex const> controls,
+                                      QubitIndex target) {
+    assert(target.value < numberOfQubits && "Operand refers to a non-existing qubit");
+
+    std::vector<QubitIndex> operands(controls.begin(), controls.end());
+    operands.push_back(target);
+    BasisVector controlMask;
+    for (auto const &control : controls) {
+        assert(control.value < numberOfQubits && control.value != target.value && "Invalid control qubit");
+        controlMask.set(control.value);
+    }
+
+    auto matrix = toGateMatrix<T>(m);
+    std::array<QubitIndex, 1> const targetOperand{ target };
+    auto &group = groups[mergeGroups(operands)];
+    if (memoryTracker) {
+        checkMemoryBytesBeforeGate(group, getMaxNonZerosPerColumn(m));
+    }
+    auto groupBytes = group.amplitudes.getMemoryBytes();
+    if (storage == SparseStorage::SortedArray) {
+        group.amplitudes.applySorted(matrix, targetOperand, controlMask);
+        updateMemoryBytesAfterGate(group.amplitudes, groupBytes);
+        return *this;
+    }
+
+    auto flippedBits = group.flippedBits;
+    group.amplitudes.applyLinear([&](auto index, auto value, auto &storage) {
+        index ^= flippedBits;
+        auto controlBits = index;
+        controlBits &= controlMask;
+        if (controlBits == controlMask) {
+            applyImpl<T, 1>(matrix, targetOperand, index, value, storage);
+        } else {
+            // No other basis vector contributes to this one.
+            storage.emplace(index, value);
+        }
+    });
+    group.flippedBits.reset();
+    updateMemoryBytesAfterGate(group.amplitudes, groupBytes);
+
+    return *this;
+}
+
+template class BasicSparseArray<float>;
+template class BasicSparseArray<double>;
+
+template class BasicQuantumState<float>;
+template class BasicQuantumState<double>;
+
 // Explicit instantiation for use in Circuit::execute, otherwise linking error.
 
-template QuantumState &
-QuantumState::apply<1>(DenseUnitaryMatrix<1 << 1> const &m,
-                       std::array<QubitIndex, 1> const &operands);
+template BasicQuantumState<float> &
+BasicQuantumState<float>::apply<1>(DenseUnitaryMatrix<1 << 1> const &m,
+                                   std::array<QubitIndex, 1> const &operands);
+
+template BasicQuantumState<float> &
+BasicQuantumState<float>::apply<2>(DenseUnitaryMatrix<1 << 2> const &m,
+                                   std::array<QubitIndex, 2> const &operands);
+
+template BasicQuantumState<float> &
+BasicQuantumState<float>::apply<3>(DenseUnitaryMatrix<1 << 3> const &m,
+                                   std::array<QubitIndex, 3> const &operands);
+
+template BasicQuantumState<double> &
+BasicQuantumState<double>::apply<1>(DenseUnitaryMatrix<1 << 1> const &m,
+                                    std::array<QubitIndex, 1> const &operands);
 
-template QuantumState &
-QuantumState::apply<2>(DenseUnitaryMatrix<1 << 2> const &m,
-                       std::array<QubitIndex, 2> const &operands);
+template BasicQuantumState<double> &
+BasicQuantumState<double>::apply<2>(DenseUnitaryMatrix<1 << 2> const &m,
+                                    std::array<QubitIndex, 2> const &operands);
 
-template QuantumState &
-QuantumState::apply<3>(DenseUnitaryMatrix<1 << 3> const &m,
-                       std::array<QubitIndex, 3> const &operands);
+template BasicQuantumState<double> &
+BasicQuantumState<double>::apply<3>(DenseUnitaryMatrix<1 << 3> const &m,
+                                    std::array<QubitIndex, 3> const &operands);
 
 } // namespace qx::core
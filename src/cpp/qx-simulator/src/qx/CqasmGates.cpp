@@ -0,0 +1,188 @@
+#include "qx/CqasmGates.hpp"
+
+#include "qx/Gates.hpp"
+
+#include "absl/container/flat_hash_map.h"
+#include <algorithm>  // copy
+#include <array>
+#include <cassert>
+#include <cmath>  // pow, trunc
+#include <fmt/format.h>
+#include <stdexcept>  // runtime_error
+#include <utility>  // move, pair
+
+
+namespace qx {
+
+namespace {
+
+constexpr std::array<std::pair<std::string_view, CqasmGateId>, 22> CQASM_GATES{ {
+    { "I", CqasmGateId::I }, { "X", CqasmGateId::X }, { "Y", CqasmGateId::Y }, { "Z", CqasmGateId::Z },
+    { "H", CqasmGateId::H }, { "S", CqasmGateId::S }, { "Sdag", CqasmGateId::Sdag }, { "T", CqasmGateId::T },
+    { "Tdag", CqasmGateId::Tdag }, { "X90", CqasmGateId::X90 }, { "mX90", CqasmGateId::mX90 },
+    { "Y90", CqasmGateId::Y90 }, { "mY90", CqasmGateId::mY90 }, { "Rx", CqasmGateId::Rx },
+    { "Ry", CqasmGateId::Ry }, { "Rz", CqasmGateId::Rz }, { "CNOT", CqasmGateId::CNOT }, { "CZ", CqasmGateId::CZ },
+    { "CR", CqasmGateId::CR }, { "CRk", CqasmGateId::CRk }, { "SWAP", CqasmGateId::SWAP },
+    { "TOFFOLI", CqasmGateId::TOFFOLI }
+} };
+
+static_assert([] {
+    for (std::size_t i = 0; i < CQASM_GATES.size(); ++i) {
+        if (static_cast<std::size_t>(CQASM_GATES[i].second) != i) {
+            return false;
+        }
+    }
+    return true;
+}(), "CQASM_GATES must be in the order of CqasmGateId");
+
+std::string_view getName(CqasmGateId id) {
+    return CQASM_GATES[static_cast<std::size_t>(id)].first;
+}
+
+double getAngle(CqasmGateId id, std::optional<double> parameter) {
+    if (!parameter) {
+        throw std::runtime_error(fmt::format("Gate {} needs an angle", getName(id)));
+    }
+    return *parameter;
+}
+
+std::int64_t getInteger(CqasmGateId id, std::optional<double> parameter) {
+    if (!parameter || std::trunc(*parameter) != *parameter) {
+        throw std::runtime_error(fmt::format("Gate {} needs an integer", getName(id)));
+    }
+    return static_cast<std::int64_t>(*parameter);
+}
+
+Circuit::Unitary<1> makeUnitary(core::DenseUnitaryMatrix<2> const &matrix,
+                                std::optional<Circuit::GateParameter> parameter = std::nullopt) {
+    return Circuit::Unitary<1>{ matrix, {}, parameter };
+}
+
+Circuit::ControlledUnitary makeControlled(core::DenseUnitaryMatrix<2> const &matrix,
+                                          std::optional<Circuit::GateParameter> parameter = std::nullopt) {
+    return Circuit::ControlledUnitary{ {}, matrix, {}, parameter };
+}
+
+void add(Circuit &circuit, Circuit::Instruction instruction, std::vector<core::QubitIndex> const &controlBits) {
+    if (controlBits.empty()) {
+        circuit.addInstruction(std::move(instruction));
+    } else {
+        circuit.addInstruction(std::move(instruction), controlBits);
+    }
+}
+
+using Prototype = std::variant<Circuit::Unitary<1>, Circuit::Unitary<2>, Circuit::ControlledUnitary>;
+
+std::size_t getNumberOfOperands(CqasmGateId id) {
+    switch (id) {
+        case CqasmGateId::CNOT:
+        case CqasmGateId::CZ:
+        case CqasmGateId::CR:
+        case CqasmGateId::CRk:
+        case CqasmGateId::SWAP:
+            return 2;
+        case CqasmGateId::TOFFOLI:
+            return 3;
+        default:
+            return 1;
+    }
+}
+
+Prototype makePrototype(CqasmGateId id, std::optional<double> parameter) {
+    switch (id) {
+        case CqasmGateId::Rx:
+            return makeUnitary(gates::RX(getAngle(id, parameter)), Circuit::GateParameter{ gates::RX_GENERATOR });
+        case CqasmGateId::Ry:
+            return makeUnitary(gates::RY(getAngle(id, parameter)), Circuit::GateParameter{ gates::RY_GENERATOR });
+        case CqasmGateId::Rz:
+            return makeUnitary(gates::RZ(getAngle(id, parameter)), Circuit::GateParameter{ gates::RZ_GENERATOR });
+        case CqasmGateId::CR:
+            return makeControlled(gates::PHASE(getAngle(id, parameter)),
+                                  Circuit::GateParameter{ gates::PHASE_GENERATOR });
+        case CqasmGateId::CRk:
+            return makeControlled(
+                gates::PHASE(static_cast<double>(gates::PI) / std::pow(2, getInteger(id, parameter) - 1)));
+        default:
+            break;
+    }
+
+    if (parameter) {
+        throw std::runtime_error(fmt::format("Gate {} does not take a parameter", getName(id)));
+    }
+    switch (id) {
+        case CqasmGateId::I: return makeUnitary(gates::IDENTITY);
+        case CqasmGateId::X: return makeUnitary(gates::X);
+        case CqasmGateId::Y: return makeUnitary(gates::Y);
+        case CqasmGateId::Z: return makeUnitary(gates::Z);
+        case CqasmGateId::H: return makeUnitary(gates::H);
+        case CqasmGateId::S: return makeUnitary(gates::S);
+        case CqasmGateId::Sdag: return makeUnitary(gates::SDAG);
+        case CqasmGateId::T: return makeUnitary(gates::T);
+        case CqasmGateId::Tdag: return makeUnitary(gates::TDAG);
+        case CqasmGateId::X90: return makeUnitary(gates::X90);
+        case CqasmGateId::mX90: return makeUnitary(gates::MX90);
+        case CqasmGateId::Y90: return makeUnitary(gates::Y90);
+        case CqasmGateId::mY90: return makeUnitary(gates::MY90);
+        case CqasmGateId::CNOT: return makeControlled(gates::X);
+        case CqasmGateId::CZ: return makeControlled(gates::Z);
+        case CqasmGateId::SWAP: return Circuit::Unitary<2>{ gates::SWAP, {} };
+        case CqasmGateId::TOFFOLI: return makeControlled(gates::X);
+        default:
+            assert(false && "Parametric gate handled above");
+            return makeUnitary(gates::IDENTITY);
+    }
+}
+
+} // namespace
+
+std::optional<CqasmGateId> findCqasmGate(std::string_view name) {
+    static auto const gatesByName = [] {
+        absl::flat_hash_map<std::string_view, CqasmGateId> result;
+        for (auto const &[gateName, id] : CQASM_GATES) {
+            result.emplace(gateName, id);
+        }
+        return result;
+    }();
+
+    if (auto it = gatesByName.find(name); it != gatesByName.end()) {
+        return it->second;
+    }
+    return std::nullopt;
+}
+
+BoundCqasmGate::BoundCqasmGate(CqasmGateId gateId, std::optional<double> parameter)
+    : id(gateId), numberOfQubits(getNumberOfOperands(gateId)), prototype(makePrototype(gateId, parameter)) {}
+
+void BoundCqasmGate::addTo(Circuit &circuit, std::span<core::QubitIndex const> qubits,
+                           std::vector<core::QubitIndex> const &controlBits) const {
+    if (qubits.size() != numberOfQubits) {
+        throw std::runtime_error(fmt::format("Gate {} takes {} qubit operands, not {}", getName(id), numberOfQubits,
+            qubits.size()));
+    }
+
+    if (auto *unitary1 = std::get_if<Circuit::Unitary<1>>(&prototype)) {
+        auto unitary = *unitary1;
+        unitary.operands[0] = qubits[0];
+        add(circuit, unitary, controlBits);
+    } else if (auto *unitary2 = std::get_if<Circuit::Unitary<2>>(&prototype)) {
+        auto unitary = *unitary2;
+        std::copy(qubits.begin(), qubits.end(), unitary.operands.begin());
+        add(circuit, unitary, controlBits);
+    } else if (auto *controlledUnitary = std::get_if<Circuit::ControlledUnitary>(&prototype)) {
+        // The last qubit is the target, and the other ones are the controls.
+        add(circuit, Circuit::ControlledUnitary{ std::vector<core::QubitIndex>(qubits.begin(), qubits.end() - 1),
+                                                 controlledUnitary->matrix, qubits.back(),
+                                                 controlledUnitary->parameter }, controlBits);
+    }
+}
+
+void addCqasmGate(Circuit &circuit, std::string const &name, std::span<core::QubitIndex const> qubits,
+                  std::optional<double> parameter, std::vector<core::QubitIndex> const &controlBits) {
+    auto id = findCqasmGate(name);
+    if (!id) {
+        throw std::runtime_error("Unsupported gate or instruction: " + name);
+    }
+    BoundCqasmGate(*id, parameter).addTo(circuit, qubits, controlBits);
+}
+
+} // namespace qx
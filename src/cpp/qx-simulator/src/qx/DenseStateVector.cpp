@@ -0,0 +1,768 @@
+#include "qx/DenseStateVector.hpp"
+
+#include "qx/Snapshot.hpp"
+
+#include <algorithm>  // any_of, clamp, count_if, fill, min, max, sort, transform
+#include <bit>  // popcount
+#include <cerrno>
+#include <cstring>  // strerror
+#include <stdexcept>  // runtime_error
+#include <thread>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define QX_HAS_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+
+namespace qx::core {
+
+namespace {
+
+std::size_t bit(std::size_t position) {
+    return static_cast<std::size_t>(1) << position;
+}
+
+#ifdef QX_HAS_MMAP
+[[noreturn]] void throwSystemError(std::string const &what, std::string const &filePath) {
+    throw std::runtime_error(what + " '" + filePath + "' for the memory-mapped state vector: " + std::strerror(errno));
+}
+#endif
+
+} // namespace
+
+template <typename T>
+AmplitudeBuffer<T>::AmplitudeBuffer(std::size_t s, std::string const &filePath) : size(s) {
+    if (filePath.empty()) {
+        inMemory.resize(size);
+        return;
+    }
+
+#ifdef QX_HAS_MMAP
+    // An existing file is left alone rather than truncated, since it is removed right away.
+    fileDescriptor = ::open(filePath.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fileDescriptor < 0) {
+        throwSystemError("Cannot create file", filePath);
+    }
+
+    // The file only needs to live as long as the mapping.
+    ::unlink(filePath.c_str());
+
+    auto bytes = size * sizeof(std::complex<T>);
+    if (::ftruncate(fileDescriptor, static_cast<off_t>(bytes)) != 0) {
+        ::close(fileDescriptor);
+        throwSystemError("Cannot resize file", filePath);
+    }
+
+    auto *address = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fileDescriptor, 0);
+    if (address == MAP_FAILED) {
+        ::close(fileDescriptor);
+        throwSystemError("Cannot map file", filePath);
+    }
+
+    // All passes over the state vector are sequential block sweeps.
+    ::madvise(address, bytes, MADV_SEQUENTIAL);
+    mapped = static_cast<std::complex<T> *>(address);
+#else
+    throw std::runtime_error("Memory-mapped state vectors are not supported on this platform");
+#endif
+}
+
+template <typename T>
+AmplitudeBuffer<T>::~AmplitudeBuffer() {
+#ifdef QX_HAS_MMAP
+    if (mapped) {
+        ::munmap(mapped, size * sizeof(std::complex<T>));
+        ::close(fileDescriptor);
+    }
+#endif
+}
+
+template <typename T>
+void AmplitudeBuffer<T>::zero() {
+#ifdef QX_HAS_MMAP
+    if (mapped) {
+        // Truncating the file drops all its pages at once, and they read back as zeros once the file is extended again.
+        auto bytes = static_cast<off_t>(size * sizeof(std::complex<T>));
+        if (::ftruncate(fileDescriptor, 0) != 0 || ::ftruncate(fileDescriptor, bytes) != 0) {
+            std::fill(mapped, mapped + size, 0);
+        }
+        return;
+    }
+#endif
+    std::fill(inMemory.begin(), inMemory.end(), 0);
+}
+
+template <typename T>
+BasicDenseStateVector<T>::BasicDenseStateVector(std::size_t n, std::string const &filePath,
+                                                std::optional<std::size_t> b)
+    : numberOfQubits(n),
+      blockQubits(std::min(n, std::max(b.value_or(filePath.empty() ? n : config::MAPPED_DENSE_BLOCK_QUBITS),
+                                       MAX_NUMBER_OF_OPERANDS))),
+      amplitudes(bit(n), filePath),
+      qubitPositions(n),
+      lastUses(blockQubits, 0) {
+    assert(numberOfQubits > 0 && "DenseStateVector needs at least one qubit");
+    assert(numberOfQubits < config::MAX_QUBIT_NUMBER && "DenseStateVector cannot support that many qubits");
+
+    for (std::size_t q = 0; q < numberOfQubits; ++q) {
+        qubitPositions[q] = q;
+    }
+
+    reset();
+}
+
+template <typename T>
+void BasicDenseStateVector<T>::reset() {
+    // The qubit order is kept: state 00...000 is invariant under qubit permutations,
+    // and the order learned during the previous shot is likely to suit the next one.
+    amplitudes.zero();
+    amplitudes.data()[0] = 1;
+    measurementRegister.reset();
+}
+
+template <typename T>
+void BasicDenseStateVector<T>::testInitialize(
+    std::initializer_list<std::pair<std::string, std::complex<double>>> values) {
+    amplitudes.zero();
+    double norm = 0;
+    for (auto const &kv : values) {
+        amplitudes.data()[toIndex(BasisVector(kv.first))] = static_cast<std::complex<T>>(kv.second);
+        norm += std::norm(kv.second);
+    }
+    assert(!isNotNull<double>(norm - 1));
+}
+
+template <typename T>
+Snapshot BasicDenseStateVector<T>::getSnapshot() const {
+    return Snapshot::fromSortedAmplitudes(numberOfQubits, getSortedNonZeroAmplitudes(), measurementRegister);
+}
+
+template <typename T>
+void BasicDenseStateVector<T>::restore(Snapshot const &snapshot) {
+    if (snapshot.numberOfQubits != numberOfQubits) {
+        throw std::runtime_error("Snapshot has " + std::to_string(snapshot.numberOfQubits) +
+            " qubits instead of " + std::to_string(numberOfQubits));
+    }
+
+    auto *data = amplitudes.data();
+    if (snapshot.representation == Snapshot::Representation::Dense &&
+        std::is_sorted(qubitPositions.begin(), qubitPositions.end())) {
+        std::transform(snapshot.amplitudes.begin(), snapshot.amplitudes.end(), data,
+                       [](auto amplitude) { return static_cast<std::complex<T>>(amplitude); });
+    } else {
+        amplitudes.zero();
+        snapshot.forEach([this, data](BasisVector basisVector, std::complex<double> amplitude) {
+            if (basisVector.toSizeT() >= amplitudes.getSize()) {
+                throw std::runtime_error("Snapshot has a basis vector beyond its number of qubits");
+            }
+            data[toIndex(basisVector)] = static_cast<std::complex<T>>(amplitude);
+        });
+    }
+    measurementRegister = snapshot.measurementRegister;
+}
+
+template <typename T>
+void BasicDenseStateVector<T>::moveInBlock(QubitIndex qubitIndex, std::uint64_t &operandPositions) {
+    auto position = qubitPositions[qubitIndex.value];
+
+    if (position >= blockQubits) {
+        // Hot qubits are evicted last, and otherwise the least recently used position is.
+        std::vector<bool> isHotPosition(blockQubits, false);
+        for (std::size_t q = 0; q < numberOfQubits; ++q) {
+            if (hotQubits.test(q) && qubitPositions[q] < blockQubits) {
+                isHotPosition[qubitPositions[q]] = true;
+            }
+        }
+
+        std::size_t lowPosition = blockQubits;
+        for (std::size_t p = 0; p < blockQubits; ++p) {
+            if (!utils::getBit(operandPositions, p) &&
+                (lowPosition == blockQubits ||
+                 std::pair(isHotPosition[p], lastUses[p]) < std::pair(isHotPosition[lowPosition], lastUses[lowPosition]))) {
+                lowPosition = p;
+            }
+        }
+        assert(lowPosition < blockQubits);
+
+        swapPositions(position, lowPosition);
+        operandPositions &= ~bit(position);
+        operandPositions |= bit(lowPosition);
+        position = lowPosition;
+    }
+
+    lastUses[position] = numberOfGates;
+}
+
+template <typename T>
+void BasicDenseStateVector<T>::setHotQubits(std::span<QubitIndex const> qubits) {
+    hotQubits.reset();
+    auto numberOfMoves = std::min(qubits.size(), blockQubits);
+    std::uint64_t keptPositions = 0;
+    for (std::size_t i = 0; i < numberOfMoves; ++i) {
+        hotQubits.set(qubits[i].value);
+        keptPositions |= bit(qubitPositions[qubits[i].value]);
+    }
+    for (std::size_t i = 0; i < numberOfMoves; ++i) {
+        moveInBlock(qubits[i], keptPositions);
+    }
+}
+
+template <typename T>
+void BasicDenseStateVector<T>::swapPositions(std::size_t highPosition, std::size_t lowPosition) {
+    assert(highPosition >= blockQubits && lowPosition < blockQubits);
+
+    // Exchanges the amplitudes with (high, low) bits (0, 1) and (1, 0), two blocks at a time.
+    auto blockSize = bit(blockQubits);
+    auto highBit = bit(highPosition - blockQubits);
+    auto lowBit = bit(lowPosition);
+    auto *data = amplitudes.data();
+
+    for (std::size_t block = 0; block < getNumberOfBlocks(); ++block) {
+        if (block & highBit) {
+            continue;
+        }
+
+        auto *highZero = data + block * blockSize;
+        auto *highOne = data + (block | highBit) * blockSize;
+        for (std::size_t base = lowBit; base < blockSize; base += 2 * lowBit) {
+            std::swap_ranges(highZero + base, highZero + base + lowBit, highOne + base - lowBit);
+        }
+    }
+
+    auto high = std::find(qubitPositions.begin(), qubitPositions.end(), highPosition);
+    auto low = std::find(qubitPositions.begin(), qubitPositions.end(), lowPosition);
+    assert(high != qubitPositions.end() && low != qubitPositions.end());
+    std::iter_swap(high, low);
+
+    ++numberOfBlockSwaps;
+}
+
+template <typename T>
+template <std::size_t NumberOfOperands>
+typename BasicDenseStateVector<T>::template PreparedGate<NumberOfOperands>
+BasicDenseStateVector<T>::prepare(DenseUnitaryMatrix<1 << NumberOfOperands> const &m,
+                                  std::array<QubitIndex, NumberOfOperands> const &operands) {
+    static_assert(NumberOfOperands <= MAX_NUMBER_OF_OPERANDS);
+    assert(NumberOfOperands <= numberOfQubits &&
+           "Quantum gate has more operands than the number of qubits in this "
+           "quantum state");
+    assert(std::find_if(operands.begin(), operands.end(),
+                        [this](auto qubitIndex) {
+                            return qubitIndex.value >= numberOfQubits;
+                        }) == operands.end() &&
+           "Operand refers to a non-existing qubit");
+
+    ++numberOfGates;
+
+    std::uint64_t operandPositions = 0;
+    for (auto const &operand : operands) {
+        operandPositions |= bit(qubitPositions[operand.value]);
+    }
+    for (auto const &operand : operands) {
+        moveInBlock(operand, operandPositions);
+    }
+
+    // Column bit k corresponds to operand NumberOfOperands - k - 1, as in the sparse representation.
+    PreparedGate<NumberOfOperands> gate{ toGateMatrix<T>(m) };
+    for (std::size_t i = 0; i < gate.offsets.size(); ++i) {
+        for (std::size_t k = 0; k < NumberOfOperands; ++k) {
+            if (utils::getBit(i, k)) {
+                gate.offsets[i] |= bit(qubitPositions[operands[NumberOfOperands - k - 1].value]);
+            }
+        }
+    }
+
+    for (std::size_t k = 0; k < NumberOfOperands; ++k) {
+        gate.sortedPositions[k] = qubitPositions[operands[k].value];
+    }
+    std::sort(gate.sortedPositions.begin(), gate.sortedPositions.end());
+    return gate;
+}
+
+template <typename T>
+typename BasicDenseStateVector<T>::PreparedControlledGate
+BasicDenseStateVector<T>::prepare(ControlledGateReference const &gate) {
+    assert(gate.target.value < numberOfQubits && "Operand refers to a non-existing qubit");
+
+    ++numberOfGates;
+
+    // The controls can stay where they are.
+    std::uint64_t operandPositions = bit(qubitPositions[gate.target.value]);
+    moveInBlock(gate.target, operandPositions);
+
+    PreparedControlledGate prepared;
+    prepared.matrix = toGateMatrix<T>(gate.matrix);
+    prepared.targetBit = bit(qubitPositions[gate.target.value]);
+    prepared.sortedPositions.push_back(qubitPositions[gate.target.value]);
+    for (auto const &control : gate.controls) {
+        assert(control.value < numberOfQubits && control.value != gate.target.value && "Invalid control qubit");
+        prepared.controlMask |= bit(qubitPositions[control.value]);
+        prepared.sortedPositions.push_back(qubitPositions[control.value]);
+    }
+    std::sort(prepared.sortedPositions.begin(), prepared.sortedPositions.end());
+    return prepared;
+}
+
+template <typename T>
+template <std::size_t NumberOfOperands>
+void BasicDenseStateVector<T>::applyToTile(PreparedGate<NumberOfOperands> const &gate, std::complex<T> *tile,
+                                           std::size_t size) {
+    static constexpr std::size_t MATRIX_SIZE = 1 << NumberOfOperands;
+    std::array<std::complex<T>, MATRIX_SIZE> values{};
+
+    for (std::size_t i = 0; i < (size >> NumberOfOperands); ++i) {
+        // Insert zeros at the operand positions.
+        auto base = i;
+        for (auto p : gate.sortedPositions) {
+            base = ((base >> p) << (p + 1)) | (base & (bit(p) - 1));
+        }
+
+        for (std::size_t c = 0; c < MATRIX_SIZE; ++c) {
+            values[c] = tile[base + gate.offsets[c]];
+        }
+        for (std::size_t r = 0; r < MATRIX_SIZE; ++r) {
+            std::complex<T> value = 0;
+            for (std::size_t c = 0; c < MATRIX_SIZE; ++c) {
+                value += gate.matrix[r][c] * values[c];
+            }
+            tile[base + gate.offsets[r]] = value;
+        }
+    }
+}
+
+template <typename T>
+void BasicDenseStateVector<T>::applyToTile(PreparedControlledGate const &gate, std::complex<T> *tile, std::size_t size,
+                                           std::size_t start) {
+    assert(gate.targetBit < size);
+
+    // Controls beyond the tile are the same for all its amplitudes.
+    auto highControlMask = gate.controlMask & ~(size - 1);
+    if ((start & highControlMask) != highControlMask) {
+        return;
+    }
+
+    auto lowControlMask = gate.controlMask & (size - 1);
+    auto lowPositions = static_cast<std::size_t>(std::count_if(gate.sortedPositions.begin(),
+        gate.sortedPositions.end(), [size](auto p) { return bit(p) < size; }));
+
+    for (std::size_t i = 0; i < (size >> lowPositions); ++i) {
+        // Insert zeros at the operand positions, and set the control bits.
+        auto base = i;
+        for (std::size_t k = 0; k < lowPositions; ++k) {
+            auto p = gate.sortedPositions[k];
+            base = ((base >> p) << (p + 1)) | (base & (bit(p) - 1));
+        }
+        base |= lowControlMask;
+
+        auto zero = tile[base];
+        auto one = tile[base | gate.targetBit];
+        tile[base] = gate.matrix[0][0] * zero + gate.matrix[0][1] * one;
+        tile[base | gate.targetBit] = gate.matrix[1][0] * zero + gate.matrix[1][1] * one;
+    }
+}
+
+template <typename T>
+template <std::size_t NumberOfOperands>
+BasicDenseStateVector<T> &
+BasicDenseStateVector<T>::apply(DenseUnitaryMatrix<1 << NumberOfOperands> const &m,
+                                std::array<QubitIndex, NumberOfOperands> const &operands) {
+    // All the operands are in block, so the blocks can be processed as one.
+    applyToTile(prepare(m, operands), amplitudes.data(), amplitudes.getSize());
+    ++numberOfGateSweeps;
+    return *this;
+}
+
+template <typename T>
+BasicDenseStateVector<T> &
+BasicDenseStateVector<T>::applyControlled(DenseUnitaryMatrix<2> const &m, std::span<QubitIndex const> controls,
+                                          QubitIndex target) {
+    applyToTile(prepare(ControlledGateReference{ m, controls, target }), amplitudes.data(), amplitudes.getSize(), 0);
+    ++numberOfGateSweeps;
+    return *this;
+}
+
+template <typename T>
+template <std::size_t NumberOfOperands>
+void BasicDenseStateVector<T>::addToSequence(GateReference<NumberOfOperands> const &gate,
+                                             std::vector<AnyPreparedGate> &tiledGates) {
+    // A block swap changes the positions of the gates that are already prepared.
+    if (std::any_of(gate.operands.begin(), gate.operands.end(),
+                    [this](auto const &operand) { return qubitPositions[operand.value] >= blockQubits; })) {
+        applyTiled(tiledGates);
+    }
+
+    auto prepared = prepare(gate.matrix, gate.operands);
+    if (prepared.sortedPositions.back() < std::min(config::DENSE_TILE_QUBITS, blockQubits)) {
+        tiledGates.emplace_back(prepared);
+        return;
+    }
+
+    applyTiled(tiledGates);
+    applyToTile(prepared, amplitudes.data(), amplitudes.getSize());
+    ++numberOfGateSweeps;
+}
+
+template <typename T>
+void BasicDenseStateVector<T>::addToSequence(ControlledGateReference const &gate,
+                                             std::vector<AnyPreparedGate> &tiledGates) {
+    if (qubitPositions[gate.target.value] >= blockQubits) {
+        applyTiled(tiledGates);
+    }
+
+    auto prepared = prepare(gate);
+    if (prepared.targetBit < bit(std::min(config::DENSE_TILE_QUBITS, blockQubits))) {
+        tiledGates.emplace_back(std::move(prepared));
+        return;
+    }
+
+    applyTiled(tiledGates);
+    applyToTile(prepared, amplitudes.data(), amplitudes.getSize(), 0);
+    ++numberOfGateSweeps;
+}
+
+template <typename T>
+void BasicDenseStateVector<T>::applyTiled(std::vector<AnyPreparedGate> &tiledGates) {
+    if (tiledGates.empty()) {
+        return;
+    }
+
+    auto tileSize = bit(std::min(config::DENSE_TILE_QUBITS, blockQubits));
+    auto *data = amplitudes.data();
+    for (std::size_t start = 0; start < amplitudes.getSize(); start += tileSize) {
+        for (auto const &gate : tiledGates) {
+            // AppleClang doesn't support std::visit
+            if (auto *gate1 = std::get_if<PreparedGate<1>>(&gate)) {
+                applyToTile(*gate1, data + start, tileSize);
+            } else if (auto *gate2 = std::get_if<PreparedGate<2>>(&gate)) {
+                applyToTile(*gate2, data + start, tileSize);
+            } else if (auto *gate3 = std::get_if<PreparedGate<3>>(&gate)) {
+                applyToTile(*gate3, data + start, tileSize);
+            } else if (auto *controlledGate = std::get_if<PreparedControlledGate>(&gate)) {
+                applyToTile(*controlledGate, data + start, tileSize, start);
+            }
+        }
+    }
+
+    tiledGates.clear();
+    ++numberOfGateSweeps;
+}
+
+template <typename T>
+void BasicDenseStateVector<T>::applySequence(std::span<SequenceGate const> gates) {
+    std::vector<AnyPreparedGate> tiledGates;
+    for (auto const &gate : gates) {
+        if (auto *gate1 = std::get_if<GateReference<1>>(&gate)) {
+            addToSequence(*gate1, tiledGates);
+        } else if (auto *gate2 = std::get_if<GateReference<2>>(&gate)) {
+            addToSequence(*gate2, tiledGates);
+        } else if (auto *gate3 = std::get_if<GateReference<3>>(&gate)) {
+            addToSequence(*gate3, tiledGates);
+        } else if (auto *controlledGate = std::get_if<ControlledGateReference>(&gate)) {
+            addToSequence(*controlledGate, tiledGates);
+        }
+    }
+    applyTiled(tiledGates);
+}
+
+template <typename T>
+BasisVector BasicDenseStateVector<T>::toBasisVector(std::size_t index) const {
+    BasisVector result;
+    for (std::size_t q = 0; q < numberOfQubits; ++q) {
+        result.set(q, utils::getBit(index, qubitPositions[q]));
+    }
+    return result;
+}
+
+template <typename T>
+std::size_t BasicDenseStateVector<T>::toIndex(BasisVector basisVector) const {
+    std::size_t index = 0;
+    for (std::size_t q = 0; q < numberOfQubits; ++q) {
+        if (basisVector.test(q)) {
+            index |= bit(qubitPositions[q]);
+        }
+    }
+    return index;
+}
+
+template <typename T>
+double BasicDenseStateVector<T>::getProbabilityOfMeasuringOne(QubitIndex qubitIndex) const {
+    auto positionBit = bit(qubitPositions[qubitIndex.value]);
+    auto const *data = amplitudes.data();
+
+    double probabilityOfMeasuringOne = 0.;
+    for (std::size_t base = positionBit; base < amplitudes.getSize(); base += 2 * positionBit) {
+        for (std::size_t i = base; i < base + positionBit; ++i) {
+            probabilityOfMeasuringOne += std::norm(data[i]);
+        }
+    }
+    return probabilityOfMeasuringOne;
+}
+
+template <typename T>
+void BasicDenseStateVector<T>::dampWithoutDecay(QubitIndex qubitIndex, double gamma, double probabilityOfMeasuringOne) {
+    auto positionBit = bit(qubitPositions[qubitIndex.value]);
+    auto norm = 1 / std::sqrt(1 - gamma * probabilityOfMeasuringOne);
+    auto zeroFactor = static_cast<T>(norm);
+    auto oneFactor = static_cast<T>(std::sqrt(1 - gamma) * norm);
+    auto *data = amplitudes.data();
+
+    for (std::size_t base = 0; base < amplitudes.getSize(); base += 2 * positionBit) {
+        for (std::size_t i = base; i < base + positionBit; ++i) {
+            data[i] *= zeroFactor;
+            data[i + positionBit] *= oneFactor;
+        }
+    }
+}
+
+template <typename T>
+void BasicDenseStateVector<T>::collapse(QubitIndex qubitIndex, bool outcome, double probabilityOfOutcome, bool resetToZero) {
+    auto positionBit = bit(qubitPositions[qubitIndex.value]);
+    auto factor = static_cast<T>(std::sqrt(1 / probabilityOfOutcome));
+    auto *data = amplitudes.data();
+
+    // There is nothing to do when 0 is measured with certainty, as for most syndrome qubits.
+    if (!outcome && probabilityOfOutcome == 1.) {
+        return;
+    }
+
+    // Renormalization, erasure of the other outcome and reset all happen in the same single pass.
+    for (std::size_t base = 0; base < amplitudes.getSize(); base += 2 * positionBit) {
+        auto *zero = data + base;
+        auto *one = zero + positionBit;
+        if (!outcome) {
+            for (std::size_t i = 0; i < positionBit; ++i) {
+                zero[i] *= factor;
+                one[i] = 0;
+            }
+        } else if (resetToZero) {
+            for (std::size_t i = 0; i < positionBit; ++i) {
+                zero[i] = one[i] * factor;
+                one[i] = 0;
+            }
+        } else {
+            for (std::size_t i = 0; i < positionBit; ++i) {
+                zero[i] = 0;
+                one[i] *= factor;
+            }
+        }
+    }
+}
+
+template <typename T>
+BasisVector BasicDenseStateVector<T>::collapseAll(double rand) {
+    auto *data = amplitudes.data();
+
+    auto collapseTo = [this](std::size_t i) {
+        auto value = amplitudes.data()[i] / std::abs(amplitudes.data()[i]);
+        amplitudes.zero();
+        amplitudes.data()[i] = value;
+        return toBasisVector(i);
+    };
+
+    double probability = 0.;
+    std::optional<std::size_t> lastNonZero;
+    for (std::size_t i = 0; i < amplitudes.getSize(); ++i) {
+        auto norm = std::norm(data[i]);
+        if (norm > 0.) {
+            lastNonZero = i;
+        }
+        probability += norm;
+        if (probability > rand) {
+            return collapseTo(i);
+        }
+    }
+
+    // Rounding errors, or rand = 1: the outcome is the last basis vector with a non-zero amplitude.
+    if (lastNonZero) {
+        return collapseTo(*lastNonZero);
+    }
+
+    throw std::runtime_error("Vector was not normalized at measurement location (a bug)");
+}
+
+template <typename T>
+std::complex<T> BasicDenseStateVector<T>::getAmplitude(BasisVector basisVector) const {
+    if (basisVector.toSizeT() >= amplitudes.getSize()) {
+        return 0;
+    }
+    return amplitudes.data()[toIndex(basisVector)];
+}
+
+template <typename T>
+std::vector<double> BasicDenseStateVector<T>::getMarginalProbabilities(std::span<QubitIndex const> qubits) const {
+    checkMarginalQubits(qubits, numberOfQubits);
+
+    std::vector<std::size_t> positionBits;
+    for (auto const &qubit : qubits) {
+        positionBits.push_back(bit(qubitPositions[qubit.value]));
+    }
+
+    // Each thread sums up its own range of amplitudes.
+    auto size = amplitudes.getSize();
+    auto numberOfThreads = std::clamp<std::size_t>(
+        size / config::MIN_AMPLITUDES_PER_QUERY_THREAD, 1, std::max(1u, std::thread::hardware_concurrency()));
+    std::vector<std::vector<double>> partialResults(numberOfThreads, std::vector<double>(bit(qubits.size()), 0.));
+
+    auto sumUp = [this, size, numberOfThreads, &positionBits, &partialResults](std::size_t t) {
+        auto const *data = amplitudes.data();
+        auto &partialResult = partialResults[t];
+        for (std::size_t i = size * t / numberOfThreads; i < size * (t + 1) / numberOfThreads; ++i) {
+            std::size_t outcome = 0;
+            for (std::size_t b = 0; b < positionBits.size(); ++b) {
+                if (i & positionBits[b]) {
+                    outcome |= bit(b);
+                }
+            }
+            partialResult[outcome] += std::norm(data[i]);
+        }
+    };
+
+    {
+        std::vector<std::jthread> threads;
+        for (std::size_t t = 1; t < numberOfThreads; ++t) {
+            threads.emplace_back(sumUp, t);
+        }
+        sumUp(0);
+    }
+
+    auto &result = partialResults[0];
+    for (std::size_t t = 1; t < numberOfThreads; ++t) {
+        for (std::size_t outcome = 0; outcome < result.size(); ++outcome) {
+            result[outcome] += partialResults[t][outcome];
+        }
+    }
+    return result;
+}
+
+template <typename T>
+std::complex<double> BasicDenseStateVector<T>::innerProduct(BasicDenseStateVector const &other) const {
+    assert(qubitPositions == other.qubitPositions);
+    auto const *data = amplitudes.data();
+    auto const *otherData = other.amplitudes.data();
+
+    std::complex<double> result = 0.;
+    for (std::size_t i = 0; i < amplitudes.getSize(); ++i) {
+        result += std::conj(static_cast<std::complex<double>>(data[i])) * static_cast<std::complex<double>>(otherData[i]);
+    }
+    return result;
+}
+
+template <typename T>
+std::complex<double> BasicDenseStateVector<T>::getMatrixElement(BasicDenseStateVector const &other,
+                                                                GateMatrix<double, 2> const &m,
+                                                                std::span<QubitIndex const> controls,
+                                                                QubitIndex target) const {
+    assert(qubitPositions == other.qubitPositions);
+    auto targetBit = bit(qubitPositions[target.value]);
+    std::size_t controlMask = 0;
+    for (auto const &control : controls) {
+        controlMask |= bit(qubitPositions[control.value]);
+    }
+    auto const *data = amplitudes.data();
+    auto const *otherData = other.amplitudes.data();
+
+    std::complex<double> result = 0.;
+    for (std::size_t i = 0; i < amplitudes.getSize(); ++i) {
+        if ((i & (controlMask | targetBit)) != controlMask) {
+            continue;
+        }
+        auto zero = static_cast<std::complex<double>>(otherData[i]);
+        auto one = static_cast<std::complex<double>>(otherData[i | targetBit]);
+        result += std::conj(static_cast<std::complex<double>>(data[i])) * (m[0][0] * zero + m[0][1] * one) +
+            std::conj(static_cast<std::complex<double>>(data[i | targetBit])) * (m[1][0] * zero + m[1][1] * one);
+    }
+    return result;
+}
+
+template <typename T>
+void BasicDenseStateVector<T>::setToPauliSum(BasicDenseStateVector const &other,
+                                             std::span<PauliTerm const> observable) {
+    assert(qubitPositions == other.qubitPositions);
+    amplitudes.zero();
+    auto *data = amplitudes.data();
+    auto const *otherData = other.amplitudes.data();
+
+    for (auto const &term : observable) {
+        assert(term.paulis.size() == numberOfQubits);
+        // P|i> = factor (-1)^|i & signMask| |i ^ flipMask>, since X|b> = |1-b>, Z|b> = (-1)^b |b>
+        // and Y|b> = i (-1)^b |1-b>.
+        std::size_t flipMask = 0;
+        std::size_t signMask = 0;
+        std::complex<double> factor = term.coefficient;
+        for (std::size_t q = 0; q < numberOfQubits; ++q) {
+            auto pauli = term.paulis[numberOfQubits - 1 - q];
+            auto positionBit = bit(qubitPositions[q]);
+            if (pauli == 'X' || pauli == 'Y') {
+                flipMask |= positionBit;
+            }
+            if (pauli == 'Y' || pauli == 'Z') {
+                signMask |= positionBit;
+            }
+            if (pauli == 'Y') {
+                factor *= std::complex<double>(0, 1);
+            }
+        }
+
+        auto factorT = static_cast<std::complex<T>>(factor);
+        for (std::size_t i = 0; i < amplitudes.getSize(); ++i) {
+            auto amplitude = factorT * otherData[i];
+            data[i ^ flipMask] += std::popcount(i & signMask) % 2 == 0 ? amplitude : -amplitude;
+        }
+    }
+}
+
+template <typename T>
+std::vector<std::pair<BasisVector, std::complex<T>>> BasicDenseStateVector<T>::getSortedNonZeroAmplitudes() const {
+    std::vector<std::pair<BasisVector, std::complex<T>>> result;
+    auto const *data = amplitudes.data();
+
+    for (std::size_t i = 0; i < amplitudes.getSize(); ++i) {
+        if (isNotNull(data[i])) {
+            result.emplace_back(toBasisVector(i), data[i]);
+        }
+    }
+
+    if (!std::is_sorted(qubitPositions.begin(), qubitPositions.end())) {
+        std::sort(result.begin(), result.end(), [](auto const &left, auto const &right) {
+            return left.first < right.first;
+        });
+    }
+    return result;
+}
+
+template class AmplitudeBuffer<float>;
+template class AmplitudeBuffer<double>;
+
+template class BasicDenseStateVector<float>;
+template class BasicDenseStateVector<double>;
+
+// Explicit instantiation for use in Circuit::execute, otherwise linking error.
+
+template BasicDenseStateVector<float> &
+BasicDenseStateVector<float>::apply<1>(DenseUnitaryMatrix<1 << 1> const &m,
+                                       std::array<QubitIndex, 1> const &operands);
+
+template BasicDenseStateVector<float> &
+BasicDenseStateVector<float>::apply<2>(DenseUnitaryMatrix<1 << 2> const &m,
+                                       std::array<QubitIndex, 2> const &operands);
+
+template BasicDenseStateVector<float> &
+BasicDenseStateVector<float>::apply<3>(DenseUnitaryMatrix<1 << 3> const &m,
+                                       std::array<QubitIndex, 3> const &operands);
+
+template BasicDenseStateVector<double> &
+BasicDenseStateVector<double>::apply<1>(DenseUnitaryMatrix<1 << 1> const &m,
+                                        std::array<QubitIndex, 1> const &operands);
+
+template BasicDenseStateVector<double> &
+BasicDenseStateVector<double>::apply<2>(DenseUnitaryMatrix<1 << 2> const &m,
+                                        std::array<QubitIndex, 2> const &operands);
+
+template BasicDenseStateVector<double> &
+BasicDenseStateVector<double>::apply<3>(DenseUnitaryMatrix<1 << 3> const &m,
+                                        std::array<QubitIndex, 3> const &operands);
+
+} // namespace qx::core
@@ -0,0 +1,850 @@
+#include "qx/DistributedStateVector.hpp"
+
+#include "qx/CompileTimeConfiguration.hpp"
+
+#include <atomic>
+#include <bit>  // countr_zero, has_single_bit
+#include <cassert>
+#include <cerrno>
+#include <cmath>  // abs, sqrt
+#include <cstring>  // strerror
+#include <new>
+#include <stdexcept>  // runtime_error
+#include <string>
+#include <thread>
+
+#if defined(__linux__)
+#include <csignal>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+
+namespace qx::core {
+
+namespace {
+
+std::size_t bit(std::size_t position) {
+    return static_cast<std::size_t>(1) << position;
+}
+
+std::size_t getNumberOfLocalQubits(std::size_t n, std::size_t numberOfRanks) {
+    if (!std::has_single_bit(numberOfRanks) || numberOfRanks > config::MAX_DISTRIBUTED_RANKS) {
+        throw std::runtime_error("Number of processes must be a power of two of at most " +
+            std::to_string(config::MAX_DISTRIBUTED_RANKS));
+    }
+    auto globalQubits = static_cast<std::size_t>(std::countr_zero(numberOfRanks));
+    if (n < globalQubits + 2) {
+        throw std::runtime_error(std::to_string(numberOfRanks) + " processes leave less than 2 qubits per process for " +
+            std::to_string(n) + " qubits");
+    }
+    return n - globalQubits;
+}
+
+// Same as core::BasicDenseStateVector::applyToTile, on a slice.
+template <typename T, std::size_t NumberOfOperands, std::size_t MaxNumberOfPositions>
+void applyGate(GateMatrix<double, 4> const &m, std::array<std::size_t, 4> const &offsets,
+               std::array<std::size_t, MaxNumberOfPositions> const &sortedPositions, std::complex<T> *slice,
+               std::size_t size) {
+    static constexpr std::size_t MATRIX_SIZE = 1 << NumberOfOperands;
+    GateMatrix<T, MATRIX_SIZE> matrix;
+    for (std::size_t r = 0; r < MATRIX_SIZE; ++r) {
+        for (std::size_t c = 0; c < MATRIX_SIZE; ++c) {
+            matrix[r][c] = static_cast<std::complex<T>>(m[r][c]);
+        }
+    }
+    std::array<std::complex<T>, MATRIX_SIZE> values{};
+
+    for (std::size_t i = 0; i < (size >> NumberOfOperands); ++i) {
+        // Insert zeros at the operand positions.
+        auto base = i;
+        for (std::size_t k = 0; k < NumberOfOperands; ++k) {
+            auto p = sortedPositions[k];
+            base = ((base >> p) << (p + 1)) | (base & (bit(p) - 1));
+        }
+
+        for (std::size_t c = 0; c < MATRIX_SIZE; ++c) {
+            values[c] = slice[base + offsets[c]];
+        }
+        for (std::size_t r = 0; r < MATRIX_SIZE; ++r) {
+            std::complex<T> value = 0;
+            for (std::size_t c = 0; c < MATRIX_SIZE; ++c) {
+                value += matrix[r][c] * values[c];
+            }
+            slice[base + offsets[r]] = value;
+        }
+    }
+}
+
+#if defined(__linux__)
+[[noreturn]] void throwSystemError(std::string const &what) {
+    throw std::runtime_error(what + " for the distributed state vector: " + std::strerror(errno));
+}
+
+// Maps a new POSIX shared-memory segment, which the worker processes then inherit.
+void *mapSharedMemory(std::string const &name, std::size_t bytes) {
+    auto fileDescriptor = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fileDescriptor < 0) {
+        throwSystemError("Cannot create shared memory '" + name + "'");
+    }
+
+    // The segment only needs to live as long as the mappings.
+    ::shm_unlink(name.c_str());
+
+    if (::ftruncate(fileDescriptor, static_cast<off_t>(bytes)) != 0) {
+        ::close(fileDescriptor);
+        throwSystemError("Cannot resize shared memory '" + name + "'");
+    }
+    auto *address = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fileDescriptor, 0);
+    ::close(fileDescriptor);
+    if (address == MAP_FAILED) {
+        throwSystemError("Cannot map shared memory '" + name + "'");
+    }
+    return address;
+}
+#endif
+
+} // namespace
+
+template <typename T>
+struct BasicDistributedStateVector<T>::Command {
+    enum class Type : std::uint32_t {
+        Exit,
+        Zero,
+        Norm,
+        ApplyGate,
+        ApplyControlled,
+        SwapPositions,
+        ProbabilityOfMeasuringOne,
+        Collapse,
+        DampWithoutDecay
+    };
+
+    Type type = Type::Exit;
+
+    // ApplyGate and ApplyControlled: the matrix and the sorted local operand positions.
+    // ApplyGate also uses the offsets of the matrix columns, and ApplyControlled only the top-left 2x2 matrix.
+    std::size_t numberOfOperands = 0;
+    GateMatrix<double, 4> matrix{};
+    std::array<std::size_t, 4> offsets{};
+    std::array<std::size_t, config::MAX_QUBIT_NUMBER> sortedPositions{};
+    std::size_t numberOfPositions = 0;
+
+    // Local bits of the controls and of the target, or of the qubit to measure, collapse, swap or damp.
+    std::size_t controlMask = 0;
+    std::size_t targetBit = 0;
+
+    // Rank bits of the controls, or of the qubit to collapse, swap or damp when it is stored in a global bit.
+    std::size_t rankMask = 0;
+
+    bool outcome = false;
+    bool resetToZero = false;
+    double factor = 1.;
+    double oneFactor = 1.;
+};
+
+template <typename T>
+struct BasicDistributedStateVector<T>::SharedControl {
+#if defined(__linux__)
+    pthread_barrier_t start;
+    pthread_barrier_t done;
+#endif
+    bool hasBarriers = false;
+    Command command;
+    std::array<double, config::MAX_DISTRIBUTED_RANKS> partials{};
+};
+
+template <typename T>
+BasicDistributedStateVector<T>::BasicDistributedStateVector(std::size_t n, std::size_t r)
+    : numberOfQubits(n),
+      numberOfRanks(r),
+      localQubits(getNumberOfLocalQubits(n, r)),
+      qubitPositions(n),
+      lastUses(localQubits, 0) {
+    assert(numberOfQubits < config::MAX_QUBIT_NUMBER && "DistributedStateVector cannot support that many qubits");
+
+    for (std::size_t q = 0; q < numberOfQubits; ++q) {
+        qubitPositions[q] = q;
+    }
+
+#if defined(__linux__)
+    static std::atomic<std::uint64_t> numberOfInstances = 0;
+    auto name = "/qx-" + std::to_string(::getpid()) + "-" + std::to_string(numberOfInstances++);
+
+    try {
+        auto *address = ::mmap(nullptr, sizeof(SharedControl), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (address == MAP_FAILED) {
+            throwSystemError("Cannot map the control block");
+        }
+        control = new (address) SharedControl{};
+
+        // Each rank only ever writes its own slice, apart from slice exchanges, and touches its pages first.
+        amplitudes = static_cast<std::complex<T> *>(
+            mapSharedMemory(name, numberOfRanks * getSliceSize() * sizeof(std::complex<T>)));
+
+        pthread_barrierattr_t attributes;
+        ::pthread_barrierattr_init(&attributes);
+        ::pthread_barrierattr_setpshared(&attributes, PTHREAD_PROCESS_SHARED);
+        ::pthread_barrier_init(&control->start, &attributes, static_cast<unsigned>(numberOfRanks));
+        ::pthread_barrier_init(&control->done, &attributes, static_cast<unsigned>(numberOfRanks));
+        ::pthread_barrierattr_destroy(&attributes);
+        control->hasBarriers = true;
+
+        auto parent = ::getpid();
+        for (std::size_t rank = 1; rank < numberOfRanks; ++rank) {
+            auto pid = ::fork();
+            if (pid < 0) {
+                throwSystemError("Cannot start worker process " + std::to_string(rank));
+            }
+            if (pid == 0) {
+                // Workers only touch the shared memory, which is safe even in the child of a multithreaded process.
+                ::prctl(PR_SET_PDEATHSIG, SIGKILL);
+                if (::getppid() != parent) {
+                    ::_exit(0);
+                }
+                serve(rank);
+            }
+            workers.push_back(pid);
+        }
+    } catch (...) {
+        // Workers may be missing from the barriers, so the others cannot be stopped with a command.
+        for (auto pid : workers) {
+            ::kill(pid, SIGKILL);
+            ::waitpid(pid, nullptr, 0);
+        }
+        workers.clear();
+        release();
+        throw;
+    }
+
+    reset();
+#else
+    throw std::runtime_error("Distributed state vectors are only supported on Linux");
+#endif
+}
+
+template <typename T>
+BasicDistributedStateVector<T>::~BasicDistributedStateVector() {
+    release();
+}
+
+template <typename T>
+void BasicDistributedStateVector<T>::release() {
+#if defined(__linux__)
+    if (!workers.empty()) {
+        control->command.type = Command::Type::Exit;
+        ::pthread_barrier_wait(&control->start);
+    }
+    for (auto pid : workers) {
+        ::waitpid(pid, nullptr, 0);
+    }
+    workers.clear();
+
+    if (amplitudes) {
+        ::munmap(amplitudes, numberOfRanks * getSliceSize() * sizeof(std::complex<T>));
+        amplitudes = nullptr;
+    }
+    if (control) {
+        if (control->hasBarriers) {
+            ::pthread_barrier_destroy(&control->start);
+            ::pthread_barrier_destroy(&control->done);
+        }
+        ::munmap(control, sizeof(SharedControl));
+        control = nullptr;
+    }
+#endif
+}
+
+template <typename T>
+void BasicDistributedStateVector<T>::run(Command const &command) const {
+#if defined(__linux__)
+    control->command = command;
+    ::pthread_barrier_wait(&control->start);
+    execute(control->command, amplitudes, localQubits, 0, control->partials[0]);
+    ::pthread_barrier_wait(&control->done);
+#else
+    static_cast<void>(command);
+#endif
+}
+
+template <typename T>
+void BasicDistributedStateVector<T>::serve(std::size_t rank) const {
+#if defined(__linux__)
+    while (true) {
+        ::pthread_barrier_wait(&control->start);
+        if (control->command.type == Command::Type::Exit) {
+            ::_exit(0);
+        }
+        execute(control->command, amplitudes, localQubits, rank, control->partials[rank]);
+        ::pthread_barrier_wait(&control->done);
+    }
+#else
+    static_cast<void>(rank);
+    std::abort();
+#endif
+}
+
+template <typename T>
+void BasicDistributedStateVector<T>::execute(Command const &command, std::complex<T> *amplitudes,
+                                             std::size_t localQubits, std::size_t rank, double &partial) {
+    auto size = bit(localQubits);
+    auto *slice = amplitudes + rank * size;
+    auto isOne = (rank & command.rankMask) != 0;
+    partial = 0.;
+
+    switch (command.type) {
+    case Command::Type::Exit:
+        break;
+
+    case Command::Type::Zero:
+        std::fill(slice, slice + size, 0);
+        break;
+
+    case Command::Type::Norm:
+        for (std::size_t i = 0; i < size; ++i) {
+            partial += std::norm(slice[i]);
+        }
+        break;
+
+    case Command::Type::ApplyGate:
+        if (command.numberOfOperands == 1) {
+            applyGate<T, 1>(command.matrix, command.offsets, command.sortedPositions, slice, size);
+        } else {
+            applyGate<T, 2>(command.matrix, command.offsets, command.sortedPositions, slice, size);
+        }
+        break;
+
+    case Command::Type::ApplyControlled: {
+        // Controls stored in global bits select whole slices.
+        if ((rank & command.rankMask) != command.rankMask) {
+            break;
+        }
+
+        GateMatrix<T, 2> matrix;
+        for (std::size_t r = 0; r < 2; ++r) {
+            for (std::size_t c = 0; c < 2; ++c) {
+                matrix[r][c] = static_cast<std::complex<T>>(command.matrix[r][c]);
+            }
+        }
+
+        for (std::size_t i = 0; i < (size >> command.numberOfPositions); ++i) {
+            // Insert zeros at the operand positions, and set the control bits.
+            auto base = i;
+            for (std::size_t k = 0; k < command.numberOfPositions; ++k) {
+                auto p = command.sortedPositions[k];
+                base = ((base >> p) << (p + 1)) | (base & (bit(p) - 1));
+            }
+            base |= command.controlMask;
+
+            auto zero = slice[base];
+            auto one = slice[base | command.targetBit];
+            slice[base] = matrix[0][0] * zero + matrix[0][1] * one;
+            slice[base | command.targetBit] = matrix[1][0] * zero + matrix[1][1] * one;
+        }
+        break;
+    }
+
+    case Command::Type::SwapPositions: {
+        // Exchanges the amplitudes with (global, local) bits (0, 1) and (1, 0) between the two slices that differ in
+        // the global bit. Each of these two ranks exchanges half of the pairs.
+        auto *globalZero = amplitudes + (rank & ~command.rankMask) * size;
+        auto *globalOne = amplitudes + (rank | command.rankMask) * size;
+        auto localBit = command.targetBit;
+        auto numberOfPairs = size / 2;
+        auto begin = isOne ? numberOfPairs / 2 : 0;
+        auto end = begin + numberOfPairs / 2;
+
+        for (auto pair = begin; pair < end;) {
+            // Pair p is the p-th index whose local bit is 0, and consecutive pairs come in runs of localBit indices.
+            auto offset = pair & (localBit - 1);
+            auto run = std::min(localBit - offset, end - pair);
+            auto index = ((pair & ~(localBit - 1)) << 1) | offset;
+            std::swap_ranges(globalZero + (index | localBit), globalZero + (index | localBit) + run, globalOne + index);
+            pair += run;
+        }
+        break;
+    }
+
+    case Command::Type::ProbabilityOfMeasuringOne:
+        for (std::size_t base = command.targetBit; base < size; base += 2 * command.targetBit) {
+            for (std::size_t i = base; i < base + command.targetBit; ++i) {
+                partial += std::norm(slice[i]);
+            }
+        }
+        break;
+
+    case Command::Type::Collapse: {
+        auto factor = static_cast<T>(command.factor);
+        if (command.rankMask != 0) {
+            // The slices with global bit 1 are moved to their partners with global bit 0 by these partners.
+            if (command.outcome && command.resetToZero) {
+                if (!isOne) {
+                    auto *one = slice + command.rankMask * size;
+                    for (std::size_t i = 0; i < size; ++i) {
+                        slice[i] = one[i] * factor;
+                        one[i] = 0;
+                    }
+                }
+            } else if (isOne == command.outcome) {
+                for (std::size_t i = 0; i < size; ++i) {
+                    slice[i] *= factor;
+                }
+            } else {
+                std::fill(slice, slice + size, 0);
+            }
+            break;
+        }
+
+        auto positionBit = command.targetBit;
+        for (std::size_t base = 0; base < size; base += 2 * positionBit) {
+            auto *zero = slice + base;
+            auto *one = zero + positionBit;
+            if (!command.outcome) {
+                for (std::size_t i = 0; i < positionBit; ++i) {
+                    zero[i] *= factor;
+                    one[i] = 0;
+                }
+            } else if (command.resetToZero) {
+                for (std::size_t i = 0; i < positionBit; ++i) {
+                    zero[i] = one[i] * factor;
+                    one[i] = 0;
+                }
+            } else {
+                for (std::size_t i = 0; i < positionBit; ++i) {
+                    zero[i] = 0;
+                    one[i] *= factor;
+                }
+            }
+        }
+        break;
+    }
+
+    case Command::Type::DampWithoutDecay: {
+        auto zeroFactor = static_cast<T>(command.factor);
+        auto oneFactor = static_cast<T>(command.oneFactor);
+        if (command.rankMask != 0) {
+            auto factor = isOne ? oneFactor : zeroFactor;
+            for (std::size_t i = 0; i < size; ++i) {
+                slice[i] *= factor;
+            }
+            break;
+        }
+
+        auto positionBit = command.targetBit;
+        for (std::size_t base = 0; base < size; base += 2 * positionBit) {
+            for (std::size_t i = base; i < base + positionBit; ++i) {
+                slice[i] *= zeroFactor;
+                slice[i + positionBit] *= oneFactor;
+            }
+        }
+        break;
+    }
+    }
+}
+
+template <typename T>
+void BasicDistributedStateVector<T>::reset() {
+    // The qubit order is kept, as in core::BasicDenseStateVector.
+    Command command;
+    command.type = Command::Type::Zero;
+    run(command);
+    amplitudes[0] = 1;
+    measurementRegister.reset();
+}
+
+template <typename T>
+Snapshot BasicDistributedStateVector<T>::getSnapshot() const {
+    return Snapshot::fromSortedAmplitudes(numberOfQubits, getSortedNonZeroAmplitudes(), measurementRegister);
+}
+
+template <typename T>
+void BasicDistributedStateVector<T>::restore(Snapshot const &snapshot) {
+    if (snapshot.numberOfQubits != numberOfQubits) {
+        throw std::runtime_error("Snapshot has " + std::to_string(snapshot.numberOfQubits) +
+            " qubits instead of " + std::to_string(numberOfQubits));
+    }
+
+    Command command;
+    command.type = Command::Type::Zero;
+    run(command);
+    snapshot.forEach([this](BasisVector basisVector, std::complex<double> amplitude) {
+        if (basisVector.toSizeT() >= bit(numberOfQubits)) {
+            throw std::runtime_error("Snapshot has a basis vector beyond its number of qubits");
+        }
+        amplitudes[toIndex(basisVector)] = static_cast<std::complex<T>>(amplitude);
+    });
+    measurementRegister = snapshot.measurementRegister;
+}
+
+template <typename T>
+void BasicDistributedStateVector<T>::moveLocal(QubitIndex qubitIndex, std::uint64_t &operandPositions) {
+    auto position = qubitPositions[qubitIndex.value];
+
+    if (position >= localQubits) {
+        // Hot qubits are evicted last, and otherwise the least recently used position is.
+        std::vector<bool> isHotPosition(localQubits, false);
+        for (std::size_t q = 0; q < numberOfQubits; ++q) {
+            if (hotQubits.test(q) && qubitPositions[q] < localQubits) {
+                isHotPosition[qubitPositions[q]] = true;
+            }
+        }
+
+        std::size_t localPosition = localQubits;
+        for (std::size_t p = 0; p < localQubits; ++p) {
+            if (!utils::getBit(operandPositions, p) &&
+                (localPosition == localQubits ||
+                 std::pair(isHotPosition[p], lastUses[p]) <
+                     std::pair(isHotPosition[localPosition], lastUses[localPosition]))) {
+                localPosition = p;
+            }
+        }
+        assert(localPosition < localQubits);
+
+        swapPositions(position, localPosition);
+        operandPositions &= ~bit(position);
+        operandPositions |= bit(localPosition);
+        position = localPosition;
+    }
+
+    lastUses[position] = numberOfGates;
+}
+
+template <typename T>
+void BasicDistributedStateVector<T>::setHotQubits(std::span<QubitIndex const> qubits) {
+    hotQubits.reset();
+    auto numberOfMoves = std::min(qubits.size(), localQubits);
+    std::uint64_t keptPositions = 0;
+    for (std::size_t i = 0; i < numberOfMoves; ++i) {
+        hotQubits.set(qubits[i].value);
+        keptPositions |= bit(qubitPositions[qubits[i].value]);
+    }
+    for (std::size_t i = 0; i < numberOfMoves; ++i) {
+        moveLocal(qubits[i], keptPositions);
+    }
+}
+
+template <typename T>
+void BasicDistributedStateVector<T>::swapPositions(std::size_t globalPosition, std::size_t localPosition) {
+    assert(globalPosition >= localQubits && localPosition < localQubits);
+
+    Command command;
+    command.type = Command::Type::SwapPositions;
+    command.rankMask = bit(globalPosition - localQubits);
+    command.targetBit = bit(localPosition);
+    run(command);
+
+    auto global = std::find(qubitPositions.begin(), qubitPositions.end(), globalPosition);
+    auto local = std::find(qubitPositions.begin(), qubitPositions.end(), localPosition);
+    assert(global != qubitPositions.end() && local != qubitPositions.end());
+    std::iter_swap(global, local);
+
+    ++numberOfSliceExchanges;
+}
+
+template <typename T>
+template <std::size_t NumberOfOperands>
+BasicDistributedStateVector<T> &
+BasicDistributedStateVector<T>::apply(DenseUnitaryMatrix<1 << NumberOfOperands> const &m,
+                                      std::array<QubitIndex, NumberOfOperands> const &operands) {
+    static_assert(NumberOfOperands <= 2);
+    assert(std::find_if(operands.begin(), operands.end(),
+                        [this](auto qubitIndex) {
+                            return qubitIndex.value >= numberOfQubits;
+                        }) == operands.end() &&
+           "Operand refers to a non-existing qubit");
+
+    ++numberOfGates;
+
+    std::uint64_t operandPositions = 0;
+    for (auto const &operand : operands) {
+        operandPositions |= bit(qubitPositions[operand.value]);
+    }
+    for (auto const &operand : operands) {
+        moveLocal(operand, operandPositions);
+    }
+
+    // Column bit k corresponds to operand NumberOfOperands - k - 1, as in core::BasicDenseStateVector.
+    Command command;
+    command.type = Command::Type::ApplyGate;
+    command.numberOfOperands = NumberOfOperands;
+    for (std::size_t i = 0; i < bit(NumberOfOperands); ++i) {
+        for (std::size_t j = 0; j < bit(NumberOfOperands); ++j) {
+            command.matrix[i][j] = m.at(i, j);
+        }
+        for (std::size_t k = 0; k < NumberOfOperands; ++k) {
+            if (utils::getBit(i, k)) {
+                command.offsets[i] |= bit(qubitPositions[operands[NumberOfOperands - k - 1].value]);
+            }
+        }
+    }
+    for (std::size_t k = 0; k < NumberOfOperands; ++k) {
+        command.sortedPositions[k] = qubitPositions[operands[k].value];
+    }
+    command.numberOfPositions = NumberOfOperands;
+    std::sort(command.sortedPositions.begin(), command.sortedPositions.begin() + NumberOfOperands);
+
+    run(command);
+    return *this;
+}
+
+template <typename T>
+BasicDistributedStateVector<T> &
+BasicDistributedStateVector<T>::applyControlled(DenseUnitaryMatrix<2> const &m, std::span<QubitIndex const> controls,
+                                                QubitIndex target) {
+    assert(target.value < numberOfQubits && "Operand refers to a non-existing qubit");
+
+    ++numberOfGates;
+
+    // The controls can stay where they are.
+    std::uint64_t operandPositions = bit(qubitPositions[target.value]);
+    moveLocal(target, operandPositions);
+
+    Command command;
+    command.type = Command::Type::ApplyControlled;
+    for (std::size_t i = 0; i < 2; ++i) {
+        for (std::size_t j = 0; j < 2; ++j) {
+            command.matrix[i][j] = m.at(i, j);
+        }
+    }
+    command.targetBit = bit(qubitPositions[target.value]);
+    command.sortedPositions[command.numberOfPositions++] = qubitPositions[target.value];
+    for (auto const &control : controls) {
+        assert(control.value < numberOfQubits && control.value != target.value && "Invalid control qubit");
+        auto position = qubitPositions[control.value];
+        if (position < localQubits) {
+            command.controlMask |= bit(position);
+            command.sortedPositions[command.numberOfPositions++] = position;
+        } else {
+            command.rankMask |= bit(position - localQubits);
+        }
+    }
+    std::sort(command.sortedPositions.begin(), command.sortedPositions.begin() + command.numberOfPositions);
+
+    run(command);
+    return *this;
+}
+
+template <typename T>
+BasisVector BasicDistributedStateVector<T>::toBasisVector(std::size_t index) const {
+    BasisVector result;
+    for (std::size_t q = 0; q < numberOfQubits; ++q) {
+        result.set(q, utils::getBit(index, qubitPositions[q]));
+    }
+    return result;
+}
+
+template <typename T>
+std::size_t BasicDistributedStateVector<T>::toIndex(BasisVector basisVector) const {
+    std::size_t index = 0;
+    for (std::size_t q = 0; q < numberOfQubits; ++q) {
+        if (basisVector.test(q)) {
+            index |= bit(qubitPositions[q]);
+        }
+    }
+    return index;
+}
+
+template <typename T>
+double BasicDistributedStateVector<T>::getProbabilityOfMeasuringOne(QubitIndex qubitIndex) const {
+    auto position = qubitPositions[qubitIndex.value];
+
+    // For a qubit stored in a global bit, this is the norm of the slices with that bit set.
+    Command command;
+    std::size_t rankMask = 0;
+    if (position < localQubits) {
+        command.type = Command::Type::ProbabilityOfMeasuringOne;
+        command.targetBit = bit(position);
+    } else {
+        command.type = Command::Type::Norm;
+        rankMask = bit(position - localQubits);
+    }
+    run(command);
+
+    double probabilityOfMeasuringOne = 0.;
+    for (std::size_t rank = 0; rank < numberOfRanks; ++rank) {
+        if ((rank & rankMask) == rankMask) {
+            probabilityOfMeasuringOne += control->partials[rank];
+        }
+    }
+    return probabilityOfMeasuringOne;
+}
+
+template <typename T>
+void BasicDistributedStateVector<T>::dampWithoutDecay(QubitIndex qubitIndex, double gamma,
+                                                      double probabilityOfMeasuringOne) {
+    auto position = qubitPositions[qubitIndex.value];
+    auto norm = 1 / std::sqrt(1 - gamma * probabilityOfMeasuringOne);
+
+    Command command;
+    command.type = Command::Type::DampWithoutDecay;
+    command.factor = norm;
+    command.oneFactor = std::sqrt(1 - gamma) * norm;
+    if (position < localQubits) {
+        command.targetBit = bit(position);
+    } else {
+        command.rankMask = bit(position - localQubits);
+    }
+    run(command);
+}
+
+template <typename T>
+void BasicDistributedStateVector<T>::collapse(QubitIndex qubitIndex, bool outcome, double probabilityOfOutcome,
+                                              bool resetToZero) {
+    // There is nothing to do when 0 is measured with certainty, as for most syndrome qubits.
+    if (!outcome && probabilityOfOutcome == 1.) {
+        return;
+    }
+
+    auto position = qubitPositions[qubitIndex.value];
+
+    Command command;
+    command.type = Command::Type::Collapse;
+    command.outcome = outcome;
+    command.resetToZero = resetToZero;
+    command.factor = std::sqrt(1 / probabilityOfOutcome);
+    if (position < localQubits) {
+        command.targetBit = bit(position);
+    } else {
+        command.rankMask = bit(position - localQubits);
+    }
+    run(command);
+}
+
+template <typename T>
+BasisVector BasicDistributedStateVector<T>::collapseAll(double rand) {
+    Command command;
+    command.type = Command::Type::Norm;
+    run(command);
+
+    auto collapseTo = [this, &command](std::size_t i) {
+        auto value = amplitudes[i] / std::abs(amplitudes[i]);
+        command.type = Command::Type::Zero;
+        run(command);
+        amplitudes[i] = value;
+        return toBasisVector(i);
+    };
+
+    // The slice norms pick the slice, which is then scanned by this process. Its amplitudes can add up to a little
+    // less than its norm, which was summed up in another order, and the scan then goes on with the next slices.
+    double probability = 0.;
+    bool scanning = false;
+    for (std::size_t rank = 0; rank < numberOfRanks; ++rank) {
+        if (!scanning && probability + control->partials[rank] <= rand) {
+            probability += control->partials[rank];
+            continue;
+        }
+
+        scanning = true;
+        for (auto i = rank * getSliceSize(); i < (rank + 1) * getSliceSize(); ++i) {
+            probability += std::norm(amplitudes[i]);
+            if (probability > rand) {
+                return collapseTo(i);
+            }
+        }
+    }
+
+    // Rounding errors, or rand = 1: the outcome is the last basis vector with a non-zero amplitude.
+    for (auto i = bit(numberOfQubits); i-- > 0;) {
+        if (std::norm(amplitudes[i]) > 0.) {
+            return collapseTo(i);
+        }
+    }
+
+    throw std::runtime_error("Vector was not normalized at measurement location (a bug)");
+}
+
+template <typename T>
+std::complex<T> BasicDistributedStateVector<T>::getAmplitude(BasisVector basisVector) const {
+    if (basisVector.toSizeT() >= bit(numberOfQubits)) {
+        return 0;
+    }
+    return amplitudes[toIndex(basisVector)];
+}
+
+template <typename T>
+std::vector<double> BasicDistributedStateVector<T>::getMarginalProbabilities(
+    std::span<QubitIndex const> qubits) const {
+    checkMarginalQubits(qubits, numberOfQubits);
+
+    std::vector<std::size_t> positionBits;
+    for (auto const &qubit : qubits) {
+        positionBits.push_back(bit(qubitPositions[qubit.value]));
+    }
+
+    // Each slice is summed up by its own thread of this process.
+    std::vector<std::vector<double>> partialResults(numberOfRanks, std::vector<double>(bit(qubits.size()), 0.));
+    auto sumUp = [this, &positionBits, &partialResults](std::size_t rank) {
+        auto &partialResult = partialResults[rank];
+        for (auto i = rank * getSliceSize(); i < (rank + 1) * getSliceSize(); ++i) {
+            std::size_t outcome = 0;
+            for (std::size_t b = 0; b < positionBits.size(); ++b) {
+                if (i & positionBits[b]) {
+                    outcome |= bit(b);
+                }
+            }
+            partialResult[outcome] += std::norm(amplitudes[i]);
+        }
+    };
+
+    {
+        std::vector<std::jthread> threads;
+        for (std::size_t rank = 1; rank < numberOfRanks; ++rank) {
+            threads.emplace_back(sumUp, rank);
+        }
+        sumUp(0);
+    }
+
+    auto &result = partialResults[0];
+    for (std::size_t rank = 1; rank < numberOfRanks; ++rank) {
+        for (std::size_t outcome = 0; outcome < result.size(); ++outcome) {
+            result[outcome] += partialResults[rank][outcome];
+        }
+    }
+    return result;
+}
+
+template <typename T>
+std::vector<std::pair<BasisVector, std::complex<T>>>
+BasicDistributedStateVector<T>::getSortedNonZeroAmplitudes() const {
+    std::vector<std::pair<BasisVector, std::complex<T>>> result;
+
+    for (std::size_t i = 0; i < bit(numberOfQubits); ++i) {
+        if (isNotNull(amplitudes[i])) {
+            result.emplace_back(toBasisVector(i), amplitudes[i]);
+        }
+    }
+
+    if (!std::is_sorted(qubitPositions.begin(), qubitPositions.end())) {
+        std::sort(result.begin(), result.end(), [](auto const &left, auto const &right) {
+            return left.first < right.first;
+        });
+    }
+    return result;
+}
+
+template class BasicDistributedStateVector<float>;
+template class BasicDistributedStateVector<double>;
+
+// Explicit instantiation for use in Circuit::execute, otherwise linking error.
+
+template BasicDistributedStateVector<float> &
+BasicDistributedStateVector<float>::apply<1>(DenseUnitaryMatrix<1 << 1> const &m,
+                                             std::array<QubitIndex, 1> const &operands);
+
+template BasicDistributedStateVector<float> &
+BasicDistributedStateVector<float>::apply<2>(DenseUnitaryMatrix<1 << 2> const &m,
+                                             std::array<QubitIndex, 2> const &operands);
+
+template BasicDistributedStateVector<double> &
+BasicDistributedStateVector<double>::apply<1>(DenseUnitaryMatrix<1 << 1> const &m,
+                                              std::array<QubitIndex, 1> const &operands);
+
+template BasicDistributedStateVector<double> &
+BasicDistributedStateVector<double>::apply<2>(DenseUnitaryMatrix<1 << 2> const &m,
+                                              std::array<QubitIndex, 2> const &operands);
+
+} // namespace qx::core
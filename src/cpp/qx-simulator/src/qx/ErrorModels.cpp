@@ -1,12 +1,15 @@
 #include "qx/ErrorModels.hpp"
 
+#include "qx/DenseStateVector.hpp"
+#include "qx/DistributedStateVector.hpp"
 #include "qx/Gates.hpp"
 #include "qx/Random.hpp"
 
 
 namespace qx::error_models {
 
-void DepolarizingChannel::addError(qx::core::QuantumState &quantumState) const {
+template <typename State>
+void DepolarizingChannel::addError(State &quantumState) const {
     auto random = random::randomZeroOneDouble();
     if (random > probability) {
         return;
@@ -25,4 +28,62 @@ void DepolarizingChannel::addError(qx::core::QuantumState &quantumState) const {
     }
 }
 
+template <typename State>
+void AmplitudeDampingChannel::addError(State &quantumState, std::span<core::QubitIndex const> operands) const {
+    for (auto const &operand : operands) {
+        if (!operandsUntilCandidateDecay) {
+            operandsUntilCandidateDecay = random::randomGeometric(gamma);
+        }
+        auto candidateDecay = *operandsUntilCandidateDecay == 0;
+        if (candidateDecay) {
+            operandsUntilCandidateDecay.reset();
+        } else {
+            --*operandsUntilCandidateDecay;
+        }
+
+        // There is nothing to damp in |0>, and the no-jump evolution of |1> only changes its norm.
+        auto probabilityOfMeasuringOne = quantumState.getProbabilityOfMeasuringOne(operand);
+        if (probabilityOfMeasuringOne < config::EPS) {
+            continue;
+        }
+
+        // A candidate decay happens with probability gamma, so this decays with probability gamma * P(|1>).
+        if (candidateDecay && random::randomZeroOneDouble() <= probabilityOfMeasuringOne) {
+            quantumState.decay(operand, probabilityOfMeasuringOne);
+        } else if (probabilityOfMeasuringOne < 1 - config::EPS) {
+            quantumState.dampWithoutDecay(operand, gamma, probabilityOfMeasuringOne);
+        }
+    }
+}
+
+template void DepolarizingChannel::addError(core::BasicQuantumState<float> &quantumState) const;
+
+template void DepolarizingChannel::addError(core::BasicQuantumState<double> &quantumState) const;
+
+template void DepolarizingChannel::addError(core::BasicDenseStateVector<float> &quantumState) const;
+
+template void DepolarizingChannel::addError(core::BasicDenseStateVector<double> &quantumState) const;
+
+template void DepolarizingChannel::addError(core::BasicDistributedStateVector<float> &quantumState) const;
+
+template void DepolarizingChannel::addError(core::BasicDistributedStateVector<double> &quantumState) const;
+
+template void AmplitudeDampingChannel::addError(core::BasicQuantumState<float> &quantumState,
+                                                std::span<core::QubitIndex const> operands) const;
+
+template void AmplitudeDampingChannel::addError(core::BasicQuantumState<double> &quantumState,
+                                                std::span<core::QubitIndex const> operands) const;
+
+template void AmplitudeDampingChannel::addError(core::BasicDenseStateVector<float> &quantumState,
+                                                std::span<core::QubitIndex const> operands) const;
+
+template void AmplitudeDampingChannel::addError(core::BasicDenseStateVector<double> &quantumState,
+                                                std::span<core::QubitIndex const> operands) const;
+
+template void AmplitudeDampingChannel::addError(core::BasicDistributedStateVector<float> &quantumState,
+                                                std::span<core::QubitIndex const> operands) const;
+
+template void AmplitudeDampingChannel::addError(core::BasicDistributedStateVector<double> &quantumState,
+                                                std::span<core::QubitIndex const> operands) const;
+
 } // namespace qx::error_models
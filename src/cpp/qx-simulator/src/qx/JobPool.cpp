@@ -0,0 +1,166 @@
+#include "qx/JobPool.hpp"
+
+#include <algorithm>  // find, find_if
+#include <exception>
+#include <utility>  // move
+
+
+namespace qx {
+
+Job::Job(Task t, std::size_t shotsRequested, SimulationProgress::Callback callback)
+    : task(std::move(t)), shotsRequested(shotsRequested), progress(std::move(callback)) {}
+
+bool Job::isDone() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return result.has_value();
+}
+
+Job::Result Job::wait() const {
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this]() { return result.has_value(); });
+    return *result;
+}
+
+bool Job::waitFor(std::chrono::milliseconds timeout) const {
+    std::unique_lock<std::mutex> lock(mutex);
+    return done.wait_for(lock, timeout, [this]() { return result.has_value(); });
+}
+
+void Job::cancel() {
+    progress.cancel();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!started && !result) {
+        result = SimulationError{ "Job was cancelled before it started" };
+        done.notify_all();
+    }
+}
+
+void Job::run() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (result) {
+            return;
+        }
+        started = true;
+    }
+
+    Result r;
+    try {
+        r = task(progress);
+    } catch (std::exception const &e) {
+        r = SimulationError{ std::string("Job failed: ") + e.what() };
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    result = std::move(r);
+    done.notify_all();
+}
+
+JobPool &JobPool::getInstance() {
+    static JobPool instance(std::max(1u, std::thread::hardware_concurrency()));
+    return instance;
+}
+
+JobPool::JobPool(std::size_t n) {
+    setNumberOfThreads(n);
+}
+
+JobPool::~JobPool() {
+    shutdown();
+}
+
+void JobPool::shutdown() {
+    std::vector<std::thread> stoppingWorkers;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        for (auto const &job : queue) {
+            job->cancel();
+        }
+        for (auto const &job : runningJobs) {
+            job->cancel();
+        }
+        queue.clear();
+        finishedWorkers.clear();
+        stoppingWorkers.swap(workers);
+    }
+    jobAvailable.notify_all();
+
+    for (auto &worker : stoppingWorkers) {
+        worker.join();
+    }
+}
+
+std::shared_ptr<Job> JobPool::submit(Job::Task task, std::size_t shotsRequested,
+                                     SimulationProgress::Callback callback) {
+    auto job = std::make_shared<Job>(std::move(task), shotsRequested, std::move(callback));
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopping) {
+            job->cancel();
+            return job;
+        }
+        joinFinishedWorkers();
+        queue.push_back(job);
+    }
+    jobAvailable.notify_one();
+    return job;
+}
+
+std::size_t JobPool::getNumberOfThreads() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return numberOfThreads;
+}
+
+void JobPool::setNumberOfThreads(std::size_t n) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        numberOfThreads = std::max<std::size_t>(1, n);
+        joinFinishedWorkers();
+        while (!stopping && numberOfRunningWorkers < numberOfThreads) {
+            workers.emplace_back(&JobPool::work, this);
+            ++numberOfRunningWorkers;
+        }
+    }
+    jobAvailable.notify_all();
+}
+
+void JobPool::joinFinishedWorkers() {
+    for (auto id : finishedWorkers) {
+        auto worker = std::find_if(workers.begin(), workers.end(),
+            [id](std::thread const &w) { return w.get_id() == id; });
+        worker->join();
+        workers.erase(worker);
+    }
+    finishedWorkers.clear();
+}
+
+void JobPool::work() {
+    while (true) {
+        std::shared_ptr<Job> job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            jobAvailable.wait(lock, [this]() {
+                return stopping || !queue.empty() || numberOfRunningWorkers > numberOfThreads;
+            });
+            if (stopping || numberOfRunningWorkers > numberOfThreads) {
+                --numberOfRunningWorkers;
+                if (!stopping) {
+                    finishedWorkers.push_back(std::this_thread::get_id());
+                }
+                return;
+            }
+            job = std::move(queue.front());
+            queue.pop_front();
+            runningJobs.push_back(job);
+        }
+
+        job->run();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        runningJobs.erase(std::find(runningJobs.begin(), runningJobs.end(), job));
+    }
+}
+
+} // namespace qx
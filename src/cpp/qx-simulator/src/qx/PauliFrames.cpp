@@ -0,0 +1,249 @@
+#include "qx/PauliFrames.hpp"
+
+#include "qx/Random.hpp"
+
+#include "absl/container/flat_hash_map.h"
+#include <algorithm>  // copy_n
+#include <bit>  // popcount
+#include <cassert>
+#include <iterator>  // back_inserter
+#include <optional>
+#include <stdexcept>  // runtime_error
+#include <tuple>
+#include <utility>  // pair
+
+
+namespace qx {
+
+namespace {
+
+constexpr char const *NOT_CLIFFORD = "Pauli frames only support Clifford gates, measurements and resets";
+
+// X^xMask Z^zMask on the bits of the index of a gate matrix.
+template <std::size_t N>
+core::DenseUnitaryMatrix<N> getPauliMatrix(std::size_t xMask, std::size_t zMask) {
+    typename core::DenseUnitaryMatrix<N>::Matrix m{};
+    for (std::size_t j = 0; j < N; ++j) {
+        m[j ^ xMask][j] = std::popcount(j & zMask) % 2 == 0 ? 1. : -1.;
+    }
+    return core::DenseUnitaryMatrix<N>::fromUnitary(m);
+}
+
+// The masks of the Pauli operator X^xMask Z^zMask that the matrix is equal to up to a phase, if any.
+template <std::size_t N>
+std::optional<std::pair<std::size_t, std::size_t>> findPauli(core::DenseUnitaryMatrix<N> const &matrix) {
+    std::size_t xMask = 0;
+    while (xMask < N && !core::isNotNull(matrix.at(xMask, 0))) {
+        ++xMask;
+    }
+    if (xMask == N) {
+        return std::nullopt;
+    }
+
+    auto phase = matrix.at(xMask, 0);
+    std::size_t zMask = 0;
+    for (std::size_t bit = 1; bit < N; bit <<= 1) {
+        if (!core::isNotNull(matrix.at(bit ^ xMask, bit) + phase)) {
+            zMask |= bit;
+        }
+    }
+
+    auto pauli = getPauliMatrix<N>(xMask, zMask);
+    for (std::size_t i = 0; i < N; ++i) {
+        for (std::size_t j = 0; j < N; ++j) {
+            if (core::isNotNull(matrix.at(i, j) - phase * pauli.at(i, j))) {
+                return std::nullopt;
+            }
+        }
+    }
+    return std::pair{ xMask, zMask };
+}
+
+template <std::size_t Size>
+void xorInto(std::array<std::uint64_t, Size> &lanes, std::array<std::uint64_t, Size> const &other) {
+    for (std::size_t w = 0; w < Size; ++w) {
+        lanes[w] ^= other[w];
+    }
+}
+
+template <std::size_t Size>
+void randomize(std::array<std::uint64_t, Size> &lanes) {
+    for (auto &word : lanes) {
+        word = random::randomBits();
+    }
+}
+
+template <std::size_t Size>
+void flip(std::array<std::uint64_t, Size> &lanes, std::size_t shot) {
+    lanes[shot / 64] ^= static_cast<std::uint64_t>(1) << (shot % 64);
+}
+
+template <std::size_t Size>
+bool test(std::array<std::uint64_t, Size> const &lanes, std::size_t shot) {
+    return (lanes[shot / 64] >> (shot % 64)) & 1;
+}
+
+} // namespace
+
+template <std::size_t N>
+PauliFrameSampler::CliffordGate PauliFrameSampler::getCliffordGate(core::DenseUnitaryMatrix<N> const &matrix,
+                                                                   std::span<core::QubitIndex const> operands) {
+    CliffordGate gate;
+    gate.numberOfQubits = operands.size();
+    assert(std::size_t{ 1 } << gate.numberOfQubits == N);
+    for (std::size_t b = 0; b < gate.numberOfQubits; ++b) {
+        // Bit b of the index of the gate matrix is operands[numberOfOperands - b - 1], as in the quantum state.
+        gate.qubits[b] = operands[gate.numberOfQubits - b - 1].value;
+
+        for (auto [generator, xMask, zMask] : { std::tuple{ 2 * b, std::size_t{ 1 } << b, std::size_t{ 0 } },
+                                                std::tuple{ 2 * b + 1, std::size_t{ 0 }, std::size_t{ 1 } << b } }) {
+            auto image = findPauli(matrix * getPauliMatrix<N>(xMask, zMask) * matrix.dagger());
+            if (!image) {
+                throw std::runtime_error(NOT_CLIFFORD);
+            }
+            gate.images[generator] = CliffordGate::Image{ static_cast<std::uint8_t>(image->first),
+                                                          static_cast<std::uint8_t>(image->second) };
+        }
+    }
+    return gate;
+}
+
+PauliFrameSampler::PauliFrameSampler(Circuit const &circuit, std::size_t n)
+    : numberOfQubits(n), measuredQubits(circuit.getMeasuredQubits(n)) {
+    for (auto const &controlledInstruction : circuit.getControlledInstructions()) {
+        if (controlledInstruction.condition) {
+            throw std::runtime_error("Pauli frames do not support conditional instructions");
+        }
+
+        auto const &instruction = controlledInstruction.instruction;
+        if (auto *measure = std::get_if<Circuit::Measure>(&instruction)) {
+            operations.emplace_back(*measure);
+        } else if (auto *measureAll = std::get_if<Circuit::MeasureAll>(&instruction)) {
+            operations.emplace_back(*measureAll);
+        } else if (auto *prepZ = std::get_if<Circuit::PrepZ>(&instruction)) {
+            operations.emplace_back(*prepZ);
+        } else if (std::get_if<Circuit::QubitLayout>(&instruction)) {
+            // Only a hint for the dense backend, which takes no depolarizing error, see Circuit::execute.
+            continue;
+        } else if (auto *instruction1 = std::get_if<Circuit::Unitary<1>>(&instruction)) {
+            operations.emplace_back(getCliffordGate(instruction1->matrix, instruction1->operands));
+        } else if (auto *instruction2 = std::get_if<Circuit::Unitary<2>>(&instruction)) {
+            operations.emplace_back(getCliffordGate(instruction2->matrix, instruction2->operands));
+        } else if (auto *controlledUnitary = std::get_if<Circuit::ControlledUnitary>(&instruction)) {
+            if (controlledUnitary->controls.empty()) {
+                operations.emplace_back(
+                    getCliffordGate(controlledUnitary->matrix, std::span(&controlledUnitary->target, 1)));
+            } else if (controlledUnitary->controls.size() == 1) {
+                // The control is the high bit of the index, as the first operand of CNOT.
+                core::DenseUnitaryMatrix<4>::Matrix entries{};
+                entries[0][0] = 1;
+                entries[1][1] = 1;
+                for (std::size_t i = 0; i < 2; ++i) {
+                    for (std::size_t j = 0; j < 2; ++j) {
+                        entries[2 + i][2 + j] = controlledUnitary->matrix.at(i, j);
+                    }
+                }
+                std::array<core::QubitIndex, 2> operands{ controlledUnitary->controls[0], controlledUnitary->target };
+                operations.emplace_back(getCliffordGate(core::DenseUnitaryMatrix<4>::fromUnitary(entries), operands));
+            } else {
+                throw std::runtime_error(NOT_CLIFFORD);
+            }
+        } else {
+            throw std::runtime_error(NOT_CLIFFORD);
+        }
+    }
+
+    // The operations are repeated as Circuit::execute repeats the instructions.
+    auto const operationsPerIteration = operations.size();
+    operations.reserve(operationsPerIteration * circuit.getIterations());
+    for (std::size_t iteration = 1; iteration < circuit.getIterations(); ++iteration) {
+        std::copy_n(operations.begin(), operationsPerIteration, std::back_inserter(operations));
+    }
+}
+
+void PauliFrameSampler::sample(BasisVector reference, std::size_t shots, double depolarizingProbability,
+                               ShotsCallback const &callback) const {
+    assert(0 < shots && shots <= BATCH_SIZE);
+
+    // Frames start with random Z parts, which leave state 00...000 unchanged.
+    std::vector<Lanes> x(numberOfQubits, Lanes{});
+    std::vector<Lanes> z(numberOfQubits, Lanes{});
+    std::vector<Lanes> measuredFlips(numberOfQubits, Lanes{});
+    for (auto &lanes : z) {
+        randomize(lanes);
+    }
+
+    // Before instruction i, shot s has a depolarizing error with index i * shots + s: the number of error-free
+    // indices until the next error is sampled directly, so that random numbers are only drawn for errors.
+    auto hasErrors = depolarizingProbability > 0. && numberOfQubits > 0;
+    auto nextError = hasErrors ? random::randomGeometric(depolarizingProbability) : operations.size() * shots;
+
+    for (std::size_t i = 0; i < operations.size(); ++i) {
+        for (; nextError < (i + 1) * shots; nextError += 1 + random::randomGeometric(depolarizingProbability)) {
+            auto shot = nextError - i * shots;
+            auto qubit = random::randomInteger(0, numberOfQubits - 1);
+            // X, Y or Z with the same probability.
+            auto pauli = random::randomInteger(0, 2);
+            if (pauli != 2) {
+                flip(x[qubit], shot);
+            }
+            if (pauli != 0) {
+                flip(z[qubit], shot);
+            }
+        }
+
+        auto const &operation = operations[i];
+        if (auto *gate = std::get_if<CliffordGate>(&operation)) {
+            std::array<Lanes, 4> in;
+            std::array<Lanes, 2> outX{};
+            std::array<Lanes, 2> outZ{};
+            for (std::size_t b = 0; b < gate->numberOfQubits; ++b) {
+                in[2 * b] = x[gate->qubits[b]];
+                in[2 * b + 1] = z[gate->qubits[b]];
+            }
+            for (std::size_t generator = 0; generator < 2 * gate->numberOfQubits; ++generator) {
+                auto const &image = gate->images[generator];
+                for (std::size_t b = 0; b < gate->numberOfQubits; ++b) {
+                    if ((image.xMask >> b) & 1) {
+                        xorInto(outX[b], in[generator]);
+                    }
+                    if ((image.zMask >> b) & 1) {
+                        xorInto(outZ[b], in[generator]);
+                    }
+                }
+            }
+            for (std::size_t b = 0; b < gate->numberOfQubits; ++b) {
+                x[gate->qubits[b]] = outX[b];
+                z[gate->qubits[b]] = outZ[b];
+            }
+        } else if (auto *measure = std::get_if<Circuit::Measure>(&operation)) {
+            measuredFlips[measure->qubitIndex.value] = x[measure->qubitIndex.value];
+            randomize(z[measure->qubitIndex.value]);
+        } else if (std::get_if<Circuit::MeasureAll>(&operation)) {
+            for (std::size_t qubit = 0; qubit < numberOfQubits; ++qubit) {
+                measuredFlips[qubit] = x[qubit];
+                randomize(z[qubit]);
+            }
+        } else if (auto *prepZ = std::get_if<Circuit::PrepZ>(&operation)) {
+            x[prepZ->qubitIndex.value] = Lanes{};
+            randomize(z[prepZ->qubitIndex.value]);
+        }
+    }
+
+    // The measurement register only keeps the last outcome of each qubit, hence its last flips.
+    absl::flat_hash_map<BasisVector, std::uint64_t> measurementRegisters;
+    for (std::size_t shot = 0; shot < shots; ++shot) {
+        auto measurementRegister = reference;
+        for (auto qubit : measuredQubits) {
+            if (test(measuredFlips[qubit], shot)) {
+                measurementRegister.set(qubit, !reference.test(qubit));
+            }
+        }
+        ++measurementRegisters[measurementRegister];
+    }
+    for (auto const &[measurementRegister, count] : measurementRegisters) {
+        callback(measurementRegister, count);
+    }
+}
+
+} // namespace qx
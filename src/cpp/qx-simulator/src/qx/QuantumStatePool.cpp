@@ -0,0 +1,59 @@
+#include "qx/QuantumStatePool.hpp"
+
+#include <algorithm>  // find_if
+#include <vector>
+
+
+namespace qx::core {
+
+namespace {
+
+// Least recently returned first.
+template <typename T>
+thread_local std::vector<std::unique_ptr<BasicQuantumState<T>>> freeStates;
+
+} // namespace
+
+template <typename T>
+void QuantumStatePool<T>::Return::operator()(BasicQuantumState<T> *quantumState) const {
+    std::unique_ptr<BasicQuantumState<T>> owned(quantumState);
+    owned->setMemoryTracker(nullptr);
+    owned->reset();
+    owned->shrinkSpareAmplitudes();
+
+    auto &states = freeStates<T>;
+    if (states.size() >= config::QUANTUM_STATE_POOL_SIZE) {
+        states.erase(states.begin());
+    }
+    states.push_back(std::move(owned));
+}
+
+template <typename T>
+typename QuantumStatePool<T>::Handle QuantumStatePool<T>::borrow(std::size_t numberOfQubits, SparseStorage storage) {
+    auto &states = freeStates<T>;
+    auto it = std::find_if(states.rbegin(), states.rend(), [numberOfQubits, storage](auto const &state) {
+        return state->getNumberOfQubits() == numberOfQubits && state->getSparseStorage() == storage;
+    });
+    if (it == states.rend()) {
+        return Handle(new BasicQuantumState<T>(numberOfQubits, storage));
+    }
+
+    Handle result(it->release());
+    states.erase(std::next(it).base());
+    return result;
+}
+
+template <typename T>
+std::size_t QuantumStatePool<T>::getSize() {
+    return freeStates<T>.size();
+}
+
+template <typename T>
+void QuantumStatePool<T>::clear() {
+    freeStates<T>.clear();
+}
+
+template class QuantumStatePool<float>;
+template class QuantumStatePool<double>;
+
+} // namespace qx::core
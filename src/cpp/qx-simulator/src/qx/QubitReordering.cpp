@@ -0,0 +1,86 @@
+#include "qx/QubitReordering.hpp"
+
+#include <algorithm>  // sort
+#include <span>
+#include <vector>
+
+
+namespace qx {
+
+namespace {
+
+// Controls do not count: the dense state vector leaves them where they are.
+std::span<core::QubitIndex const> getOperands(Circuit::Instruction const &instruction) {
+    if (auto *instruction1 = std::get_if<Circuit::Unitary<1>>(&instruction)) {
+        return instruction1->operands;
+    } else if (auto *instruction2 = std::get_if<Circuit::Unitary<2>>(&instruction)) {
+        return instruction2->operands;
+    } else if (auto *controlledUnitary = std::get_if<Circuit::ControlledUnitary>(&instruction)) {
+        return std::span(&controlledUnitary->target, 1);
+    }
+    return {};
+}
+
+struct QubitUses {
+    std::size_t qubit = 0;
+    std::size_t numberOfGates = 0;
+    std::size_t firstGate = 0;
+};
+
+} // namespace
+
+Circuit reorderQubits(Circuit const &circuit, std::size_t lowPositions, std::size_t windowSize) {
+    assert(windowSize > 0);
+
+    Circuit result(circuit.getName(), circuit.getIterations());
+    auto const &instructions = circuit.getControlledInstructions();
+    std::vector<core::QubitIndex> previousHotQubits;
+
+    for (std::size_t start = 0; start < instructions.size();) {
+        // The window ends after windowSize gates. Other instructions do not count.
+        std::vector<QubitUses> uses;
+        std::size_t end = start;
+        for (std::size_t gates = 0; end < instructions.size() && gates < windowSize; ++end) {
+            auto operands = getOperands(instructions[end].instruction);
+            for (auto const &operand : operands) {
+                auto it = std::find_if(uses.begin(), uses.end(),
+                    [&operand](auto const &u) { return u.qubit == operand.value; });
+                if (it == uses.end()) {
+                    uses.push_back(QubitUses{ .qubit = operand.value, .numberOfGates = 1, .firstGate = gates });
+                } else {
+                    ++it->numberOfGates;
+                }
+            }
+            gates += !operands.empty();
+        }
+
+        std::sort(uses.begin(), uses.end(), [](auto const &left, auto const &right) {
+            return std::pair(right.numberOfGates, left.firstGate) < std::pair(left.numberOfGates, right.firstGate);
+        });
+        std::vector<core::QubitIndex> hotQubits;
+        for (std::size_t i = 0; i < std::min(uses.size(), lowPositions); ++i) {
+            hotQubits.push_back(core::QubitIndex{ uses[i].qubit });
+        }
+
+        auto sameQubits = [](std::vector<core::QubitIndex> left, std::vector<core::QubitIndex> right) {
+            auto byIndex = [](auto const &l, auto const &r) { return l.value < r.value; };
+            std::sort(left.begin(), left.end(), byIndex);
+            std::sort(right.begin(), right.end(), byIndex);
+            return std::equal(left.begin(), left.end(), right.begin(), right.end(),
+                [](auto const &l, auto const &r) { return l.value == r.value; });
+        };
+        if (!hotQubits.empty() && !sameQubits(hotQubits, previousHotQubits)) {
+            Circuit::ControlledInstruction layout{ Circuit::QubitLayout{ hotQubits }, std::nullopt };
+            result.addInstruction(layout);
+            previousHotQubits = std::move(hotQubits);
+        }
+
+        for (; start < end; ++start) {
+            result.addInstruction(instructions[start]);
+        }
+    }
+
+    return result;
+}
+
+} // namespace qx
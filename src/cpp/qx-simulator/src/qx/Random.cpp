@@ -1,5 +1,6 @@
 #include "qx/Random.hpp"
 
+#include <array>
 #include <random>
 
 
@@ -10,8 +11,9 @@ class RandomNumberGenerator {
 public:
     using RandomNumberGeneratorType = std::mt19937_64;
 
+    // One generator per thread, so that simulations can run concurrently.
     static RandomNumberGeneratorType &getInstance() {
-        static RandomNumberGenerator instance;
+        static thread_local RandomNumberGenerator instance;
         return instance.randomNumberGenerator;
     }
 
@@ -73,6 +75,148 @@ std::uint_fast64_t randomInteger(std::uint_fast64_t min,
     return result;
 }
 
+std::uint64_t randomBits() {
+    return RandomNumberGenerator::getInstance()();
+}
+
+std::uint64_t randomGeometric(double p) {
+    assert(0. <= p && p <= 1.);
+    static constexpr std::uint64_t MAX_RESULT = static_cast<std::uint64_t>(1) << 62;
+
+    if (p <= 0.) {
+        return MAX_RESULT;
+    }
+
+    // Inversion of the cumulative distribution function. randomZeroOneDouble() is never 0.
+    auto failures = std::floor(std::log(randomZeroOneDouble()) / std::log1p(-p));
+    if (!(failures < static_cast<double>(MAX_RESULT))) {
+        return failures >= 0. ? MAX_RESULT : 0;
+    }
+    return static_cast<std::uint64_t>(std::max(failures, 0.));
+}
+
+namespace {
+
+// log(k!) - log of its Stirling approximation, (k + 1/2) log(k + 1) - (k + 1) + log(2 pi) / 2.
+double getStirlingCorrection(double k) {
+    static constexpr std::array<double, 10> SMALL_K = { 0.08106146679532726, 0.04134069595540929, 0.02767792568499834,
+                                                        0.02079067210376509, 0.01664469118982119, 0.01387612882307075,
+                                                        0.01189670994589177, 0.01041126526197209, 0.009255462182712733,
+                                                        0.008330563433362871 };
+    if (k < static_cast<double>(SMALL_K.size())) {
+        return SMALL_K[static_cast<std::size_t>(k)];
+    }
+    auto inverse = 1. / (k + 1.);
+    auto inverseSquared = inverse * inverse;
+    return (1. / 12 - (1. / 360 - inverseSquared / 1260) * inverseSquared) * inverse;
+}
+
+// Transformed rejection with decomposition (BTRD, Hormann 1993), for p <= 1/2 and n * p >= BTRD_MIN_MEAN.
+// Takes a bounded expected number of uniform variates, whatever n.
+std::uint64_t randomBinomialBtrd(std::uint64_t n, double p) {
+    auto const nd = static_cast<double>(n);
+    auto const m = std::floor((nd + 1) * p);
+    auto const r = p / (1 - p);
+    auto const nr = (nd + 1) * r;
+    auto const npq = nd * p * (1 - p);
+    auto const spq = std::sqrt(npq);
+    auto const b = 1.15 + 2.53 * spq;
+    auto const a = -0.0873 + 0.0248 * b + 0.01 * p;
+    auto const c = nd * p + 0.5;
+    auto const alpha = (2.83 + 5.1 / b) * spq;
+    auto const vr = 0.92 - 4.2 / b;
+    auto const urvr = 0.86 * vr;
+
+    while (true) {
+        auto v = randomZeroOneDouble();
+        if (v <= urvr) {
+            // Most variates come from the triangle under the hat, and are accepted right away.
+            auto u = v / vr - 0.43;
+            auto k = std::floor((2 * a / (0.5 - std::abs(u)) + b) * u + c);
+            if (0 <= k && k <= nd) {
+                return static_cast<std::uint64_t>(k);
+            }
+            continue;
+        }
+
+        double u;
+        if (v >= vr) {
+            u = randomZeroOneDouble() - 0.5;
+        } else {
+            u = v / vr - 0.93;
+            u = std::copysign(0.5, u) - u;
+            v = randomZeroOneDouble() * vr;
+        }
+
+        auto us = 0.5 - std::abs(u);
+        auto k = std::floor((2 * a / us + b) * u + c);
+        if (k < 0 || k > nd) {
+            continue;
+        }
+        v = v * alpha / (a / (us * us) + b);
+        auto km = std::abs(k - m);
+
+        if (km <= 15) {
+            // Ratio of the probabilities of k and of the mode, by recursion.
+            double f = 1;
+            if (m < k) {
+                for (auto i = m + 1; i <= k; ++i) {
+                    f *= nr / i - r;
+                }
+            } else {
+                for (auto i = k + 1; i <= m; ++i) {
+                    v *= nr / i - r;
+                }
+            }
+            if (v <= f) {
+                return static_cast<std::uint64_t>(k);
+            }
+            continue;
+        }
+
+        // Squeeze, then the exact ratio from Stirling's formula.
+        v = std::log(v);
+        auto rho = (km / npq) * (((km / 3 + 0.625) * km + 1. / 6) / npq + 0.5);
+        auto t = -km * km / (2 * npq);
+        if (v < t - rho) {
+            return static_cast<std::uint64_t>(k);
+        }
+        if (v > t + rho) {
+            continue;
+        }
+
+        auto nm = nd - m + 1;
+        auto h = (m + 0.5) * std::log((m + 1) / (r * nm)) + getStirlingCorrection(m) + getStirlingCorrection(nd - m);
+        auto nk = nd - k + 1;
+        if (v <= h + (nd + 1) * std::log(nm / nk) + (k + 0.5) * std::log(nk * r / (k + 1)) -
+                getStirlingCorrection(k) - getStirlingCorrection(nd - k)) {
+            return static_cast<std::uint64_t>(k);
+        }
+    }
+}
+
+} // namespace
+
+std::uint64_t randomBinomial(std::uint64_t n, double p) {
+    assert(0. <= p && p <= 1.);
+
+    if (p > 0.5) {
+        return n - randomBinomial(n, 1 - p);
+    }
+
+    // BTRD needs a mean of at least 10, below which skipping from one success to the next takes few variates.
+    static constexpr double BTRD_MIN_MEAN = 10.;
+    if (static_cast<double>(n) * p >= BTRD_MIN_MEAN) {
+        return randomBinomialBtrd(n, p);
+    }
+
+    std::uint64_t successes = 0;
+    for (auto trial = randomGeometric(p); trial < n; trial += 1 + randomGeometric(p)) {
+        ++successes;
+    }
+    return successes;
+}
+
 double uniformMinMaxIntegerDistribution(std::uint_fast64_t min,
                                         std::uint_fast64_t max, double x) {
     assert(min <= max);
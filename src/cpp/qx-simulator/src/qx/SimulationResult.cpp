@@ -1,17 +1,170 @@
 #include "qx/SimulationResult.hpp"
 
 #include "qx/Core.hpp"
+#include "qx/Random.hpp"
+
+#include <bit>  // bit_floor
+#include <fmt/format.h>
 #include <iomanip>
 #include <iostream>
+#include <stdexcept>  // runtime_error
 #include <variant>
 
 
 namespace qx {
 
-void SimulationResultAccumulator::append(BasisVector measuredState) {
-    assert(measuredStates.size() <= (1u << quantumState.getNumberOfQubits()));
-    measuredStates[measuredState]++;
-    nMeasurements++;
+namespace {
+
+// Step between the nodes of a Fenwick tree.
+std::size_t getLowestBit(std::size_t i) {
+    return i & (~i + 1);
+}
+
+} // namespace
+
+ShotRecorder::ShotRecorder(std::size_t numberOfBits, std::string const &filePath) {
+    records.number_of_bits = numberOfBits;
+    records.bytes_per_shot = (numberOfBits + 7) / 8;
+    if (!filePath.empty()) {
+        file.open(filePath, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            throw std::runtime_error(fmt::format("cannot create {}", filePath));
+        }
+        records.bytes.reserve(config::SHOT_RECORD_CHUNK_BYTES + records.bytes_per_shot);
+    }
+}
+
+void ShotRecorder::append(BasisVector measurementRegister, std::uint64_t count) {
+    if (!pending.empty()) {
+        appendPending();
+    }
+
+    // The measurement register fits in a single word, whose bytes are the row from the least significant one.
+    auto word = measurementRegister.toSizeT();
+    for (std::uint64_t shot = 0; shot < count; ++shot) {
+        for (std::size_t byte = 0; byte < records.bytes_per_shot; ++byte) {
+            records.bytes.push_back(static_cast<std::uint8_t>(word >> (8 * byte)));
+        }
+        ++records.number_of_shots;
+        if (file.is_open() && records.bytes.size() >= config::SHOT_RECORD_CHUNK_BYTES) {
+            flush();
+        }
+    }
+}
+
+void ShotRecorder::appendUnordered(BasisVector measurementRegister, std::uint64_t count) {
+    if (count > 0) {
+        pending[measurementRegister] += count;
+    }
+}
+
+// Draws the register of each shot in turn among the shots left, with a Fenwick tree of the shots left per register,
+// so that a shot takes O(log(registers)) rather than a random permutation of all the shots in memory.
+void ShotRecorder::appendPending() {
+    std::vector<BasisVector> registers;
+    std::vector<std::uint64_t> tree(1, 0);
+    std::uint64_t shotsLeft = 0;
+    for (auto const &[measurementRegister, count] : pending) {
+        registers.push_back(measurementRegister);
+        tree.push_back(count);
+        shotsLeft += count;
+    }
+    pending.clear();
+    if (registers.size() == 1) {
+        append(registers[0], shotsLeft);
+        return;
+    }
+
+    auto const size = registers.size();
+    for (std::size_t i = 1; i <= size; ++i) {
+        if (auto parent = i + getLowestBit(i); parent <= size) {
+            tree[parent] += tree[i];
+        }
+    }
+    for (; shotsLeft > 0; --shotsLeft) {
+        auto shot = random::randomInteger(0, shotsLeft - 1);
+        std::size_t position = 0;
+        for (auto step = std::bit_floor(size); step > 0; step >>= 1) {
+            if (position + step <= size && tree[position + step] <= shot) {
+                position += step;
+                shot -= tree[position];
+            }
+        }
+        for (auto i = position + 1; i <= size; i += getLowestBit(i)) {
+            --tree[i];
+        }
+        append(registers[position]);
+    }
+}
+
+void ShotRecorder::flush() {
+    file.write(reinterpret_cast<char const *>(records.bytes.data()), static_cast<std::streamsize>(records.bytes.size()));
+    records.bytes.clear();
+}
+
+ShotRecords ShotRecorder::finish() {
+    if (!pending.empty()) {
+        appendPending();
+    }
+    if (file.is_open()) {
+        flush();
+        file.close();
+        if (!file) {
+            throw std::runtime_error("cannot write the shot records");
+        }
+    }
+    return std::move(records);
+}
+
+void SimulationResultAccumulator::append(BasisVector measuredState, std::uint64_t count) {
+    read(measuredState, count, false);
+}
+
+void SimulationResultAccumulator::appendUnordered(BasisVector measuredState, std::uint64_t count) {
+    read(measuredState, count, true);
+}
+
+void SimulationResultAccumulator::read(BasisVector measuredState, std::uint64_t count, bool ranTogether) {
+    if (shotRecorder && shotReadoutError) {
+        shotReadoutError->addReadStates(measuredState, count, shotMeasuredQubits,
+            [this, ranTogether](BasisVector readState, std::uint64_t readCount) {
+                add(readState, readCount, ranTogether);
+            });
+        return;
+    }
+    add(measuredState, count, ranTogether);
+}
+
+void SimulationResultAccumulator::add(BasisVector readState, std::uint64_t count, bool ranTogether) {
+    assert(measuredStates.size() <= (1u << numberOfQubits));
+    measuredStates[readState] += count;
+    nMeasurements += count;
+    if (!shotRecorder) {
+        return;
+    }
+    if (ranTogether) {
+        shotRecorder->appendUnordered(readState, count);
+    } else {
+        shotRecorder->append(readState, count);
+    }
+}
+
+void SimulationResultAccumulator::recordShots(std::string const &filePath,
+                                              std::optional<error_models::ReadoutError> readoutError,
+                                              std::vector<std::size_t> measuredQubits) {
+    shotRecorder.emplace(numberOfQubits, filePath);
+    shotReadoutError = readoutError;
+    shotMeasuredQubits = std::move(measuredQubits);
+}
+
+void SimulationResultAccumulator::applyReadoutError(error_models::ReadoutError const &readoutError,
+                                                    std::vector<std::size_t> const &measuredQubits) {
+    absl::btree_map<BasisVector, std::uint64_t> readStates;
+    for (auto const &[measuredState, count] : measuredStates) {
+        readoutError.addReadStates(measuredState, count, measuredQubits,
+            [&readStates](BasisVector readState, std::uint64_t readCount) { readStates[readState] += readCount; });
+    }
+    measuredStates.swap(readStates);
 }
 
 std::ostream &operator<<(std::ostream &os, SimulationResult const &r) {
@@ -39,13 +192,18 @@ std::ostream &operator<<(std::ostream &os, SimulationResult const &r) {
     return os;
 }
 
-SimulationResult SimulationResultAccumulator::get() {
+SimulationResult SimulationResultAccumulator::getMeasurementResults() {
     SimulationResult simulationResult;
     simulationResult.shots_requested = nMeasurements;
     simulationResult.shots_done = nMeasurements;
 
     assert(nMeasurements > 0);
 
+    if (shotRecorder) {
+        simulationResult.shot_records = shotRecorder->finish();
+        shotRecorder.reset();
+    }
+
     for (const auto &kv : measuredStates) {
         const auto &state = kv.first;
         const auto &count = kv.second;
@@ -53,24 +211,13 @@ SimulationResult SimulationResultAccumulator::get() {
         simulationResult.results.emplace_back(getStateString(state), count);
     }
 
-    forAllNonZeroStates([&simulationResult](auto stateString, auto c) {
-        simulationResult.state.push_back(std::make_pair(
-            stateString, Complex{ .real = c.real(), .imag = c.imag(), .norm = std::norm(c) }));
-    });
-
     return simulationResult;
 }
 
-template <typename F>
-void SimulationResultAccumulator::forAllNonZeroStates(F &&f) {
-    quantumState.forEach(
-        [&f, this](auto const &kv) { f(getStateString(kv.first), kv.second); });
-}
-
 std::string SimulationResultAccumulator::getStateString(BasisVector s) {
     auto str = s.toString();
 
-    return str.substr(str.size() - quantumState.getNumberOfQubits(),
+    return str.substr(str.size() - numberOfQubits,
                       str.size());
 }
 
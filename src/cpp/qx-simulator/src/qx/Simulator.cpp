@@ -1,17 +1,27 @@
 #include "qx/Simulator.hpp"
 
 #include "qx/Circuit.hpp"
+#include "qx/CircuitCache.hpp"
+#include "qx/DenseStateVector.hpp"
+#include "qx/DistributedStateVector.hpp"
 #include "qx/ErrorModels.hpp"
+#include "qx/PauliFrames.hpp"
+#include "qx/QuantumStatePool.hpp"
+#include "qx/QubitReordering.hpp"
 #include "qx/V3xLibqasmInterface.hpp"
 #include "qx/Random.hpp"
 #include "qx/SimulationResult.hpp"
+#include "qx/Snapshot.hpp"
 
 #include "v3x/cqasm.hpp"
 
+#include <algorithm>  // min
+#include <bit>  // bit_width
 #include <fmt/format.h>
 #include <fmt/ranges.h>
 #include <fstream>
 #include <iostream>
+#include <limits>
 #include <optional>
 #include <vector>
 
@@ -46,12 +56,7 @@ std::variant<V3Program, SimulationError> getV3ProgramOrError(V3AnalysisResult co
     return program;
 }
 
-std::variant<SimulationResult, SimulationError>
-execute(
-    V3AnalysisResult const& analysisResult,
-    std::size_t iterations,
-    std::optional<std::uint_fast64_t> seed) {
-
+std::variant<CircuitCache::Entry, SimulationError> compile(V3AnalysisResult const& analysisResult) {
     auto programOrError = getV3ProgramOrError(analysisResult);
 
     if (auto* error = std::get_if<SimulationError>(&programOrError)) {
@@ -62,14 +67,6 @@ execute(
 
     assert(!program.empty());
 
-    if (iterations <= 0) {
-        return SimulationError{ "Invalid number of iterations" };
-    }
-
-    if (seed) {
-        random::seed(*seed);
-    }
-
     std::size_t qubitCount = 0;
     auto const& v = program->qubit_variable_declaration;
     if (v->typ->type() == cqasm::v3x::types::NodeType::QubitArray) {
@@ -82,22 +79,520 @@ execute(
         return SimulationError{ "Cannot run that many qubits in this version of QX-simulator" };
     }
 
-    qx::core::QuantumState quantumState(qubitCount);
+    return CircuitCache::Entry{ std::make_shared<Circuit const>(loadCqasmCode(*program)), qubitCount };
+}
+
+std::vector<core::QubitIndex> getMarginalQubits(SimulationOptions const& options) {
+    std::vector<core::QubitIndex> result;
+    for (auto qubit : options.marginal_qubits) {
+        result.push_back(core::QubitIndex{ qubit });
+    }
+    return result;
+}
+
+std::optional<SimulationError> checkQueries(SimulationOptions const& options, std::size_t qubitCount) {
+    for (auto const& basisState : options.amplitude_queries) {
+        if (basisState.size() != qubitCount || basisState.find_first_not_of("01") != std::string::npos) {
+            return SimulationError{ fmt::format("Invalid amplitude query '{}': expected {} characters 0 or 1",
+                basisState, qubitCount) };
+        }
+    }
 
-    qx::Circuit circuit = loadCqasmCode(*program);
+    try {
+        core::checkMarginalQubits(getMarginalQubits(options), qubitCount);
+    } catch (std::exception const& e) {
+        return SimulationError{ fmt::format("Invalid marginal qubits: {}", e.what()) };
+    }
+    return std::nullopt;
+}
 
-    SimulationResultAccumulator simulationResultAccumulator(quantumState);
+std::optional<SimulationError> checkErrorModels(SimulationOptions const& options) {
+    for (auto [name, probability] : { std::pair{ "depolarizing_probability", options.depolarizing_probability },
+                                      std::pair{ "amplitude_damping", options.amplitude_damping },
+                                      std::pair{ "readout_error_zero_to_one", options.readout_error_zero_to_one },
+                                      std::pair{ "readout_error_one_to_zero", options.readout_error_one_to_zero } }) {
+        if (!(0. <= probability && probability <= 1.)) {
+            return SimulationError{ fmt::format("Invalid {}: {} is not between 0 and 1", name, probability) };
+        }
+    }
 
-    for (std::size_t s = 0; s < iterations; ++s) {
-        quantumState.reset();
-        circuit.execute(quantumState, std::monostate{});
+    if (options.depolarizing_probability > 0. && options.amplitude_damping > 0.) {
+        return SimulationError{ "Cannot combine depolarizing_probability and amplitude_damping" };
+    }
+    return std::nullopt;
+}
+
+std::uint64_t saturatingMultiply(std::uint64_t left, std::uint64_t right) {
+    if (right != 0 && left > std::numeric_limits<std::uint64_t>::max() / right) {
+        return std::numeric_limits<std::uint64_t>::max();
+    }
+    return left * right;
+}
+
+// See estimateMemoryString. The Pauli frames run their reference shot on the sparse backend.
+template <typename T>
+MemoryEstimate getMemoryEstimate(Circuit const& circuit, std::size_t qubitCount, std::size_t iterations,
+    std::optional<core::Snapshot> const& initialState, SimulationOptions const& options) {
+    auto powerOfTwo = [](std::size_t exponent) {
+        return exponent < 64 ? std::uint64_t{ 1 } << exponent : std::numeric_limits<std::uint64_t>::max();
+    };
+
+    if (options.backend == StateBackend::Dense && !options.pauli_frames) {
+        auto amplitudes = powerOfTwo(qubitCount);
+        return MemoryEstimate{ .max_amplitudes = amplitudes,
+                               .max_amplitude_bytes = saturatingMultiply(amplitudes, sizeof(std::complex<T>)) };
+    }
+
+    std::size_t initialQubits = 0;
+    if (initialState) {
+        initialQubits = static_cast<std::size_t>(
+            std::bit_width(std::max<std::size_t>(initialState->getNumberOfAmplitudes(), 1) - 1));
+    }
+    auto amplitudes = powerOfTwo(circuit.getMaxAmplitudeQubits(qubitCount, initialQubits));
+    auto bytes = core::BasicSparseArray<T>::getMaxMemoryBytes(amplitudes, options.sparse_storage);
+    if (options.shot_branching) {
+        // Each branch that is not done yet is a copy of the state, with at most half of the shots of the previous one.
+        bytes = saturatingMultiply(bytes, static_cast<std::uint64_t>(std::bit_width(iterations)));
+    }
+    return MemoryEstimate{ .max_amplitudes = amplitudes, .max_amplitude_bytes = bytes };
+}
+
+MemoryEstimate getMemoryEstimate(Circuit const& circuit, std::size_t qubitCount, std::size_t iterations,
+    std::optional<core::Snapshot> const& initialState, SimulationOptions const& options) {
+    if (options.precision == Precision::Float) {
+        return getMemoryEstimate<float>(circuit, qubitCount, iterations, initialState, options);
+    }
+    return getMemoryEstimate<double>(circuit, qubitCount, iterations, initialState, options);
+}
+
+// A new error model per run, since the amplitude damping channel keeps track of its next decay across gates.
+error_models::ErrorModel getErrorModel(SimulationOptions const& options) {
+    if (options.depolarizing_probability > 0.) {
+        return error_models::DepolarizingChannel(options.depolarizing_probability);
+    }
+    if (options.amplitude_damping > 0.) {
+        return error_models::AmplitudeDampingChannel(options.amplitude_damping);
+    }
+    return std::monostate{};
+}
+
+// Looks up the queried amplitudes and marginal probabilities, without going through the whole sorted state.
+template <typename State>
+void addQueryResults(SimulationResult& simulationResult, State const& quantumState, SimulationOptions const& options) {
+    for (auto const& basisState : options.amplitude_queries) {
+        auto amplitude = quantumState.getAmplitude(BasisVector(basisState));
+        simulationResult.amplitudes.emplace_back(basisState,
+            Complex{ .real = amplitude.real(), .imag = amplitude.imag(), .norm = std::norm(amplitude) });
+    }
+
+    if (options.marginal_qubits.empty()) {
+        return;
+    }
+    auto probabilities = quantumState.getMarginalProbabilities(getMarginalQubits(options));
+    for (std::size_t outcome = 0; outcome < probabilities.size(); ++outcome) {
+        auto outcomeString = BasisVector::fromSizeT(outcome).toString();
+        simulationResult.marginal_probabilities.emplace_back(
+            outcomeString.substr(outcomeString.size() - options.marginal_qubits.size()), probabilities[outcome]);
+    }
+}
+
+bool hasReadoutError(SimulationOptions const& options) {
+    return options.readout_error_zero_to_one > 0. || options.readout_error_one_to_zero > 0.;
+}
+
+// With SimulationOptions::record_shots, before the first shot.
+std::optional<SimulationError> startRecording(SimulationResultAccumulator &simulationResultAccumulator,
+    Circuit const& circuit, std::size_t qubitCount, SimulationOptions const& options) {
+    if (!options.record_shots) {
+        return std::nullopt;
+    }
+
+    std::optional<error_models::ReadoutError> readoutError;
+    if (hasReadoutError(options)) {
+        readoutError.emplace(options.readout_error_zero_to_one, options.readout_error_one_to_zero);
+    }
+    try {
+        simulationResultAccumulator.recordShots(options.shot_record_file, readoutError,
+            circuit.getMeasuredQubits(qubitCount));
+    } catch (std::exception const& e) {
+        return SimulationError{ fmt::format("Cannot record the shots: {}", e.what()) };
+    }
+    return std::nullopt;
+}
+
+// Post-processing of the shots, which all ran on quantumState.
+template <typename State>
+std::variant<SimulationResult, SimulationError> getResult(State &quantumState,
+    SimulationResultAccumulator &simulationResultAccumulator, Circuit const& circuit, std::size_t iterations,
+    core::MemoryTracker const& memoryTracker, SimulationOptions const& options) {
+    if (!options.final_state_file.empty()) {
+        try {
+            core::saveSnapshot(quantumState.getSnapshot(), options.final_state_file, options.compress_final_state);
+        } catch (std::exception const& e) {
+            return SimulationError{ fmt::format("Cannot save the final state: {}", e.what()) };
+        }
+    }
+
+    // Recorded shots were read as they were appended, see startRecording.
+    if (!options.record_shots && hasReadoutError(options)) {
+        simulationResultAccumulator.applyReadoutError(
+            error_models::ReadoutError(options.readout_error_zero_to_one, options.readout_error_one_to_zero),
+            circuit.getMeasuredQubits(quantumState.getNumberOfQubits()));
+    }
+
+    std::optional<SimulationResult> simulationResult;
+    try {
+        simulationResult = simulationResultAccumulator.get(quantumState, options.include_state);
+    } catch (std::exception const& e) {
+        return SimulationError{ fmt::format("Cannot record the shots: {}", e.what()) };
+    }
+    simulationResult->shots_requested = iterations;
+    simulationResult->amplitude_bytes = memoryTracker.getBytes();
+    simulationResult->peak_amplitude_bytes = memoryTracker.getPeakBytes();
+    addQueryResults(*simulationResult, quantumState, options);
+    return *std::move(simulationResult);
+}
+
+// Exceptions during the shots, such as a memory budget that is exceeded, stop the simulation.
+template <typename State>
+std::variant<SimulationResult, SimulationError> run(State &quantumState, Circuit const& circuit, std::size_t iterations,
+    std::optional<core::Snapshot> const& initialState, core::MemoryTracker const& memoryTracker,
+    SimulationOptions const& options, SimulationProgress* progress) {
+    SimulationResultAccumulator simulationResultAccumulator(quantumState.getNumberOfQubits());
+    if (auto error = startRecording(simulationResultAccumulator, circuit, quantumState.getNumberOfQubits(), options)) {
+        return *error;
+    }
+    auto errorModel = getErrorModel(options);
+
+    std::size_t shotsDone = 0;
+    for (; shotsDone < iterations; ++shotsDone) {
+        if (progress && progress->isCancelled()) {
+            break;
+        }
+        try {
+            quantumState.reset();
+            if (initialState) {
+                quantumState.restore(*initialState);
+            }
+            circuit.execute(quantumState, errorModel);
+        } catch (std::exception const& e) {
+            return SimulationError{ fmt::format("Simulation aborted: {}", e.what()) };
+        }
         simulationResultAccumulator.append(
             quantumState.getMeasurementRegister());
+        if (progress) {
+            progress->onShotDone(iterations);
+        }
+    }
+
+    if (shotsDone == 0) {
+        return SimulationError{ "Simulation was cancelled" };
     }
 
-    auto simulationResult = simulationResultAccumulator.get();
+    return getResult(quantumState, simulationResultAccumulator, circuit, iterations, memoryTracker, options);
+}
+
+// All the shots at once, see Circuit::executeBranching. A cancellation is only taken into account before the start.
+template <typename T>
+std::variant<SimulationResult, SimulationError> runBranching(core::BasicQuantumState<T> &quantumState,
+    Circuit const& circuit, std::size_t iterations, std::optional<core::Snapshot> const& initialState,
+    core::MemoryTracker const& memoryTracker, SimulationOptions const& options, SimulationProgress* progress) {
+    if (progress && progress->isCancelled()) {
+        return SimulationError{ "Simulation was cancelled" };
+    }
+
+    SimulationResultAccumulator simulationResultAccumulator(quantumState.getNumberOfQubits());
+    if (auto error = startRecording(simulationResultAccumulator, circuit, quantumState.getNumberOfQubits(), options)) {
+        return *error;
+    }
+    try {
+        if (initialState) {
+            quantumState.restore(*initialState);
+        }
+        circuit.executeBranching(quantumState, iterations,
+            [&simulationResultAccumulator, iterations, progress](BasisVector measurementRegister, std::uint64_t shots) {
+                simulationResultAccumulator.appendUnordered(measurementRegister, shots);
+                if (progress) {
+                    progress->onShotsDone(shots, iterations);
+                }
+            });
+    } catch (std::exception const& e) {
+        return SimulationError{ fmt::format("Simulation aborted: {}", e.what()) };
+    }
 
-    return simulationResult;
+    return getResult(quantumState, simulationResultAccumulator, circuit, iterations, memoryTracker, options);
+}
+
+// One noiseless reference shot, then the other shots in batches of Pauli frames, see PauliFrameSampler.
+template <typename T>
+std::variant<SimulationResult, SimulationError> runPauliFrames(core::BasicQuantumState<T> &quantumState,
+    Circuit const& circuit, std::size_t iterations, core::MemoryTracker const& memoryTracker,
+    SimulationOptions const& options, SimulationProgress* progress) {
+    std::optional<PauliFrameSampler> pauliFrameSampler;
+    try {
+        pauliFrameSampler.emplace(circuit, quantumState.getNumberOfQubits());
+    } catch (std::exception const& e) {
+        return SimulationError{ e.what() };
+    }
+
+    try {
+        circuit.execute(quantumState, std::monostate{});
+    } catch (std::exception const& e) {
+        return SimulationError{ fmt::format("Simulation aborted: {}", e.what()) };
+    }
+    auto reference = quantumState.getMeasurementRegister();
+
+    SimulationResultAccumulator simulationResultAccumulator(quantumState.getNumberOfQubits());
+    if (auto error = startRecording(simulationResultAccumulator, circuit, quantumState.getNumberOfQubits(), options)) {
+        return *error;
+    }
+    std::size_t shotsDone = 0;
+    while (shotsDone < iterations) {
+        if (progress && progress->isCancelled()) {
+            break;
+        }
+        auto shots = std::min(iterations - shotsDone, PauliFrameSampler::BATCH_SIZE);
+        pauliFrameSampler->sample(reference, shots, options.depolarizing_probability,
+            [&simulationResultAccumulator](BasisVector measurementRegister, std::uint64_t count) {
+                simulationResultAccumulator.appendUnordered(measurementRegister, count);
+            });
+        shotsDone += shots;
+        if (progress) {
+            progress->onShotsDone(shots, iterations);
+        }
+    }
+
+    if (shotsDone == 0) {
+        return SimulationError{ "Simulation was cancelled" };
+    }
+
+    return getResult(quantumState, simulationResultAccumulator, circuit, iterations, memoryTracker, options);
+}
+
+template <typename T>
+std::variant<SimulationResult, SimulationError> run(Circuit const& circuit, std::size_t qubitCount,
+    std::size_t iterations, std::optional<core::Snapshot> const& initialState, SimulationOptions const& options,
+    SimulationProgress* progress) {
+    // Outlives the states that report to it.
+    core::MemoryTracker memoryTracker(options.max_memory_bytes);
+
+    if (options.backend == StateBackend::Dense && !options.pauli_frames) {
+        if (qubitCount >= config::MAX_QUBIT_NUMBER) {
+            return SimulationError{ "Cannot run that many qubits with the dense backend" };
+        }
+
+        // Within the budget, which was checked before.
+        memoryTracker.update(0,
+            getMemoryEstimate<T>(circuit, qubitCount, iterations, initialState, options).max_amplitude_bytes);
+
+        if (options.dense_processes > 1) {
+            std::optional<core::BasicDistributedStateVector<T>> distributedStateVector;
+            try {
+                distributedStateVector.emplace(qubitCount, options.dense_processes);
+            } catch (std::exception const& e) {
+                return SimulationError{ fmt::format("Cannot allocate the distributed state vector: {}", e.what()) };
+            }
+            if (options.reorder_qubits) {
+                auto reordered = reorderQubits(circuit, distributedStateVector->getLocalQubits());
+                return run(*distributedStateVector, reordered, iterations, initialState, memoryTracker, options,
+                    progress);
+            }
+            return run(*distributedStateVector, circuit, iterations, initialState, memoryTracker, options, progress);
+        }
+
+        std::optional<core::BasicDenseStateVector<T>> denseStateVector;
+        try {
+            denseStateVector.emplace(qubitCount, options.dense_state_file,
+                options.dense_block_qubits > 0 ? std::optional(options.dense_block_qubits) : std::nullopt);
+        } catch (std::exception const& e) {
+            return SimulationError{ fmt::format("Cannot allocate the dense state vector: {}", e.what()) };
+        }
+        // In RAM, all the qubits are in block, so the pass would only add layouts that move nothing. It does not map
+        // the hottest qubits into the config::DENSE_TILE_QUBITS low-order bits either.
+        if (options.reorder_qubits && !options.dense_state_file.empty()) {
+            auto reordered = reorderQubits(circuit, denseStateVector->getBlockQubits());
+            return run(*denseStateVector, reordered, iterations, initialState, memoryTracker, options, progress);
+        }
+        return run(*denseStateVector, circuit, iterations, initialState, memoryTracker, options, progress);
+    }
+
+    // Consecutive simulations on this thread reuse the allocations of the previous ones.
+    auto quantumState = core::QuantumStatePool<T>::borrow(qubitCount, options.sparse_storage);
+    try {
+        quantumState->setMemoryTracker(&memoryTracker);
+    } catch (std::exception const& e) {
+        return SimulationError{ fmt::format("Simulation aborted: {}", e.what()) };
+    }
+
+    if (options.pauli_frames) {
+        return runPauliFrames(*quantumState, circuit, iterations, memoryTracker, options, progress);
+    }
+    if (options.shot_branching) {
+        return runBranching(*quantumState, circuit, iterations, initialState, memoryTracker, options, progress);
+    }
+    return run(*quantumState, circuit, iterations, initialState, memoryTracker, options, progress);
+}
+
+std::variant<SimulationResult, SimulationError>
+execute(
+    CircuitCache::Entry const& compiled,
+    std::size_t iterations,
+    std::optional<std::uint_fast64_t> seed,
+    SimulationOptions const& options,
+    SimulationProgress* progress) {
+
+    if (iterations <= 0) {
+        return SimulationError{ "Invalid number of iterations" };
+    }
+
+    if (seed) {
+        random::seed(*seed);
+    }
+
+    auto const& circuit = *compiled.circuit;
+
+    if (auto error = checkQueries(options, compiled.qubitCount)) {
+        return *error;
+    }
+
+    if (auto error = checkErrorModels(options)) {
+        return *error;
+    }
+
+    if (options.shot_branching && (options.backend != StateBackend::Sparse || options.depolarizing_probability > 0. ||
+                                   options.amplitude_damping > 0.)) {
+        return SimulationError{ "Shot branching needs the sparse backend, without depolarizing or amplitude damping" };
+    }
+
+    if (options.dense_processes > 1 && (options.backend != StateBackend::Dense || !options.dense_state_file.empty())) {
+        return SimulationError{ "dense_processes needs the dense backend, without dense_state_file" };
+    }
+
+    if (!options.shot_record_file.empty() && !options.record_shots) {
+        return SimulationError{ "shot_record_file needs record_shots" };
+    }
+
+    if (options.pauli_frames && (options.amplitude_damping > 0. || options.shot_branching ||
+                                 !options.initial_state_file.empty())) {
+        return SimulationError{ "Pauli frames are not compatible with amplitude_damping, shot_branching and "
+                                "initial_state_file" };
+    }
+
+    std::optional<core::Snapshot> initialState;
+    if (!options.initial_state_file.empty()) {
+        try {
+            initialState = core::loadSnapshot(options.initial_state_file);
+        } catch (std::exception const& e) {
+            return SimulationError{ fmt::format("Cannot load the initial state: {}", e.what()) };
+        }
+
+        if (initialState->numberOfQubits != compiled.qubitCount) {
+            return SimulationError{ fmt::format("The initial state has {} qubits, but the circuit has {}",
+                initialState->numberOfQubits, compiled.qubitCount) };
+        }
+    }
+
+    // The sparse backend is checked gate by gate instead, since its estimate for the whole circuit is usually far too
+    // high: see BasicQuantumState::checkMemoryBytesBeforeGate.
+    if (options.max_memory_bytes > 0 && options.backend == StateBackend::Dense && !options.pauli_frames) {
+        auto estimate = getMemoryEstimate(circuit, compiled.qubitCount, iterations, initialState, options);
+        if (estimate.max_amplitude_bytes > options.max_memory_bytes) {
+            return SimulationError{ fmt::format("The amplitudes take {} bytes, more than the memory budget of {} bytes",
+                estimate.max_amplitude_bytes, options.max_memory_bytes) };
+        }
+    }
+
+    if (options.precision == Precision::Float) {
+        return run<float>(circuit, compiled.qubitCount, iterations, initialState, options, progress);
+    }
+    return run<double>(circuit, compiled.qubitCount, iterations, initialState, options, progress);
+}
+
+std::variant<SimulationResult, SimulationError>
+execute(
+    V3AnalysisResult const& analysisResult,
+    std::size_t iterations,
+    std::optional<std::uint_fast64_t> seed,
+    SimulationOptions const& options,
+    SimulationProgress* progress) {
+
+    auto compiledOrError = compile(analysisResult);
+
+    if (auto* error = std::get_if<SimulationError>(&compiledOrError)) {
+        return *error;
+    }
+
+    return execute(std::get<CircuitCache::Entry>(compiledOrError), iterations, seed, options, progress);
+}
+
+// Compiled circuits are looked up in, and added to, the circuit cache.
+std::variant<CircuitCache::Entry, SimulationError> compileString(std::string const& s,
+    std::string const& cqasm_version) {
+    auto &circuitCache = CircuitCache::getInstance();
+    if (auto cached = circuitCache.find(s, cqasm_version)) {
+        return *cached;
+    }
+
+    auto compiledOrError = compile(parseCqasmV3xString(s));
+    if (auto* compiled = std::get_if<CircuitCache::Entry>(&compiledOrError)) {
+        circuitCache.insert(s, cqasm_version, *compiled);
+    }
+    return compiledOrError;
+}
+
+std::variant<MemoryEstimate, SimulationError> estimateMemory(
+    std::variant<CircuitCache::Entry, SimulationError> const& compiledOrError, std::size_t iterations,
+    SimulationOptions const& options) {
+    if (auto* error = std::get_if<SimulationError>(&compiledOrError)) {
+        return *error;
+    }
+
+    std::optional<core::Snapshot> initialState;
+    if (!options.initial_state_file.empty()) {
+        try {
+            initialState = core::loadSnapshot(options.initial_state_file);
+        } catch (std::exception const& e) {
+            return SimulationError{ fmt::format("Cannot load the initial state: {}", e.what()) };
+        }
+    }
+
+    auto const& compiled = std::get<CircuitCache::Entry>(compiledOrError);
+    return getMemoryEstimate(*compiled.circuit, compiled.qubitCount, iterations, initialState, options);
+}
+
+std::variant<UnitaryResult, SimulationError> getUnitary(
+    std::variant<CircuitCache::Entry, SimulationError> const& compiledOrError) {
+    if (auto* error = std::get_if<SimulationError>(&compiledOrError)) {
+        return *error;
+    }
+
+    auto const& compiled = std::get<CircuitCache::Entry>(compiledOrError);
+    try {
+        auto unitary = compiled.circuit->getUnitary(compiled.qubitCount);
+        return UnitaryResult{ .number_of_qubits = compiled.qubitCount, .matrix = unitary.takeEntries() };
+    } catch (std::exception const& e) {
+        return SimulationError{ e.what() };
+    }
+}
+
+std::variant<GradientResult, SimulationError> getGradients(
+    std::variant<CircuitCache::Entry, SimulationError> const& compiledOrError, Observable const& observable) {
+    if (auto* error = std::get_if<SimulationError>(&compiledOrError)) {
+        return *error;
+    }
+
+    std::vector<core::PauliTerm> terms;
+    for (auto const& [paulis, coefficient] : observable) {
+        terms.push_back(core::PauliTerm{ .coefficient = coefficient, .paulis = paulis });
+    }
+
+    auto const& compiled = std::get<CircuitCache::Entry>(compiledOrError);
+    try {
+        auto gradients = compiled.circuit->getGradients(compiled.qubitCount, terms);
+        return GradientResult{ .expectation = gradients.expectation, .gradients = std::move(gradients.gradients) };
+    } catch (std::exception const& e) {
+        return SimulationError{ e.what() };
+    }
 }
 }
 
@@ -106,11 +601,17 @@ executeString(
     std::string const &s,
     std::size_t iterations,
     std::optional<std::uint_fast64_t> seed,
-    std::string cqasm_version) {
+    std::string cqasm_version,
+    SimulationOptions const &options,
+    SimulationProgress *progress) {
 
     if (cqasm_version == "3.0") {
-        auto analysisResult = parseCqasmV3xString(s);
-        return execute(analysisResult, iterations, seed);
+        auto compiledOrError = compileString(s, cqasm_version);
+        if (auto* error = std::get_if<SimulationError>(&compiledOrError)) {
+            return *error;
+        }
+
+        return execute(std::get<CircuitCache::Entry>(compiledOrError), iterations, seed, options, progress);
     } else {
         return SimulationError{ fmt::format("Unknown cqasm version: {}", cqasm_version) };
     }
@@ -121,11 +622,107 @@ executeFile(
     std::string const &filePath,
     std::size_t iterations,
     std::optional<std::uint_fast64_t> seed,
-    std::string cqasm_version) {
+    std::string cqasm_version,
+    SimulationOptions const &options,
+    SimulationProgress *progress) {
 
     if (cqasm_version == "3.0") {
         auto analysisResult = parseCqasmV3xFile(filePath);
-        return execute(analysisResult, iterations, seed);
+        return execute(analysisResult, iterations, seed, options, progress);
+    } else {
+        return SimulationError{ fmt::format("Unknown cqasm version: {}", cqasm_version) };
+    }
+}
+
+std::variant<SimulationResult, SimulationError>
+executeCircuit(
+    CircuitBuilder const &circuit,
+    std::size_t iterations,
+    std::optional<std::uint_fast64_t> seed,
+    SimulationOptions const &options,
+    SimulationProgress *progress) {
+
+    if (auto const& error = circuit.getError()) {
+        return SimulationError{ *error };
+    }
+
+    return execute(CircuitCache::Entry{ circuit.getCircuit(), circuit.getNumberOfQubits() }, iterations, seed, options,
+        progress);
+}
+
+std::variant<MemoryEstimate, SimulationError>
+estimateMemoryString(
+    std::string const &s,
+    std::size_t iterations,
+    std::string cqasm_version,
+    SimulationOptions const &options) {
+
+    if (cqasm_version == "3.0") {
+        return estimateMemory(compileString(s, cqasm_version), iterations, options);
+    } else {
+        return SimulationError{ fmt::format("Unknown cqasm version: {}", cqasm_version) };
+    }
+}
+
+std::variant<MemoryEstimate, SimulationError>
+estimateMemoryFile(
+    std::string const &filePath,
+    std::size_t iterations,
+    std::string cqasm_version,
+    SimulationOptions const &options) {
+
+    if (cqasm_version == "3.0") {
+        return estimateMemory(compile(parseCqasmV3xFile(filePath)), iterations, options);
+    } else {
+        return SimulationError{ fmt::format("Unknown cqasm version: {}", cqasm_version) };
+    }
+}
+
+std::variant<UnitaryResult, SimulationError>
+getUnitaryString(
+    std::string const &s,
+    std::string cqasm_version) {
+
+    if (cqasm_version == "3.0") {
+        return getUnitary(compileString(s, cqasm_version));
+    } else {
+        return SimulationError{ fmt::format("Unknown cqasm version: {}", cqasm_version) };
+    }
+}
+
+std::variant<UnitaryResult, SimulationError>
+getUnitaryFile(
+    std::string const &filePath,
+    std::string cqasm_version) {
+
+    if (cqasm_version == "3.0") {
+        return getUnitary(compile(parseCqasmV3xFile(filePath)));
+    } else {
+        return SimulationError{ fmt::format("Unknown cqasm version: {}", cqasm_version) };
+    }
+}
+
+std::variant<GradientResult, SimulationError>
+getGradientsString(
+    std::string const &s,
+    Observable const &observable,
+    std::string cqasm_version) {
+
+    if (cqasm_version == "3.0") {
+        return getGradients(compileString(s, cqasm_version), observable);
+    } else {
+        return SimulationError{ fmt::format("Unknown cqasm version: {}", cqasm_version) };
+    }
+}
+
+std::variant<GradientResult, SimulationError>
+getGradientsFile(
+    std::string const &filePath,
+    Observable const &observable,
+    std::string cqasm_version) {
+
+    if (cqasm_version == "3.0") {
+        return getGradients(compile(parseCqasmV3xFile(filePath)), observable);
     } else {
         return SimulationError{ fmt::format("Unknown cqasm version: {}", cqasm_version) };
     }
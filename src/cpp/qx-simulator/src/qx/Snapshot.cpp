@@ -0,0 +1,250 @@
+#include "qx/Snapshot.hpp"
+
+#include <array>
+#include <bit>  // endian
+#include <fstream>
+#include <stdexcept>  // runtime_error
+#include <type_traits>  // is_trivially_copyable_v
+
+
+namespace qx::core {
+
+namespace {
+
+constexpr std::array<char, 6> MAGIC = { 'Q', 'X', 'S', 'N', 'A', 'P' };
+constexpr std::uint16_t FORMAT_VERSION = 1;
+constexpr std::uint32_t COMPRESSED_BASIS_VECTORS = 1;
+
+// All fields are little-endian, and are followed by the basis vectors (sparse snapshots only),
+// then by the amplitudes as pairs of doubles.
+struct Header {
+    std::array<char, 6> magic = MAGIC;
+    std::uint16_t formatVersion = FORMAT_VERSION;
+    Snapshot::Representation representation = Snapshot::Representation::Sparse;
+    std::uint32_t flags = 0;
+    std::uint64_t numberOfQubits = 0;
+    std::uint64_t numberOfAmplitudes = 0;
+    std::uint64_t measurementRegister = 0;
+    std::uint64_t basisVectorsBytes = 0;
+};
+
+static_assert(sizeof(Header) == 48);
+static_assert(sizeof(BasisVector) == sizeof(std::uint64_t) && std::is_trivially_copyable_v<BasisVector>);
+static_assert(sizeof(std::complex<double>) == 2 * sizeof(double));
+
+void checkEndianness() {
+    if constexpr (std::endian::native != std::endian::little) {
+        throw std::runtime_error("Snapshots are only supported on little-endian systems");
+    }
+}
+
+// LEB128 encoding of the differences between consecutive (sorted) basis vectors.
+std::vector<std::uint8_t> compressBasisVectors(std::vector<BasisVector> const &basisVectors) {
+    std::vector<std::uint8_t> result;
+    result.reserve(2 * basisVectors.size());
+
+    std::uint64_t previous = 0;
+    for (auto const &basisVector : basisVectors) {
+        auto delta = basisVector.toSizeT() - previous;
+        previous = basisVector.toSizeT();
+        while (delta >= 0x80) {
+            result.push_back(static_cast<std::uint8_t>(delta | 0x80));
+            delta >>= 7;
+        }
+        result.push_back(static_cast<std::uint8_t>(delta));
+    }
+    return result;
+}
+
+void decompressBasisVectors(std::vector<std::uint8_t> const &bytes, std::vector<BasisVector> &basisVectors) {
+    std::uint64_t previous = 0;
+    std::size_t i = 0;
+    for (auto &basisVector : basisVectors) {
+        std::uint64_t delta = 0;
+        for (std::size_t shift = 0;; shift += 7) {
+            if (i >= bytes.size() || shift >= 64) {
+                throw std::runtime_error("Corrupted basis vectors in snapshot");
+            }
+            auto byte = bytes[i++];
+            delta |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) {
+                break;
+            }
+        }
+        previous += delta;
+        basisVector = BasisVector::fromSizeT(previous);
+    }
+}
+
+template <typename T>
+void write(std::ofstream &file, T const *data, std::size_t count) {
+    file.write(reinterpret_cast<char const *>(data), static_cast<std::streamsize>(count * sizeof(T)));
+}
+
+template <typename T>
+void read(std::ifstream &file, T *data, std::size_t count, std::string const &filePath) {
+    file.read(reinterpret_cast<char *>(data), static_cast<std::streamsize>(count * sizeof(T)));
+    if (!file) {
+        throw std::runtime_error("Truncated snapshot file '" + filePath + "'");
+    }
+}
+
+} // namespace
+
+template <typename T>
+Snapshot Snapshot::fromSortedAmplitudes(std::size_t numberOfQubits,
+    std::vector<std::pair<BasisVector, std::complex<T>>> const &sortedAmplitudes,
+    BasisVector measurementRegister) {
+    Snapshot result;
+    result.numberOfQubits = numberOfQubits;
+    result.measurementRegister = measurementRegister;
+
+    // Dense amplitudes take 16 bytes each, sparse ones 24 bytes (uncompressed).
+    if (numberOfQubits < 32 && 2 * (static_cast<std::size_t>(1) << numberOfQubits) <= 3 * sortedAmplitudes.size()) {
+        result.representation = Representation::Dense;
+        result.amplitudes.resize(static_cast<std::size_t>(1) << numberOfQubits, 0);
+        for (auto const &[basisVector, amplitude] : sortedAmplitudes) {
+            result.amplitudes[basisVector.toSizeT()] = static_cast<std::complex<double>>(amplitude);
+        }
+        return result;
+    }
+
+    result.basisVectors.reserve(sortedAmplitudes.size());
+    result.amplitudes.reserve(sortedAmplitudes.size());
+    for (auto const &[basisVector, amplitude] : sortedAmplitudes) {
+        result.basisVectors.push_back(basisVector);
+        result.amplitudes.push_back(static_cast<std::complex<double>>(amplitude));
+    }
+    return result;
+}
+
+template Snapshot Snapshot::fromSortedAmplitudes(std::size_t numberOfQubits,
+    std::vector<std::pair<BasisVector, std::complex<float>>> const &sortedAmplitudes,
+    BasisVector measurementRegister);
+
+template Snapshot Snapshot::fromSortedAmplitudes(std::size_t numberOfQubits,
+    std::vector<std::pair<BasisVector, std::complex<double>>> const &sortedAmplitudes,
+    BasisVector measurementRegister);
+
+void saveSnapshot(Snapshot const &snapshot, std::string const &filePath, bool compress) {
+    checkEndianness();
+
+    auto sparse = snapshot.representation == Snapshot::Representation::Sparse;
+    compress = compress && sparse;
+    std::vector<std::uint8_t> compressedBasisVectors;
+    if (compress) {
+        compressedBasisVectors = compressBasisVectors(snapshot.basisVectors);
+    }
+
+    Header header;
+    header.representation = snapshot.representation;
+    header.flags = compress ? COMPRESSED_BASIS_VECTORS : 0;
+    header.numberOfQubits = snapshot.numberOfQubits;
+    header.numberOfAmplitudes = snapshot.amplitudes.size();
+    header.measurementRegister = snapshot.measurementRegister.toSizeT();
+    header.basisVectorsBytes = !sparse ? 0
+        : compress ? compressedBasisVectors.size()
+        : snapshot.basisVectors.size() * sizeof(BasisVector);
+
+    std::ofstream file(filePath, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        throw std::runtime_error("Cannot open snapshot file '" + filePath + "' for writing");
+    }
+
+    write(file, &header, 1);
+    if (compress) {
+        write(file, compressedBasisVectors.data(), compressedBasisVectors.size());
+    } else if (sparse) {
+        write(file, snapshot.basisVectors.data(), snapshot.basisVectors.size());
+    }
+    write(file, snapshot.amplitudes.data(), snapshot.amplitudes.size());
+
+    file.close();
+    if (!file) {
+        throw std::runtime_error("Cannot write snapshot file '" + filePath + "'");
+    }
+}
+
+Snapshot loadSnapshot(std::string const &filePath) {
+    checkEndianness();
+
+    std::ifstream file(filePath, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Cannot open snapshot file '" + filePath + "'");
+    }
+
+    Header header;
+    read(file, &header, 1, filePath);
+    if (header.magic != MAGIC) {
+        throw std::runtime_error("'" + filePath + "' is not a snapshot file");
+    }
+    if (header.formatVersion != FORMAT_VERSION) {
+        throw std::runtime_error("Unsupported snapshot format version " + std::to_string(header.formatVersion));
+    }
+    if (header.numberOfQubits == 0 || header.numberOfQubits > config::MAX_QUBIT_NUMBER) {
+        throw std::runtime_error("Invalid number of qubits in snapshot");
+    }
+    if (header.numberOfAmplitudes == 0) {
+        throw std::runtime_error("Snapshot has no amplitudes");
+    }
+
+    Snapshot result;
+    result.numberOfQubits = header.numberOfQubits;
+    result.representation = header.representation;
+    result.measurementRegister = BasisVector::fromSizeT(header.measurementRegister);
+
+    // Check the sizes against the file size before allocating anything.
+    auto headerEnd = file.tellg();
+    file.seekg(0, std::ios::end);
+    auto payloadBytes = static_cast<std::uint64_t>(file.tellg() - headerEnd);
+    file.seekg(headerEnd);
+
+    auto amplitudesBytes = header.numberOfAmplitudes * sizeof(std::complex<double>);
+    if (header.numberOfAmplitudes > payloadBytes / sizeof(std::complex<double>) ||
+        header.basisVectorsBytes != payloadBytes - amplitudesBytes) {
+        throw std::runtime_error("Truncated snapshot file '" + filePath + "'");
+    }
+
+    if (result.representation == Snapshot::Representation::Sparse) {
+        result.basisVectors.resize(header.numberOfAmplitudes);
+        if (header.flags & COMPRESSED_BASIS_VECTORS) {
+            std::vector<std::uint8_t> compressedBasisVectors(header.basisVectorsBytes);
+            read(file, compressedBasisVectors.data(), compressedBasisVectors.size(), filePath);
+            decompressBasisVectors(compressedBasisVectors, result.basisVectors);
+        } else {
+            if (header.basisVectorsBytes != header.numberOfAmplitudes * sizeof(BasisVector)) {
+                throw std::runtime_error("Corrupted basis vectors in snapshot");
+            }
+            read(file, result.basisVectors.data(), result.basisVectors.size(), filePath);
+        }
+
+        if (header.numberOfQubits < 64) {
+            for (auto const &basisVector : result.basisVectors) {
+                if (basisVector.toSizeT() >> header.numberOfQubits) {
+                    throw std::runtime_error("Snapshot has a basis vector beyond its number of qubits");
+                }
+            }
+        }
+
+        // As documented in Snapshot, the basis vectors of a sparse snapshot are sorted and unique.
+        for (std::size_t i = 1; i < result.basisVectors.size(); ++i) {
+            if (!(result.basisVectors[i - 1] < result.basisVectors[i])) {
+                throw std::runtime_error("Corrupted basis vectors in snapshot");
+            }
+        }
+    } else if (result.representation == Snapshot::Representation::Dense) {
+        if (header.numberOfQubits >= 32 ||
+            header.numberOfAmplitudes != static_cast<std::uint64_t>(1) << header.numberOfQubits) {
+            throw std::runtime_error("Invalid number of amplitudes in dense snapshot");
+        }
+    } else {
+        throw std::runtime_error("Unknown snapshot representation");
+    }
+
+    result.amplitudes.resize(header.numberOfAmplitudes);
+    read(file, result.amplitudes.data(), result.amplitudes.size(), filePath);
+
+    return result;
+}
+
+} // namespace qx::core
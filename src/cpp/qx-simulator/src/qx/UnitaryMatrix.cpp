@@ -0,0 +1,153 @@
+#include "qx/UnitaryMatrix.hpp"
+
+#include <algorithm>  // sort
+#include <fmt/format.h>
+#include <stdexcept>  // runtime_error
+
+
+namespace qx::core {
+
+namespace {
+
+std::size_t bit(std::size_t position) {
+    return static_cast<std::size_t>(1) << position;
+}
+
+} // namespace
+
+UnitaryMatrix::UnitaryMatrix(std::size_t n) : numberOfQubits(n), dimension(bit(n)) {
+    if (n > config::MAX_UNITARY_QUBITS) {
+        throw std::runtime_error(fmt::format("Cannot compute the unitary of more than {} qubits",
+            config::MAX_UNITARY_QUBITS));
+    }
+
+    entries.resize(dimension * dimension, 0.);
+    for (std::size_t i = 0; i < dimension; ++i) {
+        entries[i + i * dimension] = 1.;
+    }
+}
+
+template <std::size_t NumberOfOperands>
+void UnitaryMatrix::apply(DenseUnitaryMatrix<1 << NumberOfOperands> const &m,
+                          std::array<QubitIndex, NumberOfOperands> const &operands, std::size_t firstColumn,
+                          std::size_t endColumn) {
+    assert(NumberOfOperands <= numberOfQubits && "Quantum gate has more operands than the number of qubits");
+    assert(firstColumn <= endColumn && endColumn <= dimension);
+
+    // Offsets of the entries mixed by the gate, in the order of the matrix columns.
+    // Column bit k corresponds to operand NumberOfOperands - k - 1, as in the state vectors.
+    static constexpr std::size_t MATRIX_SIZE = 1 << NumberOfOperands;
+    std::array<std::size_t, MATRIX_SIZE> offsets{};
+    for (std::size_t i = 0; i < MATRIX_SIZE; ++i) {
+        for (std::size_t k = 0; k < NumberOfOperands; ++k) {
+            if (utils::getBit(i, k)) {
+                offsets[i] |= bit(operands[NumberOfOperands - k - 1].value);
+            }
+        }
+    }
+
+    std::array<std::size_t, NumberOfOperands> sortedPositions{};
+    for (std::size_t k = 0; k < NumberOfOperands; ++k) {
+        sortedPositions[k] = operands[k].value;
+    }
+    std::sort(sortedPositions.begin(), sortedPositions.end());
+
+    // Real and imaginary parts are kept apart, so that the inner loop vectorizes:
+    // std::complex multiplication checks for NaN and infinity, which gets in the way.
+    std::array<std::array<double, MATRIX_SIZE>, MATRIX_SIZE> real{};
+    std::array<std::array<double, MATRIX_SIZE>, MATRIX_SIZE> imag{};
+    for (std::size_t r = 0; r < MATRIX_SIZE; ++r) {
+        for (std::size_t c = 0; c < MATRIX_SIZE; ++c) {
+            real[r][c] = m.at(r, c).real();
+            imag[r][c] = m.at(r, c).imag();
+        }
+    }
+
+    // The entries below the lowest operand are contiguous, and are processed together in the inner loop.
+    auto innerSize = bit(sortedPositions[0]);
+    auto outerSize = dimension >> NumberOfOperands >> sortedPositions[0];
+
+    for (auto column = firstColumn; column < endColumn; ++column) {
+        auto *columnData = reinterpret_cast<double *>(entries.data() + column * dimension);
+
+        for (std::size_t outer = 0; outer < outerSize; ++outer) {
+            // Insert zeros at the operand positions.
+            auto base = outer << sortedPositions[0];
+            for (auto p : sortedPositions) {
+                base = ((base >> p) << (p + 1)) | (base & (bit(p) - 1));
+            }
+
+            std::array<double *, MATRIX_SIZE> pointers{};
+            for (std::size_t c = 0; c < MATRIX_SIZE; ++c) {
+                pointers[c] = columnData + 2 * (base + offsets[c]);
+            }
+
+            for (std::size_t inner = 0; inner < innerSize; ++inner) {
+                std::array<double, MATRIX_SIZE> inReal{};
+                std::array<double, MATRIX_SIZE> inImag{};
+                for (std::size_t c = 0; c < MATRIX_SIZE; ++c) {
+                    inReal[c] = pointers[c][2 * inner];
+                    inImag[c] = pointers[c][2 * inner + 1];
+                }
+                for (std::size_t r = 0; r < MATRIX_SIZE; ++r) {
+                    double outReal = 0.;
+                    double outImag = 0.;
+                    for (std::size_t c = 0; c < MATRIX_SIZE; ++c) {
+                        outReal += real[r][c] * inReal[c] - imag[r][c] * inImag[c];
+                        outImag += real[r][c] * inImag[c] + imag[r][c] * inReal[c];
+                    }
+                    pointers[r][2 * inner] = outReal;
+                    pointers[r][2 * inner + 1] = outImag;
+                }
+            }
+        }
+    }
+}
+
+void UnitaryMatrix::applyControlled(DenseUnitaryMatrix<2> const &m, std::span<QubitIndex const> controls,
+                                    QubitIndex target, std::size_t firstColumn, std::size_t endColumn) {
+    assert(target.value < numberOfQubits && "Operand refers to a non-existing qubit");
+    assert(firstColumn <= endColumn && endColumn <= dimension);
+
+    auto targetBit = bit(target.value);
+    std::size_t controlMask = 0;
+    std::vector<std::size_t> sortedPositions{ target.value };
+    for (auto const &control : controls) {
+        assert(control.value < numberOfQubits && control.value != target.value && "Invalid control qubit");
+        controlMask |= bit(control.value);
+        sortedPositions.push_back(control.value);
+    }
+    std::sort(sortedPositions.begin(), sortedPositions.end());
+
+    for (auto column = firstColumn; column < endColumn; ++column) {
+        auto *columnData = entries.data() + column * dimension;
+
+        // Only the entries whose control bits are all set are visited.
+        for (std::size_t i = 0; i < (dimension >> sortedPositions.size()); ++i) {
+            auto base = i;
+            for (auto p : sortedPositions) {
+                base = ((base >> p) << (p + 1)) | (base & (bit(p) - 1));
+            }
+            base |= controlMask;
+
+            auto zero = columnData[base];
+            auto one = columnData[base | targetBit];
+            columnData[base] = m.at(0, 0) * zero + m.at(0, 1) * one;
+            columnData[base | targetBit] = m.at(1, 0) * zero + m.at(1, 1) * one;
+        }
+    }
+}
+
+template void UnitaryMatrix::apply<1>(DenseUnitaryMatrix<1 << 1> const &m,
+                                      std::array<QubitIndex, 1> const &operands, std::size_t firstColumn,
+                                      std::size_t endColumn);
+
+template void UnitaryMatrix::apply<2>(DenseUnitaryMatrix<1 << 2> const &m,
+                                      std::array<QubitIndex, 2> const &operands, std::size_t firstColumn,
+                                      std::size_t endColumn);
+
+template void UnitaryMatrix::apply<3>(DenseUnitaryMatrix<1 << 3> const &m,
+                                      std::array<QubitIndex, 3> const &operands, std::size_t firstColumn,
+                                      std::size_t endColumn);
+
+} // namespace qx::core
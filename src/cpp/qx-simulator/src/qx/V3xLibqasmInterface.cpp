@@ -2,45 +2,67 @@
 
 #include "qx/Circuit.hpp"
 #include "qx/Core.hpp"
-#include "qx/Gates.hpp"
+#include "qx/CqasmGates.hpp"
 #include "v3x/cqasm-semantic-gen.hpp"
 
-#include <algorithm>  // generate_n
+#include <array>
+#include <optional>
+#include <span>
+#include <stdexcept>  // runtime_error
 
 
 namespace qx {
 
 namespace v3cq = ::cqasm::v3x::semantic;
-namespace v3primitives = ::cqasm::v3x::primitives;
-namespace v3tree = ::cqasm::tree;
 namespace v3types = ::cqasm::v3x::types;
 namespace v3values = ::cqasm::v3x::values;
 
 namespace {
+// Qubit indices of an operand, read in place: either a whole register, or the indices of an index reference.
+class QubitRange {
+public:
+    QubitRange() = default;
+
+    explicit QubitRange(std::size_t registerSize) : size(registerSize) {}
+
+    explicit QubitRange(v3cq::Many<v3values::ConstInt> const &indices) : indices(&indices), size(indices.size()) {}
+
+    [[nodiscard]] std::size_t getSize() const { return size; }
+
+    [[nodiscard]] core::QubitIndex operator[](std::size_t i) const {
+        return core::QubitIndex{ indices ? static_cast<std::size_t>((*indices)[i]->value) : i };
+    }
+
+private:
+    v3cq::Many<v3values::ConstInt> const *indices = nullptr;
+    std::size_t size = 0;
+};
+
 class OperandsHelper {
 public:
     explicit OperandsHelper(const v3cq::Instruction &instruction)
         : instruction(instruction) {}
 
-    [[nodiscard]] v3cq::Many<v3values::ConstInt> get_register_operand(int id) const {
+    [[nodiscard]] QubitRange get_register_operand(int id) const {
         if (auto variable_ref = instruction.operands[id]->as_variable_ref()) {
-            auto variable_size = v3types::size_of(variable_ref->variable->typ);
-            auto ret = v3cq::Many<v3values::ConstInt>{};
-            ret.get_vec().resize(variable_size);
-            std::generate_n(ret.get_vec().begin(), variable_size, [i=0]() mutable {
-                return v3tree::make<v3values::ConstInt>(static_cast<v3primitives::Int>(i++));
-            });
-            return ret;
+            return QubitRange(static_cast<std::size_t>(v3types::size_of(variable_ref->variable->typ)));
         }
-        return instruction.operands[id]->as_index_ref()->indices;
+        return QubitRange(instruction.operands[id]->as_index_ref()->indices);
     }
 
-    [[nodiscard]] double get_float_operand(int id) const {
-        return instruction.operands[id]->as_const_float()->value;
+    // The angle or integer, for operands that are not qubits.
+    [[nodiscard]] std::optional<double> get_parameter_operand(int id) const {
+        if (auto const_float = instruction.operands[id]->as_const_float()) {
+            return const_float->value;
+        }
+        if (auto const_int = instruction.operands[id]->as_const_int()) {
+            return static_cast<double>(const_int->value);
+        }
+        return std::nullopt;
     }
 
-    [[nodiscard]] std::int64_t get_int_operand(int id) const {
-        return instruction.operands[id]->as_const_int()->value;
+    [[nodiscard]] int size() const {
+        return static_cast<int>(instruction.operands.size());
     }
 
 private:
@@ -58,97 +80,46 @@ public:
     }
 
 private:
-    template <std::size_t NumberOfQubitOperands>
-    void addGates(
-        core::DenseUnitaryMatrix<1 << NumberOfQubitOperands> matrix,
-        std::array<v3cq::Many<v3values::ConstInt>, NumberOfQubitOperands> operands) {
-        static_assert(NumberOfQubitOperands > 0);
-
-#ifndef NDEBUG
-        std::for_each(operands.begin(), operands.end(),
-            [&operands](v3cq::Many<v3values::ConstInt> const &ops) {
-                assert(ops.size() == operands[0].size());
-            });
-#endif
-
-        for (std::size_t i = 0; i < operands[0].size(); ++i) {
-            std::array<core::QubitIndex, NumberOfQubitOperands> ops{};
-            for (std::size_t op = 0; op < NumberOfQubitOperands; ++op) {
-                ops[op] = core::QubitIndex{
-                    static_cast<std::size_t>(operands[op][i]->value)};
-            }
-
-            Circuit::Unitary<NumberOfQubitOperands> unitary{matrix, ops};
-
-            auto controlBits = std::make_shared<std::vector<core::QubitIndex>>();
-            circuit.addInstruction(unitary, controlBits);
-        }
-    }
-
+    // Registers of qubits are broadcast: the gate is added once per index, over all the qubit operands.
+    // Its matrix is only computed once per statement.
     void addGates(const v3cq::Instruction &instruction) {
         auto &name = instruction.instruction_ref->name;
         OperandsHelper operands(instruction);
 
-        if (name == "TOFFOLI") {
-            addGates<3>(gates::TOFFOLI, {
-                operands.get_register_operand(0),
-                operands.get_register_operand(1),
-                operands.get_register_operand(2)
-            });
-        } else if (name == "I") {
-            addGates<1>(gates::IDENTITY, {operands.get_register_operand(0)});
-        } else if (name == "X") {
-            addGates<1>(gates::X, {operands.get_register_operand(0)});
-        } else if (name == "Y") {
-            addGates<1>(gates::Y, {operands.get_register_operand(0)});
-        } else if (name == "Z") {
-            addGates<1>(gates::Z, {operands.get_register_operand(0)});
-        } else if (name == "H") {
-            addGates<1>(gates::H, {operands.get_register_operand(0)});
-        } else if (name == "S") {
-            addGates<1>(gates::S, {operands.get_register_operand(0)});
-        } else if (name == "Sdag") {
-            addGates<1>(gates::SDAG, {operands.get_register_operand(0)});
-        } else if (name == "T") {
-            addGates<1>(gates::T, {operands.get_register_operand(0)});
-        } else if (name == "Tdag") {
-            addGates<1>(gates::TDAG, {operands.get_register_operand(0)});
-        } else if (name == "Rx") {
-            addGates<1>(gates::RX(operands.get_float_operand(1)), { operands.get_register_operand(0) });
-        } else if (name == "Ry") {
-            addGates<1>(gates::RY(operands.get_float_operand(1)), { operands.get_register_operand(0) });
-        } else if (name == "Rz") {
-            addGates<1>(gates::RZ(operands.get_float_operand(1)), { operands.get_register_operand(0) });
-        } else if (name == "CNOT") {
-            addGates<2>(gates::CNOT, { operands.get_register_operand(0), operands.get_register_operand(1) });
-        } else if (name == "CZ") {
-            addGates<2>(gates::CZ, { operands.get_register_operand(0), operands.get_register_operand(1) });
-        } else if (name == "SWAP") {
-            addGates<2>(gates::SWAP, { operands.get_register_operand(0), operands.get_register_operand(1) });
-        } else if (name == "X90") {
-            return addGates<1>(gates::X90, { operands.get_register_operand(0) });
-        } else if (name == "mX90") {
-            return addGates<1>(gates::MX90, { operands.get_register_operand(0) });
-        } else if (name == "Y90") {
-            return addGates<1>(gates::Y90, { operands.get_register_operand(0) });
-        } else if (name == "mY90") {
-            return addGates<1>(gates::MY90, { operands.get_register_operand(0) });
-        } else if (name == "measure") {
-            for (const auto &q : operands.get_register_operand(0)) {
-                auto controlBits = std::make_shared<std::vector<core::QubitIndex>>();
-                circuit.addInstruction(
-                    Circuit::Measure{ core::QubitIndex{ static_cast<std::size_t>(q->value) } },
-                    controlBits
-                );
+        auto id = findCqasmGate(name);
+        if (!id) {
+            if (name != "measure") {
+                throw std::runtime_error("Unsupported gate or instruction: " + name);
+            }
+            auto qubits = operands.get_register_operand(0);
+            for (std::size_t i = 0; i < qubits.getSize(); ++i) {
+                circuit.addInstruction(Circuit::Measure{ qubits[i] });
+            }
+            return;
+        }
+
+        std::array<QubitRange, 3> registers{};
+        std::size_t numberOfRegisters = 0;
+        std::optional<double> parameter;
+        for (int operand = 0; operand < operands.size(); ++operand) {
+            if (auto p = operands.get_parameter_operand(operand)) {
+                parameter = p;
+            } else if (numberOfRegisters < registers.size()) {
+                registers[numberOfRegisters++] = operands.get_register_operand(operand);
+            } else {
+                throw std::runtime_error("Too many qubit operands for gate " + name);
+            }
+        }
+
+        BoundCqasmGate gate(*id, parameter);
+        auto broadcastSize = numberOfRegisters == 0 ? 1 : registers[0].getSize();
+        std::array<core::QubitIndex, 3> qubits{};
+        for (std::size_t i = 0; i < broadcastSize; ++i) {
+            for (std::size_t r = 0; r < numberOfRegisters; ++r) {
+                assert(registers[r].getSize() == broadcastSize);
+                qubits[r] = registers[r][i];
             }
-        } else if (name == "CR") {
-            addGates<2>(gates::CR(operands.get_float_operand(2)),
-                { operands.get_register_operand(0), operands.get_register_operand(1) });
-        } else if (name == "CRk") {
-            addGates<2>( gates::CR(static_cast<double>(gates::PI) / std::pow(2, operands.get_int_operand(2) - 1)),
-                { operands.get_register_operand(0), operands.get_register_operand(1) });
-        } else {
-            throw std::runtime_error("Unsupported gate or instruction: " + name);
+            gate.addTo(circuit, std::span(qubits.data(), numberOfRegisters));
         }
     }
 
@@ -67,6 +67,12 @@ TEST(bitset, from_string) {
     EXPECT_EQ(victim.toSizeT(), 10);
 }
 
+TEST(bitset, from_size_t) {
+    auto victim = Bitset<64>::fromSizeT(10);
+    EXPECT_EQ(victim, Bitset<64>{"1010"});
+    EXPECT_EQ(victim.toSizeT(), 10);
+}
+
 TEST(bitset, to_string) {
     Bitset<15> victim{};
     victim.set(0);
@@ -111,4 +117,31 @@ TEST(bitset, operator_xor__large_bitset) {
     EXPECT_FALSE(victim.test(875));
 }
 
+TEST(bitset, operator_or) {
+    Bitset<15> victim{"000010000010001"};
+    Bitset<15> mask{"000011001000001"};
+
+    victim |= mask;
+    EXPECT_EQ(victim.toString(), "000011001010001");
+}
+
+TEST(bitset, operator_and) {
+    Bitset<15> victim{"000010000010001"};
+    Bitset<15> mask{"000011001000001"};
+
+    victim &= mask;
+    EXPECT_EQ(victim.toString(), "000010000000001");
+}
+
+TEST(bitset, count) {
+    Bitset<150> victim{};
+    EXPECT_EQ(victim.count(), 0);
+
+    victim.set(0);
+    victim.set(63);
+    victim.set(64);
+    victim.set(149);
+    EXPECT_EQ(victim.count(), 4);
+}
+
 } // namespace qx::utils
@@ -0,0 +1,92 @@
+#include "qx/CircuitBuilder.hpp"
+#include "qx/Circuit.hpp"
+#include "qx/CqasmGates.hpp"
+#include "qx/Gates.hpp"
+
+#include <gtest/gtest.h>
+
+
+namespace qx {
+
+class CircuitBuilderTest : public ::testing::Test {
+public:
+    static core::QuantumState run(CircuitBuilder const &builder) {
+        core::QuantumState state(builder.getNumberOfQubits());
+        builder.getCircuit()->execute(state, std::monostate{});
+        return state;
+    }
+};
+
+TEST_F(CircuitBuilderTest, gates) {
+    CircuitBuilder victim(3);
+    victim.addGate("H", { 0 }).addGate("CNOT", { 0, 1 }).addGate("Rx", { 2 }, gates::PI).addGate("TOFFOLI", { 0, 1, 2 });
+    ASSERT_FALSE(victim.getError().has_value());
+    EXPECT_EQ(victim.getCircuit()->getNumberOfInstructions(), 4);
+
+    // (|000> + |011>) / sqrt(2) after Rx(pi) on qubit 2, which the Toffoli gate flips back where qubits 0 and 1 are 1.
+    auto state = run(victim);
+    EXPECT_NEAR(std::abs(state.getAmplitude(BasisVector("100"))), 1 / std::sqrt(2), config::EPS);
+    EXPECT_NEAR(std::abs(state.getAmplitude(BasisVector("011"))), 1 / std::sqrt(2), config::EPS);
+}
+
+TEST_F(CircuitBuilderTest, measurements_and_conditional_gates) {
+    CircuitBuilder victim(2);
+    victim.addGate("X", { 0 }).addMeasure(0).addGate("X", { 1 }, std::nullopt, { 0 }).addMeasureAll();
+    victim.addReset(0);
+    ASSERT_FALSE(victim.getError().has_value());
+
+    auto state = run(victim);
+    EXPECT_EQ(state.getMeasurementRegister(), BasisVector("10"));
+    EXPECT_NEAR(std::abs(state.getAmplitude(BasisVector("10"))), 1., config::EPS);
+}
+
+TEST_F(CircuitBuilderTest, first_error_is_kept) {
+    CircuitBuilder victim(2);
+    victim.addGate("X", { 2 });
+    victim.addGate("Foo", { 0 });
+    EXPECT_EQ(victim.getError(), "Qubit 2 is out of range, the circuit has 2 qubits");
+    EXPECT_EQ(victim.getCircuit()->getNumberOfInstructions(), 0);
+
+    EXPECT_EQ(CircuitBuilder(2).addGate("Foo", { 0 }).getError(), "Unsupported gate or instruction: Foo");
+    EXPECT_EQ(CircuitBuilder(2).addGate("CNOT", { 1, 1 }).getError(), "Qubit 1 is used twice by the same instruction");
+    EXPECT_EQ(CircuitBuilder(2).addGate("CNOT", { 1 }).getError(), "Gate CNOT takes 2 qubit operands, not 1");
+    EXPECT_EQ(CircuitBuilder(2).addGate("Rx", { 1 }).getError(), "Gate Rx needs an angle");
+    EXPECT_EQ(CircuitBuilder(2).addGate("CRk", { 0, 1 }, 1.5).getError(), "Gate CRk needs an integer");
+    EXPECT_EQ(CircuitBuilder(2).addGate("H", { 1 }, 1.).getError(), "Gate H does not take a parameter");
+    EXPECT_EQ(CircuitBuilder(2).addMeasure(3).getError(), "Qubit 3 is out of range, the circuit has 2 qubits");
+    EXPECT_TRUE(CircuitBuilder(0).getError().has_value());
+}
+
+TEST_F(CircuitBuilderTest, circuit_is_copied_on_write) {
+    CircuitBuilder victim(1);
+    victim.addGate("X", { 0 });
+    auto circuit = victim.getCircuit();
+    victim.addGate("X", { 0 });
+
+    EXPECT_EQ(circuit->getNumberOfInstructions(), 1);
+    EXPECT_EQ(victim.getCircuit()->getNumberOfInstructions(), 2);
+}
+
+TEST_F(CircuitBuilderTest, bound_cqasm_gate_is_added_on_any_qubits) {
+    ASSERT_EQ(findCqasmGate("CRk"), CqasmGateId::CRk);
+    EXPECT_FALSE(findCqasmGate("crk").has_value());
+
+    // One Rx(pi) matrix, broadcast like "Rx(pi) q" on a register.
+    BoundCqasmGate victim(CqasmGateId::Rx, gates::PI);
+    EXPECT_EQ(victim.getNumberOfQubits(), 1);
+    Circuit circuit;
+    for (std::size_t qubit = 0; qubit < 3; ++qubit) {
+        core::QubitIndex operand{ qubit };
+        victim.addTo(circuit, std::span(&operand, 1));
+    }
+
+    core::QuantumState state(3);
+    circuit.execute(state, std::monostate{});
+    EXPECT_NEAR(std::abs(state.getAmplitude(BasisVector("111"))), 1., config::EPS);
+
+    EXPECT_THROW(BoundCqasmGate(CqasmGateId::Rx, std::nullopt), std::runtime_error);
+    EXPECT_THROW(BoundCqasmGate(CqasmGateId::CRk, 1.5), std::runtime_error);
+    EXPECT_THROW(BoundCqasmGate(CqasmGateId::H, 1.), std::runtime_error);
+}
+
+}  // namespace qx
@@ -0,0 +1,89 @@
+#include "qx/CircuitCache.hpp"
+#include "qx/Gates.hpp"
+
+#include <gtest/gtest.h>
+
+
+namespace qx {
+
+class CircuitCacheTest : public ::testing::Test {
+public:
+    static CircuitCache::Entry makeEntry(std::size_t numberOfGates) {
+        auto circuit = std::make_shared<Circuit>();
+        for (std::size_t i = 0; i < numberOfGates; ++i) {
+            circuit->addInstruction(Circuit::Unitary<1>{ gates::X, { core::QubitIndex{ 0 } } });
+        }
+        return CircuitCache::Entry{ circuit, 1 };
+    }
+};
+
+TEST_F(CircuitCacheTest, hit_and_miss) {
+    CircuitCache victim;
+
+    EXPECT_FALSE(victim.find("X q", "3.0").has_value());
+    victim.insert("X q", "3.0", makeEntry(1));
+
+    auto cached = victim.find("X q", "3.0");
+    ASSERT_TRUE(cached.has_value());
+    EXPECT_EQ(cached->qubitCount, 1);
+    EXPECT_EQ(cached->circuit->getNumberOfInstructions(), 1);
+
+    EXPECT_FALSE(victim.find("X q", "1.0").has_value());
+    EXPECT_FALSE(victim.find("Y q", "3.0").has_value());
+
+    auto statistics = victim.getStatistics();
+    EXPECT_EQ(statistics.hits, 1);
+    EXPECT_EQ(statistics.misses, 3);
+    EXPECT_EQ(statistics.entries, 1);
+    EXPECT_GT(statistics.bytes, 0);
+}
+
+TEST_F(CircuitCacheTest, least_recently_used_is_evicted) {
+    CircuitCache probe;
+    probe.insert("a", "3.0", makeEntry(10));
+    auto entryBytes = probe.getStatistics().bytes;
+
+    CircuitCache victim(2 * entryBytes);
+    victim.insert("a", "3.0", makeEntry(10));
+    victim.insert("b", "3.0", makeEntry(10));
+    EXPECT_TRUE(victim.find("a", "3.0").has_value());
+
+    victim.insert("c", "3.0", makeEntry(10));
+
+    EXPECT_TRUE(victim.find("a", "3.0").has_value());
+    EXPECT_FALSE(victim.find("b", "3.0").has_value());
+    EXPECT_TRUE(victim.find("c", "3.0").has_value());
+
+    auto statistics = victim.getStatistics();
+    EXPECT_EQ(statistics.entries, 2);
+    EXPECT_EQ(statistics.evictions, 1);
+    EXPECT_LE(statistics.bytes, statistics.maxBytes);
+}
+
+TEST_F(CircuitCacheTest, oversized_entries_are_not_cached) {
+    CircuitCache victim(100);
+    victim.insert("a", "3.0", makeEntry(1000));
+
+    EXPECT_FALSE(victim.find("a", "3.0").has_value());
+    EXPECT_EQ(victim.getStatistics().entries, 0);
+    EXPECT_EQ(victim.getStatistics().bytes, 0);
+}
+
+TEST_F(CircuitCacheTest, set_max_bytes_and_clear) {
+    CircuitCache victim;
+    victim.insert("a", "3.0", makeEntry(1));
+    victim.insert("b", "3.0", makeEntry(1));
+    EXPECT_EQ(victim.getStatistics().entries, 2);
+
+    victim.setMaxBytes(0);
+    EXPECT_EQ(victim.getStatistics().entries, 0);
+    EXPECT_EQ(victim.getStatistics().evictions, 2);
+
+    victim.insert("a", "3.0", makeEntry(1));
+    EXPECT_FALSE(victim.find("a", "3.0").has_value());
+
+    victim.clear();
+    EXPECT_EQ(victim.getStatistics().misses, 0);
+}
+
+}  // namespace qx
@@ -0,0 +1,295 @@
+#include "qx/Circuit.hpp"
+#include "qx/DenseStateVector.hpp"
+#include "qx/Gates.hpp"
+#include "qx/Random.hpp"
+
+#include <gtest/gtest.h>
+#include <map>
+
+
+namespace qx {
+
+class CircuitTest : public ::testing::Test {
+public:
+    static core::QuantumState run(Circuit const &circuit, std::size_t numberOfQubits) {
+        core::QuantumState state(numberOfQubits);
+        circuit.execute(state, std::monostate{});
+        return state;
+    }
+
+    static std::map<BasisVector, std::uint64_t> runBranching(Circuit const &circuit, std::size_t numberOfQubits,
+                                                             std::uint64_t shots) {
+        core::QuantumState state(numberOfQubits);
+        std::map<BasisVector, std::uint64_t> result;
+        circuit.executeBranching(state, shots, [&result](BasisVector measurementRegister, std::uint64_t branchShots) {
+            EXPECT_GT(branchShots, 0);
+            result[measurementRegister] += branchShots;
+        });
+        return result;
+    }
+
+    static void setMeasurementRegister(Circuit &circuit, BasisVector value) {
+        circuit.addInstruction(Circuit::MeasurementRegisterOperation{
+            [value](BasisVector &measurementRegister) { measurementRegister = value; } });
+    }
+};
+
+TEST_F(CircuitTest, unconditional_instruction) {
+    Circuit circuit;
+    circuit.addInstruction(Circuit::Unitary<1>{ gates::X, { core::QubitIndex{ 1 } } }, {});
+    circuit.addInstruction(Circuit::MeasureAll{});
+
+    EXPECT_EQ(run(circuit, 3).getMeasurementRegister(), BasisVector("010"));
+}
+
+TEST_F(CircuitTest, all_control_bits_set) {
+    Circuit circuit;
+    setMeasurementRegister(circuit, BasisVector("101"));
+    circuit.addInstruction(Circuit::Unitary<1>{ gates::X, { core::QubitIndex{ 1 } } },
+        { core::QubitIndex{ 0 }, core::QubitIndex{ 2 } });
+    circuit.addInstruction(Circuit::Measure{ core::QubitIndex{ 1 } });
+
+    EXPECT_EQ(run(circuit, 3).getMeasurementRegister(), BasisVector("111"));
+}
+
+TEST_F(CircuitTest, one_control_bit_not_set) {
+    Circuit circuit;
+    setMeasurementRegister(circuit, BasisVector("110"));
+    circuit.addInstruction(Circuit::Unitary<1>{ gates::X, { core::QubitIndex{ 0 } } },
+        { core::QubitIndex{ 0 }, core::QubitIndex{ 2 } });
+    circuit.addInstruction(Circuit::Measure{ core::QubitIndex{ 0 } });
+
+    EXPECT_EQ(run(circuit, 3).getMeasurementRegister(), BasisVector("110"));
+}
+
+TEST_F(CircuitTest, dense_gates_are_applied_together) {
+    Circuit circuit;
+    circuit.addInstruction(Circuit::Unitary<1>{ gates::H, { core::QubitIndex{ 0 } } });
+    circuit.addInstruction(Circuit::Unitary<2>{ gates::CNOT, { core::QubitIndex{ 0 }, core::QubitIndex{ 1 } } });
+    circuit.addInstruction(Circuit::Unitary<1>{ gates::X, { core::QubitIndex{ 2 } } });
+    circuit.addInstruction(Circuit::Measure{ core::QubitIndex{ 2 } });
+    circuit.addInstruction(Circuit::Unitary<1>{ gates::X, { core::QubitIndex{ 1 } } }, { core::QubitIndex{ 2 } });
+    circuit.addInstruction(Circuit::Unitary<1>{ gates::X, { core::QubitIndex{ 0 } } }, { core::QubitIndex{ 0 } });
+
+    core::DenseStateVector state(3);
+    circuit.execute(state, std::monostate{});
+    EXPECT_EQ(state.getNumberOfGateSweeps(), 2);
+    EXPECT_EQ(state.getMeasurementRegister(), BasisVector("100"));
+    EXPECT_NEAR(std::abs(state.getAmplitude(BasisVector("101"))), 1 / std::sqrt(2), config::EPS);
+    EXPECT_NEAR(std::abs(state.getAmplitude(BasisVector("110"))), 1 / std::sqrt(2), config::EPS);
+}
+
+TEST_F(CircuitTest, controlled_unitary) {
+    Circuit circuit;
+    circuit.addInstruction(Circuit::Unitary<1>{ gates::X, { core::QubitIndex{ 0 } } });
+    circuit.addInstruction(Circuit::Unitary<1>{ gates::X, { core::QubitIndex{ 2 } } });
+    circuit.addInstruction(Circuit::ControlledUnitary{ { core::QubitIndex{ 0 }, core::QubitIndex{ 2 } }, gates::X,
+        core::QubitIndex{ 3 } });
+    circuit.addInstruction(Circuit::ControlledUnitary{ { core::QubitIndex{ 0 }, core::QubitIndex{ 1 } }, gates::X,
+        core::QubitIndex{ 2 } });
+    circuit.addInstruction(Circuit::MeasureAll{});
+
+    EXPECT_EQ(run(circuit, 4).getMeasurementRegister(), BasisVector("1101"));
+
+    core::DenseStateVector state(4);
+    circuit.execute(state, std::monostate{});
+    EXPECT_EQ(state.getMeasurementRegister(), BasisVector("1101"));
+}
+
+TEST_F(CircuitTest, branching_without_measurement) {
+    Circuit circuit;
+    circuit.addInstruction(Circuit::Unitary<1>{ gates::H, { core::QubitIndex{ 0 } } });
+
+    EXPECT_EQ(runBranching(circuit, 2, 1000), (std::map<BasisVector, std::uint64_t>{ { BasisVector("00"), 1000 } }));
+}
+
+TEST_F(CircuitTest, branching_at_mid_circuit_measurements) {
+    random::seed(123);
+
+    // Syndrome-like rounds: qubit 1 copies qubit 0, is measured, and is reset when it was 1.
+    Circuit circuit("", 2);
+    circuit.addInstruction(Circuit::Unitary<1>{ gates::RX(1.), { core::QubitIndex{ 0 } } });
+    circuit.addInstruction(Circuit::Unitary<2>{ gates::CNOT, { core::QubitIndex{ 0 }, core::QubitIndex{ 1 } } });
+    circuit.addInstruction(Circuit::Measure{ core::QubitIndex{ 1 } });
+    circuit.addInstruction(Circuit::Unitary<1>{ gates::X, { core::QubitIndex{ 1 } } }, { core::QubitIndex{ 1 } });
+
+    std::uint64_t const shots = 100000;
+    auto result = runBranching(circuit, 2, shots);
+
+    // The first round collapses qubit 0, which is flipped by the second RX with probability p.
+    ASSERT_EQ(result.size(), 2);
+    EXPECT_EQ(result[BasisVector("00")] + result[BasisVector("10")], shots);
+    auto p = std::pow(std::sin(0.5), 2);
+    EXPECT_NEAR(static_cast<double>(result[BasisVector("10")]) / shots, 2 * p * (1 - p), 0.01);
+}
+
+TEST_F(CircuitTest, branching_at_measure_all) {
+    random::seed(123);
+
+    Circuit circuit;
+    circuit.addInstruction(Circuit::Unitary<1>{ gates::H, { core::QubitIndex{ 0 } } });
+    circuit.addInstruction(Circuit::Unitary<2>{ gates::CNOT, { core::QubitIndex{ 0 }, core::QubitIndex{ 2 } } });
+    circuit.addInstruction(Circuit::Unitary<1>{ gates::H, { core::QubitIndex{ 1 } } });
+    circuit.addInstruction(Circuit::MeasureAll{});
+
+    std::uint64_t const shots = 100000;
+    auto result = runBranching(circuit, 3, shots);
+
+    ASSERT_EQ(result.size(), 4);
+    for (auto const &[measurementRegister, count] : result) {
+        EXPECT_EQ(measurementRegister.test(0), measurementRegister.test(2));
+        EXPECT_NEAR(static_cast<double>(count) / shots, 0.25, 0.01);
+    }
+}
+
+TEST_F(CircuitTest, unitary) {
+    Circuit circuit("", 2);
+    circuit.addInstruction(Circuit::Unitary<1>{ gates::H, { core::QubitIndex{ 0 } } });
+    circuit.addInstruction(Circuit::Unitary<2>{ gates::CNOT, { core::QubitIndex{ 0 }, core::QubitIndex{ 1 } } });
+
+    core::UnitaryMatrix expected(2);
+    for (int i = 0; i < 2; ++i) {
+        expected.apply<1>(gates::H, { core::QubitIndex{ 0 } });
+        expected.apply<2>(gates::CNOT, { core::QubitIndex{ 0 }, core::QubitIndex{ 1 } });
+    }
+    EXPECT_EQ(circuit.getUnitary(2).getEntries(), expected.getEntries());
+
+    // The next iteration would run gates after the measurement.
+    circuit.addInstruction(Circuit::MeasureAll{});
+    EXPECT_THROW(std::ignore = circuit.getUnitary(2), std::runtime_error);
+}
+
+TEST_F(CircuitTest, unitary_ignores_final_measurements) {
+    Circuit circuit;
+    circuit.addInstruction(Circuit::Unitary<1>{ gates::H, { core::QubitIndex{ 0 } } });
+    circuit.addInstruction(Circuit::Unitary<2>{ gates::CNOT, { core::QubitIndex{ 0 }, core::QubitIndex{ 1 } } });
+    circuit.addInstruction(Circuit::Measure{ core::QubitIndex{ 1 } });
+    circuit.addInstruction(Circuit::MeasureAll{});
+
+    auto unitary = circuit.getUnitary(2);
+    EXPECT_NEAR(unitary.at(0, 0).real(), 1 / std::sqrt(2), config::EPS);
+    EXPECT_NEAR(unitary.at(3, 0).real(), 1 / std::sqrt(2), config::EPS);
+    EXPECT_NEAR(unitary.at(3, 1).real(), -1 / std::sqrt(2), config::EPS);
+}
+
+TEST_F(CircuitTest, max_amplitude_qubits) {
+    Circuit circuit("", 3);
+    circuit.addInstruction(Circuit::Unitary<1>{ gates::H, { core::QubitIndex{ 0 } } });
+    circuit.addInstruction(Circuit::Unitary<2>{ gates::CNOT, { core::QubitIndex{ 0 }, core::QubitIndex{ 1 } } });
+    circuit.addInstruction(Circuit::Unitary<1>{ gates::T, { core::QubitIndex{ 1 } } });
+    circuit.addInstruction(Circuit::ControlledUnitary{ { core::QubitIndex{ 1 } }, gates::RX(0.3), core::QubitIndex{ 2 } });
+    circuit.addInstruction(Circuit::Measure{ core::QubitIndex{ 2 } });
+
+    // H and the controlled RX can each double the number of amplitudes, in each of the 3 iterations.
+    EXPECT_EQ(circuit.getMaxAmplitudeQubits(10), 6);
+    EXPECT_EQ(circuit.getMaxAmplitudeQubits(10, 3), 9);
+    EXPECT_EQ(circuit.getMaxAmplitudeQubits(5), 5);
+
+    Circuit permutations;
+    permutations.addInstruction(Circuit::Unitary<1>{ gates::X, { core::QubitIndex{ 0 } } });
+    permutations.addInstruction(Circuit::Unitary<2>{ gates::SWAP, { core::QubitIndex{ 0 }, core::QubitIndex{ 1 } } });
+    permutations.addInstruction(Circuit::Unitary<2>{ gates::CZ, { core::QubitIndex{ 0 }, core::QubitIndex{ 1 } } });
+    EXPECT_EQ(permutations.getMaxAmplitudeQubits(2), 0);
+}
+
+TEST_F(CircuitTest, unitary_in_blocks) {
+    // 11 qubits give blocks of 8 columns, which are processed concurrently.
+    std::size_t const n = 11;
+    Circuit circuit;
+    for (std::size_t q = 0; q < n; ++q) {
+        circuit.addInstruction(Circuit::Unitary<1>{ gates::H, { core::QubitIndex{ q } } });
+        circuit.addInstruction(Circuit::Unitary<2>{ gates::CNOT, { core::QubitIndex{ q }, core::QubitIndex{ (q + 3) % n } } });
+    }
+
+    core::UnitaryMatrix expected(n);
+    for (std::size_t q = 0; q < n; ++q) {
+        expected.apply<1>(gates::H, { core::QubitIndex{ q } });
+        expected.apply<2>(gates::CNOT, { core::QubitIndex{ q }, core::QubitIndex{ (q + 3) % n } });
+    }
+
+    EXPECT_EQ(circuit.getUnitary(n).getEntries(), expected.getEntries());
+}
+
+TEST_F(CircuitTest, unitary_of_non_unitary_circuits) {
+    Circuit midCircuitMeasurement;
+    midCircuitMeasurement.addInstruction(Circuit::Measure{ core::QubitIndex{ 0 } });
+    midCircuitMeasurement.addInstruction(Circuit::Unitary<1>{ gates::X, { core::QubitIndex{ 0 } } });
+    EXPECT_THROW(std::ignore = midCircuitMeasurement.getUnitary(1), std::runtime_error);
+
+    Circuit reset;
+    reset.addInstruction(Circuit::PrepZ{ core::QubitIndex{ 0 } });
+    EXPECT_THROW(std::ignore = reset.getUnitary(1), std::runtime_error);
+
+    Circuit conditional;
+    conditional.addInstruction(Circuit::Unitary<1>{ gates::X, { core::QubitIndex{ 0 } } }, { core::QubitIndex{ 1 } });
+    EXPECT_THROW(std::ignore = conditional.getUnitary(2), std::runtime_error);
+}
+
+TEST_F(CircuitTest, gradients_of_a_rotation) {
+    Circuit circuit;
+    circuit.addInstruction(Circuit::Unitary<1>{ gates::RX(0.3), { core::QubitIndex{ 0 } },
+                                                Circuit::GateParameter{ gates::RX_GENERATOR } });
+    circuit.addInstruction(Circuit::Measure{ core::QubitIndex{ 0 } });
+
+    std::vector<core::PauliTerm> observable{ { 2., "Z" } };
+    auto result = circuit.getGradients(1, observable);
+    EXPECT_NEAR(result.expectation, 2 * std::cos(0.3), config::EPS);
+    ASSERT_EQ(result.gradients.size(), 1);
+    EXPECT_NEAR(result.gradients[0], -2 * std::sin(0.3), config::EPS);
+}
+
+TEST_F(CircuitTest, gradients_match_finite_differences) {
+    // Two iterations: each parametric instruction runs twice, and gets the sum of both derivatives.
+    auto getCircuit = [](std::vector<double> const &angles) {
+        Circuit circuit("", 2);
+        auto q = [](std::size_t i) { return core::QubitIndex{ i }; };
+        circuit.addInstruction(Circuit::Unitary<1>{ gates::RX(angles[0]), { q(0) },
+                                                    Circuit::GateParameter{ gates::RX_GENERATOR } });
+        circuit.addInstruction(Circuit::Unitary<1>{ gates::RY(angles[1]), { q(1) },
+                                                    Circuit::GateParameter{ gates::RY_GENERATOR } });
+        circuit.addInstruction(Circuit::Unitary<1>{ gates::H, { q(2) } });
+        circuit.addInstruction(Circuit::ControlledUnitary{ { q(0) }, gates::X, q(1) });
+        circuit.addInstruction(Circuit::Unitary<1>{ gates::RZ(angles[2]), { q(1) },
+                                                    Circuit::GateParameter{ gates::RZ_GENERATOR } });
+        circuit.addInstruction(Circuit::ControlledUnitary{ { q(1) }, gates::PHASE(angles[3]), q(2),
+                                                           Circuit::GateParameter{ gates::PHASE_GENERATOR } });
+        circuit.addInstruction(Circuit::ControlledUnitary{ { q(0), q(2) }, gates::RY(angles[4]), q(1),
+                                                           Circuit::GateParameter{ gates::RY_GENERATOR } });
+        circuit.addInstruction(Circuit::Unitary<2>{ gates::SWAP, { q(0), q(2) } });
+        return circuit;
+    };
+    std::vector<double> angles{ 0.4, -1.1, 2.3, 0.7, 1.9 };
+    std::vector<core::PauliTerm> observable{ { 0.5, "ZIX" }, { -1.2, "YZI" }, { 0.3, "XXY" } };
+
+    auto result = getCircuit(angles).getGradients(3, observable);
+    ASSERT_EQ(result.gradients.size(), angles.size());
+    double const h = 1e-5;
+    for (std::size_t i = 0; i < angles.size(); ++i) {
+        auto plus = angles;
+        plus[i] += h;
+        auto minus = angles;
+        minus[i] -= h;
+        auto derivative = (getCircuit(plus).getGradients(3, observable).expectation -
+                           getCircuit(minus).getGradients(3, observable).expectation) / (2 * h);
+        EXPECT_NEAR(result.gradients[i], derivative, 1e-7) << "parameter " << i;
+    }
+}
+
+TEST_F(CircuitTest, gradients_of_invalid_inputs) {
+    Circuit circuit;
+    circuit.addInstruction(Circuit::Unitary<1>{ gates::RY(0.5), { core::QubitIndex{ 0 } },
+                                                Circuit::GateParameter{ gates::RY_GENERATOR } });
+    std::vector<core::PauliTerm> tooShort{ { 1., "Z" } };
+    EXPECT_THROW(std::ignore = circuit.getGradients(2, tooShort), std::runtime_error);
+    std::vector<core::PauliTerm> notPauli{ { 1., "ZA" } };
+    EXPECT_THROW(std::ignore = circuit.getGradients(2, notPauli), std::runtime_error);
+    std::vector<core::PauliTerm> tooLarge{ { 1., std::string(config::MAX_GRADIENT_QUBITS + 1, 'Z') } };
+    EXPECT_THROW(std::ignore = circuit.getGradients(config::MAX_GRADIENT_QUBITS + 1, tooLarge), std::runtime_error);
+
+    circuit.addInstruction(Circuit::Measure{ core::QubitIndex{ 0 } });
+    circuit.addInstruction(Circuit::Unitary<1>{ gates::X, { core::QubitIndex{ 0 } } });
+    std::vector<core::PauliTerm> observable{ { 1., "IZ" } };
+    EXPECT_THROW(std::ignore = circuit.getGradients(2, observable), std::runtime_error);
+}
+
+}  // namespace qx
@@ -0,0 +1,372 @@
+#include "qx/DenseStateVector.hpp"
+#include "qx/Gates.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <random>  // random_device
+#include <string>
+
+
+namespace qx::core {
+
+using namespace std::complex_literals;
+
+class DenseStateVectorTest : public ::testing::Test {
+public:
+    static void checkEq(DenseStateVector &victim,
+                        std::vector<std::complex<double>> expected) {
+        ASSERT_EQ(expected.size(), 1 << victim.getNumberOfQubits());
+
+        std::size_t nonZeros = std::count_if(expected.begin(), expected.end(), isNotNull<double>);
+
+        victim.forEach([&nonZeros, &expected](auto const &kv) {
+            EXPECT_GT(nonZeros, 0);
+            EXPECT_NEAR(expected[kv.first.toSizeT()].real(), kv.second.real(),
+                        .00000000000001);
+            EXPECT_NEAR(expected[kv.first.toSizeT()].imag(), kv.second.imag(),
+                        .00000000000001);
+            --nonZeros;
+        });
+        EXPECT_EQ(nonZeros, 0);
+    }
+
+    // Same gates on a dense and a sparse state, which must then agree.
+    template <typename State> static void applyTestCircuit(State &state) {
+        state.template apply<1>(gates::H, std::array<QubitIndex, 1>{QubitIndex{0}});
+        state.template apply<1>(gates::RX(0.3), std::array<QubitIndex, 1>{QubitIndex{5}});
+        state.template apply<2>(gates::CNOT, std::array<QubitIndex, 2>{QubitIndex{0}, QubitIndex{4}});
+        state.template apply<1>(gates::T, std::array<QubitIndex, 1>{QubitIndex{4}});
+        state.template apply<3>(gates::TOFFOLI, std::array<QubitIndex, 3>{QubitIndex{4}, QubitIndex{5}, QubitIndex{1}});
+        state.template apply<2>(gates::CR(0.7), std::array<QubitIndex, 2>{QubitIndex{1}, QubitIndex{3}});
+        state.template apply<1>(gates::Y, std::array<QubitIndex, 1>{QubitIndex{3}});
+        state.template apply<2>(gates::SWAP, std::array<QubitIndex, 2>{QubitIndex{2}, QubitIndex{5}});
+        state.template apply<1>(gates::H, std::array<QubitIndex, 1>{QubitIndex{4}});
+    }
+
+    static std::vector<std::complex<double>> toVector(QuantumState &state) {
+        std::vector<std::complex<double>> result(1 << state.getNumberOfQubits(), 0);
+        state.forEach([&result](auto const &kv) { result[kv.first.toSizeT()] = kv.second; });
+        return result;
+    }
+};
+
+TEST_F(DenseStateVectorTest, apply_hadamard) {
+    DenseStateVector victim(3);
+
+    EXPECT_EQ(victim.getNumberOfQubits(), 3);
+    EXPECT_FALSE(victim.isMapped());
+    checkEq(victim, {1, 0, 0, 0, 0, 0, 0, 0});
+
+    victim.apply<1>(gates::H, std::array<QubitIndex, 1>{QubitIndex{1}});
+
+    checkEq(victim, {1 / std::sqrt(2), 0, 1 / std::sqrt(2), 0, 0, 0, 0, 0});
+}
+
+TEST_F(DenseStateVectorTest, apply_cnot) {
+    DenseStateVector victim(2);
+    victim.testInitialize({{"10", 0.123}, {"11", std::sqrt(1 - std::pow(0.123, 2))}});
+
+    checkEq(victim, {0, 0, 0.123, std::sqrt(1 - std::pow(0.123, 2))});
+
+    victim.apply<2>(gates::CNOT, std::array<QubitIndex, 2>{QubitIndex{1}, QubitIndex{0}});
+
+    checkEq(victim, {0, 0, std::sqrt(1 - std::pow(0.123, 2)), 0.123});
+}
+
+TEST_F(DenseStateVectorTest, same_as_sparse_representation) {
+    QuantumState expected(6);
+    applyTestCircuit(expected);
+
+    DenseStateVector victim(6);
+    applyTestCircuit(victim);
+    EXPECT_EQ(victim.getNumberOfBlockSwaps(), 0);
+
+    checkEq(victim, toVector(expected));
+}
+
+TEST_F(DenseStateVectorTest, block_swaps) {
+    QuantumState expected(6);
+    applyTestCircuit(expected);
+
+    DenseStateVector victim(6, "", 3);
+    EXPECT_EQ(victim.getBlockQubits(), 3);
+    applyTestCircuit(victim);
+    EXPECT_GT(victim.getNumberOfBlockSwaps(), 0);
+
+    checkEq(victim, toVector(expected));
+
+    victim.measure(QubitIndex{5}, []() { return 0.2; });
+    expected.measure(QubitIndex{5}, []() { return 0.2; });
+    EXPECT_EQ(victim.getMeasurementRegister(), expected.getMeasurementRegister());
+    checkEq(victim, toVector(expected));
+
+    victim.prep(QubitIndex{4}, []() { return 0.7; });
+    expected.prep(QubitIndex{4}, []() { return 0.7; });
+    checkEq(victim, toVector(expected));
+}
+
+TEST_F(DenseStateVectorTest, hot_qubits) {
+    QuantumState expected(6);
+    applyTestCircuit(expected);
+
+    DenseStateVector victim(6, "", 3);
+    applyTestCircuit(victim);
+    auto blockSwaps = victim.getNumberOfBlockSwaps();
+
+    std::array<QubitIndex, 4> hotQubits{QubitIndex{2}, QubitIndex{3}, QubitIndex{1}, QubitIndex{0}};
+    victim.setHotQubits(hotQubits);
+    for (std::size_t i = 0; i < 3; ++i) {
+        EXPECT_LT(victim.getQubitOrder()[hotQubits[i].value], 3);
+    }
+    checkEq(victim, toVector(expected));
+
+    EXPECT_GE(victim.getNumberOfBlockSwaps(), blockSwaps);
+
+    // Qubits 2 and 3 stay in block, and qubits 0 and 1 share the remaining position.
+    victim.setHotQubits(std::span(hotQubits).first(2));
+    auto swapsBeforeGates = victim.getNumberOfBlockSwaps();
+    for (std::size_t q : {3, 0, 2, 1, 3, 2}) {
+        victim.apply<1>(gates::X, std::array<QubitIndex, 1>{QubitIndex{q}});
+        victim.apply<1>(gates::X, std::array<QubitIndex, 1>{QubitIndex{q}});
+    }
+    EXPECT_LE(victim.getNumberOfBlockSwaps(), swapsBeforeGates + 2);
+    checkEq(victim, toVector(expected));
+}
+
+TEST_F(DenseStateVectorTest, controlled_gates) {
+    QuantumState expected(6);
+    applyTestCircuit(expected);
+    expected.apply<3>(gates::TOFFOLI, std::array<QubitIndex, 3>{QubitIndex{5}, QubitIndex{4}, QubitIndex{0}});
+    expected.apply<2>(gates::CR(0.4), std::array<QubitIndex, 2>{QubitIndex{1}, QubitIndex{2}});
+
+    DenseStateVector victim(6, "", 3);
+    applyTestCircuit(victim);
+    std::array<QubitIndex, 2> twoControls{QubitIndex{5}, QubitIndex{4}};
+    victim.applyControlled(gates::X, twoControls, QubitIndex{0});
+    std::array<QubitIndex, 1> control{QubitIndex{1}};
+    victim.applyControlled(gates::PHASE(0.4), control, QubitIndex{2});
+    checkEq(victim, toVector(expected));
+
+    // Controls do not need to be in block: the target is the qubit at position 0, and all the others are controls.
+    auto blockSwaps = victim.getNumberOfBlockSwaps();
+    auto const &qubitOrder = victim.getQubitOrder();
+    QubitIndex target{static_cast<std::size_t>(std::find(qubitOrder.begin(), qubitOrder.end(), 0) - qubitOrder.begin())};
+    std::vector<QubitIndex> controls;
+    for (std::size_t q = 0; q < 6; ++q) {
+        if (q != target.value) {
+            controls.push_back(QubitIndex{q});
+        }
+    }
+    victim.applyControlled(gates::Y, controls, target);
+    expected.applyControlled(gates::Y, controls, target);
+    EXPECT_EQ(victim.getNumberOfBlockSwaps(), blockSwaps);
+    checkEq(victim, toVector(expected));
+}
+
+TEST_F(DenseStateVectorTest, gate_sequence_in_tiles) {
+    // Two tiles of 2^14 amplitudes per block of 2^15, and block swaps for qubits 15 and 16.
+    std::size_t const n = config::DENSE_TILE_QUBITS + 3;
+    auto rx = gates::RX(0.4);
+    auto ry = gates::RY(1.1);
+    auto cr = gates::CR(0.3);
+    std::array<QubitIndex, 1> q0{QubitIndex{0}}, q13{QubitIndex{13}}, q14{QubitIndex{14}}, q16{QubitIndex{16}};
+    std::array<QubitIndex, 2> q3q16{QubitIndex{3}, QubitIndex{16}}, q5q13{QubitIndex{5}, QubitIndex{13}};
+    std::array<QubitIndex, 3> q13q0q7{QubitIndex{13}, QubitIndex{0}, QubitIndex{7}};
+    std::array<QubitIndex, 2> q16q2{QubitIndex{16}, QubitIndex{2}};
+    std::array<QubitIndex, 1> q15{QubitIndex{15}};
+
+    using Gate1 = DenseStateVector::GateReference<1>;
+    using Gate2 = DenseStateVector::GateReference<2>;
+    using Gate3 = DenseStateVector::GateReference<3>;
+    using ControlledGate = DenseStateVector::ControlledGateReference;
+    std::vector<DenseStateVector::SequenceGate> gates{
+        Gate1{gates::H, q0}, Gate1{rx, q13}, Gate2{gates::CNOT, q5q13}, Gate1{gates::H, q16},
+        Gate2{cr, q3q16}, Gate1{ry, q14}, Gate3{gates::TOFFOLI, q13q0q7}, Gate1{gates::H, q13},
+        Gate1{gates::T, q0}, ControlledGate{gates::X, q16q2, QubitIndex{4}},
+        ControlledGate{gates::Z, q15, QubitIndex{13}}, Gate1{rx, q14}, ControlledGate{ry, q0, QubitIndex{16}}};
+
+    for (auto blockQubits : {n, n - 2}) {
+        DenseStateVector expected(n, "", blockQubits);
+        expected.apply<1>(gates::H, q0).apply<1>(rx, q13).apply<2>(gates::CNOT, q5q13).apply<1>(gates::H, q16);
+        expected.apply<2>(cr, q3q16).apply<1>(ry, q14).apply<3>(gates::TOFFOLI, q13q0q7);
+        expected.apply<1>(gates::H, q13).apply<1>(gates::T, q0).applyControlled(gates::X, q16q2, QubitIndex{4});
+        expected.applyControlled(gates::Z, q15, QubitIndex{13}).apply<1>(rx, q14);
+        expected.applyControlled(ry, q0, QubitIndex{16});
+        EXPECT_EQ(expected.getNumberOfGateSweeps(), gates.size());
+
+        DenseStateVector victim(n, "", blockQubits);
+        victim.applySequence(gates);
+        EXPECT_EQ(victim.getNumberOfBlockSwaps(), expected.getNumberOfBlockSwaps());
+        EXPECT_LT(victim.getNumberOfGateSweeps(), gates.size());
+
+        for (std::size_t i = 0; i < (std::size_t{1} << n); ++i) {
+            auto basisVector = BasisVector::fromSizeT(i);
+            EXPECT_NEAR(std::abs(victim.getAmplitude(basisVector) - expected.getAmplitude(basisVector)), 0.,
+                        config::EPS);
+        }
+    }
+}
+
+TEST_F(DenseStateVectorTest, measure_on_superposed_state) {
+    DenseStateVector victim(2);
+    victim.testInitialize({{"10", 0.123}, {"11", std::sqrt(1 - std::pow(0.123, 2))}});
+
+    victim.measure(QubitIndex{0}, []() { return 0.994; });
+    checkEq(victim, {0, 0, 1, 0});
+    EXPECT_EQ(victim.getMeasurementRegister(), BasisVector("00"));
+
+    victim.testInitialize({{"10", 0.123}, {"11", std::sqrt(1 - std::pow(0.123, 2))}});
+    victim.measure(QubitIndex{0}, []() { return 0.254; });
+    checkEq(victim, {0, 0, 0, 1});
+    EXPECT_EQ(victim.getMeasurementRegister(), BasisVector("01"));
+}
+
+TEST_F(DenseStateVectorTest, measure_all) {
+    DenseStateVector victim(3);
+    victim.testInitialize({{"110", 1i}});
+
+    victim.measureAll([]() { return 0.994; });
+    checkEq(victim, {0, 0, 0, 0, 0, 0, 1i, 0});
+
+    EXPECT_EQ(victim.getMeasurementRegister(), BasisVector("110"));
+}
+
+TEST_F(DenseStateVectorTest, prep) {
+    DenseStateVector victim(2);
+    victim.testInitialize({{"00", 0.123}, {"11", std::sqrt(1 - std::pow(0.123, 2))}});
+
+    victim.prep(QubitIndex{0}, []() { return 0.245; });
+    checkEq(victim, {0, 0, 1, 0});
+}
+
+TEST_F(DenseStateVectorTest, reset_keeps_qubit_order) {
+    DenseStateVector victim(6, "", 3);
+    applyTestCircuit(victim);
+    auto qubitOrder = victim.getQubitOrder();
+
+    victim.reset();
+    EXPECT_EQ(victim.getQubitOrder(), qubitOrder);
+    checkEq(victim, {1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+                     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0});
+}
+
+TEST_F(DenseStateVectorTest, float_precision) {
+    QuantumState expected(6);
+    applyTestCircuit(expected);
+    auto expectedVector = toVector(expected);
+
+    BasicDenseStateVector<float> victim(6, "", 3);
+    applyTestCircuit(victim);
+
+    std::size_t nonZeros = std::count_if(expectedVector.begin(), expectedVector.end(), isNotNull<double>);
+    victim.forEach([&nonZeros, &expectedVector](auto const &kv) {
+        EXPECT_NEAR(expectedVector[kv.first.toSizeT()].real(), kv.second.real(), config::EPSILON<float>);
+        EXPECT_NEAR(expectedVector[kv.first.toSizeT()].imag(), kv.second.imag(), config::EPSILON<float>);
+        --nonZeros;
+    });
+    EXPECT_EQ(nonZeros, 0);
+}
+
+TEST_F(DenseStateVectorTest, amplitude_and_marginal_queries) {
+    QuantumState expected(6);
+    applyTestCircuit(expected);
+    auto expectedVector = toVector(expected);
+
+    DenseStateVector victim(6, "", 3);
+    applyTestCircuit(victim);
+
+    for (std::size_t i = 0; i < expectedVector.size(); ++i) {
+        auto amplitude = victim.getAmplitude(BasisVector::fromSizeT(i));
+        EXPECT_NEAR(amplitude.real(), expectedVector[i].real(), config::EPS);
+        EXPECT_NEAR(amplitude.imag(), expectedVector[i].imag(), config::EPS);
+    }
+
+    std::array<QubitIndex, 3> qubits{QubitIndex{5}, QubitIndex{0}, QubitIndex{4}};
+    auto marginals = victim.getMarginalProbabilities(qubits);
+    auto expectedMarginals = expected.getMarginalProbabilities(qubits);
+    ASSERT_EQ(marginals.size(), expectedMarginals.size());
+    for (std::size_t i = 0; i < marginals.size(); ++i) {
+        EXPECT_NEAR(marginals[i], expectedMarginals[i], config::EPS);
+    }
+}
+
+TEST_F(DenseStateVectorTest, pauli_sum_and_matrix_elements) {
+    DenseStateVector state(2);
+    state.testInitialize({{"00", 1 / std::sqrt(2)}, {"11", 1i / std::sqrt(2)}});
+
+    // ZZ and XY leave the state unchanged, and IZ flips the sign of |11>.
+    std::vector<PauliTerm> observable{{0.5, "ZZ"}, {2., "XY"}, {3., "IZ"}};
+    DenseStateVector victim(2);
+    victim.setToPauliSum(state, observable);
+    EXPECT_NEAR(victim.getAmplitude(BasisVector("00")).real(), 5.5 / std::sqrt(2), config::EPS);
+    EXPECT_NEAR(victim.getAmplitude(BasisVector("11")).imag(), -0.5 / std::sqrt(2), config::EPS);
+    EXPECT_NEAR(std::abs(victim.getAmplitude(BasisVector("01"))), 0., config::EPS);
+
+    auto expectation = state.innerProduct(victim);
+    EXPECT_NEAR(expectation.real(), 2.5, config::EPS);
+    EXPECT_NEAR(expectation.imag(), 0., config::EPS);
+
+    // Z on qubit 0 only acts on |11>, where qubit 1 is set.
+    std::array<QubitIndex, 1> controls{QubitIndex{1}};
+    EXPECT_NEAR(state.getMatrixElement(state, toGateMatrix<double>(gates::Z), controls, QubitIndex{0}).real(), -0.5,
+                config::EPS);
+    EXPECT_NEAR(std::abs(state.getMatrixElement(state, toGateMatrix<double>(gates::X), {}, QubitIndex{0})), 0.,
+                config::EPS);
+}
+
+TEST_F(DenseStateVectorTest, marginal_probabilities_in_parallel) {
+    std::size_t const n = 22;
+    DenseStateVector victim(n);
+    for (std::size_t q = 0; q < n; q += 3) {
+        victim.apply<1>(gates::RX(0.1 * static_cast<double>(q + 1)), std::array<QubitIndex, 1>{QubitIndex{q}});
+    }
+
+    std::array<QubitIndex, 2> qubits{QubitIndex{21}, QubitIndex{3}};
+    auto marginals = victim.getMarginalProbabilities(qubits);
+    auto p21 = std::pow(std::sin(2.2 / 2), 2);
+    auto p3 = std::pow(std::sin(0.4 / 2), 2);
+    ASSERT_EQ(marginals.size(), 4);
+    EXPECT_NEAR(marginals[0], (1 - p21) * (1 - p3), 1e-9);
+    EXPECT_NEAR(marginals[1], p21 * (1 - p3), 1e-9);
+    EXPECT_NEAR(marginals[2], (1 - p21) * p3, 1e-9);
+    EXPECT_NEAR(marginals[3], p21 * p3, 1e-9);
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+TEST_F(DenseStateVectorTest, memory_mapped_file) {
+    // Unique per run, since ctest -j runs the tests in parallel processes.
+    auto filePath = (std::filesystem::temp_directory_path() /
+        ("qx_dense_state_vector_test_" + std::to_string(std::random_device{}()) + ".bin")).string();
+
+    QuantumState expected(6);
+    applyTestCircuit(expected);
+
+    {
+        DenseStateVector victim(6, filePath, 4);
+        EXPECT_TRUE(victim.isMapped());
+        EXPECT_EQ(victim.getBlockQubits(), 4);
+        EXPECT_FALSE(std::filesystem::exists(filePath));
+
+        applyTestCircuit(victim);
+        checkEq(victim, toVector(expected));
+
+        victim.reset();
+        applyTestCircuit(victim);
+        checkEq(victim, toVector(expected));
+    }
+
+    EXPECT_FALSE(std::filesystem::exists(filePath));
+
+    // An existing file is neither truncated nor removed.
+    {
+        std::ofstream existing(filePath);
+        existing << "keep";
+    }
+    EXPECT_THROW(DenseStateVector(6, filePath, 4), std::runtime_error);
+    EXPECT_EQ(std::filesystem::file_size(filePath), 4);
+    std::filesystem::remove(filePath);
+}
+#endif
+
+}  // namespace qx::core
@@ -1,4 +1,5 @@
 #include "qx/Core.hpp"
+#include "qx/Gates.hpp"
 
 #include <gmock/gmock.h>  // ThrowsMessage
 #include <gtest/gtest.h>
@@ -46,4 +47,14 @@ TEST(dense_unitary_matrix_test, dagger) {
     EXPECT_EQ(m.dagger(), mDag);
 }
 
+TEST(dense_unitary_matrix_test, rotations_are_unitary_without_check) {
+    for (double angle : {-2.5, 0., 0.1, 1., 3.14, 100.}) {
+        EXPECT_EQ(gates::RX(angle) * gates::RX(angle).dagger(), DenseUnitaryMatrix<2>::identity());
+        EXPECT_EQ(gates::RY(angle) * gates::RY(angle).dagger(), DenseUnitaryMatrix<2>::identity());
+        EXPECT_EQ(gates::RZ(angle) * gates::RZ(angle).dagger(), DenseUnitaryMatrix<2>::identity());
+        EXPECT_EQ(gates::PHASE(angle) * gates::PHASE(angle).dagger(), DenseUnitaryMatrix<2>::identity());
+        EXPECT_EQ(gates::CR(angle) * gates::CR(angle).dagger(), DenseUnitaryMatrix<4>::identity());
+    }
+}
+
 }  // namespace qx::core
@@ -0,0 +1,196 @@
+#include "qx/DenseStateVector.hpp"
+#include "qx/DistributedStateVector.hpp"
+#include "qx/Gates.hpp"
+
+#include <gtest/gtest.h>
+#include <stdexcept>  // runtime_error
+
+
+namespace qx::core {
+
+#if defined(__linux__)
+
+class DistributedStateVectorTest : public ::testing::Test {
+public:
+    // 6 qubits among 4 processes: qubits 4 and 5 start in the global bits.
+    static constexpr std::size_t NUMBER_OF_QUBITS = 6;
+    static constexpr std::size_t NUMBER_OF_RANKS = 4;
+
+    template <typename State> static void applyTestCircuit(State &state) {
+        std::array<QubitIndex, 2> controls{QubitIndex{4}, QubitIndex{5}};
+        state.template apply<1>(gates::H, std::array<QubitIndex, 1>{QubitIndex{0}});
+        state.template apply<1>(gates::RX(0.3), std::array<QubitIndex, 1>{QubitIndex{5}});
+        state.template apply<2>(gates::CNOT, std::array<QubitIndex, 2>{QubitIndex{0}, QubitIndex{4}});
+        state.template apply<1>(gates::T, std::array<QubitIndex, 1>{QubitIndex{4}});
+        state.applyControlled(gates::X, controls, QubitIndex{1});
+        state.template apply<2>(gates::CR(0.7), std::array<QubitIndex, 2>{QubitIndex{1}, QubitIndex{3}});
+        state.template apply<1>(gates::Y, std::array<QubitIndex, 1>{QubitIndex{3}});
+        state.template apply<2>(gates::SWAP, std::array<QubitIndex, 2>{QubitIndex{2}, QubitIndex{5}});
+        state.template apply<1>(gates::H, std::array<QubitIndex, 1>{QubitIndex{4}});
+        state.template apply<1>(gates::RY(1.1), std::array<QubitIndex, 1>{QubitIndex{2}});
+    }
+
+    static void checkEq(DistributedStateVector const &victim, DenseStateVector const &expected) {
+        for (std::size_t i = 0; i < (std::size_t{1} << NUMBER_OF_QUBITS); ++i) {
+            auto basisVector = BasisVector::fromSizeT(i);
+            EXPECT_NEAR(std::abs(victim.getAmplitude(basisVector) - expected.getAmplitude(basisVector)), 0.,
+                        config::EPS);
+        }
+        EXPECT_EQ(victim.getMeasurementRegister(), expected.getMeasurementRegister());
+    }
+
+    static std::size_t countAmplitudes(Snapshot const &snapshot) {
+        std::size_t result = 0;
+        snapshot.forEach([&result](BasisVector, std::complex<double>) { ++result; });
+        return result;
+    }
+
+    // A qubit that is currently stored in a global bit.
+    static QubitIndex getGlobalQubit(DistributedStateVector const &victim) {
+        auto const &qubitOrder = victim.getQubitOrder();
+        for (std::size_t q = 0; q < NUMBER_OF_QUBITS; ++q) {
+            if (qubitOrder[q] >= victim.getLocalQubits()) {
+                return QubitIndex{q};
+            }
+        }
+        return QubitIndex{0};
+    }
+};
+
+TEST_F(DistributedStateVectorTest, same_as_dense_state_vector) {
+    DenseStateVector expected(NUMBER_OF_QUBITS);
+    applyTestCircuit(expected);
+
+    DistributedStateVector victim(NUMBER_OF_QUBITS, NUMBER_OF_RANKS);
+    EXPECT_EQ(victim.getNumberOfRanks(), NUMBER_OF_RANKS);
+    EXPECT_EQ(victim.getLocalQubits(), 4);
+    applyTestCircuit(victim);
+    EXPECT_GT(victim.getNumberOfSliceExchanges(), 0);
+
+    checkEq(victim, expected);
+}
+
+TEST_F(DistributedStateVectorTest, global_controls_select_slices) {
+    std::array<QubitIndex, 2> controls{QubitIndex{5}, QubitIndex{4}};
+    std::array<QubitIndex, 1> control{QubitIndex{2}};
+
+    DenseStateVector expected(NUMBER_OF_QUBITS);
+    for (std::size_t q : {0, 4, 5}) {
+        expected.apply<1>(gates::H, std::array<QubitIndex, 1>{QubitIndex{q}});
+    }
+
+    // Restoring keeps qubits 4 and 5 in the global bits.
+    DistributedStateVector victim(NUMBER_OF_QUBITS, NUMBER_OF_RANKS);
+    victim.restore(expected.getSnapshot());
+
+    expected.applyControlled(gates::X, controls, QubitIndex{2});
+    expected.applyControlled(gates::RY(0.4), control, QubitIndex{0});
+    victim.applyControlled(gates::X, controls, QubitIndex{2});
+    victim.applyControlled(gates::RY(0.4), control, QubitIndex{0});
+    EXPECT_EQ(victim.getNumberOfSliceExchanges(), 0);
+
+    checkEq(victim, expected);
+}
+
+TEST_F(DistributedStateVectorTest, measurements_on_global_qubits) {
+    DenseStateVector expected(NUMBER_OF_QUBITS);
+    applyTestCircuit(expected);
+
+    DistributedStateVector victim(NUMBER_OF_QUBITS, NUMBER_OF_RANKS);
+    applyTestCircuit(victim);
+
+    auto qubit = getGlobalQubit(victim);
+    EXPECT_NEAR(victim.getProbabilityOfMeasuringOne(qubit), expected.getProbabilityOfMeasuringOne(qubit), config::EPS);
+    victim.measure(qubit, []() { return 0.3; });
+    expected.measure(qubit, []() { return 0.3; });
+    checkEq(victim, expected);
+
+    qubit = getGlobalQubit(victim);
+    auto probabilityOfMeasuringOne = victim.getProbabilityOfMeasuringOne(qubit);
+    victim.dampWithoutDecay(qubit, 0.2, probabilityOfMeasuringOne);
+    expected.dampWithoutDecay(qubit, 0.2, probabilityOfMeasuringOne);
+    checkEq(victim, expected);
+
+    victim.prep(qubit, []() { return 0.; });
+    expected.prep(qubit, []() { return 0.; });
+    checkEq(victim, expected);
+
+    // A measurement on a local qubit, after which the global qubit is brought back.
+    victim.measure(QubitIndex{0}, []() { return 0.6; });
+    expected.measure(QubitIndex{0}, []() { return 0.6; });
+    victim.apply<1>(gates::H, std::array<QubitIndex, 1>{qubit});
+    expected.apply<1>(gates::H, std::array<QubitIndex, 1>{qubit});
+    checkEq(victim, expected);
+
+    std::array<QubitIndex, 3> marginalQubits{QubitIndex{5}, QubitIndex{0}, QubitIndex{3}};
+    auto marginals = victim.getMarginalProbabilities(marginalQubits);
+    auto expectedMarginals = expected.getMarginalProbabilities(marginalQubits);
+    ASSERT_EQ(marginals.size(), expectedMarginals.size());
+    for (std::size_t outcome = 0; outcome < marginals.size(); ++outcome) {
+        EXPECT_NEAR(marginals[outcome], expectedMarginals[outcome], config::EPS);
+    }
+}
+
+TEST_F(DistributedStateVectorTest, measure_all_reset_and_snapshot) {
+    DenseStateVector expected(NUMBER_OF_QUBITS);
+    applyTestCircuit(expected);
+
+    DistributedStateVector victim(NUMBER_OF_QUBITS, NUMBER_OF_RANKS);
+    applyTestCircuit(victim);
+
+    auto snapshot = victim.getSnapshot();
+    EXPECT_EQ(countAmplitudes(snapshot), countAmplitudes(expected.getSnapshot()));
+
+    victim.measureAll([]() { return 0.8; });
+    expected.measureAll([]() { return 0.8; });
+    checkEq(victim, expected);
+
+    victim.restore(snapshot);
+    expected.restore(snapshot);
+    checkEq(victim, expected);
+
+    auto qubitOrder = victim.getQubitOrder();
+    victim.reset();
+    EXPECT_EQ(victim.getQubitOrder(), qubitOrder);
+    EXPECT_EQ(victim.getAmplitude(BasisVector{}), std::complex<double>(1.));
+    EXPECT_EQ(countAmplitudes(victim.getSnapshot()), 1);
+}
+
+TEST_F(DistributedStateVectorTest, measure_all_at_the_end_of_the_distribution) {
+    // With rand = 1, the sum of the probabilities never exceeds it: both backends pick the last non-zero amplitude,
+    // which is in the last slice.
+    DenseStateVector expected(NUMBER_OF_QUBITS);
+    applyTestCircuit(expected);
+
+    DistributedStateVector victim(NUMBER_OF_QUBITS, NUMBER_OF_RANKS);
+    applyTestCircuit(victim);
+
+    victim.measureAll([]() { return 1.; });
+    expected.measureAll([]() { return 1.; });
+    checkEq(victim, expected);
+    EXPECT_EQ(countAmplitudes(victim.getSnapshot()), 1);
+}
+
+TEST_F(DistributedStateVectorTest, float_precision) {
+    BasicDenseStateVector<float> expected(NUMBER_OF_QUBITS);
+    applyTestCircuit(expected);
+
+    BasicDistributedStateVector<float> victim(NUMBER_OF_QUBITS, 2);
+    applyTestCircuit(victim);
+
+    for (std::size_t i = 0; i < (std::size_t{1} << NUMBER_OF_QUBITS); ++i) {
+        auto basisVector = BasisVector::fromSizeT(i);
+        EXPECT_NEAR(std::abs(victim.getAmplitude(basisVector) - expected.getAmplitude(basisVector)), 0.,
+                    config::EPSILON<float>);
+    }
+}
+
+TEST_F(DistributedStateVectorTest, invalid_number_of_processes) {
+    EXPECT_THROW(DistributedStateVector(NUMBER_OF_QUBITS, 3), std::runtime_error);
+    EXPECT_THROW(DistributedStateVector(NUMBER_OF_QUBITS, 2 * config::MAX_DISTRIBUTED_RANKS), std::runtime_error);
+    EXPECT_THROW(DistributedStateVector(3, 4), std::runtime_error);
+}
+
+#endif
+
+}  // namespace qx::core
@@ -1,7 +1,10 @@
+#include "qx/DenseStateVector.hpp"
 #include "qx/ErrorModels.hpp"
+#include "qx/Gates.hpp"
 #include "qx/Random.hpp"
 
 #include <gtest/gtest.h>
+#include <map>
 
 
 namespace qx::error_models {
@@ -56,4 +59,103 @@ TEST_F(ErrorModelsTest, depolarizing_channel__probability_0) {
     checkState({{BasisVector{"000"}, 1. + 0.i}});
 }
 
+TEST_F(ErrorModelsTest, amplitude_damping_channel__gamma_1) {
+    AmplitudeDampingChannel const channel(1.);
+    core::QuantumState state(3);
+    state.apply<1>(gates::X, std::array<core::QubitIndex, 1>{core::QubitIndex{1}});
+    state.apply<1>(gates::X, std::array<core::QubitIndex, 1>{core::QubitIndex{2}});
+
+    std::array<core::QubitIndex, 2> operands{core::QubitIndex{1}, core::QubitIndex{0}};
+    channel.addError(state, operands);
+
+    state.forEach([](auto const &kv) {
+        EXPECT_EQ(kv.first, BasisVector{"100"});
+        EXPECT_NEAR(std::abs(kv.second), 1., config::EPS);
+    });
+}
+
+TEST_F(ErrorModelsTest, amplitude_damping_channel__population) {
+    // Starting from |+>, the population of |1> after k damped gates is (1 - gamma)^k / 2, averaged over trajectories.
+    double const gamma = 0.1;
+    std::size_t const gates = 5;
+    std::size_t const trajectories = 20000;
+
+    AmplitudeDampingChannel const channel(gamma);
+    std::array<core::QubitIndex, 1> operand{core::QubitIndex{0}};
+    double population = 0.;
+    for (std::size_t i = 0; i < trajectories; ++i) {
+        core::QuantumState state(1);
+        state.apply<1>(gates::H, operand);
+        for (std::size_t k = 0; k < gates; ++k) {
+            channel.addError(state, operand);
+        }
+        population += state.getProbabilityOfMeasuringOne(operand[0]);
+    }
+
+    EXPECT_NEAR(population / trajectories, std::pow(1 - gamma, gates) / 2, 0.01);
+}
+
+TEST_F(ErrorModelsTest, amplitude_damping_channel__dense_same_as_sparse) {
+    AmplitudeDampingChannel const channel(0.3);
+    std::array<core::QubitIndex, 1> operand{core::QubitIndex{1}};
+    std::array<core::QubitIndex, 2> cnotOperands{core::QubitIndex{1}, core::QubitIndex{0}};
+
+    core::QuantumState sparse(2);
+    sparse.apply<1>(gates::H, operand);
+    sparse.apply<2>(gates::CNOT, cnotOperands);
+    sparse.dampWithoutDecay(operand[0], 0.3, sparse.getProbabilityOfMeasuringOne(operand[0]));
+
+    core::DenseStateVector dense(2);
+    dense.apply<1>(gates::H, operand);
+    dense.apply<2>(gates::CNOT, cnotOperands);
+    dense.dampWithoutDecay(operand[0], 0.3, dense.getProbabilityOfMeasuringOne(operand[0]));
+
+    std::map<BasisVector, std::complex<double>> expected;
+    sparse.forEach([&expected](auto const &kv) { expected[kv.first] = kv.second; });
+    EXPECT_NEAR(std::norm(expected[BasisVector{"11"}]), 0.7 / 1.7, config::EPS);
+
+    std::size_t count = 0;
+    dense.forEach([&expected, &count](auto const &kv) {
+        ++count;
+        EXPECT_NEAR(expected[kv.first].real(), kv.second.real(), config::EPS);
+        EXPECT_NEAR(expected[kv.first].imag(), kv.second.imag(), config::EPS);
+    });
+    EXPECT_EQ(count, expected.size());
+}
+
+TEST_F(ErrorModelsTest, readout_error) {
+    ReadoutError const readoutError(0.1, 0.3);
+    std::uint64_t const count = 100000;
+    std::vector<std::size_t> measuredQubits{0, 2};
+
+    std::map<BasisVector, std::uint64_t> readStates;
+    readoutError.addReadStates(BasisVector{"001"}, count, measuredQubits,
+        [&readStates](BasisVector readState, std::uint64_t readCount) { readStates[readState] += readCount; });
+
+    std::uint64_t total = 0;
+    for (auto const &[readState, readCount] : readStates) {
+        // Qubit 1 is not measured, so it is never read wrongly.
+        EXPECT_FALSE(readState.test(1));
+        total += readCount;
+    }
+    EXPECT_EQ(total, count);
+
+    // Qubit 0 is read as 0 with probability 0.3, qubit 2 is read as 1 with probability 0.1.
+    EXPECT_NEAR(static_cast<double>(readStates[BasisVector{"001"}]) / count, 0.7 * 0.9, 0.01);
+    EXPECT_NEAR(static_cast<double>(readStates[BasisVector{"000"}]) / count, 0.3 * 0.9, 0.01);
+    EXPECT_NEAR(static_cast<double>(readStates[BasisVector{"101"}]) / count, 0.7 * 0.1, 0.01);
+    EXPECT_NEAR(static_cast<double>(readStates[BasisVector{"100"}]) / count, 0.3 * 0.1, 0.01);
+}
+
+TEST_F(ErrorModelsTest, readout_error__probability_0) {
+    ReadoutError const readoutError(0., 0.);
+    std::vector<std::size_t> measuredQubits{0, 1, 2};
+
+    std::map<BasisVector, std::uint64_t> readStates;
+    readoutError.addReadStates(BasisVector{"101"}, 1000, measuredQubits,
+        [&readStates](BasisVector readState, std::uint64_t readCount) { readStates[readState] += readCount; });
+
+    EXPECT_EQ(readStates, (std::map<BasisVector, std::uint64_t>{{BasisVector{"101"}, 1000}}));
+}
+
 }  // namespace qx::error_models
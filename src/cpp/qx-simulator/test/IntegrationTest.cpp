@@ -1,9 +1,14 @@
+#include "qx/CircuitCache.hpp"
 #include "qx/Random.hpp"
 #include "qx/Simulator.hpp"
 
 #include <cmath>  // abs
+#include <filesystem>
+#include <fmt/format.h>
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
+#include <map>
+#include <random>  // random_device
 
 
 namespace qx {
@@ -17,6 +22,12 @@ public:
         EXPECT_TRUE(std::holds_alternative<SimulationResult>(result));
         return *std::get_if<SimulationResult>(&result);
     }
+
+    // Unique per run, since ctest -j runs the tests in parallel processes.
+    static std::string getTemporaryFilePath(std::string const &prefix) {
+        return (std::filesystem::temp_directory_path() /
+            fmt::format("{}_{}.bin", prefix, std::random_device{}())).string();
+    }
 };
 
 bool operator==(Complex const &left, Complex const &right) {
@@ -142,4 +153,318 @@ measure q[2]
     EXPECT_EQ(actual.state[0].second, (Complex{ .real = 1, .imag = 0, .norm = 1 }));
 }
 
+TEST_F(IntegrationTest, circuit_cache) {
+    auto cqasm = R"(
+version 3.0
+
+qubit[2] q
+
+H q[0]
+CNOT q[0], q[1]
+measure q
+)";
+    auto &circuitCache = CircuitCache::getInstance();
+    circuitCache.clear();
+
+    auto first = executeString(cqasm, 100, 42);
+    auto second = executeString(cqasm, 100, 42);
+    ASSERT_TRUE(std::holds_alternative<SimulationResult>(first));
+    ASSERT_TRUE(std::holds_alternative<SimulationResult>(second));
+    EXPECT_EQ(std::get<SimulationResult>(first).results, std::get<SimulationResult>(second).results);
+
+    auto statistics = circuitCache.getStatistics();
+    EXPECT_EQ(statistics.misses, 1);
+    EXPECT_EQ(statistics.hits, 1);
+    EXPECT_EQ(statistics.entries, 1);
+
+    // Analysis errors are not cached.
+    EXPECT_TRUE(std::holds_alternative<SimulationError>(executeString("version 3.0; qubit q; H q[0")));
+    EXPECT_EQ(circuitCache.getStatistics().entries, 1);
+}
+
+TEST_F(IntegrationTest, dense_backend) {
+    auto cqasm = R"(
+version 3.0
+
+qubit[6] q
+
+H q[0]
+CNOT q[0], q[5]
+X q[2]
+measure q[5]
+)";
+    SimulationOptions options;
+    options.backend = StateBackend::Dense;
+    options.dense_block_qubits = 3;
+
+    auto sparse = executeString(cqasm, 100, 42);
+    auto dense = executeString(cqasm, 100, 42, "3.0", options);
+    ASSERT_TRUE(std::holds_alternative<SimulationResult>(sparse));
+    ASSERT_TRUE(std::holds_alternative<SimulationResult>(dense));
+    EXPECT_EQ(std::get<SimulationResult>(dense).results, std::get<SimulationResult>(sparse).results);
+    EXPECT_EQ(std::get<SimulationResult>(dense).state, std::get<SimulationResult>(sparse).state);
+
+#if defined(__linux__)
+    options.dense_block_qubits = 0;
+    options.dense_processes = 4;
+    auto distributed = executeString(cqasm, 100, 42, "3.0", options);
+    ASSERT_TRUE(std::holds_alternative<SimulationResult>(distributed));
+    EXPECT_EQ(std::get<SimulationResult>(distributed).results, std::get<SimulationResult>(sparse).results);
+    EXPECT_EQ(std::get<SimulationResult>(distributed).state, std::get<SimulationResult>(sparse).state);
+
+    options.dense_processes = 3;
+    EXPECT_TRUE(std::holds_alternative<SimulationError>(executeString(cqasm, 100, 42, "3.0", options)));
+#endif
+}
+
+TEST_F(IntegrationTest, float_precision) {
+    auto cqasm = R"(
+version 3.0
+
+qubit[2] q
+
+H q[0]
+CNOT q[0], q[1]
+)";
+    SimulationOptions options;
+    options.precision = Precision::Float;
+
+    for (auto backend : { StateBackend::Sparse, StateBackend::Dense }) {
+        options.backend = backend;
+        auto result = executeString(cqasm, 1, std::nullopt, "3.0", options);
+        ASSERT_TRUE(std::holds_alternative<SimulationResult>(result));
+
+        auto const &state = std::get<SimulationResult>(result).state;
+        ASSERT_EQ(state.size(), 2);
+        EXPECT_EQ(state[0].first, "00");
+        EXPECT_EQ(state[1].first, "11");
+        EXPECT_NEAR(state[0].second.real, 1 / std::sqrt(2), config::EPSILON<float>);
+        EXPECT_NEAR(state[1].second.norm, 0.5, config::EPSILON<float>);
+    }
+}
+
+TEST_F(IntegrationTest, shot_branching) {
+    auto cqasm = R"(
+version 3.0
+
+qubit[2] q
+bit[2] b
+
+H q[0]
+CNOT q[0], q[1]
+b[0] = measure q[0]
+H q[1]
+b[1] = measure q[1]
+)";
+    SimulationOptions options;
+    options.shot_branching = true;
+
+    auto result = executeString(cqasm, 10000, 42, "3.0", options);
+    ASSERT_TRUE(std::holds_alternative<SimulationResult>(result));
+    auto const &simulationResult = std::get<SimulationResult>(result);
+    EXPECT_EQ(simulationResult.shots_requested, 10000);
+    EXPECT_EQ(simulationResult.shots_done, 10000);
+    ASSERT_EQ(simulationResult.results.size(), 4);
+    for (auto const &[state, count] : simulationResult.results) {
+        EXPECT_NEAR(count, 2500, 200);
+    }
+
+    options.backend = StateBackend::Dense;
+    EXPECT_TRUE(std::holds_alternative<SimulationError>(executeString(cqasm, 10, 42, "3.0", options)));
+}
+
+TEST_F(IntegrationTest, pauli_frames) {
+    auto cqasm = R"(
+version 3.0
+
+qubit[3] q
+bit[3] b
+
+H q[0]
+CNOT q[0], q[1]
+CNOT q[1], q[2]
+b = measure q
+)";
+    SimulationOptions options;
+    options.pauli_frames = true;
+
+    auto result = executeString(cqasm, 10000, 42, "3.0", options);
+    ASSERT_TRUE(std::holds_alternative<SimulationResult>(result));
+    auto const &simulationResult = std::get<SimulationResult>(result);
+    EXPECT_EQ(simulationResult.shots_done, 10000);
+    ASSERT_EQ(simulationResult.results.size(), 2);
+    for (auto const &[state, count] : simulationResult.results) {
+        EXPECT_TRUE(state == "000" || state == "111");
+        EXPECT_NEAR(count, 5000, 300);
+    }
+
+    options.depolarizing_probability = 0.01;
+    result = executeString(cqasm, 10000, 42, "3.0", options);
+    ASSERT_TRUE(std::holds_alternative<SimulationResult>(result));
+    EXPECT_EQ(std::get<SimulationResult>(result).results.size(), 8);
+
+    EXPECT_TRUE(std::holds_alternative<SimulationError>(
+        executeString("version 3.0; qubit q; bit b; T q; b = measure q", 10, 42, "3.0", options)));
+}
+
+TEST_F(IntegrationTest, shot_records) {
+    auto cqasm = R"(
+version 3.0
+
+qubit[9] q
+bit[9] b
+
+H q[0]
+CNOT q[0], q[8]
+b = measure q
+)";
+    SimulationOptions options;
+    options.record_shots = true;
+    options.readout_error_one_to_zero = 0.1;
+
+    auto result = executeString(cqasm, 1000, 42, "3.0", options);
+    ASSERT_TRUE(std::holds_alternative<SimulationResult>(result));
+    auto const &simulationResult = std::get<SimulationResult>(result);
+    ASSERT_TRUE(simulationResult.shot_records.has_value());
+    auto const &records = *simulationResult.shot_records;
+    EXPECT_EQ(records.number_of_bits, 9);
+    EXPECT_EQ(records.bytes_per_shot, 2);
+    EXPECT_EQ(records.number_of_shots, 1000);
+    ASSERT_EQ(records.bytes.size(), 2000);
+
+    // The records hold the same shots as the results, read errors included.
+    std::map<std::string, std::uint64_t> recordedResults;
+    for (std::size_t shot = 0; shot < records.number_of_shots; ++shot) {
+        auto low = records.bytes[2 * shot];
+        auto high = records.bytes[2 * shot + 1];
+        EXPECT_TRUE(low == 0 || low == 1);
+        EXPECT_TRUE(high == 0 || high == 1);
+        ++recordedResults[fmt::format("{}{:08b}", high, low)];
+    }
+    EXPECT_EQ(recordedResults.size(), 4);
+    EXPECT_EQ(SimulationResult::Results(recordedResults.begin(), recordedResults.end()), simulationResult.results);
+
+    auto filePath = getTemporaryFilePath("qx_integration_test_shots");
+    options.shot_record_file = filePath;
+    result = executeString(cqasm, 1000, 42, "3.0", options);
+    ASSERT_TRUE(std::holds_alternative<SimulationResult>(result));
+    EXPECT_TRUE(std::get<SimulationResult>(result).shot_records->bytes.empty());
+    EXPECT_EQ(std::filesystem::file_size(filePath), 2000);
+    std::filesystem::remove(filePath);
+
+    options.record_shots = false;
+    EXPECT_TRUE(std::holds_alternative<SimulationError>(executeString(cqasm, 10, 42, "3.0", options)));
+}
+
+TEST_F(IntegrationTest, memory_budget) {
+    std::string cqasm = "version 3.0\nqubit[20] q\n";
+    for (std::size_t q = 0; q < 20; ++q) {
+        cqasm += fmt::format("H q[{}]\n", q);
+    }
+    auto result = executeString(cqasm);
+    ASSERT_TRUE(std::holds_alternative<SimulationResult>(result));
+    auto const &simulationResult = std::get<SimulationResult>(result);
+    EXPECT_GT(simulationResult.amplitude_bytes, 0);
+    EXPECT_GE(simulationResult.peak_amplitude_bytes, simulationResult.amplitude_bytes);
+
+    auto estimate = estimateMemoryString(cqasm);
+    ASSERT_TRUE(std::holds_alternative<MemoryEstimate>(estimate));
+    EXPECT_EQ(std::get<MemoryEstimate>(estimate).max_amplitudes, 1 << 20);
+    EXPECT_GE(std::get<MemoryEstimate>(estimate).max_amplitude_bytes, simulationResult.peak_amplitude_bytes);
+
+    // Within the budget, since the qubits are in separate groups of 2 amplitudes each.
+    SimulationOptions options;
+    options.max_memory_bytes = 1 << 20;
+    EXPECT_TRUE(std::holds_alternative<SimulationResult>(executeString(cqasm, 1, std::nullopt, "3.0", options)));
+
+    // Once entangled, the 2^20 amplitudes of their group take more than the budget.
+    auto entangled = cqasm;
+    for (std::size_t q = 0; q + 1 < 20; ++q) {
+        entangled += fmt::format("CNOT q[{}], q[{}]\n", q, q + 1);
+    }
+    EXPECT_TRUE(std::holds_alternative<SimulationError>(executeString(entangled, 1, std::nullopt, "3.0", options)));
+
+    // The dense backend is rejected before it starts.
+    options.backend = StateBackend::Dense;
+    estimate = estimateMemoryString(cqasm, 1, "3.0", options);
+    ASSERT_TRUE(std::holds_alternative<MemoryEstimate>(estimate));
+    EXPECT_EQ(std::get<MemoryEstimate>(estimate).max_amplitude_bytes, 16 << 20);
+    EXPECT_TRUE(std::holds_alternative<SimulationError>(executeString(cqasm, 1, std::nullopt, "3.0", options)));
+}
+
+TEST_F(IntegrationTest, unitary) {
+    auto result = getUnitaryString("version 3.0; qubit[2] q; bit[2] b; H q[0]; CNOT q[0], q[1]; b = measure q");
+    ASSERT_TRUE(std::holds_alternative<UnitaryResult>(result));
+
+    auto const &unitary = std::get<UnitaryResult>(result);
+    EXPECT_EQ(unitary.number_of_qubits, 2);
+    ASSERT_EQ(unitary.matrix.size(), 16);
+    // Column 0 is the Bell state (|00> + |11>) / sqrt(2).
+    EXPECT_NEAR(unitary.matrix[0].real(), 1 / std::sqrt(2), config::EPS);
+    EXPECT_NEAR(unitary.matrix[3].real(), 1 / std::sqrt(2), config::EPS);
+
+    EXPECT_TRUE(std::holds_alternative<SimulationError>(
+        getUnitaryString("version 3.0; qubit q; bit b; b = measure q; X q")));
+}
+
+TEST_F(IntegrationTest, circuit_builder) {
+    CircuitBuilder circuit(3);
+    circuit.addGate("H", { 0 }).addGate("CNOT", { 0, 1 }).addMeasure(0).addMeasure(1);
+    circuit.addGate("X", { 2 }, std::nullopt, { 1 }).addMeasure(2);
+
+    auto result = executeCircuit(circuit, 1000, 7);
+    ASSERT_TRUE(std::holds_alternative<SimulationResult>(result));
+    auto const &simulationResult = std::get<SimulationResult>(result);
+    EXPECT_EQ(simulationResult.shots_done, 1000);
+    ASSERT_EQ(simulationResult.results.size(), 2);
+    EXPECT_EQ(simulationResult.results[0].first, "000");
+    EXPECT_EQ(simulationResult.results[1].first, "111");
+
+    auto error = executeCircuit(CircuitBuilder(2).addGate("CNOT", { 0, 2 }));
+    ASSERT_TRUE(std::holds_alternative<SimulationError>(error));
+    EXPECT_EQ(std::get<SimulationError>(error).message, "Qubit 2 is out of range, the circuit has 2 qubits");
+}
+
+TEST_F(IntegrationTest, gradients) {
+    // cos(a/2) |00> + sin(a/2) |11>, on which CR only changes the phase of |11>.
+    auto result = getGradientsString("version 3.0; qubit[2] q; bit[2] b; Ry q[0], 0.6; CNOT q[0], q[1]; "
+        "CR q[0], q[1], 0.3; b = measure q", Observable{ { "ZI", 1. }, { "IZ", 0.5 } });
+    ASSERT_TRUE(std::holds_alternative<GradientResult>(result));
+
+    auto const &gradients = std::get<GradientResult>(result);
+    EXPECT_NEAR(gradients.expectation, 1.5 * std::cos(0.6), config::EPS);
+    ASSERT_EQ(gradients.gradients.size(), 2);
+    EXPECT_NEAR(gradients.gradients[0], -1.5 * std::sin(0.6), config::EPS);
+    EXPECT_NEAR(gradients.gradients[1], 0., config::EPS);
+
+    EXPECT_TRUE(std::holds_alternative<SimulationError>(
+        getGradientsString("version 3.0; qubit[2] q; Rx q[0], 0.1", Observable{ { "Z", 1. } })));
+}
+
+TEST_F(IntegrationTest, snapshot) {
+    auto filePath = getTemporaryFilePath("qx_integration_test_snapshot");
+
+    SimulationOptions saveOptions;
+    saveOptions.final_state_file = filePath;
+    saveOptions.compress_final_state = true;
+    auto prepared = executeString("version 3.0; qubit[3] q; H q[0]; CNOT q[0], q[2]", 1, std::nullopt, "3.0",
+        saveOptions);
+    ASSERT_TRUE(std::holds_alternative<SimulationResult>(prepared));
+
+    SimulationOptions loadOptions;
+    loadOptions.initial_state_file = filePath;
+    auto actual = executeString("version 3.0; qubit[3] q; X q[1]", 1, std::nullopt, "3.0", loadOptions);
+    ASSERT_TRUE(std::holds_alternative<SimulationResult>(actual));
+    EXPECT_EQ(std::get<SimulationResult>(actual).state,
+        (SimulationResult::State{
+            { "010", Complex{ .real = 1 / std::sqrt(2), .imag = 0, .norm = 0.5 } },
+            { "111", Complex{ .real = 1 / std::sqrt(2), .imag = 0, .norm = 0.5 } }
+    }));
+
+    auto wrongSize = executeString("version 3.0; qubit[2] q; X q[1]", 1, std::nullopt, "3.0", loadOptions);
+    EXPECT_TRUE(std::holds_alternative<SimulationError>(wrongSize));
+
+    std::filesystem::remove(filePath);
+}
+
 } // namespace qx
@@ -0,0 +1,158 @@
+#include "qx/JobPool.hpp"
+
+#include <atomic>
+#include <gtest/gtest.h>
+#include <thread>
+#include <utility>  // pair
+#include <vector>
+
+
+namespace qx {
+
+class JobPoolTest : public ::testing::Test {
+public:
+    // Task running the requested shots, unless it is cancelled.
+    static Job::Task makeTask(std::size_t shots) {
+        return [shots](SimulationProgress &progress) -> Job::Result {
+            SimulationResult result;
+            result.shots_requested = shots;
+            while (result.shots_done < shots && !progress.isCancelled()) {
+                ++result.shots_done;
+                progress.onShotDone(shots);
+            }
+            return result;
+        };
+    }
+
+    // Task that only returns once released.
+    static Job::Task makeBlockingTask(std::atomic<bool> &released) {
+        return [&released](SimulationProgress &) -> Job::Result {
+            while (!released) {
+                std::this_thread::yield();
+            }
+            return SimulationResult{};
+        };
+    }
+};
+
+TEST_F(JobPoolTest, run_jobs) {
+    JobPool victim(2);
+    EXPECT_EQ(victim.getNumberOfThreads(), 2);
+
+    std::vector<std::shared_ptr<Job>> jobs;
+    for (std::size_t shots = 1; shots <= 10; ++shots) {
+        jobs.push_back(victim.submit(makeTask(shots), shots));
+    }
+
+    for (std::size_t shots = 1; shots <= 10; ++shots) {
+        auto const &job = jobs[shots - 1];
+        auto result = job->wait();
+        ASSERT_TRUE(std::holds_alternative<SimulationResult>(result));
+        EXPECT_EQ(std::get<SimulationResult>(result).shots_done, shots);
+        EXPECT_TRUE(job->isDone());
+        EXPECT_EQ(job->getShotsDone(), shots);
+        EXPECT_EQ(job->getShotsRequested(), shots);
+    }
+}
+
+TEST_F(JobPoolTest, progress_callback) {
+    JobPool victim(1);
+    std::vector<std::pair<std::size_t, std::size_t>> calls;
+
+    auto job = victim.submit(makeTask(250), 250, [&calls](std::size_t shotsDone, std::size_t shotsRequested) {
+        calls.emplace_back(shotsDone, shotsRequested);
+    });
+    (void) job->wait();
+
+    ASSERT_EQ(calls.size(), 125);
+    EXPECT_EQ(calls.front(), std::make_pair(std::size_t{ 2 }, std::size_t{ 250 }));
+    EXPECT_EQ(calls.back(), std::make_pair(std::size_t{ 250 }, std::size_t{ 250 }));
+}
+
+TEST_F(JobPoolTest, cancel_queued_job) {
+    JobPool victim(1);
+    std::atomic<bool> released = false;
+
+    auto blocking = victim.submit(makeBlockingTask(released), 1);
+    auto queued = victim.submit(makeTask(3), 3);
+    EXPECT_FALSE(queued->waitFor(std::chrono::milliseconds(10)));
+
+    queued->cancel();
+    EXPECT_TRUE(queued->isDone());
+    auto result = queued->wait();
+    ASSERT_TRUE(std::holds_alternative<SimulationError>(result));
+    EXPECT_EQ(std::get<SimulationError>(result).message, "Job was cancelled before it started");
+    EXPECT_EQ(queued->getShotsDone(), 0);
+
+    released = true;
+    EXPECT_TRUE(std::holds_alternative<SimulationResult>(blocking->wait()));
+}
+
+TEST_F(JobPoolTest, cancel_running_job) {
+    JobPool victim(1);
+    std::atomic<bool> started = false;
+
+    auto job = victim.submit([&started](SimulationProgress &progress) -> Job::Result {
+        started = true;
+        while (!progress.isCancelled()) {
+            std::this_thread::yield();
+        }
+        return SimulationError{ "Stopped" };
+    }, 1);
+
+    while (!started) {
+        std::this_thread::yield();
+    }
+    job->cancel();
+
+    auto result = job->wait();
+    ASSERT_TRUE(std::holds_alternative<SimulationError>(result));
+    EXPECT_EQ(std::get<SimulationError>(result).message, "Stopped");
+}
+
+TEST_F(JobPoolTest, set_number_of_threads) {
+    JobPool victim(3);
+    victim.setNumberOfThreads(1);
+    EXPECT_EQ(victim.getNumberOfThreads(), 1);
+    EXPECT_TRUE(std::holds_alternative<SimulationResult>(victim.submit(makeTask(5), 5)->wait()));
+
+    victim.setNumberOfThreads(4);
+    EXPECT_EQ(victim.getNumberOfThreads(), 4);
+    EXPECT_TRUE(std::holds_alternative<SimulationResult>(victim.submit(makeTask(5), 5)->wait()));
+
+    // The workers that stopped are joined as the pool shrinks and grows again.
+    for (std::size_t i = 0; i < 20; ++i) {
+        victim.setNumberOfThreads(1);
+        victim.setNumberOfThreads(4);
+    }
+    EXPECT_TRUE(std::holds_alternative<SimulationResult>(victim.submit(makeTask(5), 5)->wait()));
+}
+
+TEST_F(JobPoolTest, shutdown) {
+    JobPool victim(1);
+    std::atomic<bool> started = false;
+
+    auto running = victim.submit([&started](SimulationProgress &progress) -> Job::Result {
+        started = true;
+        while (!progress.isCancelled()) {
+            std::this_thread::yield();
+        }
+        return SimulationError{ "Stopped" };
+    }, 1);
+    auto queued = victim.submit(makeTask(3), 3);
+    while (!started) {
+        std::this_thread::yield();
+    }
+
+    victim.shutdown();
+    EXPECT_TRUE(running->isDone());
+    EXPECT_TRUE(queued->isDone());
+    EXPECT_TRUE(std::holds_alternative<SimulationError>(queued->wait()));
+
+    auto late = victim.submit(makeTask(3), 3);
+    EXPECT_TRUE(late->isDone());
+    ASSERT_TRUE(std::holds_alternative<SimulationError>(late->wait()));
+    EXPECT_EQ(late->getShotsDone(), 0);
+}
+
+}  // namespace qx
@@ -0,0 +1,118 @@
+#include "qx/Core.hpp"
+#include "qx/Gates.hpp"
+#include "qx/PauliFrames.hpp"
+#include "qx/Random.hpp"
+
+#include <cmath>  // pow, sqrt
+#include <gtest/gtest.h>
+#include <map>
+#include <stdexcept>  // runtime_error
+
+
+namespace qx {
+
+class PauliFramesTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        random::seed(123);
+    }
+
+    // Measurement registers of the shots, with the reference from a noiseless shot, as the simulator does.
+    static std::map<std::string, std::uint64_t> sample(Circuit const &circuit, std::size_t numberOfQubits,
+                                                       std::size_t batches, double depolarizingProbability = 0.) {
+        PauliFrameSampler victim(circuit, numberOfQubits);
+        core::QuantumState reference(numberOfQubits);
+        circuit.execute(reference, std::monostate{});
+
+        std::map<std::string, std::uint64_t> result;
+        for (std::size_t batch = 0; batch < batches; ++batch) {
+            victim.sample(reference.getMeasurementRegister(), PauliFrameSampler::BATCH_SIZE, depolarizingProbability,
+                [&result, numberOfQubits](BasisVector measurementRegister, std::uint64_t count) {
+                    auto s = measurementRegister.toString();
+                    result[s.substr(s.size() - numberOfQubits)] += count;
+                });
+        }
+        return result;
+    }
+};
+
+TEST_F(PauliFramesTest, ghz_state) {
+    Circuit circuit;
+    circuit.addInstruction(Circuit::Unitary<1>{ gates::H, { core::QubitIndex{ 0 } } });
+    circuit.addInstruction(Circuit::Unitary<2>{ gates::CNOT, { core::QubitIndex{ 0 }, core::QubitIndex{ 1 } } });
+    circuit.addInstruction(Circuit::ControlledUnitary{ { core::QubitIndex{ 1 } }, gates::X, core::QubitIndex{ 2 } });
+    circuit.addInstruction(Circuit::MeasureAll{});
+
+    auto result = sample(circuit, 3, 4);
+    ASSERT_EQ(result.size(), 2);
+    EXPECT_EQ(result["000"] + result["111"], 4 * PauliFrameSampler::BATCH_SIZE);
+    EXPECT_NEAR(static_cast<double>(result["000"]) / (4 * PauliFrameSampler::BATCH_SIZE), 0.5, 0.1);
+}
+
+TEST_F(PauliFramesTest, mid_circuit_measurement_and_reset) {
+    // Rx(pi / 2) and Y90 are Clifford gates, so qubit 0 is measured at random, then reset and flipped.
+    Circuit circuit;
+    circuit.addInstruction(Circuit::Unitary<1>{ gates::RX(gates::PI / 2), { core::QubitIndex{ 0 } } });
+    circuit.addInstruction(Circuit::Unitary<1>{ gates::Y90, { core::QubitIndex{ 1 } } });
+    circuit.addInstruction(Circuit::Measure{ core::QubitIndex{ 0 } });
+    circuit.addInstruction(Circuit::Unitary<2>{ gates::SWAP, { core::QubitIndex{ 0 }, core::QubitIndex{ 1 } } });
+    circuit.addInstruction(Circuit::PrepZ{ core::QubitIndex{ 0 } });
+    circuit.addInstruction(Circuit::Unitary<1>{ gates::X, { core::QubitIndex{ 0 } } });
+    circuit.addInstruction(Circuit::Measure{ core::QubitIndex{ 0 } });
+    circuit.addInstruction(Circuit::Measure{ core::QubitIndex{ 1 } });
+
+    auto result = sample(circuit, 2, 4);
+    EXPECT_EQ(result["01"] + result["11"], 4 * PauliFrameSampler::BATCH_SIZE);
+    EXPECT_NEAR(static_cast<double>(result["01"]) / (4 * PauliFrameSampler::BATCH_SIZE), 0.5, 0.1);
+}
+
+TEST_F(PauliFramesTest, depolarizing_errors) {
+    // An error before each of the 10 instructions flips the outcome with probability 2/3.
+    Circuit circuit;
+    for (std::size_t i = 0; i < 9; ++i) {
+        circuit.addInstruction(Circuit::Unitary<1>{ gates::IDENTITY, { core::QubitIndex{ 0 } } });
+    }
+    circuit.addInstruction(Circuit::Measure{ core::QubitIndex{ 0 } });
+
+    auto probability = 0.05;
+    auto shots = 40 * PauliFrameSampler::BATCH_SIZE;
+    auto expected = (1 - std::pow(1 - 4 * probability / 3, 10)) / 2;
+    auto result = sample(circuit, 1, 40, probability);
+    EXPECT_EQ(result["0"] + result["1"], shots);
+    EXPECT_NEAR(static_cast<double>(result["1"]) / shots, expected,
+                4 * std::sqrt(expected * (1 - expected) / shots));
+}
+
+TEST_F(PauliFramesTest, iterations) {
+    // Two iterations of 5 instructions give as many errors as the 10 instructions above.
+    Circuit circuit("", 2);
+    for (std::size_t i = 0; i < 4; ++i) {
+        circuit.addInstruction(Circuit::Unitary<1>{ gates::X, { core::QubitIndex{ 0 } } });
+    }
+    circuit.addInstruction(Circuit::Measure{ core::QubitIndex{ 0 } });
+
+    auto probability = 0.05;
+    auto shots = 40 * PauliFrameSampler::BATCH_SIZE;
+    auto expected = (1 - std::pow(1 - 4 * probability / 3, 10)) / 2;
+    auto result = sample(circuit, 1, 40, probability);
+    EXPECT_EQ(result["0"] + result["1"], shots);
+    EXPECT_NEAR(static_cast<double>(result["1"]) / shots, expected,
+                4 * std::sqrt(expected * (1 - expected) / shots));
+}
+
+TEST_F(PauliFramesTest, only_clifford_gates) {
+    Circuit tGate;
+    tGate.addInstruction(Circuit::Unitary<1>{ gates::T, { core::QubitIndex{ 0 } } });
+    EXPECT_THROW(PauliFrameSampler(tGate, 1), std::runtime_error);
+
+    Circuit toffoli;
+    toffoli.addInstruction(Circuit::ControlledUnitary{ { core::QubitIndex{ 0 }, core::QubitIndex{ 1 } }, gates::X,
+                                                       core::QubitIndex{ 2 } });
+    EXPECT_THROW(PauliFrameSampler(toffoli, 3), std::runtime_error);
+
+    Circuit conditional;
+    conditional.addInstruction(Circuit::Unitary<1>{ gates::X, { core::QubitIndex{ 0 } } }, { core::QubitIndex{ 1 } });
+    EXPECT_THROW(PauliFrameSampler(conditional, 2), std::runtime_error);
+}
+
+}  // namespace qx
@@ -0,0 +1,134 @@
+#include "qx/Gates.hpp"
+#include "qx/QuantumStatePool.hpp"
+
+#include <gtest/gtest.h>
+#include <vector>
+
+
+namespace qx::core {
+
+class QuantumStatePoolTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        QuantumStatePool<double>::clear();
+    }
+
+    void TearDown() override {
+        QuantumStatePool<double>::clear();
+    }
+
+    static std::size_t countAmplitudes(QuantumState &state) {
+        std::size_t result = 0;
+        state.forEach([&result](auto const &) { ++result; });
+        return result;
+    }
+
+    static void entangle(QuantumState &state, std::size_t n) {
+        for (std::size_t q = 0; q < n; ++q) {
+            state.apply<1>(gates::H, std::array<QubitIndex, 1>{QubitIndex{q}});
+        }
+        for (std::size_t q = 0; q + 1 < n; ++q) {
+            state.apply<2>(gates::CNOT, std::array<QubitIndex, 2>{QubitIndex{q}, QubitIndex{q + 1}});
+        }
+    }
+};
+
+TEST_F(QuantumStatePoolTest, returned_state_is_reset_and_reused) {
+    QuantumState const *borrowed = nullptr;
+    {
+        auto state = QuantumStatePool<double>::borrow(3);
+        borrowed = state.get();
+        state->apply<1>(gates::H, std::array<QubitIndex, 1>{QubitIndex{0}});
+        state->apply<2>(gates::CNOT, std::array<QubitIndex, 2>{QubitIndex{0}, QubitIndex{2}});
+        state->measure(QubitIndex{2}, []() { return 0.1; });
+        EXPECT_EQ(QuantumStatePool<double>::getSize(), 0);
+    }
+    EXPECT_EQ(QuantumStatePool<double>::getSize(), 1);
+
+    auto state = QuantumStatePool<double>::borrow(3);
+    EXPECT_EQ(state.get(), borrowed);
+    EXPECT_EQ(QuantumStatePool<double>::getSize(), 0);
+    EXPECT_EQ(state->getNumberOfQubitGroups(), 0);
+    EXPECT_EQ(state->getMeasurementRegister(), BasisVector{});
+    EXPECT_EQ(countAmplitudes(*state), 1);
+    EXPECT_EQ(state->getAmplitude(BasisVector{}), std::complex<double>(1.));
+
+    // Gates run as on a new state.
+    state->apply<1>(gates::H, std::array<QubitIndex, 1>{QubitIndex{1}});
+    EXPECT_EQ(countAmplitudes(*state), 2);
+}
+
+TEST_F(QuantumStatePoolTest, number_of_qubits_and_storage_must_match) {
+    QuantumState const *borrowed = nullptr;
+    {
+        auto state = QuantumStatePool<double>::borrow(3);
+        borrowed = state.get();
+    }
+
+    auto otherNumberOfQubits = QuantumStatePool<double>::borrow(4);
+    EXPECT_NE(otherNumberOfQubits.get(), borrowed);
+    EXPECT_EQ(otherNumberOfQubits->getNumberOfQubits(), 4);
+
+    auto otherStorage = QuantumStatePool<double>::borrow(3, SparseStorage::SortedArray);
+    EXPECT_NE(otherStorage.get(), borrowed);
+    EXPECT_EQ(otherStorage->getSparseStorage(), SparseStorage::SortedArray);
+    EXPECT_EQ(QuantumStatePool<double>::getSize(), 1);
+}
+
+TEST_F(QuantumStatePoolTest, reused_state_does_not_reallocate) {
+    for (auto storage : {SparseStorage::HashMap, SparseStorage::SortedArray}) {
+        QuantumState const *borrowed = nullptr;
+        std::uint64_t bytes = 0;
+        {
+            auto state = QuantumStatePool<double>::borrow(14, storage);
+            borrowed = state.get();
+            entangle(*state, 14);
+            bytes = state->getMemoryBytes();
+            EXPECT_GT(bytes, 100000);
+        }
+
+        // The amplitudes of the previous simulation are kept, and are charged from the start. The same gates then
+        // reuse them: new containers of that size would double the peak.
+        MemoryTracker tracker;
+        auto state = QuantumStatePool<double>::borrow(14, storage);
+        ASSERT_EQ(state.get(), borrowed);
+        state->setMemoryTracker(&tracker);
+        EXPECT_EQ(tracker.getBytes(), bytes);
+        entangle(*state, 14);
+        EXPECT_EQ(countAmplitudes(*state), 1 << 14);
+        EXPECT_LT(tracker.getPeakBytes(), bytes + bytes / 10);
+    }
+}
+
+TEST_F(QuantumStatePoolTest, large_allocations_are_not_charged_beyond_the_next_budget) {
+    for (auto storage : {SparseStorage::HashMap, SparseStorage::SortedArray}) {
+        QuantumState const *borrowed = nullptr;
+        {
+            auto state = QuantumStatePool<double>::borrow(14, storage);
+            borrowed = state.get();
+            entangle(*state, 14);
+            EXPECT_GT(state->getMemoryBytes(), 100000);
+        }
+
+        MemoryTracker tracker(100000);
+        auto state = QuantumStatePool<double>::borrow(14, storage);
+        ASSERT_EQ(state.get(), borrowed);
+        EXPECT_NO_THROW(state->setMemoryTracker(&tracker));
+        EXPECT_LE(tracker.getBytes(), 100000);
+        EXPECT_NO_THROW(entangle(*state, 3));
+        EXPECT_EQ(countAmplitudes(*state), 8);
+    }
+}
+
+TEST_F(QuantumStatePoolTest, pool_is_bounded) {
+    {
+        std::vector<QuantumStatePool<double>::Handle> states;
+        for (std::size_t n = 1; n <= config::QUANTUM_STATE_POOL_SIZE + 2; ++n) {
+            states.push_back(QuantumStatePool<double>::borrow(n));
+        }
+    }
+    EXPECT_EQ(QuantumStatePool<double>::getSize(), config::QUANTUM_STATE_POOL_SIZE);
+    EXPECT_EQ(QuantumStatePool<float>::getSize(), 0);
+}
+
+}  // namespace qx::core
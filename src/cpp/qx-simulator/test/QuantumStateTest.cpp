@@ -3,6 +3,7 @@
 
 #include <algorithm>  // count_if
 #include <gtest/gtest.h>
+#include <stdexcept>  // runtime_error
 
 
 namespace qx ::core {
@@ -15,7 +16,7 @@ public:
                         std::vector<std::complex<double>> expected) {
         ASSERT_EQ(expected.size(), 1 << victim.getNumberOfQubits());
 
-        std::size_t nonZeros = std::count_if(expected.begin(), expected.end(), isNotNull);
+        std::size_t nonZeros = std::count_if(expected.begin(), expected.end(), isNotNull<double>);
 
         victim.forEach([&nonZeros, &expected](auto const &kv) {
             EXPECT_GT(nonZeros, 0);
@@ -66,6 +67,39 @@ TEST_F(QuantumStateTest, apply_cnot) {
     checkEq(victim, {0, 0, std::sqrt(1 - std::pow(0.123, 2)), 0.123});
 }
 
+TEST_F(QuantumStateTest, apply_controlled) {
+    QuantumState victim(4);
+    for (std::size_t q = 0; q < 4; ++q) {
+        victim.apply<1>(gates::RY(0.3 * static_cast<double>(q + 1)), std::array<QubitIndex, 1>{QubitIndex{q}});
+    }
+    QuantumState expected(victim);
+
+    std::array<QubitIndex, 2> controls{QubitIndex{0}, QubitIndex{1}};
+    victim.applyControlled(gates::X, controls, QubitIndex{2});
+    expected.apply<3>(gates::TOFFOLI, std::array<QubitIndex, 3>{QubitIndex{0}, QubitIndex{1}, QubitIndex{2}});
+    std::array<QubitIndex, 1> control{QubitIndex{3}};
+    victim.applyControlled(gates::PHASE(0.7), control, QubitIndex{1});
+    expected.apply<2>(gates::CR(0.7), std::array<QubitIndex, 2>{QubitIndex{3}, QubitIndex{1}});
+
+    std::vector<std::complex<double>> expectedVector(16, 0.);
+    expected.forEach([&expectedVector](auto const &kv) { expectedVector[kv.first.toSizeT()] = kv.second; });
+    checkEq(victim, expectedVector);
+}
+
+TEST_F(QuantumStateTest, apply_multi_controlled) {
+    QuantumState victim(4);
+    for (std::size_t q = 0; q < 4; ++q) {
+        victim.apply<1>(gates::H, std::array<QubitIndex, 1>{QubitIndex{q}});
+    }
+
+    std::array<QubitIndex, 3> controls{QubitIndex{3}, QubitIndex{0}, QubitIndex{2}};
+    victim.applyControlled(gates::Z, controls, QubitIndex{1});
+
+    std::vector<std::complex<double>> expected(16, 0.25);
+    expected[15] = -0.25;
+    checkEq(victim, expected);
+}
+
 TEST_F(QuantumStateTest, measure_on_non_superposed_state) {
     QuantumState victim(2);
     victim.testInitialize({{"10", 0.123}, {"11", std::sqrt(1 - std::pow(0.123, 2))}});
@@ -110,6 +144,29 @@ TEST_F(QuantumStateTest, measure_all) {
     EXPECT_EQ(victim.getMeasurementRegister(), BasisVector("110"));
 }
 
+TEST_F(QuantumStateTest, measure_all_at_the_end_of_the_distribution) {
+    // The probabilities add up to a little less than rand, as after rounding errors: the outcome is the last
+    // basis vector, in the order of the sorted array.
+    for (auto rand : {1. - 1e-15, 1.}) {
+        QuantumState victim(2, SparseStorage::SortedArray);
+        victim.testInitialize({{"01", 0.6}, {"10", 0.8 * (1 - 1e-14)}});
+
+        EXPECT_NO_THROW(victim.measureAll([rand]() { return rand; }));
+        EXPECT_EQ(victim.getMeasurementRegister(), BasisVector("10"));
+        checkEq(victim, {0, 0, 1, 0});
+    }
+
+    // Groups after the first one also get rand = 1.
+    QuantumState victim(4);
+    victim.apply<1>(gates::H, std::array<QubitIndex, 1>{QubitIndex{0}});
+    victim.apply<1>(gates::H, std::array<QubitIndex, 1>{QubitIndex{2}});
+    ASSERT_EQ(victim.getNumberOfQubitGroups(), 2);
+    EXPECT_NO_THROW(victim.measureAll([]() { return 1.; }));
+    std::size_t nonZeros = 0;
+    victim.forEach([&nonZeros](auto const &) { ++nonZeros; });
+    EXPECT_EQ(nonZeros, 1);
+}
+
 TEST_F(QuantumStateTest, prep__case_0) {
     // Prep leads to a non-deterministic global quantum state because of the state collapse.
     QuantumState victim(2);
@@ -128,4 +185,313 @@ TEST_F(QuantumStateTest, prep__case_1) {
     checkEq(victim, {0, 0, 1, 0});
 }
 
+TEST_F(QuantumStateTest, qubit_groups__merged_by_multi_qubit_gates) {
+    QuantumState victim(4);
+    EXPECT_EQ(victim.getNumberOfQubitGroups(), 0);
+
+    victim.apply<1>(gates::H, std::array<QubitIndex, 1>{QubitIndex{0}});
+    victim.apply<1>(gates::H, std::array<QubitIndex, 1>{QubitIndex{2}});
+    EXPECT_EQ(victim.getNumberOfQubitGroups(), 2);
+    checkEq(victim, {0.5, 0.5, 0, 0, 0.5, 0.5, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0});
+
+    victim.apply<2>(gates::CNOT, std::array<QubitIndex, 2>{QubitIndex{0}, QubitIndex{3}});
+    EXPECT_EQ(victim.getNumberOfQubitGroups(), 2);
+    checkEq(victim, {0.5, 0, 0, 0, 0.5, 0, 0, 0, 0, 0.5, 0, 0, 0, 0.5, 0, 0});
+
+    victim.apply<2>(gates::CZ, std::array<QubitIndex, 2>{QubitIndex{2}, QubitIndex{3}});
+    EXPECT_EQ(victim.getNumberOfQubitGroups(), 1);
+    checkEq(victim, {0.5, 0, 0, 0, 0.5, 0, 0, 0, 0, 0.5, 0, 0, 0, -0.5, 0, 0});
+}
+
+TEST_F(QuantumStateTest, qubit_groups__measured_qubit_is_split_off) {
+    QuantumState victim(3);
+    victim.apply<1>(gates::H, std::array<QubitIndex, 1>{QubitIndex{0}});
+    victim.apply<2>(gates::CNOT, std::array<QubitIndex, 2>{QubitIndex{0}, QubitIndex{1}});
+    victim.apply<1>(gates::H, std::array<QubitIndex, 1>{QubitIndex{2}});
+    victim.apply<2>(gates::CNOT, std::array<QubitIndex, 2>{QubitIndex{1}, QubitIndex{2}});
+    EXPECT_EQ(victim.getNumberOfQubitGroups(), 1);
+
+    victim.measure(QubitIndex{1}, []() { return 0.1; });
+    EXPECT_EQ(victim.getMeasurementRegister(), BasisVector("010"));
+    EXPECT_EQ(victim.getNumberOfQubitGroups(), 2);
+    checkEq(victim, {0, 0, 0, 1 / std::sqrt(2), 0, 0, 0, 1 / std::sqrt(2)});
+
+    victim.measure(QubitIndex{0}, []() { return 0.9; });
+    EXPECT_EQ(victim.getMeasurementRegister(), BasisVector("011"));
+    checkEq(victim, {0, 0, 0, 1 / std::sqrt(2), 0, 0, 0, 1 / std::sqrt(2)});
+
+    victim.prep(QubitIndex{1}, []() { return 0.5; });
+    EXPECT_EQ(victim.getMeasurementRegister(), BasisVector("001"));
+    checkEq(victim, {0, 1 / std::sqrt(2), 0, 0, 0, 1 / std::sqrt(2), 0, 0});
+}
+
+TEST_F(QuantumStateTest, qubit_groups__global_phase_is_kept) {
+    QuantumState victim(2);
+    victim.apply<1>(gates::Y, std::array<QubitIndex, 1>{QubitIndex{0}});
+    checkEq(victim, {0, 1i, 0, 0});
+
+    victim.measure(QubitIndex{0}, []() { return 0.5; });
+    checkEq(victim, {0, 1i, 0, 0});
+
+    victim.prep(QubitIndex{0}, []() { return 0.5; });
+    checkEq(victim, {1i, 0, 0, 0});
+}
+
+TEST_F(QuantumStateTest, qubit_groups__measure_all) {
+    QuantumState victim(3);
+    victim.apply<1>(gates::H, std::array<QubitIndex, 1>{QubitIndex{0}});
+    victim.apply<1>(gates::X, std::array<QubitIndex, 1>{QubitIndex{1}});
+    victim.apply<1>(gates::H, std::array<QubitIndex, 1>{QubitIndex{2}});
+    victim.apply<1>(gates::Z, std::array<QubitIndex, 1>{QubitIndex{2}});
+
+    // Which basis vector is measured depends on the iteration order of flat_hash_map, which is unspecified.
+    victim.measureAll([]() { return 0.25; });
+    EXPECT_EQ(victim.getNumberOfQubitGroups(), 3);
+    EXPECT_TRUE(victim.getMeasurementRegister().test(1));
+
+    std::size_t nonZeros = 0;
+    victim.forEach([&nonZeros, &victim](auto const &kv) {
+        EXPECT_EQ(kv.first, victim.getMeasurementRegister());
+        EXPECT_NEAR(std::abs(kv.second), 1, .00000000000001);
+        ++nonZeros;
+    });
+    EXPECT_EQ(nonZeros, 1);
+}
+
+TEST_F(QuantumStateTest, repeated_syndrome_extraction) {
+    QuantumState victim(3);
+    auto extractParity = [&victim]() {
+        victim.apply<2>(gates::CNOT, std::array<QubitIndex, 2>{QubitIndex{0}, QubitIndex{2}});
+        victim.apply<2>(gates::CNOT, std::array<QubitIndex, 2>{QubitIndex{1}, QubitIndex{2}});
+        victim.measure(QubitIndex{2}, []() { return 0.5; });
+    };
+
+    victim.apply<1>(gates::H, std::array<QubitIndex, 1>{QubitIndex{0}});
+    victim.apply<2>(gates::CNOT, std::array<QubitIndex, 2>{QubitIndex{0}, QubitIndex{1}});
+    extractParity();
+    EXPECT_FALSE(victim.getMeasurementRegister().test(2));
+    checkEq(victim, {1 / std::sqrt(2), 0, 0, 1 / std::sqrt(2), 0, 0, 0, 0});
+
+    victim.apply<1>(gates::X, std::array<QubitIndex, 1>{QubitIndex{0}});
+    extractParity();
+    EXPECT_TRUE(victim.getMeasurementRegister().test(2));
+    EXPECT_EQ(victim.getNumberOfQubitGroups(), 2);
+    checkEq(victim, {0, 0, 0, 0, 0, 1 / std::sqrt(2), 1 / std::sqrt(2), 0});
+
+    victim.prep(QubitIndex{2}, []() { return 0.5; });
+    checkEq(victim, {0, 1 / std::sqrt(2), 1 / std::sqrt(2), 0, 0, 0, 0, 0});
+
+    // Outcome 1, and q0 is reset out of its group.
+    victim.prep(QubitIndex{0}, []() { return 0.1; });
+    checkEq(victim, {1, 0, 0, 0, 0, 0, 0, 0});
+
+    victim.apply<1>(gates::X, std::array<QubitIndex, 1>{QubitIndex{1}});
+    victim.apply<2>(gates::CNOT, std::array<QubitIndex, 2>{QubitIndex{1}, QubitIndex{0}});
+    checkEq(victim, {0, 0, 0, 1, 0, 0, 0, 0});
+    extractParity();
+    EXPECT_FALSE(victim.getMeasurementRegister().test(2));
+    checkEq(victim, {0, 0, 0, 1, 0, 0, 0, 0});
+}
+
+TEST_F(QuantumStateTest, amplitude_and_marginal_queries) {
+    QuantumState victim(5);
+    victim.apply<1>(gates::H, std::array<QubitIndex, 1>{QubitIndex{0}});
+    victim.apply<2>(gates::CNOT, std::array<QubitIndex, 2>{QubitIndex{0}, QubitIndex{3}});
+    victim.apply<1>(gates::RX(0.3), std::array<QubitIndex, 1>{QubitIndex{1}});
+    victim.apply<1>(gates::X, std::array<QubitIndex, 1>{QubitIndex{4}});
+    victim.apply<2>(gates::CR(0.7), std::array<QubitIndex, 2>{QubitIndex{4}, QubitIndex{1}});
+    victim.measure(QubitIndex{4}, []() { return 0.2; });
+    EXPECT_EQ(victim.getNumberOfQubitGroups(), 3);
+
+    std::vector<std::complex<double>> expected(1 << 5, 0);
+    victim.forEach([&expected](auto const &kv) { expected[kv.first.toSizeT()] = kv.second; });
+
+    for (std::size_t i = 0; i < expected.size(); ++i) {
+        auto amplitude = victim.getAmplitude(BasisVector::fromSizeT(i));
+        EXPECT_NEAR(amplitude.real(), expected[i].real(), config::EPS);
+        EXPECT_NEAR(amplitude.imag(), expected[i].imag(), config::EPS);
+    }
+    EXPECT_EQ(victim.getAmplitude(BasisVector::fromSizeT(1 << 5)), std::complex<double>(0));
+
+    std::array<QubitIndex, 3> qubits{QubitIndex{3}, QubitIndex{2}, QubitIndex{1}};
+    auto marginals = victim.getMarginalProbabilities(qubits);
+    std::vector<double> expectedMarginals(8, 0.);
+    for (std::size_t i = 0; i < expected.size(); ++i) {
+        expectedMarginals[utils::getBit(i, 3) | utils::getBit(i, 2) << 1 | utils::getBit(i, 1) << 2] +=
+            std::norm(expected[i]);
+    }
+    ASSERT_EQ(marginals.size(), 8);
+    for (std::size_t i = 0; i < marginals.size(); ++i) {
+        EXPECT_NEAR(marginals[i], expectedMarginals[i], config::EPS);
+    }
+
+    EXPECT_THROW((void) victim.getMarginalProbabilities(std::array<QubitIndex, 1>{QubitIndex{5}}), std::runtime_error);
+    EXPECT_THROW((void) victim.getMarginalProbabilities(std::array<QubitIndex, 2>{QubitIndex{1}, QubitIndex{1}}),
+                 std::runtime_error);
+}
+
+TEST_F(QuantumStateTest, float_precision) {
+    QuantumState expected(4);
+    BasicQuantumState<float> victim(4);
+    auto applyGates = [](auto &state) {
+        state.template apply<1>(gates::H, std::array<QubitIndex, 1>{QubitIndex{0}});
+        state.template apply<2>(gates::CNOT, std::array<QubitIndex, 2>{QubitIndex{0}, QubitIndex{3}});
+        state.template apply<1>(gates::RX(0.3), std::array<QubitIndex, 1>{QubitIndex{1}});
+        state.template apply<3>(gates::TOFFOLI, std::array<QubitIndex, 3>{QubitIndex{3}, QubitIndex{1}, QubitIndex{2}});
+        state.template apply<1>(gates::T, std::array<QubitIndex, 1>{QubitIndex{2}});
+        state.measure(QubitIndex{1}, []() { return 0.9; });
+    };
+    applyGates(expected);
+    applyGates(victim);
+
+    std::vector<std::pair<BasisVector, std::complex<double>>> expectedAmplitudes;
+    expected.forEach([&expectedAmplitudes](auto const &kv) { expectedAmplitudes.push_back(kv); });
+
+    std::size_t i = 0;
+    victim.forEach([&i, &expectedAmplitudes](auto const &kv) {
+        static_assert(std::is_same_v<std::decay_t<decltype(kv.second)>, std::complex<float>>);
+        ASSERT_LT(i, expectedAmplitudes.size());
+        EXPECT_EQ(kv.first, expectedAmplitudes[i].first);
+        EXPECT_NEAR(kv.second.real(), expectedAmplitudes[i].second.real(), config::EPSILON<float>);
+        EXPECT_NEAR(kv.second.imag(), expectedAmplitudes[i].second.imag(), config::EPSILON<float>);
+        ++i;
+    });
+    EXPECT_EQ(i, expectedAmplitudes.size());
+    EXPECT_EQ(victim.getMeasurementRegister(), expected.getMeasurementRegister());
+}
+
+TEST_F(QuantumStateTest, memory_tracker) {
+    MemoryTracker tracker;
+    {
+        QuantumState victim(10);
+        victim.setMemoryTracker(&tracker);
+        for (std::size_t q = 0; q < 10; ++q) {
+            victim.apply<1>(gates::H, std::array<QubitIndex, 1>{QubitIndex{q}});
+            victim.apply<2>(gates::CNOT, std::array<QubitIndex, 2>{QubitIndex{q}, QubitIndex{(q + 1) % 10}});
+        }
+        EXPECT_EQ(tracker.getBytes(), victim.getMemoryBytes());
+        EXPECT_GE(victim.getMemoryBytes(), 1024 * sizeof(std::pair<BasisVector const, std::complex<double>>));
+        EXPECT_LE(victim.getMemoryBytes(), BasicSparseArray<double>::getMaxMemoryBytes(1024, SparseStorage::HashMap));
+
+        // A copy reports its own bytes, without those of the scratch amplitudes.
+        std::uint64_t copyBytes = 0;
+        {
+            auto copy = victim;
+            copyBytes = copy.getMemoryBytes();
+            EXPECT_LT(copyBytes, victim.getMemoryBytes());
+            EXPECT_EQ(tracker.getBytes(), victim.getMemoryBytes() + copyBytes);
+        }
+        EXPECT_EQ(tracker.getBytes(), victim.getMemoryBytes());
+        EXPECT_EQ(tracker.getPeakBytes(), victim.getMemoryBytes() + copyBytes);
+
+        // A move takes the bytes over, and leaves an empty state without tracker.
+        auto victimBytes = victim.getMemoryBytes();
+        auto moved = std::move(victim);
+        EXPECT_EQ(moved.getMemoryBytes(), victimBytes);
+        EXPECT_EQ(tracker.getBytes(), victimBytes);
+        EXPECT_EQ(victim.getNumberOfQubitGroups(), 0);
+        EXPECT_EQ(victim.getAmplitude(BasisVector{}), std::complex<double>(1.));
+        EXPECT_EQ(tracker.getPeakBytes(), victimBytes + copyBytes);
+    }
+    EXPECT_EQ(tracker.getBytes(), 0);
+
+    // The state that would exceed the budget throws, without counting its bytes.
+    MemoryTracker smallTracker(4096);
+    QuantumState victim(10);
+    victim.setMemoryTracker(&smallTracker);
+    EXPECT_THROW(
+        {
+            for (std::size_t q = 0; q < 10; ++q) {
+                victim.apply<1>(gates::H, std::array<QubitIndex, 1>{QubitIndex{q}});
+                victim.apply<2>(gates::CNOT, std::array<QubitIndex, 2>{QubitIndex{q}, QubitIndex{(q + 1) % 10}});
+            }
+        },
+        std::runtime_error);
+    EXPECT_LE(smallTracker.getPeakBytes(), 4096);
+    victim.setMemoryTracker(nullptr);
+    EXPECT_EQ(smallTracker.getBytes(), 0);
+}
+
+TEST_F(QuantumStateTest, memory_tracker_checks_before_the_gate) {
+    QuantumState victim(9);
+    for (std::size_t q = 0; q < 8; ++q) {
+        victim.apply<1>(gates::H, std::array<QubitIndex, 1>{QubitIndex{q}});
+    }
+    for (std::size_t q = 0; q < 7; ++q) {
+        victim.apply<2>(gates::CNOT, std::array<QubitIndex, 2>{QubitIndex{q}, QubitIndex{q + 1}});
+    }
+
+    // The 8 qubits of the group have all their 256 basis vectors, so this gate cannot grow the amplitudes.
+    MemoryTracker tracker(victim.getMemoryBytes() + 64);
+    victim.setMemoryTracker(&tracker);
+    victim.apply<1>(gates::H, std::array<QubitIndex, 1>{QubitIndex{0}});
+    victim.setMemoryTracker(nullptr);
+
+    // Once the group has 9 qubits, the same gate could double them: it throws before it runs.
+    victim.apply<2>(gates::CNOT, std::array<QubitIndex, 2>{QubitIndex{0}, QubitIndex{8}});
+    ASSERT_EQ(victim.getNumberOfQubitGroups(), 1);
+    auto bytes = victim.getMemoryBytes();
+    auto getAmplitudes = [&victim] {
+        std::vector<std::complex<double>> result;
+        for (std::size_t i = 0; i < (1 << 9); ++i) {
+            result.push_back(victim.getAmplitude(BasisVector::fromSizeT(i)));
+        }
+        return result;
+    };
+    auto amplitudes = getAmplitudes();
+    MemoryTracker smallTracker(bytes + 64);
+    victim.setMemoryTracker(&smallTracker);
+    EXPECT_THROW(victim.apply<1>(gates::H, std::array<QubitIndex, 1>{QubitIndex{0}}), std::runtime_error);
+    EXPECT_EQ(victim.getMemoryBytes(), bytes);
+    EXPECT_EQ(smallTracker.getPeakBytes(), bytes);
+    EXPECT_EQ(getAmplitudes(), amplitudes);
+    victim.setMemoryTracker(nullptr);
+}
+
+TEST_F(QuantumStateTest, sorted_array) {
+    QuantumState expected(5);
+    QuantumState victim(5, SparseStorage::SortedArray);
+    EXPECT_EQ(victim.getSparseStorage(), SparseStorage::SortedArray);
+    auto applyGates = [](auto &state) {
+        state.template apply<1>(gates::H, std::array<QubitIndex, 1>{QubitIndex{0}});
+        state.template apply<1>(gates::H, std::array<QubitIndex, 1>{QubitIndex{4}});
+        state.template apply<1>(gates::RX(0.3), std::array<QubitIndex, 1>{QubitIndex{1}});
+        state.template apply<2>(gates::CNOT, std::array<QubitIndex, 2>{QubitIndex{4}, QubitIndex{2}});
+        state.measure(QubitIndex{0}, []() { return 0.1; });
+        state.template apply<3>(gates::TOFFOLI, std::array<QubitIndex, 3>{QubitIndex{1}, QubitIndex{4}, QubitIndex{3}});
+        std::array<QubitIndex, 2> const controls{QubitIndex{2}, QubitIndex{3}};
+        state.applyControlled(gates::RY(0.7), controls, QubitIndex{0});
+        state.template apply<2>(gates::SWAP, std::array<QubitIndex, 2>{QubitIndex{0}, QubitIndex{1}});
+        state.measure(QubitIndex{2}, []() { return 0.2; });
+        state.prep(QubitIndex{4}, []() { return 0.3; });
+        state.template apply<1>(gates::T, std::array<QubitIndex, 1>{QubitIndex{3}});
+    };
+    applyGates(expected);
+    applyGates(victim);
+
+    std::vector<std::pair<BasisVector, std::complex<double>>> expectedAmplitudes;
+    expected.forEach([&expectedAmplitudes](auto const &kv) { expectedAmplitudes.push_back(kv); });
+
+    std::size_t i = 0;
+    victim.forEach([&i, &expectedAmplitudes](auto const &kv) {
+        ASSERT_LT(i, expectedAmplitudes.size());
+        EXPECT_EQ(kv.first, expectedAmplitudes[i].first);
+        EXPECT_NEAR(kv.second.real(), expectedAmplitudes[i].second.real(), config::EPS);
+        EXPECT_NEAR(kv.second.imag(), expectedAmplitudes[i].second.imag(), config::EPS);
+        ++i;
+    });
+    EXPECT_EQ(i, expectedAmplitudes.size());
+    EXPECT_EQ(victim.getMeasurementRegister(), expected.getMeasurementRegister());
+
+    for (auto const &[basisVector, amplitude] : expectedAmplitudes) {
+        EXPECT_NEAR(std::abs(victim.getAmplitude(basisVector) - amplitude), 0, config::EPS);
+    }
+    std::array<QubitIndex, 3> const qubits{QubitIndex{3}, QubitIndex{0}, QubitIndex{1}};
+    auto marginals = victim.getMarginalProbabilities(qubits);
+    auto expectedMarginals = expected.getMarginalProbabilities(qubits);
+    for (std::size_t j = 0; j < marginals.size(); ++j) {
+        EXPECT_NEAR(marginals[j], expectedMarginals[j], config::EPS);
+    }
+}
+
 } // namespace qx::core
@@ -0,0 +1,132 @@
+#include "qx/DenseStateVector.hpp"
+#include "qx/ErrorModels.hpp"
+#include "qx/Gates.hpp"
+#include "qx/QubitReordering.hpp"
+#include "qx/Random.hpp"
+
+#include <absl/container/flat_hash_map.h>
+#include <gtest/gtest.h>
+
+
+namespace qx {
+
+class QubitReorderingTest : public ::testing::Test {
+public:
+    static void addH(Circuit &circuit, std::size_t qubit) {
+        circuit.addInstruction(Circuit::Unitary<1>{ gates::H, { core::QubitIndex{ qubit } } });
+    }
+
+    static std::vector<std::size_t> getHotQubits(Circuit::Instruction const &instruction) {
+        auto const *qubitLayout = std::get_if<Circuit::QubitLayout>(&instruction);
+        EXPECT_NE(qubitLayout, nullptr);
+        std::vector<std::size_t> result;
+        if (qubitLayout) {
+            for (auto const &qubit : qubitLayout->hotQubits) {
+                result.push_back(qubit.value);
+            }
+        }
+        return result;
+    }
+
+    static std::vector<std::complex<double>> toVector(core::DenseStateVector &state) {
+        std::vector<std::complex<double>> result(std::size_t{ 1 } << state.getNumberOfQubits(), 0);
+        state.forEach([&result](auto const &kv) { result[kv.first.toSizeT()] = kv.second; });
+        return result;
+    }
+};
+
+TEST_F(QubitReorderingTest, layout_per_window) {
+    Circuit circuit("bell", 3);
+    for (std::size_t q : { 4, 4, 5, 4 }) {
+        addH(circuit, q);
+    }
+    circuit.addInstruction(Circuit::MeasureAll{});
+    for (std::size_t q : { 5, 4, 4, 5 }) {
+        addH(circuit, q);
+    }
+    for (std::size_t q : { 0, 0, 0, 1 }) {
+        addH(circuit, q);
+    }
+
+    auto reordered = reorderQubits(circuit, 2, 4);
+    EXPECT_EQ(reordered.getName(), "bell");
+    EXPECT_EQ(reordered.getIterations(), 3);
+
+    // The second window has the same two hottest qubits as the first one, so there is no layout before it.
+    auto const &instructions = reordered.getControlledInstructions();
+    ASSERT_EQ(instructions.size(), 15);
+    EXPECT_EQ(getHotQubits(instructions[0].instruction), (std::vector<std::size_t>{ 4, 5 }));
+    EXPECT_TRUE(std::holds_alternative<Circuit::MeasureAll>(instructions[5].instruction));
+    EXPECT_EQ(getHotQubits(instructions[10].instruction), (std::vector<std::size_t>{ 0, 1 }));
+}
+
+TEST_F(QubitReorderingTest, no_gates) {
+    Circuit circuit;
+    circuit.addInstruction(Circuit::Measure{ core::QubitIndex{ 0 } });
+
+    EXPECT_EQ(reorderQubits(circuit, 2).getNumberOfInstructions(), 1);
+}
+
+TEST_F(QubitReorderingTest, fewer_block_swaps_and_same_state) {
+    // Cycling over one more qubit than there are in-block positions: the least recently used in-block qubit
+    // is always the next one needed, so without hint every gate swaps a block.
+    std::size_t const n = 6;
+    Circuit circuit;
+    for (std::size_t round = 0; round < 20; ++round) {
+        for (std::size_t q = 0; q < n; ++q) {
+            circuit.addInstruction(Circuit::Unitary<1>{ gates::RX(0.1 * static_cast<double>(round + q)),
+                { core::QubitIndex{ q } } });
+        }
+        circuit.addInstruction(Circuit::Unitary<2>{ gates::CNOT,
+            { core::QubitIndex{ round % n }, core::QubitIndex{ (round + 1) % n } } });
+    }
+
+    core::DenseStateVector expected(n, "", 5);
+    circuit.execute(expected, std::monostate{});
+
+    core::DenseStateVector victim(n, "", 5);
+    reorderQubits(circuit, victim.getBlockQubits()).execute(victim, std::monostate{});
+
+    EXPECT_LT(victim.getNumberOfBlockSwaps(), expected.getNumberOfBlockSwaps());
+    auto expectedVector = toVector(expected);
+    auto actualVector = toVector(victim);
+    for (std::size_t i = 0; i < expectedVector.size(); ++i) {
+        EXPECT_NEAR(std::abs(actualVector[i] - expectedVector[i]), 0., config::EPS);
+    }
+}
+
+TEST_F(QubitReorderingTest, same_depolarizing_errors) {
+    std::size_t const n = 6;
+    Circuit circuit;
+    for (std::size_t round = 0; round < 4; ++round) {
+        for (std::size_t q = 0; q < n; ++q) {
+            addH(circuit, q);
+            circuit.addInstruction(Circuit::Unitary<2>{ gates::CNOT,
+                { core::QubitIndex{ q }, core::QubitIndex{ (q + round + 1) % n } } });
+        }
+    }
+    // Unlike MeasureAll, which goes through the amplitudes in the order in which they are stored, a measurement of one
+    // qubit draws the same outcome from the same random number whatever the layout.
+    for (std::size_t q = 0; q < n; ++q) {
+        circuit.addInstruction(Circuit::Measure{ core::QubitIndex{ q } });
+    }
+    auto reordered = reorderQubits(circuit, 3, 8);
+    ASSERT_GT(reordered.getNumberOfInstructions(), circuit.getNumberOfInstructions());
+
+    // The layout hints draw no random numbers, so with the same seed, every shot gets the same errors and outcomes.
+    error_models::DepolarizingChannel const depolarizingChannel(0.2);
+    auto getCounts = [&depolarizingChannel](Circuit const &c) {
+        random::seed(123);
+        core::DenseStateVector state(n, "", 3);
+        absl::flat_hash_map<std::size_t, std::size_t> result;
+        for (std::size_t shot = 0; shot < 200; ++shot) {
+            state.reset();
+            c.execute(state, depolarizingChannel);
+            ++result[state.getMeasurementRegister().toSizeT()];
+        }
+        return result;
+    };
+    EXPECT_EQ(getCounts(reordered), getCounts(circuit));
+}
+
+}  // namespace qx
@@ -167,4 +167,63 @@ TEST_F(RandomTestThirdSeedTest, kolmogorov_smirnov_test_for_random_integer) {
         [&min, &max](double x) { return uniformMinMaxIntegerDistribution(min, max, x); });
 }
 
+TEST_F(RandomTestFirstSeedTest, kolmogorov_smirnov_test_for_random_geometric) {
+    std::size_t sampleSize = 100000;
+    double p = 0.05;
+    std::vector<double> samples(sampleSize);
+    std::generate(samples.begin(), samples.end(), [p]() { return static_cast<double>(randomGeometric(p)); });
+
+    checkKolmogorovSmirnov(samples,
+        [p](double x) { return x < 0 ? 0. : 1 - std::pow(1 - p, std::floor(x) + 1); });
+}
+
+TEST_F(RandomTest, random_geometric_edge_cases) {
+    EXPECT_EQ(randomGeometric(1.), 0);
+    EXPECT_EQ(randomGeometric(0.), static_cast<std::uint64_t>(1) << 62);
+}
+
+TEST_F(RandomTestFirstSeedTest, random_binomial) {
+    for (double p : {0.03, 0.5, 0.8}) {
+        std::uint64_t const n = 1000;
+        std::size_t const samples = 2000;
+        double sum = 0.;
+        double sumOfSquares = 0.;
+        for (std::size_t i = 0; i < samples; ++i) {
+            auto x = static_cast<double>(randomBinomial(n, p));
+            EXPECT_LE(x, static_cast<double>(n));
+            sum += x;
+            sumOfSquares += x * x;
+        }
+
+        auto mean = sum / samples;
+        auto variance = sumOfSquares / samples - mean * mean;
+        EXPECT_NEAR(mean, n * p, 5 * std::sqrt(n * p * (1 - p) / samples));
+        EXPECT_NEAR(variance / (n * p * (1 - p)), 1., 0.15);
+    }
+
+    EXPECT_EQ(randomBinomial(10, 0.), 0);
+    EXPECT_EQ(randomBinomial(10, 1.), 10);
+    EXPECT_EQ(randomBinomial(0, 0.5), 0);
+}
+
+TEST_F(RandomTestFirstSeedTest, random_binomial_large_n) {
+    // Trial by trial, this would take about 10^15 random numbers.
+    std::uint64_t const n = 1'000'000'000'000;
+    for (double p : {0.3, 0.5}) {
+        std::size_t const samples = 5000;
+        double sum = 0.;
+        double sumOfSquares = 0.;
+        for (std::size_t i = 0; i < samples; ++i) {
+            auto x = static_cast<double>(randomBinomial(n, p));
+            sum += x;
+            sumOfSquares += x * x;
+        }
+
+        auto mean = sum / samples;
+        auto variance = sumOfSquares / samples - mean * mean;
+        EXPECT_NEAR(mean, n * p, 5 * std::sqrt(n * p * (1 - p) / samples));
+        EXPECT_NEAR(variance / (n * p * (1 - p)), 1., 0.15);
+    }
+}
+
 } // namespace qx::random
@@ -0,0 +1,134 @@
+#include "qx/Core.hpp"
+#include "qx/Random.hpp"
+#include "qx/SimulationResult.hpp"
+
+#include <cstdio>  // remove
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <iterator>  // istreambuf_iterator
+#include <random>  // random_device
+#include <stdexcept>  // runtime_error
+#include <string>
+
+
+namespace qx {
+
+class SimulationResultTest : public ::testing::Test {
+public:
+    static std::vector<std::uint8_t> readFile(std::string const &filePath) {
+        std::ifstream file(filePath, std::ios::binary);
+        return { std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+    }
+};
+
+TEST_F(SimulationResultTest, shot_records_are_bit_packed_in_order) {
+    ShotRecorder victim(10);
+    victim.append(BasisVector("1000000001"));
+    victim.append(BasisVector("0000000110"), 2);
+    victim.append(BasisVector("0100000000"));
+
+    auto records = victim.finish();
+    EXPECT_EQ(records.number_of_bits, 10);
+    EXPECT_EQ(records.bytes_per_shot, 2);
+    EXPECT_EQ(records.number_of_shots, 4);
+    EXPECT_EQ(records.bytes, (std::vector<std::uint8_t>{ 0x01, 0x02, 0x06, 0x00, 0x06, 0x00, 0x00, 0x01 }));
+}
+
+TEST_F(SimulationResultTest, shots_that_ran_together_are_shuffled) {
+    random::seed(123);
+    std::size_t const shotsPerRegister = 1000;
+    ShotRecorder victim(8);
+    victim.appendUnordered(BasisVector("00000001"), shotsPerRegister);
+    victim.appendUnordered(BasisVector("00000010"), shotsPerRegister);
+    victim.appendUnordered(BasisVector("00000001"), shotsPerRegister);
+    victim.append(BasisVector("10000000"));
+
+    auto records = victim.finish();
+    ASSERT_EQ(records.number_of_shots, 3 * shotsPerRegister + 1);
+    EXPECT_EQ(records.bytes.back(), 0x80);
+
+    // In a random order, about 4/9 of consecutive shots got different registers, rather than 1 in 1000.
+    std::size_t ones = 0;
+    std::size_t changes = 0;
+    for (std::size_t shot = 0; shot < 3 * shotsPerRegister; ++shot) {
+        ones += records.bytes[shot] == 0x01;
+        changes += shot > 0 && records.bytes[shot] != records.bytes[shot - 1];
+    }
+    EXPECT_EQ(ones, 2 * shotsPerRegister);
+    EXPECT_NEAR(static_cast<double>(changes) / (3 * shotsPerRegister), 4. / 9, 0.05);
+}
+
+TEST_F(SimulationResultTest, shot_records_are_written_to_file_in_chunks) {
+    // Unique per run, since ctest -j runs the tests in parallel processes.
+    auto filePath = (std::filesystem::temp_directory_path() /
+        ("qx_shot_records_test_" + std::to_string(std::random_device{}()) + ".bin")).string();
+
+    // Enough shots for several chunks, with a last chunk that is not full.
+    std::size_t numberOfShots = 2 * config::SHOT_RECORD_CHUNK_BYTES / 3 + 5;
+    std::vector<std::uint8_t> expected;
+    {
+        ShotRecorder victim(20, filePath);
+        for (std::size_t shot = 0; shot < numberOfShots; ++shot) {
+            auto measurementRegister = BasisVector::fromSizeT(shot % (1 << 20));
+            victim.append(measurementRegister);
+            for (std::size_t byte = 0; byte < 3; ++byte) {
+                expected.push_back(static_cast<std::uint8_t>(measurementRegister.toSizeT() >> (8 * byte)));
+            }
+        }
+
+        auto records = victim.finish();
+        EXPECT_EQ(records.number_of_shots, numberOfShots);
+        EXPECT_EQ(records.bytes_per_shot, 3);
+        EXPECT_TRUE(records.bytes.empty());
+    }
+
+    EXPECT_EQ(readFile(filePath), expected);
+    std::remove(filePath.c_str());
+
+    EXPECT_THROW(ShotRecorder(4, "/nonexistent/qx_shot_records_test.bin"), std::runtime_error);
+}
+
+TEST_F(SimulationResultTest, recorded_shots_agree_with_the_results) {
+    SimulationResultAccumulator victim(2);
+    victim.recordShots("", error_models::ReadoutError(0., 1.), { 0 });
+    victim.append(BasisVector("11"), 3);
+    victim.append(BasisVector("00"));
+
+    // The bit of qubit 0 is always read as 0, and that of qubit 1 is not measured.
+    core::QuantumState quantumState(2);
+    auto result = victim.get(quantumState, false);
+    EXPECT_EQ(result.results, (SimulationResult::Results{ { "00", 1 }, { "10", 3 } }));
+    ASSERT_TRUE(result.shot_records.has_value());
+    EXPECT_EQ(result.shot_records->bytes, (std::vector<std::uint8_t>{ 0x02, 0x02, 0x02, 0x00 }));
+}
+
+TEST_F(SimulationResultTest, single_shots_that_ran_together_are_shuffled_with_the_others) {
+    // Branches of 1 and of several shots, as from Circuit::executeBranching, with and without readout error.
+    for (auto readoutError : { std::optional<error_models::ReadoutError>{},
+                               std::optional<error_models::ReadoutError>{ error_models::ReadoutError(0., 0.) } }) {
+        random::seed(123);
+        std::size_t const numberOfGroups = 1000;
+        SimulationResultAccumulator victim(8);
+        victim.recordShots("", readoutError, { 0, 1 });
+        for (std::size_t group = 0; group < numberOfGroups; ++group) {
+            victim.appendUnordered(BasisVector("00000001"), 1);
+            victim.appendUnordered(BasisVector("00000010"), 2);
+        }
+
+        core::QuantumState quantumState(8);
+        auto result = victim.get(quantumState, false);
+        ASSERT_TRUE(result.shot_records.has_value());
+        auto const &bytes = result.shot_records->bytes;
+        ASSERT_EQ(bytes.size(), 3 * numberOfGroups);
+
+        // Not in blocks of the groups, where every shot of 1 would be followed by a change: about 4/9 change.
+        std::size_t changes = 0;
+        for (std::size_t shot = 1; shot < bytes.size(); ++shot) {
+            changes += bytes[shot] != bytes[shot - 1];
+        }
+        EXPECT_NEAR(static_cast<double>(changes) / bytes.size(), 4. / 9, 0.05);
+    }
+}
+
+}  // namespace qx
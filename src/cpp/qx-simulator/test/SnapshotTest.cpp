@@ -0,0 +1,171 @@
+#include "qx/DenseStateVector.hpp"
+#include "qx/Gates.hpp"
+#include "qx/Snapshot.hpp"
+
+#include <cmath>  // sqrt
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <random>  // random_device
+#include <string>
+
+
+namespace qx::core {
+
+class SnapshotTest : public ::testing::Test {
+public:
+    void SetUp() override {
+        // Unique per test and per run, since ctest -j runs the tests in parallel processes.
+        auto const *testInfo = ::testing::UnitTest::GetInstance()->current_test_info();
+        filePath = (std::filesystem::temp_directory_path() / (std::string("qx_snapshot_test_") + testInfo->name() +
+            "_" + std::to_string(std::random_device{}()) + ".bin")).string();
+    }
+
+    void TearDown() override {
+        std::filesystem::remove(filePath);
+    }
+
+    template <typename State>
+    static std::vector<std::pair<BasisVector, std::complex<double>>> getAmplitudes(State &state) {
+        std::vector<std::pair<BasisVector, std::complex<double>>> result;
+        state.forEach([&result](auto const &kv) { result.push_back(kv); });
+        return result;
+    }
+
+    static void checkEq(std::vector<std::pair<BasisVector, std::complex<double>>> const &actual,
+                        std::vector<std::pair<BasisVector, std::complex<double>>> const &expected) {
+        ASSERT_EQ(actual.size(), expected.size());
+        for (std::size_t i = 0; i < actual.size(); ++i) {
+            EXPECT_EQ(actual[i].first, expected[i].first);
+            EXPECT_NEAR(actual[i].second.real(), expected[i].second.real(), .00000000000001);
+            EXPECT_NEAR(actual[i].second.imag(), expected[i].second.imag(), .00000000000001);
+        }
+    }
+
+    std::string filePath;
+};
+
+TEST_F(SnapshotTest, sparse_round_trip) {
+    QuantumState state(40);
+    state.apply<1>(gates::H, std::array<QubitIndex, 1>{QubitIndex{3}});
+    state.apply<2>(gates::CNOT, std::array<QubitIndex, 2>{QubitIndex{3}, QubitIndex{38}});
+    state.apply<1>(gates::RY(0.4), std::array<QubitIndex, 1>{QubitIndex{20}});
+    state.getMeasurementRegister().set(7);
+
+    auto snapshot = state.getSnapshot();
+    EXPECT_EQ(snapshot.representation, Snapshot::Representation::Sparse);
+    EXPECT_EQ(snapshot.getNumberOfAmplitudes(), 4);
+
+    for (auto compress : { false, true }) {
+        saveSnapshot(snapshot, filePath, compress);
+        auto loaded = loadSnapshot(filePath);
+        EXPECT_EQ(loaded.numberOfQubits, 40);
+        EXPECT_EQ(loaded.basisVectors, snapshot.basisVectors);
+        EXPECT_EQ(loaded.amplitudes, snapshot.amplitudes);
+        EXPECT_EQ(loaded.measurementRegister, state.getMeasurementRegister());
+
+        QuantumState restored(40);
+        restored.restore(loaded);
+        EXPECT_EQ(restored.getNumberOfQubitGroups(), 1);
+        EXPECT_EQ(restored.getMeasurementRegister(), state.getMeasurementRegister());
+        checkEq(getAmplitudes(restored), getAmplitudes(state));
+    }
+}
+
+TEST_F(SnapshotTest, compression) {
+    QuantumState state(20);
+    for (std::size_t q = 0; q < 10; ++q) {
+        state.apply<1>(gates::H, std::array<QubitIndex, 1>{QubitIndex{q}});
+    }
+    auto snapshot = state.getSnapshot();
+    EXPECT_EQ(snapshot.representation, Snapshot::Representation::Sparse);
+
+    saveSnapshot(snapshot, filePath, false);
+    auto uncompressedSize = std::filesystem::file_size(filePath);
+    saveSnapshot(snapshot, filePath, true);
+    EXPECT_LT(std::filesystem::file_size(filePath), uncompressedSize * 3 / 4);
+
+    EXPECT_EQ(loadSnapshot(filePath).basisVectors, snapshot.basisVectors);
+}
+
+TEST_F(SnapshotTest, dense_representation) {
+    QuantumState state(3);
+    for (std::size_t q = 0; q < 3; ++q) {
+        state.apply<1>(gates::H, std::array<QubitIndex, 1>{QubitIndex{q}});
+    }
+
+    auto snapshot = state.getSnapshot();
+    EXPECT_EQ(snapshot.representation, Snapshot::Representation::Dense);
+    EXPECT_TRUE(snapshot.basisVectors.empty());
+    EXPECT_EQ(snapshot.getNumberOfAmplitudes(), 8);
+
+    saveSnapshot(snapshot, filePath, true);
+    EXPECT_EQ(std::filesystem::file_size(filePath), 48 + 8 * sizeof(std::complex<double>));
+
+    DenseStateVector restored(3);
+    restored.restore(loadSnapshot(filePath));
+    checkEq(getAmplitudes(restored), getAmplitudes(state));
+}
+
+TEST_F(SnapshotTest, dense_state_vector_with_block_swaps) {
+    DenseStateVector state(6, "", 3);
+    state.apply<1>(gates::H, std::array<QubitIndex, 1>{QubitIndex{5}});
+    state.apply<2>(gates::CNOT, std::array<QubitIndex, 2>{QubitIndex{5}, QubitIndex{0}});
+    state.apply<1>(gates::RX(0.1), std::array<QubitIndex, 1>{QubitIndex{4}});
+    ASSERT_GT(state.getNumberOfBlockSwaps(), 0);
+
+    saveSnapshot(state.getSnapshot(), filePath);
+
+    QuantumState sparse(6);
+    sparse.restore(loadSnapshot(filePath));
+    checkEq(getAmplitudes(sparse), getAmplitudes(state));
+
+    DenseStateVector dense(6, "", 3);
+    dense.apply<1>(gates::X, std::array<QubitIndex, 1>{QubitIndex{4}});
+    dense.restore(loadSnapshot(filePath));
+    checkEq(getAmplitudes(dense), getAmplitudes(state));
+}
+
+TEST_F(SnapshotTest, restore_keeps_global_phase_of_zero_state) {
+    QuantumState state(2);
+    state.testInitialize({{"00", std::complex<double>(0, 1)}});
+
+    QuantumState restored(2);
+    restored.restore(state.getSnapshot());
+    checkEq(getAmplitudes(restored), {{BasisVector{}, std::complex<double>(0, 1)}});
+}
+
+TEST_F(SnapshotTest, errors) {
+    QuantumState state(2);
+    state.apply<1>(gates::X, std::array<QubitIndex, 1>{QubitIndex{1}});
+    saveSnapshot(state.getSnapshot(), filePath);
+
+    QuantumState tooSmall(1);
+    EXPECT_THROW(tooSmall.restore(loadSnapshot(filePath)), std::runtime_error);
+
+    std::filesystem::resize_file(filePath, std::filesystem::file_size(filePath) - 1);
+    EXPECT_THROW(loadSnapshot(filePath), std::runtime_error);
+
+    std::ofstream(filePath) << "not a snapshot, but long enough to hold a header, which is 48 bytes";
+    EXPECT_THROW(loadSnapshot(filePath), std::runtime_error);
+
+    EXPECT_THROW(loadSnapshot(filePath + ".missing"), std::runtime_error);
+}
+
+TEST_F(SnapshotTest, unsorted_or_duplicate_basis_vectors) {
+    for (auto basisVectors : { std::vector<std::size_t>{ 3, 1 }, std::vector<std::size_t>{ 2, 2 } }) {
+        Snapshot snapshot;
+        snapshot.numberOfQubits = 2;
+        for (auto basisVector : basisVectors) {
+            snapshot.basisVectors.push_back(BasisVector::fromSizeT(basisVector));
+            snapshot.amplitudes.push_back(std::sqrt(.5));
+        }
+
+        for (auto compress : { false, true }) {
+            saveSnapshot(snapshot, filePath, compress);
+            EXPECT_THROW(loadSnapshot(filePath), std::runtime_error);
+        }
+    }
+}
+
+}  // namespace qx::core
@@ -30,4 +30,23 @@ TEST(sparse_array, set) {
 #endif
 }
 
+TEST(sparse_array, sorted_array) {
+    SparseArray victim(8, SparseStorage::SortedArray);
+
+    victim.set(BasisVector("101"), 0.5);
+    victim.set(BasisVector("001"), 0.5i);
+    victim.set(BasisVector("110"), -0.5);
+    victim.set(BasisVector("101"), 0.1);
+    victim.set(BasisVector("011"), 0);
+
+    EXPECT_EQ(victim.testToVector(),
+        std::vector<std::complex<double>>({0, 0.5i, 0, 0, 0, 0.5, -0.5, 0}));
+    EXPECT_EQ(victim.get(BasisVector("110")), -0.5);
+    EXPECT_EQ(victim.get(BasisVector("111")), 0.);
+
+    std::vector<std::size_t> order;
+    victim.forEach([&order](auto const &kv) { order.push_back(kv.first.toSizeT()); });
+    EXPECT_EQ(order, std::vector<std::size_t>({1, 5, 6}));
+}
+
 }  // namespace qx::core
@@ -0,0 +1,92 @@
+#include "qx/Gates.hpp"
+#include "qx/UnitaryMatrix.hpp"
+
+#include <gtest/gtest.h>
+
+
+namespace qx::core {
+
+class UnitaryMatrixTest : public ::testing::Test {
+public:
+    // Column j of the unitary is the state that basis vector j evolves to.
+    template <typename F> static void checkColumns(UnitaryMatrix const &victim, F &&applyGates) {
+        for (std::size_t column = 0; column < victim.getDimension(); ++column) {
+            QuantumState state(victim.getNumberOfQubits());
+            for (std::size_t q = 0; q < victim.getNumberOfQubits(); ++q) {
+                if (utils::getBit(column, q)) {
+                    state.apply<1>(gates::X, std::array<QubitIndex, 1>{QubitIndex{q}});
+                }
+            }
+            applyGates(state);
+
+            std::vector<std::complex<double>> expected(victim.getDimension(), 0.);
+            state.forEach([&expected](auto const &kv) { expected[kv.first.toSizeT()] = kv.second; });
+            for (std::size_t row = 0; row < victim.getDimension(); ++row) {
+                EXPECT_NEAR(victim.at(row, column).real(), expected[row].real(), config::EPS);
+                EXPECT_NEAR(victim.at(row, column).imag(), expected[row].imag(), config::EPS);
+            }
+        }
+    }
+};
+
+TEST_F(UnitaryMatrixTest, identity) {
+    UnitaryMatrix victim(2);
+
+    EXPECT_EQ(victim.getDimension(), 4);
+    EXPECT_EQ(victim.getEntries(), (std::vector<std::complex<double>>{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1}));
+}
+
+TEST_F(UnitaryMatrixTest, column_major) {
+    UnitaryMatrix victim(2);
+    victim.apply<2>(gates::CNOT, std::array<QubitIndex, 2>{QubitIndex{0}, QubitIndex{1}});
+
+    // Basis vector 01 (qubit 0 set) goes to 11.
+    EXPECT_EQ(victim.getEntries(), (std::vector<std::complex<double>>{1, 0, 0, 0, 0, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0}));
+}
+
+TEST_F(UnitaryMatrixTest, controlled) {
+    std::array<QubitIndex, 2> controls{QubitIndex{2}, QubitIndex{3}};
+    std::array<QubitIndex, 1> control{QubitIndex{1}};
+
+    UnitaryMatrix victim(4);
+    victim.apply<1>(gates::H, std::array<QubitIndex, 1>{QubitIndex{2}});
+    victim.applyControlled(gates::X, controls, QubitIndex{1});
+    victim.applyControlled(gates::PHASE(0.7), control, QubitIndex{3});
+
+    checkColumns(victim, [](auto &state) {
+        state.template apply<1>(gates::H, std::array<QubitIndex, 1>{QubitIndex{2}});
+        state.template apply<3>(gates::TOFFOLI, std::array<QubitIndex, 3>{QubitIndex{2}, QubitIndex{3}, QubitIndex{1}});
+        state.template apply<2>(gates::CR(0.7), std::array<QubitIndex, 2>{QubitIndex{1}, QubitIndex{3}});
+    });
+}
+
+TEST_F(UnitaryMatrixTest, same_as_state_vectors) {
+    auto applyGates = [](auto &state) {
+        state.template apply<1>(gates::H, std::array<QubitIndex, 1>{QubitIndex{0}});
+        state.template apply<1>(gates::RX(0.3), std::array<QubitIndex, 1>{QubitIndex{3}});
+        state.template apply<2>(gates::CNOT, std::array<QubitIndex, 2>{QubitIndex{0}, QubitIndex{2}});
+        state.template apply<1>(gates::T, std::array<QubitIndex, 1>{QubitIndex{2}});
+        state.template apply<3>(gates::TOFFOLI, std::array<QubitIndex, 3>{QubitIndex{2}, QubitIndex{3}, QubitIndex{1}});
+        state.template apply<2>(gates::CR(0.7), std::array<QubitIndex, 2>{QubitIndex{1}, QubitIndex{3}});
+        state.template apply<1>(gates::Y, std::array<QubitIndex, 1>{QubitIndex{3}});
+        state.template apply<2>(gates::SWAP, std::array<QubitIndex, 2>{QubitIndex{2}, QubitIndex{0}});
+    };
+
+    UnitaryMatrix victim(4);
+    applyGates(victim);
+
+    checkColumns(victim, applyGates);
+}
+
+TEST_F(UnitaryMatrixTest, column_range) {
+    UnitaryMatrix victim(2);
+    victim.apply<1>(gates::X, std::array<QubitIndex, 1>{QubitIndex{1}}, 1, 3);
+
+    EXPECT_EQ(victim.getEntries(), (std::vector<std::complex<double>>{1, 0, 0, 0, 0, 0, 0, 1, 1, 0, 0, 0, 0, 0, 0, 1}));
+}
+
+TEST_F(UnitaryMatrixTest, too_many_qubits) {
+    EXPECT_THROW(UnitaryMatrix(config::MAX_UNITARY_QUBITS + 1), std::runtime_error);
+}
+
+}  // namespace qx::core
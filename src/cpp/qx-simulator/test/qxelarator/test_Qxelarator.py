@@ -60,6 +60,216 @@ measure q
         simulation_result = qxelarator.execute_string(cqasm_string, iterations=20, seed=123)
         self.assertEqual(simulation_result.results, {"0": 12, "1": 8})
 
+    def test_amplitude_and_marginal_queries(self):
+        cqasm_string = """\
+version 3.0
+
+qubit[3] q
+
+H q[0]
+CNOT q[0], q[2]
+"""
+        options = qxelarator.SimulationOptions()
+        options.include_state = False
+        options.amplitude_queries = ["101", "001"]
+        options.marginal_qubits = [2, 1]
+        simulation_result = qxelarator.execute_string(cqasm_string, options=options)
+
+        self.assertEqual(simulation_result.state, {})
+        self.assertAlmostEqual(simulation_result.amplitudes["101"], complex(2 ** -0.5, 0.))
+        self.assertEqual(simulation_result.amplitudes["001"], complex(0., 0.))
+        self.assertEqual(len(simulation_result.marginal_probabilities), 4)
+        self.assertAlmostEqual(simulation_result.marginal_probabilities["00"], 0.5)
+        self.assertAlmostEqual(simulation_result.marginal_probabilities["01"], 0.5)
+
+    def test_error_models(self):
+        cqasm_string = """
+version 3.0
+
+qubit[2] q
+bit[2] b
+
+X q[0]
+b = measure q
+"""
+        options = qxelarator.SimulationOptions()
+        options.amplitude_damping = 1.
+        options.readout_error_zero_to_one = 1.
+        simulation_result = qxelarator.execute_string(cqasm_string, iterations=10, options=options)
+        self.assertIsInstance(simulation_result, qxelarator.SimulationResult)
+        self.assertEqual(simulation_result.results, {"11": 10})
+
+        options.depolarizing_probability = 0.1
+        simulation_error = qxelarator.execute_string(cqasm_string, options=options)
+        self.assertIsInstance(simulation_error, qxelarator.SimulationError)
+
+    def test_shot_records(self):
+        import numpy as np
+
+        cqasm_string = """
+version 3.0
+
+qubit[10] q
+bit[10] b
+
+H q[0]
+CNOT q[0], q[9]
+b = measure q
+"""
+        options = qxelarator.SimulationOptions()
+        options.record_shots = True
+        simulation_result = qxelarator.execute_string(cqasm_string, iterations=100, seed=123, options=options)
+        records = simulation_result.shot_records
+        self.assertIsInstance(records, np.ndarray)
+        self.assertEqual(records.dtype, np.uint8)
+        self.assertEqual(records.shape, (100, 2))
+
+        bits = np.unpackbits(records, axis=1, count=10, bitorder="little")
+        self.assertTrue(np.array_equal(bits[:, 0], bits[:, 9]))
+        self.assertEqual(int(bits[:, 0].sum()), simulation_result.results.get("1000000001", 0))
+
+        self.assertIsNone(qxelarator.execute_string(cqasm_string).shot_records)
+
+    def test_memory_budget(self):
+        cqasm_string = "version 3.0\nqubit[16] q\n" + "".join(f"H q[{i}]\n" for i in range(16))
+
+        estimate = qxelarator.estimate_memory_string(cqasm_string)
+        self.assertEqual(estimate["max_amplitudes"], 2 ** 16)
+
+        simulation_result = qxelarator.execute_string(cqasm_string)
+        self.assertGreater(simulation_result.amplitude_bytes, 0)
+        self.assertLessEqual(simulation_result.peak_amplitude_bytes, estimate["max_amplitude_bytes"])
+
+        options = qxelarator.SimulationOptions()
+        options.backend = qxelarator.StateBackend_Dense
+        options.max_memory_bytes = 1024
+        simulation_error = qxelarator.execute_string(cqasm_string, options=options)
+        self.assertIsInstance(simulation_error, qxelarator.SimulationError)
+
+    def test_save_and_load_snapshot(self):
+        file_path = f"test_snapshot_{os.getpid()}.qxs"
+        prepared = qxelarator.execute_string("version 3.0\nqubit[3] q\nH q[0]\nCNOT q[0], q[2]")
+        self.assertIsNone(qxelarator.save_snapshot(file_path, prepared.state, compress=True))
+
+        snapshot = qxelarator.load_snapshot(file_path)
+        self.assertIsInstance(snapshot, qxelarator.Snapshot)
+        self.assertEqual(snapshot.state.keys(), prepared.state.keys())
+        for basis_state, amplitude in prepared.state.items():
+            self.assertAlmostEqual(snapshot.state[basis_state], amplitude)
+        self.assertEqual(snapshot.measurement_register, "000")
+
+        options = qxelarator.SimulationOptions()
+        options.initial_state_file = file_path
+        simulation_result = qxelarator.execute_string("version 3.0\nqubit[3] q\nCNOT q[0], q[2]\nH q[0]",
+                                                      options=options)
+        self.assertAlmostEqual(simulation_result.state["000"], 1)
+        os.remove(file_path)
+
+        self.assertIsInstance(qxelarator.save_snapshot(file_path, {"01": 1, "2": 0}), qxelarator.SimulationError)
+        self.assertIsInstance(qxelarator.load_snapshot(file_path), qxelarator.SimulationError)
+
+    def test_get_unitary_string(self):
+        import numpy as np
+
+        unitary = qxelarator.get_unitary_string("""
+version 3.0
+
+qubit[2] q
+
+H q[0]
+CNOT q[0], q[1]
+""")
+        self.assertIsInstance(unitary, np.ndarray)
+        self.assertEqual(unitary.shape, (4, 4))
+        self.assertTrue(np.allclose(unitary @ unitary.conj().T, np.eye(4)))
+        # Column 0 is the Bell state (|00> + |11>) / sqrt(2).
+        self.assertTrue(np.allclose(unitary[:, 0], [1 / np.sqrt(2), 0, 0, 1 / np.sqrt(2)]))
+
+        simulation_error = qxelarator.get_unitary_string("version 3.0; qubit q; bit b; b = measure q; X q")
+        self.assertIsInstance(simulation_error, qxelarator.SimulationError)
+
+    def test_get_gradients_string(self):
+        import math
+
+        # cos(a/2) |00> + sin(a/2) |11>, on which CR only changes the phase of |11>.
+        gradient_result = qxelarator.get_gradients_string("""
+version 3.0
+
+qubit[2] q
+
+Ry q[0], 0.6
+CNOT q[0], q[1]
+CR q[0], q[1], 0.3
+""", {"ZI": 1., "IZ": 0.5})
+        self.assertIsInstance(gradient_result, qxelarator.GradientResult)
+        self.assertAlmostEqual(gradient_result.expectation, 1.5 * math.cos(0.6))
+        self.assertEqual(len(gradient_result.gradients), 2)
+        self.assertAlmostEqual(gradient_result.gradients[0], -1.5 * math.sin(0.6))
+        self.assertAlmostEqual(gradient_result.gradients[1], 0.)
+
+        simulation_error = qxelarator.get_gradients_string("version 3.0; qubit[2] q; Rx q[0], 0.1", {"Z": 1.})
+        self.assertIsInstance(simulation_error, qxelarator.SimulationError)
+
+    def test_submit_string(self):
+        cqasm_string = """\
+version 3.0
+
+qubit q
+
+H q
+measure q
+"""
+        progress = []
+        job = qxelarator.submit_string(cqasm_string, iterations=20, seed=123,
+                                       progress=lambda done, requested: progress.append((done, requested)))
+        simulation_result = job.wait()
+
+        self.assertTrue(job.done())
+        self.assertEqual(job.shots_done(), 20)
+        self.assertEqual(job.shots_requested(), 20)
+        self.assertIsInstance(simulation_result, qxelarator.SimulationResult)
+        self.assertEqual(simulation_result.results, {"0": 12, "1": 8})
+        self.assertEqual(progress[-1], (20, 20))
+
+    def test_submit_file_concurrently(self):
+        cqasm_file_name = os.path.join(os.path.dirname(os.path.realpath(__file__)), 'bell_pair.qasm')
+        jobs = [qxelarator.submit_file(cqasm_file_name, iterations=23) for _ in range(8)]
+
+        for job in jobs:
+            simulation_result = job.wait()
+            self.assertIsInstance(simulation_result, qxelarator.SimulationResult)
+            self.assertEqual(simulation_result.results, {"00": 23})
+
+
+    def test_execute_circuit(self):
+        circuit = qxelarator.Circuit(2)
+        circuit.add_gate("X", [0]).add_gate("Rx", [1], 3.141592653589793)
+        circuit.add_measure(0)
+        circuit.add_gate("X", [1], condition=[0])
+        circuit.add_measure_all()
+        self.assertIsNone(circuit.error())
+
+        simulation_result = qxelarator.execute_circuit(circuit, iterations=10)
+        self.assertIsInstance(simulation_result, qxelarator.SimulationResult)
+        self.assertEqual(simulation_result.results, {"01": 10})
+
+        circuit.add_gate("CNOT", [0, 5])
+        self.assertEqual(circuit.error(), "Qubit 5 is out of range, the circuit has 2 qubits")
+        simulation_error = qxelarator.execute_circuit(circuit)
+        self.assertIsInstance(simulation_error, qxelarator.SimulationError)
+
+    def test_submit_circuits(self):
+        jobs = []
+        for qubit in range(4):
+            circuit = qxelarator.Circuit(4)
+            circuit.add_gate("X", [qubit]).add_measure_all()
+            jobs.append(qxelarator.submit_circuit(circuit, iterations=5))
+
+        for qubit, job in enumerate(jobs):
+            simulation_result = job.wait()
+            self.assertIsInstance(simulation_result, qxelarator.SimulationResult)
+            self.assertEqual(simulation_result.results, {format(1 << qubit, "04b"): 5})
+
 
 if __name__ == '__main__':
     unittest.main()